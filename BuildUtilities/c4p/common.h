@@ -204,6 +204,16 @@ void open_name_file();
 void close_name_file();
 void begin_routine(prototype_node *, unsigned);
 void end_routine(unsigned);
+void generate_routine_name_table();
+void specialize_begin_routine(symbol_t *, unsigned);
+void specialize_end_routine();
+void specialize_note_call(symbol_t *);
+void specialize_note_runtime_routine(symbol_t *);
+void specialize_note_variable(symbol_t *);
+void specialize_note_assignment(pascal_type);
+bool is_cachable_global(const symbol_t *);
+std::string cache_global(symbol_t *, const std::string &);
+void generate_specialization_macros();
 void add_loner(const char *);
 void begin_new_c_file(const char *, int);
 void open_header_file();
@@ -261,6 +271,8 @@ extern std::string var_name_prefix;
 extern bool chars_are_unsigned;
 extern std::string name_space;
 extern bool emit_optimize_pragmas;
+extern bool specialize_flag;
+extern unsigned inline_limit;
 extern bool legacy_flag;
 extern std::string integer_literal_suffix;
 extern bool relational_cast_expressions;
@@ -215,6 +215,10 @@ program_block:
                   close_header_file();
                   if (!def_filename.empty())
                   {
+                    if (specialize_flag)
+                    {
+                      generate_specialization_macros();
+                    }
                     close_def_file();
                   }
                   close_name_file();
@@ -1029,6 +1033,7 @@ compound_statement:
                       cppout.out_s("C4P_FAST_VARS_0\n");
                     }
                     cppout.out_s("C4P_BEGIN_PROGRAM(\"" + std::string(prog_symbol->s_repr) + "\", argc, argv);\n");
+                    generate_routine_name_table();
                   }
                 }
           statement_sequence END
@@ -1109,6 +1114,10 @@ procedure_statement:
                   {
                     c4p_warning("`%s' is not a procedure identifier", $1->s_repr);
                   }
+                  if (specialize_flag)
+                  {
+                    specialize_note_call($1);
+                  }
                   cppout.out_s(std::string($1->s_repr) + " (");
                   push_parameter_node (last_parameter);
                   if ($1->s_kind == PROCEDURE_IDENTIFIER)
@@ -1561,6 +1570,10 @@ to_or_downto:
 assignment_statement:
           variable_access
                 {
+                  if (specialize_flag)
+                  {
+                    specialize_note_assignment(last_type);
+                  }
                   if (last_type == FUNCTION_TYPE)
                   {
                     cppout.out_s("c4p_result = ");
@@ -1635,6 +1648,10 @@ variable_identifier:
                       cppout.out_s("c4p_fast_" + std::string($1->s_repr) + "_" + std::to_string(routine_handle));
                       remember_fast_var($1->s_repr);
                     }
+                    else if (specialize_flag && is_cachable_global($1))
+                    {
+                      cppout.out_s(cache_global($1, (var_struct_name.empty() ? "" : var_struct_name + ".") + var_name_prefix + $1->s_repr));
+                    }
                     else
                     {
                       if ($1->s_block_level == 0 && $1->s_kind == VARIABLE_IDENTIFIER && ! ($1->s_flags & S_PREDEFINED))
@@ -1647,6 +1664,10 @@ variable_identifier:
                       }
                       cppout.out_s($1->s_repr);
                     }
+                    if (specialize_flag)
+                    {
+                      specialize_note_variable($1);
+                    }
                     break;
                   case FUNCTION_IDENTIFIER:
                     last_type = FUNCTION_TYPE;
@@ -1961,6 +1982,10 @@ factor:
                   if (last_type == FUNCTION_TYPE)
                   {
                     prototype_node * proto = reinterpret_cast<prototype_node*>(last_type_ptr);
+                    if (specialize_flag)
+                    {
+                      specialize_note_call(proto->name);
+                    }
                     if (strcmp(proto->name->s_repr, "eoln") == 0)
                     {
                       cppout.out_s("eoln(input)");
@@ -1985,6 +2010,10 @@ factor:
                   {
                     c4p_error("internal error: `%1' has no type", $1->s_repr);
                   }
+                  if (specialize_flag)
+                  {
+                    specialize_note_call($1);
+                  }
                   cppout.out_s(std::string($1->s_repr) + " (");
                   push_parameter_node(last_parameter);
                   if ($1->s_kind == FUNCTION_IDENTIFIER)
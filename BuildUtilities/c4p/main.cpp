@@ -65,6 +65,8 @@ unsigned extra_indent;
 unsigned max_lines_per_c_file;
 string name_space;
 bool emit_optimize_pragmas;
+bool specialize_flag;
+unsigned inline_limit = 12;
 bool legacy_flag;
 string integer_literal_suffix;
 bool relational_cast_expressions = false;
@@ -127,6 +129,8 @@ Options:\n\
   --class-include=FILENAME\n\
   --emit-optimize-pragmas\n\
   --entry-name=NAME\n\
+  --inline-limit=NUM\n\
+  --specialize\n\
   --declare-c-type=NAME\n\
   --var-name-prefix=PREFIX\n\
   --var-struct=NAME\n\
@@ -160,6 +164,8 @@ Options:\n\
 #define OPT_DECLARE_C_TYPE 15
 #define OPT_NAMESPACE 16
 #define OPT_EMIT_OPTIMIZE_PRAGMAS 17
+#define OPT_SPECIALIZE 18
+#define OPT_INLINE_LIMIT 19
 
 namespace {
   const struct option longopts[] =
@@ -179,11 +185,13 @@ namespace {
     "header-file", required_argument, nullptr, OPT_HEADER_FILE,
     "help", no_argument, nullptr, 'h',
     "include-filename", required_argument, nullptr, 'i',
+    "inline-limit", required_argument, nullptr, OPT_INLINE_LIMIT,
     "lines", required_argument, nullptr, 'l',
     "namespace", required_argument, nullptr, OPT_NAMESPACE,
     "one", optional_argument, nullptr, '1',
     "output-prefix", required_argument, nullptr, 'p',
     "rename", required_argument, nullptr, 'r',
+    "specialize", no_argument, nullptr, OPT_SPECIALIZE,
     "using-namespace", required_argument, nullptr, OPT_USING_NAMESPACE,
     "var-name-prefix", required_argument, nullptr, OPT_VAR_NAME_PREFIX,
     "var-struct", required_argument, nullptr, OPT_VAR_STRUCT,
@@ -269,6 +277,12 @@ void option_handler(int argc, char ** argv)
     case OPT_NAMESPACE:
       name_space = optarg;
       break;
+    case OPT_SPECIALIZE:
+      specialize_flag = true;
+      break;
+    case OPT_INLINE_LIMIT:
+      inline_limit = std::stoi(optarg);
+      break;
     case 'C':
       c_ext = ".cc";
       break;
@@ -321,6 +335,12 @@ void option_handler(int argc, char ** argv)
     pascal_file_name = argv[optind];
   }
 
+  if (specialize_flag && (def_filename.empty() || !one_c_file))
+  {
+    fprintf(stderr, T_("%s: --specialize requires --def-filename and --one\n"), myname.c_str());
+    exit(1);
+  }
+
   if (legacy_flag)
   {
     integer_literal_suffix = "l";
@@ -36,6 +36,7 @@ namespace {
   unsigned c_file_number;
   FILE * name_file;
   std::string current_fast_vars;
+  std::vector<std::string> routine_names;
 }
 
 const size_t MY_PATH_MAX = 8192;
@@ -309,6 +310,11 @@ void begin_routine(prototype_node * proto, unsigned handle)
   cppout.redir_file(DEF_FILE_NUM);
   cppout.out_s("#define C4P_HANDLE_" + std::string(proto->name->s_repr) + " " + std::to_string(handle) + "\n");
   cppout.redir_file(C_FILE_NUM);
+  if (routine_names.size() <= handle)
+  {
+    routine_names.resize(handle + 1);
+  }
+  routine_names[handle] = proto->name->s_repr;
   check_c_file_size();
   cppout.out_s("\n");
   ++block_level;
@@ -327,6 +333,10 @@ void begin_routine(prototype_node * proto, unsigned handle)
     cppout.out_s("#pragma optimize (\"\", off)\n");
     cppout.out_s("#endif\n");
   }
+  if (specialize_flag)
+  {
+    cppout.out_s("\nC4P_INLINE_" + std::to_string(handle));
+  }
   generate_routine_head(proto);
   cppout.out_s("\n");
   cppout.out_s("{\n");
@@ -336,6 +346,11 @@ void begin_routine(prototype_node * proto, unsigned handle)
     cppout.out_s("C4P_FAST_VARS_" + std::to_string(handle) + "\n");
     forget_fast_vars();
   }
+  if (specialize_flag)
+  {
+    cppout.out_s("C4P_CACHED_GLOBALS_" + std::to_string(handle) + "\n");
+    specialize_begin_routine(proto->name, handle);
+  }
 #if 0
   fprintf(name_file, "%u %s\n", handle, proto->name->s_repr);
 #endif
@@ -344,6 +359,10 @@ void begin_routine(prototype_node * proto, unsigned handle)
 
 void end_routine(unsigned handle)
 {
+  if (specialize_flag)
+  {
+    specialize_end_routine();
+  }
   unmark_type_table();
   unmark_string_table();
   unmark_symbol_table();
@@ -365,6 +384,30 @@ void end_routine(unsigned handle)
   }
 }
 
+void generate_routine_name_table()
+{
+  if (class_name.empty())
+  {
+    return;
+  }
+  if (routine_names.empty())
+  {
+    routine_names.resize(1);
+  }
+  routine_names[0] = prog_symbol->s_repr;
+  cppout.out_s("#if defined(MIKTEX_C4P_PROFILING)\n");
+  cppout.out_s("{\n");
+  cppout.out_s("static const char* const c4p_routine_names[] = {\n");
+  for (const string& name : routine_names)
+  {
+    cppout.out_s("\"" + name + "\",\n");
+  }
+  cppout.out_s("};\n");
+  cppout.out_s("this->StartProfiler(c4p_routine_names, " + std::to_string(routine_names.size()) + ");\n");
+  cppout.out_s("}\n");
+  cppout.out_s("#endif\n");
+}
+
 char * strcpye(char * s1, const char * s2)
 {
   while ((*s1++ = *s2++) != 0)
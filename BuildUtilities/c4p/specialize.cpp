@@ -0,0 +1,247 @@
+/* specialize.cpp: whole-program specialization         -*- C++ -*-
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of C4P.
+
+   C4P is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   C4P is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+   or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+   License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with C4P; if not, write to the Free Software Foundation, 59
+   Temple Place - Suite 330, Boston, MA 02111-1307, USA.  */
+
+/* In specialization mode, C4P records the call graph and the size of
+   each routine while translating.  When the whole program has been
+   seen, it defines two macros per routine in the def file:
+
+   C4P_INLINE_n precedes the definition of routine n and expands to
+   C4P_INLINE, if the routine is small, not recursive and called from
+   Pascal code.  The routine is declared inline, but it keeps its
+   external definition, so it can still be called from C++ code.
+
+   C4P_CACHED_GLOBALS_n starts the body of routine n and declares the
+   c4p_cached_ aliases of the global arrays used by the routine.  If
+   neither the routine nor any routine it calls (transitively) assigns
+   the array variable, and if no routine of this call tree calls an
+   external routine (which might reallocate the array), the array
+   pointer is copied into a local; otherwise the alias is a reference
+   to the global. */
+
+#include <cstring>
+#include <map>
+#include <set>
+
+#include "common.h"
+#include "gram.h"
+#include "output.h"
+
+using namespace std;
+
+namespace {
+  struct cached_global
+  {
+    string expression;
+    unsigned uses = 0;
+  };
+
+  struct routine_info
+  {
+    bool defined = false;
+    unsigned first_line = 0;
+    unsigned lines = 0;
+    unsigned callers = 0;
+    bool opaque = false;
+    bool not_inlinable = false;
+    set<symbol_t *> callees;
+    set<string> assigned_globals;
+    map<string, cached_global> cached_globals;
+  };
+
+  vector<routine_info> routines(1);
+  map<symbol_t *, unsigned> routine_handles;
+  set<symbol_t *> runtime_routines;
+  unsigned current_routine;
+  symbol_t * last_variable;
+
+  routine_info & current()
+  {
+    return routines[current_routine];
+  }
+
+  /* Collects the routines reachable from a routine. */
+  void collect_callees(unsigned handle, const vector<vector<unsigned>> & edges, vector<bool> & reached)
+  {
+    for (unsigned callee : edges[handle])
+    {
+      if (!reached[callee])
+      {
+        reached[callee] = true;
+        collect_callees(callee, edges, reached);
+      }
+    }
+  }
+}
+
+void specialize_begin_routine(symbol_t * name, unsigned handle)
+{
+  if (routines.size() <= handle)
+  {
+    routines.resize(handle + 1);
+  }
+  routine_handles[name] = handle;
+  current_routine = handle;
+  current().defined = true;
+  current().first_line = c_file_line_count;
+}
+
+void specialize_end_routine()
+{
+  current().lines = c_file_line_count - current().first_line;
+  current_routine = 0;
+}
+
+void specialize_note_call(symbol_t * callee)
+{
+  if (callee->s_kind != PROCEDURE_IDENTIFIER && callee->s_kind != FUNCTION_IDENTIFIER)
+  {
+    current().opaque = true;
+    return;
+  }
+  if (strcmp(callee->s_repr, "c4psetjmp") == 0)
+  {
+    /* GCC does not inline functions calling setjmp() */
+    current().not_inlinable = true;
+  }
+  current().callees.insert(callee);
+}
+
+/* Records a routine of the C4P runtime library. */
+void specialize_note_runtime_routine(symbol_t * sym)
+{
+  runtime_routines.insert(sym);
+}
+
+void specialize_note_variable(symbol_t * sym)
+{
+  last_variable = sym;
+}
+
+void specialize_note_assignment(pascal_type lhs_type)
+{
+  if (last_variable == nullptr || (lhs_type != ARRAY_NODE && lhs_type != POINTER_NODE))
+  {
+    return;
+  }
+  if (last_variable->s_kind == PARAMETER_IDENTIFIER && (last_variable->s_flags & S_BY_REFERENCE))
+  {
+    /* the caller's array might be cached */
+    current().opaque = true;
+  }
+  else if (last_variable->s_block_level == 0)
+  {
+    current().assigned_globals.insert(last_variable->s_repr);
+  }
+}
+
+bool is_cachable_global(const symbol_t * sym)
+{
+  return current_routine > 0
+    && sym->s_kind == VARIABLE_IDENTIFIER
+    && sym->s_block_level == 0
+    && !(sym->s_flags & S_PREDEFINED)
+    && (sym->s_type == ARRAY_NODE || sym->s_type == POINTER_NODE);
+}
+
+string cache_global(symbol_t * sym, const string & expression)
+{
+  cached_global & cached = current().cached_globals[sym->s_repr];
+  cached.expression = expression;
+  cached.uses += 1;
+  return "c4p_cached_" + string(sym->s_repr) + "_" + std::to_string(current_routine);
+}
+
+void generate_specialization_macros()
+{
+  unsigned n = routines.size();
+
+  vector<vector<unsigned>> edges(n);
+  for (unsigned handle = 0; handle < n; ++handle)
+  {
+    for (symbol_t * callee : routines[handle].callees)
+    {
+      auto it = routine_handles.find(callee);
+      if (it != routine_handles.end())
+      {
+        edges[handle].push_back(it->second);
+        routines[it->second].callers += 1;
+      }
+      else if (runtime_routines.find(callee) == runtime_routines.end())
+      {
+        /* an external routine: implemented in C++ */
+        routines[handle].opaque = true;
+      }
+    }
+  }
+
+  cppout.redir_file(DEF_FILE_NUM);
+  cppout.out_s("\n");
+  unsigned n_inlined = 0;
+  unsigned n_cached = 0;
+  for (unsigned handle = 1; handle < n; ++handle)
+  {
+    const routine_info & routine = routines[handle];
+    if (!routine.defined)
+    {
+      continue;
+    }
+    vector<bool> reached(n, false);
+    collect_callees(handle, edges, reached);
+    bool recursive = reached[handle];
+    reached[handle] = true;
+    bool opaque = false;
+    set<string> assigned_globals;
+    for (unsigned other = 0; other < n; ++other)
+    {
+      if (reached[other])
+      {
+        opaque = opaque || routines[other].opaque;
+        assigned_globals.insert(routines[other].assigned_globals.begin(), routines[other].assigned_globals.end());
+      }
+    }
+    string handle_str = std::to_string(handle);
+    if (routine.lines <= inline_limit && !recursive && routine.callers > 0 && !routine.not_inlinable)
+    {
+      cppout.out_s("#define C4P_INLINE_" + handle_str + " C4P_INLINE\n");
+      ++n_inlined;
+    }
+    else
+    {
+      cppout.out_s("#define C4P_INLINE_" + handle_str + "\n");
+    }
+    cppout.out_s("#define C4P_CACHED_GLOBALS_" + handle_str);
+    for (const auto & p : routine.cached_globals)
+    {
+      string local_name = "c4p_cached_" + p.first + "_" + handle_str;
+      const string & expression = p.second.expression;
+      if (!opaque && p.second.uses > 1 && assigned_globals.find(p.first) == assigned_globals.end())
+      {
+        cppout.out_s(" C4P::CachedGlobal<decltype(" + expression + ")>::type " + local_name + " = " + expression + ";");
+        ++n_cached;
+      }
+      else
+      {
+        cppout.out_s(" auto & " + local_name + " = " + expression + ";");
+      }
+    }
+    cppout.out_s("\n");
+  }
+  c4p_warning("%u routines inlined, %u global arrays cached", n_inlined, n_cached);
+}
@@ -408,6 +408,7 @@ void new_function(const char * func_name, const char * result_type)
   sym->s_kind = FUNCTION_IDENTIFIER;
   sym->s_type = PROTOTYPE_NODE;
   sym->s_type_ptr = new_type_node(PROTOTYPE_NODE, sym, 0, lookup(result_type));
+  specialize_note_runtime_routine(sym);
 }
 
 void new_build_in(const char * name, unsigned number)
@@ -425,6 +426,7 @@ void new_procedure(const char * proc_name)
   sym->s_kind = PROCEDURE_IDENTIFIER;
   sym->s_type = PROTOTYPE_NODE;
   sym->s_type_ptr = new_type_node(PROTOTYPE_NODE, sym, 0, 0);
+  specialize_note_runtime_routine(sym);
 }
 
 void new_mapping(const char * name, const char * mapped_name)
@@ -21,7 +21,9 @@
 
 #include "config.h"
 
+#include <algorithm>
 #include <csignal>
+#include <cstdio>
 #include <cstdlib>
 #include <ctime>
 
@@ -33,8 +35,12 @@
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <log4cxx/appenderskeleton.h>
 #include <log4cxx/basicconfigurator.h>
+#include <log4cxx/helpers/transcoder.h>
 #include <log4cxx/logger.h>
+#include <log4cxx/logmanager.h>
+#include <log4cxx/patternlayout.h>
 #include <log4cxx/rollingfileappender.h>
 #include <log4cxx/xml/domconfigurator.h>
 
@@ -43,6 +49,7 @@
 #include <miktex/Core/Cfg>
 #include <miktex/Core/CommandLineBuilder>
 #include <miktex/Core/ConfigNames>
+#include <miktex/Core/Directory>
 #include <miktex/Core/Exceptions>
 #include <miktex/Core/File>
 #include <miktex/Core/FileType>
@@ -51,6 +58,8 @@
 #include <miktex/Core/Process>
 #include <miktex/Core/Quoter>
 #include <miktex/Core/Session>
+#include <miktex/Core/StreamReader>
+#include <miktex/Core/StreamWriter>
 #include <miktex/Setup/SetupService>
 #include <miktex/Trace/Trace>
 #include <miktex/UI/UI>
@@ -258,34 +267,345 @@ void Application::Init(const Session::InitInfo& initInfoArg, vector<char*>& args
   Init(initInfo);
 }
 
-void Application::ConfigureLogging()
+// the relevant part of a parsed log4cxx.xml: one rolling file appender
+// attached to the root logger plus logger levels
+struct LoggingConfig
 {
-  string myName = Utils::GetExeName();
-  PathName xmlFileName;
-  if (pimpl->session->FindFile(myName + "." + MIKTEX_LOG4CXX_CONFIG_FILENAME, MIKTEX_PATH_TEXMF_PLACEHOLDER "/" MIKTEX_PATH_MIKTEX_PLATFORM_CONFIG_DIR, xmlFileName)
-    || pimpl->session->FindFile(MIKTEX_LOG4CXX_CONFIG_FILENAME, MIKTEX_PATH_TEXMF_PLACEHOLDER "/" MIKTEX_PATH_MIKTEX_PLATFORM_CONFIG_DIR, xmlFileName))
+  string stamp;
+  string file;
+  bool append = true;
+  long maxFileSize = 10 * 1024 * 1024;
+  int maxBackupIndex = 1;
+  string threshold;
+  string conversionPattern;
+  string rootLevel;
+  vector<pair<string, string>> loggerLevels;
+};
+
+namespace {
+  // DECLARE_LOG4CXX_OBJECT refers to helpers::Class
+  namespace helpers = log4cxx::helpers;
+}
+
+// a rolling file appender which opens the log file when the first
+// event passes the threshold
+class DeferredRollingFileAppender :
+  public log4cxx::AppenderSkeleton
+{
+public:
+  DECLARE_LOG4CXX_OBJECT(DeferredRollingFileAppender)
+  BEGIN_LOG4CXX_CAST_MAP()
+    LOG4CXX_CAST_ENTRY(DeferredRollingFileAppender)
+    LOG4CXX_CAST_ENTRY_CHAIN(AppenderSkeleton)
+  END_LOG4CXX_CAST_MAP()
+
+public:
+  DeferredRollingFileAppender()
+  {
+  }
+
+public:
+  void Configure(const LoggingConfig& config)
+  {
+    LOG4CXX_DECODE_CHAR(fileName, config.file);
+    this->fileName = fileName;
+    appendToFile = config.append;
+    maxFileSize = config.maxFileSize;
+    maxBackupIndex = config.maxBackupIndex;
+  }
+
+public:
+  PathName GetFile() const
   {
-    PathName logDir = pimpl->session->GetSpecialPath(SpecialPath::LogDirectory);
-    string logName = myName;
-    if (pimpl->session->IsAdminMode())
+    return PathName(fileName);
+  }
+
+public:
+  void close() override
+  {
+    if (target != nullptr)
     {
-      logName += MIKTEX_ADMIN_SUFFIX;
+      target->close();
     }
-    Utils::SetEnvironmentString("MIKTEX_LOG_DIR", logDir.ToString());
-    Utils::SetEnvironmentString("MIKTEX_LOG_NAME", logName);
-    log4cxx::xml::DOMConfigurator::configure(xmlFileName.ToWideCharString());
+    closed = true;
   }
-  else
+
+public:
+  bool requiresLayout() const override
   {
-    log4cxx::BasicConfigurator::configure();
+    return true;
   }
-  isLog4cxxConfigured = true;
-  logger = log4cxx::Logger::getLogger(myName);
+
+protected:
+  void append(const log4cxx::spi::LoggingEventPtr& event, log4cxx::helpers::Pool& pool) override
+  {
+    if (target == nullptr)
+    {
+      log4cxx::RollingFileAppenderPtr appender(new log4cxx::RollingFileAppender());
+      appender->setName(getName());
+      appender->setLayout(getLayout());
+      appender->setFile(fileName);
+      appender->setAppend(appendToFile);
+      appender->setMaximumFileSize(static_cast<int>(maxFileSize));
+      appender->setMaxBackupIndex(maxBackupIndex);
+      appender->activateOptions(pool);
+      target = appender;
+    }
+    target->doAppend(event, pool);
+  }
+
+private:
+  log4cxx::LogString fileName;
+
+private:
+  bool appendToFile = true;
+
+private:
+  long maxFileSize = 0;
+
+private:
+  int maxBackupIndex = 0;
+
+private:
+  log4cxx::RollingFileAppenderPtr target;
+};
+
+IMPLEMENT_LOG4CXX_OBJECT(DeferredRollingFileAppender)
+
+#define LOGGING_CACHE_SIGNATURE "# log4cxx configuration cache 3"
+
+// reads the cache if it has been written with the given stamp; the
+// stamp is the second line, so that a stale cache is rejected before
+// anything is parsed
+static bool ReadLoggingConfigCache(const PathName& cacheFile, const string& stamp, LoggingConfig& config)
+{
+  if (!File::Exists(cacheFile))
+  {
+    return false;
+  }
+  StreamReader reader(cacheFile);
+  string line;
+  if (!reader.ReadLine(line) || line != LOGGING_CACHE_SIGNATURE || !reader.ReadLine(line) || line != "stamp=" + stamp)
+  {
+    return false;
+  }
+  config.stamp = stamp;
+  while (reader.ReadLine(line))
+  {
+    size_t pos = line.find('=');
+    if (pos == string::npos)
+    {
+      return false;
+    }
+    string key = line.substr(0, pos);
+    string value = line.substr(pos + 1);
+    if (key == "file")
+    {
+      config.file = value;
+    }
+    else if (key == "append")
+    {
+      config.append = value == "true";
+    }
+    else if (key == "maxFileSize")
+    {
+      config.maxFileSize = std::stol(value);
+    }
+    else if (key == "maxBackupIndex")
+    {
+      config.maxBackupIndex = std::stoi(value);
+    }
+    else if (key == "threshold")
+    {
+      config.threshold = value;
+    }
+    else if (key == "pattern")
+    {
+      config.conversionPattern = value;
+    }
+    else if (key == "root")
+    {
+      config.rootLevel = value;
+    }
+    else if (key.compare(0, 7, "logger.") == 0)
+    {
+      config.loggerLevels.push_back(make_pair(key.substr(7), value));
+    }
+  }
+  reader.Close();
+  return true;
 }
 
-inline bool IsNewer(const PathName& path1, const PathName& path2)
+static void WriteLoggingConfigCache(const PathName& cacheFile, const LoggingConfig& config)
 {
-  return File::Exists(path1) && File::Exists(path2) && File::GetLastWriteTime(path1) > File::GetLastWriteTime(path2);
+  Directory::Create(PathName(cacheFile).RemoveFileSpec());
+  StreamWriter writer(cacheFile);
+  writer.WriteLine(LOGGING_CACHE_SIGNATURE);
+  writer.WriteLine("stamp=" + config.stamp);
+  writer.WriteLine("file=" + config.file);
+  writer.WriteLine("append="s + (config.append ? "true" : "false"));
+  writer.WriteLine("maxFileSize=" + std::to_string(config.maxFileSize));
+  writer.WriteLine("maxBackupIndex=" + std::to_string(config.maxBackupIndex));
+  writer.WriteLine("threshold=" + config.threshold);
+  writer.WriteLine("pattern=" + config.conversionPattern);
+  writer.WriteLine("root=" + config.rootLevel);
+  for (const auto& p : config.loggerLevels)
+  {
+    writer.WriteLine("logger." + p.first + "=" + p.second);
+  }
+  writer.Close();
+}
+
+// inspect what DOMConfigurator has set up; returns false if the
+// configuration is more than we can reproduce
+static bool ExtractLoggingConfig(LoggingConfig& config)
+{
+  log4cxx::LoggerPtr rootLogger = log4cxx::Logger::getRootLogger();
+  log4cxx::AppenderList appenders = rootLogger->getAllAppenders();
+  if (appenders.size() != 1)
+  {
+    return false;
+  }
+  log4cxx::RollingFileAppenderPtr appender = appenders[0];
+  if (appender == nullptr || appender->getFirstFilter() != nullptr)
+  {
+    return false;
+  }
+  log4cxx::PatternLayoutPtr layout = appender->getLayout();
+  if (layout == nullptr)
+  {
+    return false;
+  }
+  LOG4CXX_ENCODE_CHAR(file, appender->getFile());
+  config.file = file;
+  config.append = appender->getAppend();
+  config.maxFileSize = appender->getMaximumFileSize();
+  config.maxBackupIndex = appender->getMaxBackupIndex();
+  if (appender->getThreshold() != nullptr)
+  {
+    appender->getThreshold()->toString(config.threshold);
+  }
+  LOG4CXX_ENCODE_CHAR(conversionPattern, layout->getConversionPattern());
+  config.conversionPattern = conversionPattern;
+  if (rootLogger->getLevel() != nullptr)
+  {
+    rootLogger->getLevel()->toString(config.rootLevel);
+  }
+  for (const log4cxx::LoggerPtr& logger : log4cxx::LogManager::getCurrentLoggers())
+  {
+    if (!logger->getAllAppenders().empty())
+    {
+      return false;
+    }
+    if (logger->getLevel() != nullptr)
+    {
+      string name;
+      string level;
+      logger->getName(name);
+      logger->getLevel()->toString(level);
+      config.loggerLevels.push_back(make_pair(name, level));
+    }
+  }
+  return config.file.find('\n') == string::npos && config.conversionPattern.find('\n') == string::npos;
+}
+
+static void ApplyLoggingConfig(const LoggingConfig& config)
+{
+  LOG4CXX_DECODE_CHAR(conversionPattern, config.conversionPattern);
+  log4cxx::helpers::ObjectPtrT<DeferredRollingFileAppender> appender(new DeferredRollingFileAppender());
+  appender->setName(LOG4CXX_STR("RollingLogFile"));
+  appender->setLayout(log4cxx::LayoutPtr(new log4cxx::PatternLayout(conversionPattern)));
+  appender->Configure(config);
+  if (!config.threshold.empty())
+  {
+    appender->setThreshold(log4cxx::Level::toLevel(config.threshold));
+  }
+  log4cxx::LoggerPtr rootLogger = log4cxx::Logger::getRootLogger();
+  // same as DOMConfigurator: the root logger's appenders are replaced
+  rootLogger->removeAllAppenders();
+  rootLogger->addAppender(appender);
+  if (!config.rootLevel.empty())
+  {
+    rootLogger->setLevel(log4cxx::Level::toLevel(config.rootLevel));
+  }
+  for (const auto& p : config.loggerLevels)
+  {
+    log4cxx::Logger::getLogger(p.first)->setLevel(log4cxx::Level::toLevel(p.second));
+  }
+}
+
+static bool GetLogFile(PathName& path)
+{
+  log4cxx::AppenderPtr appender = log4cxx::Logger::getRootLogger()->getAppender(LOG4CXX_STR("RollingLogFile"));
+  log4cxx::RollingFileAppenderPtr rollingFileAppender = appender;
+  if (rollingFileAppender != nullptr)
+  {
+    path = PathName(rollingFileAppender->getFile());
+    return true;
+  }
+  log4cxx::helpers::ObjectPtrT<DeferredRollingFileAppender> deferredAppender = appender;
+  if (deferredAppender != nullptr)
+  {
+    path = deferredAppender->GetFile();
+    return true;
+  }
+  return false;
+}
+
+void Application::ConfigureLogging()
+{
+  string myName = Utils::GetExeName();
+  PathName logDir = pimpl->session->GetSpecialPath(SpecialPath::LogDirectory);
+  string logName = myName;
+  if (pimpl->session->IsAdminMode())
+  {
+    logName += MIKTEX_ADMIN_SUFFIX;
+  }
+  Utils::SetEnvironmentString("MIKTEX_LOG_DIR", logDir.ToString());
+  Utils::SetEnvironmentString("MIKTEX_LOG_NAME", logName);
+
+  // the cache is keyed on the last maintenance times: configuration
+  // files are installed (and made known to the file name database) by
+  // a maintenance run; a configuration file which is edited in place
+  // takes effect after the next one
+  PathName cacheFile = pimpl->session->GetSpecialPath(SpecialPath::DataRoot) / PathName(MIKTEX_PATH_LOG4CXX_CACHE_DIR) / PathName(logName + ".cache");
+  string stamp = pimpl->session->GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_LAST_ADMIN_MAINTENANCE, ConfigValue("0")).GetString()
+    + "," + pimpl->session->GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_LAST_USER_MAINTENANCE, ConfigValue("0")).GetString();
+  LoggingConfig cachedConfig;
+  if (ReadLoggingConfigCache(cacheFile, stamp, cachedConfig))
+  {
+    ApplyLoggingConfig(cachedConfig);
+  }
+  else
+  {
+    PathName xmlFileName;
+    if (pimpl->session->FindFile(myName + "." + MIKTEX_LOG4CXX_CONFIG_FILENAME, MIKTEX_PATH_TEXMF_PLACEHOLDER "/" MIKTEX_PATH_MIKTEX_PLATFORM_CONFIG_DIR, xmlFileName)
+      || pimpl->session->FindFile(MIKTEX_LOG4CXX_CONFIG_FILENAME, MIKTEX_PATH_TEXMF_PLACEHOLDER "/" MIKTEX_PATH_MIKTEX_PLATFORM_CONFIG_DIR, xmlFileName))
+    {
+      log4cxx::xml::DOMConfigurator::configure(xmlFileName.ToWideCharString());
+      LoggingConfig config;
+      if (ExtractLoggingConfig(config))
+      {
+        config.stamp = stamp;
+        // appenders are re-created lazily
+        log4cxx::LogManager::resetConfiguration();
+        ApplyLoggingConfig(config);
+        try
+        {
+          WriteLoggingConfigCache(cacheFile, config);
+        }
+        catch (const MiKTeXException&)
+        {
+        }
+      }
+    }
+    else
+    {
+      log4cxx::BasicConfigurator::configure();
+    }
+  }
+  isLog4cxxConfigured = true;
+  logger = log4cxx::Logger::getLogger(myName);
 }
 
 void Application::AutoMaintenance()
@@ -310,32 +630,60 @@ void Application::AutoMaintenance()
     throw 1;
   }
 
+  // fast path: nothing to do if the stamp file is at least as new as
+  // the last recorded configuration change; Core records one whenever
+  // the configuration is modified (e.g., when languages.ini is written
+  // or the file name database is refreshed)
+  time_t lastAdminUpdateDb = 0;
+  time_t lastChange = lastAdminMaintenance;
+  if (!pimpl->session->IsAdminMode())
+  {
+    lastAdminUpdateDb = pimpl->session->GetConfigValue(MIKTEX_CONFIG_SECTION_MPM, MIKTEX_CONFIG_VALUE_LAST_ADMIN_UPDATE_DB, ConfigValue("0")).GetTimeT();
+    lastChange = std::max({ lastChange, lastUserMaintenance, lastAdminUpdateDb });
+  }
+  PathName stampFile = pimpl->session->GetSpecialPath(SpecialPath::DataRoot) / PathName(MIKTEX_PATH_AUTO_MAINTENANCE_STAMP);
+  time_t stampTime;
+  if (File::TryGetLastWriteTime(stampFile, stampTime) && stampTime >= lastChange)
+  {
+    return;
+  }
+
   // must refresh FNDB if:
   //   (1) it doesn't exist
   //   (2) in user mode and an admin just modified the MiKTeX configuration
   PathName mpmDatabasePath(pimpl->session->GetMpmDatabasePathName());
-  bool mustRefreshFndb = !File::Exists(mpmDatabasePath) || (!pimpl->session->IsAdminMode() && lastAdminMaintenance > File::GetLastWriteTime(mpmDatabasePath));
+  time_t mpmDatabaseTime;
+  bool haveMpmDatabase = File::TryGetLastWriteTime(mpmDatabasePath, mpmDatabaseTime);
+  bool mustRefreshFndb = !haveMpmDatabase || (!pimpl->session->IsAdminMode() && lastAdminMaintenance > mpmDatabaseTime);
 
   // must build language.dat if:
   //   (1) in user mode and an admin just modified the MiKTeX configuration
   //   (2) in user mode and languages.ini is newer than languages.dat
-  PathName userLanguageDat = pimpl->session->IsAdminMode() ? PathName() : pimpl->session->GetSpecialPath(SpecialPath::UserConfigRoot) / PathName(MIKTEX_PATH_LANGUAGE_DAT);
-  bool mustRefreshUserLanguageDat = !pimpl->session->IsAdminMode() && File::Exists(userLanguageDat) && lastAdminMaintenance > File::GetLastWriteTime(userLanguageDat);
-  PathName userLanguagesIni = pimpl->session->IsAdminMode() ? PathName() : pimpl->session->GetSpecialPath(SpecialPath::UserConfigRoot) / PathName(MIKTEX_PATH_LANGUAGES_INI);
-  mustRefreshUserLanguageDat = mustRefreshUserLanguageDat || (!pimpl->session->IsAdminMode() && IsNewer(userLanguagesIni, userLanguageDat));
+  bool mustRefreshUserLanguageDat = false;
+  if (!pimpl->session->IsAdminMode())
+  {
+    PathName userLanguageDat = pimpl->session->GetSpecialPath(SpecialPath::UserConfigRoot) / PathName(MIKTEX_PATH_LANGUAGE_DAT);
+    PathName userLanguagesIni = pimpl->session->GetSpecialPath(SpecialPath::UserConfigRoot) / PathName(MIKTEX_PATH_LANGUAGES_INI);
+    time_t userLanguageDatTime;
+    time_t userLanguagesIniTime;
+    if (File::TryGetLastWriteTime(userLanguageDat, userLanguageDatTime))
+    {
+      mustRefreshUserLanguageDat = lastAdminMaintenance > userLanguageDatTime
+        || (File::TryGetLastWriteTime(userLanguagesIni, userLanguagesIniTime) && userLanguagesIniTime > userLanguageDatTime);
+    }
+  }
 
   // must update package db if:
   //   (1) in user mode and the system-wide package db is newer than the user package db
   bool mustUpdateDb = false;
   if (!pimpl->session->IsAdminMode())
   {
-    time_t lastAdminUpdateDb = pimpl->session->GetConfigValue(MIKTEX_CONFIG_SECTION_MPM, MIKTEX_CONFIG_VALUE_LAST_ADMIN_UPDATE_DB, ConfigValue("0")).GetTimeT();
     PathName userPackageManifestsIni = pimpl->session->GetSpecialPath(SpecialPath::InstallRoot) / PathName(MIKTEX_PATH_PACKAGE_MANIFESTS_INI);
     mustUpdateDb = File::Exists(userPackageManifestsIni) && lastAdminUpdateDb > File::GetLastWriteTime(userPackageManifestsIni);
   }
 
-  PathName initexmf;
-  if ((mustRefreshFndb || mustRefreshUserLanguageDat || mustUpdateDb) && pimpl->session->FindFile(MIKTEX_INITEXMF_EXE, FileType::EXE, initexmf))
+  bool succeeded = true;
+  if (mustRefreshFndb || mustRefreshUserLanguageDat || mustUpdateDb)
   {
     unique_ptr<MiKTeX::Core::LockFile> lockFile = LockFile::Create(pimpl->session->GetSpecialPath(SpecialPath::DataRoot) / PathName(MIKTEX_PATH_AUTO_MAINTENANCE_LOCK));
     if (!lockFile->TryLock(0ms))
@@ -343,13 +691,13 @@ void Application::AutoMaintenance()
       return;
     }
     LOG4CXX_TRACE(logger, "running MIKTEX_HOOK_AUTO_MAINTENANCE");
+    if (pimpl->packageManager == nullptr)
+    {
+      pimpl->packageManager = PackageManager::Create(PackageManager::InitInfo(this));
+    }
     if (mustUpdateDb)
     {
       LOG4CXX_INFO(logger, "refreshing user's package database from cache");
-      if (pimpl->packageManager == nullptr)
-      {
-        pimpl->packageManager = PackageManager::Create(PackageManager::InitInfo(this));
-      }
       if (pimpl->installer == nullptr)
       {
         pimpl->installer = pimpl->packageManager->CreateInstaller();
@@ -359,56 +707,54 @@ void Application::AutoMaintenance()
       pimpl->installer->SetCallback(this);
       pimpl->installer->UpdateDb({ UpdateDbOption::FromCache });
     }
-    vector<string> commonArgs{ initexmf.GetFileNameWithoutExtension().ToString() };
-    switch (pimpl->enableInstaller)
+    // maintenance runs in this process; steps whose inputs are
+    // unchanged are skipped
+    MiKTeX::Setup::MaintenanceOptions options;
+    if (mustRefreshFndb)
     {
-    case TriState::False:
-      commonArgs.push_back("--disable-installer");
-      break;
-    case TriState::True:
-      commonArgs.push_back("--enable-installer");
-      break;
-    case TriState::Undetermined:
-      break;
+      options.tasks += MiKTeX::Setup::MaintenanceTask::RefreshFndb;
+      options.tasks += MiKTeX::Setup::MaintenanceTask::MakeMaps;
     }
-    if (pimpl->session->IsAdminMode())
+    if (mustRefreshUserLanguageDat)
     {
-      commonArgs.push_back("--admin");
+      MIKTEX_ASSERT(!pimpl->session->IsAdminMode());
+      options.tasks += MiKTeX::Setup::MaintenanceTask::MakeLanguageDat;
     }
-    commonArgs.push_back("--quiet");
-    int exitCode;
-    if (mustRefreshFndb)
+    options.enableInstaller = pimpl->enableInstaller;
+    options.packageManager = pimpl->packageManager;
+    try
     {
-      vector<string> args = commonArgs;
-      args.push_back("--update-fndb");
-      LOG4CXX_INFO(logger, "running 'initexmf' to refresh the file name database");
-      pimpl->session->UnloadFilenameDatabase();
-      if (!Process::Run(initexmf, args, nullptr, &exitCode, nullptr))
+      MiKTeX::Setup::MaintenanceTaskSet done = MiKTeX::Setup::SetupService::RunMaintenance(options);
+      if (done[MiKTeX::Setup::MaintenanceTask::RefreshFndb])
       {
-        LOG4CXX_ERROR(logger, "initexmf exited with code " << exitCode);
+        LOG4CXX_INFO(logger, "refreshed the file name database");
       }
-    }
-    if (mustRefreshFndb)
-    {
-      vector<string> args = commonArgs;
-      args.push_back("--mkmaps");
-      LOG4CXX_INFO(logger, "running 'initexmf' to create font map files");
-      if (!Process::Run(initexmf, args, nullptr, &exitCode, nullptr))
+      if (done[MiKTeX::Setup::MaintenanceTask::MakeMaps])
       {
-        LOG4CXX_ERROR(logger, "initexmf exited with code " << exitCode);
+        LOG4CXX_INFO(logger, "created font map files");
       }
-    }
-    if (mustRefreshUserLanguageDat)
-    {
-      MIKTEX_ASSERT(!pimpl->session->IsAdminMode());
-      vector<string> args = commonArgs;
-      args.push_back("--mklangs");
-      LOG4CXX_INFO(logger, "running 'initexmf' to refresh language.dat");
-      if (!Process::Run(initexmf, args, nullptr, &exitCode, nullptr))
+      if (done[MiKTeX::Setup::MaintenanceTask::MakeLanguageDat])
       {
-        LOG4CXX_ERROR(logger, "initexmf exited with code " << exitCode);
+        LOG4CXX_INFO(logger, "refreshed language.dat");
       }
     }
+    catch (const MiKTeXException& ex)
+    {
+      LOG4CXX_ERROR(logger, "maintenance did not succeed: " << ex.GetErrorMessage());
+      succeeded = false;
+    }
+  }
+  if (succeeded)
+  {
+    try
+    {
+      Directory::Create(PathName(stampFile).RemoveFileSpec());
+      File::WriteBytes(stampFile, {});
+    }
+    catch (const MiKTeXException& ex)
+    {
+      LOG4CXX_WARN(logger, "could not write " << stampFile << ": " << ex.GetErrorMessage());
+    }
   }
 }
 
@@ -700,6 +1046,9 @@ bool Application::InstallPackage(const string& packageId, const PathName& trigge
   fileList.push_back(packageId);
   pimpl->installer->SetFileLists(fileList, vector<string>());
   LOG4CXX_INFO(logger, "installing package " << packageId << " triggered by " << trigger.ToString());
+  // the caller's output may still be buffered, whereas error messages go
+  // to stderr
+  fflush(stdout);
   if (!GetQuietFlag())
   {
     cout << "\n" << SEP << endl;
@@ -727,12 +1076,12 @@ bool Application::InstallPackage(const string& packageId, const PathName& trigge
     cerr
       << "\n"
       << "Unfortunately, the package " << packageId << " could not be installed." << endl;
-    log4cxx::RollingFileAppenderPtr appender = log4cxx::Logger::getRootLogger()->getAppender(LOG4CXX_STR("RollingLogFile"));
-    if (appender != nullptr)
+    PathName logFile;
+    if (GetLogFile(logFile))
     {
       cerr
         << "Please check the log file:" << "\n"
-        << PathName(appender->getFile()) << endl;
+        << logFile << endl;
     }
   }
   if (switchToAdminMode)
@@ -905,18 +1254,15 @@ void Application::Sorry(const string& name, const string& description, const str
         << endl;
     }
   }
-  if (isLog4cxxConfigured)
+  PathName logFile;
+  if (isLog4cxxConfigured && GetLogFile(logFile))
   {
-    log4cxx::RollingFileAppenderPtr appender = log4cxx::Logger::getRootLogger()->getAppender(LOG4CXX_STR("RollingLogFile"));
-    if (appender != nullptr)
-    {
-      cerr
-        << "\n"
-        << "The log file hopefully contains the information to get MiKTeX going again:" << "\n"
-        << "\n"
-        << "  " << PathName(appender->getFile())
-        << endl;
-    }
+    cerr
+      << "\n"
+      << "The log file hopefully contains the information to get MiKTeX going again:" << "\n"
+      << "\n"
+      << "  " << logFile
+      << endl;
   }
   if (!url.empty())
   {
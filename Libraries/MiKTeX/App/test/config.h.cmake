@@ -0,0 +1,23 @@
+/* config.h (created from config.h.cmake)               -*- C++ -*-
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of the MiKTeX App Library.
+
+   The MiKTeX App Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+   
+   The MiKTeX App Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX App Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#define DATAROOT "@dataroot@"
+#define INSTALLROOT "@installroot@"
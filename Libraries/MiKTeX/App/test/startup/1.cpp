@@ -0,0 +1,129 @@
+/* 1.cpp: measure Application::Init()/Finalize()
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of the MiKTeX App Library.
+
+   The MiKTeX App Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX App Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX App Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <miktex/App/Application>
+#include <miktex/Core/ConfigNames>
+#include <miktex/Core/Directory>
+#include <miktex/Core/Exceptions>
+#include <miktex/Core/File>
+#include <miktex/Core/Paths>
+#include <miktex/Core/Session>
+#include <miktex/PackageManager/PackageManager>
+
+using namespace std;
+using namespace std::chrono;
+
+using namespace MiKTeX::App;
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Packages;
+
+static Session::InitInfo MakeInitInfo(const char* argv0)
+{
+  Session::InitInfo initInfo(argv0);
+  StartupConfig startupConfig;
+  startupConfig.userConfigRoot = DATAROOT;
+  startupConfig.userDataRoot = DATAROOT;
+  startupConfig.userInstallRoot = INSTALLROOT;
+  initInfo.SetStartupConfig(startupConfig);
+  return initInfo;
+}
+
+// pretend that the sandbox has been set up and that the last
+// maintenance run succeeded
+static void Prepare(const char* argv0)
+{
+  shared_ptr<Session> session = Session::Create(MakeInitInfo(argv0));
+  session->SetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_LAST_USER_MAINTENANCE, ConfigValue(std::to_string(time(nullptr))));
+  PathName dataRoot = session->GetSpecialPath(SpecialPath::DataRoot);
+  PathName stampFile = dataRoot / PathName(MIKTEX_PATH_AUTO_MAINTENANCE_STAMP);
+  Directory::Create(PathName(stampFile).RemoveFileSpec());
+  File::WriteBytes(stampFile, {});
+  // a missing MPM file name database would trigger maintenance
+  PackageManager::Create()->CreateMpmFndb();
+  PathName cacheDir = dataRoot / PathName(MIKTEX_PATH_LOG4CXX_CACHE_DIR);
+  if (Directory::Exists(cacheDir))
+  {
+    Directory::Delete(cacheDir, true);
+  }
+}
+
+static duration<double, milli> InitAndFinalize(const char* argv0)
+{
+  Application app;
+  vector<const char*> args{ argv0, "--miktex-disable-diagnose", nullptr };
+  auto start = steady_clock::now();
+  app.Init(MakeInitInfo(argv0), args);
+  app.Finalize();
+  return steady_clock::now() - start;
+}
+
+int main(int argc, char* argv[])
+{
+  int n = argc > 1 ? atoi(argv[1]) : 100;
+  if (n < 1)
+  {
+    cerr << "usage: " << argv[0] << " [ITERATIONS]" << endl;
+    return 1;
+  }
+  try
+  {
+    Prepare(argv[0]);
+    // the first run parses log4cxx.xml and populates the cache
+    duration<double, milli> cold = InitAndFinalize(argv[0]);
+    duration<double, milli> total(0);
+    duration<double, milli> best = duration<double, milli>::max();
+    for (int i = 0; i < n; ++i)
+    {
+      duration<double, milli> d = InitAndFinalize(argv[0]);
+      total += d;
+      best = min(best, d);
+    }
+    cout << fixed << setprecision(3)
+      << "first:  " << cold.count() << " ms" << "\n"
+      << "mean:   " << total.count() / n << " ms (" << n << " iterations)" << "\n"
+      << "best:   " << best.count() << " ms" << endl;
+    return 0;
+  }
+  catch (const MiKTeXException& ex)
+  {
+    cerr << ex.GetErrorMessage() << endl;
+    return 1;
+  }
+  catch (const exception& ex)
+  {
+    cerr << ex.what() << endl;
+    return 1;
+  }
+  catch (int exitCode)
+  {
+    return exitCode;
+  }
+}
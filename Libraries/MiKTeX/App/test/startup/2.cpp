@@ -0,0 +1,216 @@
+/* 2.cpp: invalidation of the start-up caches
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of the MiKTeX App Library.
+
+   The MiKTeX App Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX App Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX App Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <algorithm>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <miktex/App/Application>
+#include <miktex/Core/ConfigNames>
+#include <miktex/Core/Directory>
+#include <miktex/Core/Exceptions>
+#include <miktex/Core/File>
+#include <miktex/Core/Fndb>
+#include <miktex/Core/Paths>
+#include <miktex/Core/Session>
+#include <miktex/Core/Utils>
+#include <miktex/PackageManager/PackageManager>
+
+using namespace std;
+
+using namespace MiKTeX::App;
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Packages;
+
+// written to the log when the auto-maintenance fast path is not taken
+const string MAINTENANCE_MESSAGE = "running MIKTEX_HOOK_AUTO_MAINTENANCE";
+
+static Session::InitInfo MakeInitInfo(const char* argv0)
+{
+  Session::InitInfo initInfo(argv0);
+  StartupConfig startupConfig;
+  startupConfig.userConfigRoot = DATAROOT;
+  startupConfig.userDataRoot = DATAROOT;
+  startupConfig.userInstallRoot = INSTALLROOT;
+  initInfo.SetStartupConfig(startupConfig);
+  return initInfo;
+}
+
+static void Check(bool condition, const string& what)
+{
+  if (!condition)
+  {
+    cerr << "FAILED: " << what << endl;
+    throw 1;
+  }
+}
+
+static string ReadText(const PathName& path)
+{
+  if (!File::Exists(path))
+  {
+    return "";
+  }
+  vector<unsigned char> bytes = File::ReadAllBytes(path);
+  return string(bytes.begin(), bytes.end());
+}
+
+static void WriteText(const PathName& path, const string& text)
+{
+  Directory::Create(PathName(path).RemoveFileSpec());
+  File::WriteBytes(path, vector<unsigned char>(text.begin(), text.end()));
+}
+
+// runs Init()/Finalize() and returns what has been appended to the log
+// file
+static string InitAndFinalize(const char* argv0, const PathName& logFile)
+{
+  string before = ReadText(logFile);
+  {
+    Application app;
+    vector<const char*> args{ argv0, "--miktex-disable-diagnose", nullptr };
+    app.Init(MakeInitInfo(argv0), args);
+    app.Finalize();
+  }
+  return ReadText(logFile).substr(before.length());
+}
+
+static void TouchStamp(const PathName& stampFile)
+{
+  WriteText(stampFile, "");
+}
+
+// records a configuration change which happened after the stamp was
+// written (as Core does when it modifies the configuration)
+static void RecordChange(const char* argv0, const PathName& stampFile)
+{
+  time_t past = time(nullptr) - 60;
+  if (File::Exists(stampFile))
+  {
+    File::SetTimes(stampFile, past, past, past);
+  }
+  shared_ptr<Session> session = Session::Create(MakeInitInfo(argv0));
+  // the value must change even if the last one was recorded in the
+  // same second
+  time_t lastChange = session->GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_LAST_USER_MAINTENANCE, ConfigValue("0")).GetTimeT();
+  session->SetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_LAST_USER_MAINTENANCE, ConfigValue(std::to_string(max(time(nullptr), lastChange + 1))));
+}
+
+int main(int argc, char* argv[])
+{
+  try
+  {
+    shared_ptr<Session> session = Session::Create(MakeInitInfo(argv[0]));
+    session->SetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_LAST_USER_MAINTENANCE, ConfigValue(std::to_string(time(nullptr))));
+    PathName dataRoot = session->GetSpecialPath(SpecialPath::DataRoot);
+    PathName configRoot = session->GetSpecialPath(SpecialPath::UserConfigRoot);
+    PathName stampFile = dataRoot / PathName(MIKTEX_PATH_AUTO_MAINTENANCE_STAMP);
+    PathName mpmDatabase = session->GetMpmDatabasePathName();
+    PathName cacheDir = dataRoot / PathName(MIKTEX_PATH_LOG4CXX_CACHE_DIR);
+    PathName logFile = dataRoot / PathName("miktex/log/apptest.log");
+    PathName configDir = PathName(INSTALLROOT) / PathName(MIKTEX_PATH_MIKTEX_PLATFORM_CONFIG_DIR);
+    PathName genericXml = configDir / PathName(MIKTEX_LOG4CXX_CONFIG_FILENAME);
+    PathName specificXml = configDir / PathName(Utils::GetExeName() + "." + MIKTEX_LOG4CXX_CONFIG_FILENAME);
+    PathName specificLogFile = dataRoot / PathName("miktex/log/apptest-specific.log");
+    if (Directory::Exists(cacheDir))
+    {
+      Directory::Delete(cacheDir, true);
+    }
+    if (File::Exists(specificXml))
+    {
+      File::Delete(specificXml);
+      Fndb::Remove({ specificXml });
+    }
+    PackageManager::Create()->CreateMpmFndb();
+    session = nullptr;
+
+    // nothing has changed since the stamp was written
+    TouchStamp(stampFile);
+    Check(InitAndFinalize(argv[0], logFile).find(MAINTENANCE_MESSAGE) == string::npos, "fast path taken while nothing has changed");
+
+    // the MPM file name database has been deleted and the change has
+    // been recorded
+    File::Delete(mpmDatabase);
+    TouchStamp(stampFile);
+    RecordChange(argv[0], stampFile);
+    Check(InitAndFinalize(argv[0], logFile).find(MAINTENANCE_MESSAGE) != string::npos, "maintenance runs when the MPM file name database is missing");
+    if (!File::Exists(mpmDatabase))
+    {
+      session = Session::Create(MakeInitInfo(argv[0]));
+      PackageManager::Create()->CreateMpmFndb();
+      session = nullptr;
+    }
+
+    // languages.ini has been written
+    PathName languageDat = configRoot / PathName(MIKTEX_PATH_LANGUAGE_DAT);
+    PathName languagesIni = configRoot / PathName(MIKTEX_PATH_LANGUAGES_INI);
+    WriteText(languageDat, "");
+    time_t past = time(nullptr) - 3600;
+    File::SetTimes(languageDat, past, past, past);
+    WriteText(languagesIni, "");
+    TouchStamp(stampFile);
+    RecordChange(argv[0], stampFile);
+    Check(InitAndFinalize(argv[0], logFile).find(MAINTENANCE_MESSAGE) != string::npos, "maintenance runs when languages.ini is newer than language.dat");
+    File::Delete(languageDat);
+    File::Delete(languagesIni);
+
+    // a configuration file which takes precedence over the cached one
+    // has been installed
+    TouchStamp(stampFile);
+    InitAndFinalize(argv[0], logFile);
+    string xml = ReadText(genericXml);
+    const string logName = "apptest.log";
+    xml.replace(xml.find(logName), logName.length(), "apptest-specific.log");
+    WriteText(specificXml, xml);
+    session = Session::Create(MakeInitInfo(argv[0]));
+    Fndb::Add({ { specificXml } });
+    session = nullptr;
+    RecordChange(argv[0], stampFile);
+    File::Delete(stampFile);
+    InitAndFinalize(argv[0], logFile);
+    Check(ReadText(specificLogFile).find(MAINTENANCE_MESSAGE) != string::npos, "the cached logging configuration is replaced by one which takes precedence");
+    session = Session::Create(MakeInitInfo(argv[0]));
+    File::Delete(specificXml);
+    Fndb::Remove({ specificXml });
+    session = nullptr;
+
+    cout << "OK" << endl;
+    return 0;
+  }
+  catch (const MiKTeXException& ex)
+  {
+    cerr << ex.GetErrorMessage() << endl;
+    return 1;
+  }
+  catch (const exception& ex)
+  {
+    cerr << ex.what() << endl;
+    return 1;
+  }
+  catch (int exitCode)
+  {
+    return exitCode;
+  }
+}
@@ -46,16 +46,19 @@ void Directory::Delete(const PathName& path, bool recursive)
     directoriesToBeDeleted.reserve(10);
 
     unique_ptr<DirectoryLister> dirLister = DirectoryLister::Open(path);
-    DirectoryEntry entry;
-    while (dirLister->GetNext(entry))
+    vector<DirectoryEntry> entries;
+    while (dirLister->GetNextBlock(entries))
     {
-      if (entry.isDirectory)
+      for (const DirectoryEntry& entry : entries)
       {
-        directoriesToBeDeleted.push_back(PathName(path, PathName(entry.name)));
-      }
-      else
-      {
-        filesToBeDeleted.push_back(PathName(path, PathName(entry.name)));
+        if (entry.isDirectory)
+        {
+          directoriesToBeDeleted.push_back(PathName(path, PathName(entry.name)));
+        }
+        else
+        {
+          filesToBeDeleted.push_back(PathName(path, PathName(entry.name)));
+        }
       }
     }
     dirLister->Close();
@@ -22,7 +22,14 @@
 #include "config.h"
 
 #include <dirent.h>
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__)
+#  include <sys/syscall.h>
+#endif
+
+#include <cstdint>
 
 #include <miktex/Core/DirectoryLister>
 
@@ -34,6 +41,24 @@ using namespace std;
 
 using namespace MiKTeX::Core;
 
+#if defined(__linux__)
+// getdents64() returns as many entries as fit into the buffer
+constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+// the layout of the records returned by getdents64()
+struct linux_dirent64
+{
+  uint64_t d_ino;
+  int64_t d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[256];
+};
+#else
+// the number of readdir() calls which make up a block
+constexpr size_t BLOCK_SIZE = 256;
+#endif
+
 unique_ptr<DirectoryLister> DirectoryLister::Open(const PathName& directory)
 {
   return make_unique<unxDirectoryLister>(directory, nullptr, (int)Options::None);
@@ -69,33 +94,112 @@ unxDirectoryLister::~unxDirectoryLister() noexcept
 
 void unxDirectoryLister::Close()
 {
+#if defined(__linux__)
+  int fd = this->fd;
+  if (fd < 0)
+  {
+    return;
+  }
+  this->fd = -1;
+  buffer.clear();
+  buffer.shrink_to_fit();
+  bufferPos = 0;
+  bufferEnd = 0;
+  if (close(fd) != 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR_2("close", "dir", directory.ToString());
+  }
+#else
   DIR* dir = this->dir;
   if (dir == nullptr)
   {
     return;
   }
   this->dir = nullptr;
+  fd = -1;
   if (closedir(dir) != 0)
   {
     MIKTEX_FATAL_CRT_ERROR_2("closedir", "dir", directory.ToString());
   }
+#endif
 }
 
-bool unxDirectoryLister::GetNext(DirectoryEntry& direntry)
+void unxDirectoryLister::Open()
+{
+  fd = open(directory.GetData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR_2("open", "dir", directory.ToString());
+  }
+#if defined(__linux__)
+  buffer.resize(BUFFER_SIZE);
+#else
+  dir = fdopendir(fd);
+  if (dir == nullptr)
+  {
+    int error = errno;
+    close(fd);
+    fd = -1;
+    errno = error;
+    MIKTEX_FATAL_CRT_ERROR_2("fdopendir", "dir", directory.ToString());
+  }
+#endif
+}
+
+bool unxDirectoryLister::ReadEntry(const char*& name, EntryType& type)
 {
-  DirectoryEntry2 direntry2;
-  if (!GetNext(direntry2, true))
+  if (fd < 0)
+  {
+    Open();
+  }
+#if defined(__linux__)
+  if (bufferPos == bufferEnd)
+  {
+    long n = syscall(SYS_getdents64, fd, buffer.data(), buffer.size());
+    if (n < 0)
+    {
+      MIKTEX_FATAL_CRT_ERROR_2("getdents64", "dir", directory.ToString());
+    }
+    if (n == 0)
+    {
+      return false;
+    }
+    bufferPos = 0;
+    bufferEnd = n;
+  }
+  const linux_dirent64* dent = reinterpret_cast<const linux_dirent64*>(&buffer[bufferPos]);
+  bufferPos += dent->d_reclen;
+  name = dent->d_name;
+  type = dent->d_type == DT_DIR ? EntryType::Directory : dent->d_type == DT_UNKNOWN ? EntryType::Unknown : EntryType::Other;
+#else
+  int olderrno = errno;
+  struct dirent* dent = readdir(dir);
+  if (dent == nullptr)
   {
+    if (errno != olderrno)
+    {
+      MIKTEX_FATAL_CRT_ERROR_2("readdir", "dir", directory.ToString());
+    }
     return false;
   }
-  direntry.name = direntry2.name;
-  direntry.isDirectory = direntry2.isDirectory;
+  blockCount += 1;
+  name = dent->d_name;
+#if defined(HAVE_STRUCT_DIRENT_D_TYPE)
+  type = dent->d_type == DT_DIR ? EntryType::Directory : dent->d_type == DT_UNKNOWN ? EntryType::Unknown : EntryType::Other;
+#else
+  type = EntryType::Unknown;
+#endif
+#endif
   return true;
 }
 
-bool unxDirectoryLister::GetNext(DirectoryEntry2& direntry2)
+bool unxDirectoryLister::IsEndOfBlock() const
 {
-  return GetNext(direntry2, false);
+#if defined(__linux__)
+  return bufferPos == bufferEnd;
+#else
+  return blockCount >= BLOCK_SIZE;
+#endif
 }
 
 inline bool IsDotDirectory(const char* entry)
@@ -111,61 +215,135 @@ inline bool IsDotDirectory(const char* entry)
   return entry[1] == '.' && entry[2] == 0;
 }
 
-bool unxDirectoryLister::GetNext(DirectoryEntry2& direntry2, bool simple)
+bool unxDirectoryLister::NextMatch(const char*& name, EntryType& type)
 {
-  if (dir == nullptr)
+  while (ReadEntry(name, type))
   {
-    dir = opendir(directory.GetData());
-    if (dir == nullptr)
+    if (IsDotDirectory(name) || (!pattern.empty() && !PathName::Match(pattern.c_str(), name)))
     {
-      MIKTEX_FATAL_CRT_ERROR_2("opendir", "dir", directory.ToString());
+      continue;
     }
+    if (options == (int)Options::None)
+    {
+      return true;
+    }
+    if (type == EntryType::Unknown)
+    {
+      struct stat statbuf;
+      Stat(name, statbuf);
+      type = S_ISDIR(statbuf.st_mode) ? EntryType::Directory : EntryType::Other;
+    }
+    if (((options & (int)Options::DirectoriesOnly) != 0 && type != EntryType::Directory)
+      || ((options & (int)Options::FilesOnly) != 0 && type == EntryType::Directory))
+    {
+      continue;
+    }
+    return true;
+  }
+  return false;
+}
+
+// stats relative to the open directory, so that the path need not be
+// resolved again
+void unxDirectoryLister::Stat(const char* name, struct stat& statbuf)
+{
+  if (fstatat(fd, name, &statbuf, AT_SYMLINK_NOFOLLOW) != 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR_2("fstatat", "path", (directory / PathName(name)).ToString());
+  }
+}
+
+bool unxDirectoryLister::GetNext(DirectoryEntry& direntry)
+{
+  const char* name;
+  EntryType type;
+  if (!NextMatch(name, type))
+  {
+    return false;
+  }
+  direntry.name = name;
+  if (type == EntryType::Unknown)
+  {
+    struct stat statbuf;
+    Stat(name, statbuf);
+    type = S_ISDIR(statbuf.st_mode) ? EntryType::Directory : EntryType::Other;
   }
-  struct dirent* dent;
-  bool isDirectory;
-  do
+  direntry.isDirectory = type == EntryType::Directory;
+  return true;
+}
+
+bool unxDirectoryLister::GetNext(DirectoryEntry2& direntry2)
+{
+  const char* name;
+  EntryType type;
+  if (!NextMatch(name, type))
   {
-    int olderrno = errno;
-    dent = readdir(dir);
-    if (dent == nullptr)
+    return false;
+  }
+  struct stat statbuf;
+  Stat(name, statbuf);
+  direntry2.name = name;
+  direntry2.isDirectory = S_ISDIR(statbuf.st_mode) != 0;
+  direntry2.size = statbuf.st_size;
+  return true;
+}
+
+bool unxDirectoryLister::GetNextBlock(vector<DirectoryEntry>& entries)
+{
+  entries.clear();
+#if !defined(__linux__)
+  blockCount = 0;
+#endif
+  const char* name;
+  EntryType type;
+  vector<size_t> unknown;
+  while (NextMatch(name, type))
+  {
+    if (type == EntryType::Unknown)
     {
-      if (errno != olderrno)
-      {
-        MIKTEX_FATAL_CRT_ERROR_2("readdir", "dir", directory.ToString());
-      }
-      return false;
+      unknown.push_back(entries.size());
     }
-#if defined(HAVE_STRUCT_DIRENT_D_TYPE)
-    isDirectory = dent->d_type == DT_DIR;
-#else
-    if (options != (int)Options::None)
+    entries.emplace_back();
+    entries.back().name = name;
+    entries.back().isDirectory = type == EntryType::Directory;
+    if (IsEndOfBlock())
     {
-      UNIMPLEMENTED();
+      break;
     }
-#endif
-  } while (IsDotDirectory(dent->d_name)
-           || (!pattern.empty() && !PathName::Match(pattern.c_str(), dent->d_name))
-           || ((options & (int)Options::DirectoriesOnly) != 0 && !isDirectory)
-           || ((options & (int)Options::FilesOnly) != 0 && isDirectory));
-  direntry2.name = dent->d_name;
-  bool mustStat = true;
-#if defined(HAVE_STRUCT_DIRENT_D_TYPE)
-  if (dent->d_type != DT_UNKNOWN)
+  }
+  for (size_t idx : unknown)
   {
-    direntry2.isDirectory = (dent->d_type == DT_DIR);
-    mustStat = false;
+    struct stat statbuf;
+    Stat(entries[idx].name.c_str(), statbuf);
+    entries[idx].isDirectory = S_ISDIR(statbuf.st_mode) != 0;
   }
+  return !entries.empty();
+}
+
+bool unxDirectoryLister::GetNextBlock(vector<DirectoryEntry2>& entries)
+{
+  entries.clear();
+#if !defined(__linux__)
+  blockCount = 0;
 #endif
-  if (mustStat || !simple)
+  const char* name;
+  EntryType type;
+  while (NextMatch(name, type))
   {
-    struct stat statbuf;
-    PathName path = directory / PathName(dent->d_name);
-    if (lstat(path.GetData(), &statbuf) != 0)
+    entries.emplace_back();
+    entries.back().name = name;
+    if (IsEndOfBlock())
     {
-      MIKTEX_FATAL_CRT_ERROR_2("lstat", "path", path.ToString());
+      break;
     }
-    direntry2.isDirectory = S_ISDIR(statbuf.st_mode) != 0;
-    direntry2.size = statbuf.st_size;
   }
-  return true;
+  // the names have been read: now stat them in one go
+  for (DirectoryEntry2& entry : entries)
+  {
+    struct stat statbuf;
+    Stat(entry.name.c_str(), statbuf);
+    entry.isDirectory = S_ISDIR(statbuf.st_mode) != 0;
+    entry.size = statbuf.st_size;
+  }
+  return !entries.empty();
 }
@@ -1,6 +1,6 @@
 /* unxDirectoryLister.h:                                -*- C++ -*-
 
-   Copyright (C) 1996-2018 Christian Schenk
+   Copyright (C) 1996-2020 Christian Schenk
 
    This file is part of the MiKTeX Core Library.
 
@@ -24,6 +24,11 @@
 #if !defined(F2A2B73E1341485FAFAB1FC525782032)
 #define F2A2B73E1341485FAFAB1FC525782032
 
+#include <sys/stat.h>
+
+#include <cstddef>
+#include <vector>
+
 #include <miktex/Core/DirectoryLister>
 #include <miktex/Core/PathName>
 
@@ -47,11 +52,54 @@ public:
 public:
   bool GetNext(MiKTeX::Core::DirectoryEntry2& direntry2) override;
 
+public:
+  bool GetNextBlock(std::vector<MiKTeX::Core::DirectoryEntry>& entries) override;
+
+public:
+  bool GetNextBlock(std::vector<MiKTeX::Core::DirectoryEntry2>& entries) override;
+
+private:
+  enum class EntryType
+  {
+    Unknown,
+    Directory,
+    Other
+  };
+
+private:
+  void Open();
+
+private:
+  bool ReadEntry(const char*& name, EntryType& type);
+
+private:
+  bool IsEndOfBlock() const;
+
+private:
+  bool NextMatch(const char*& name, EntryType& type);
+
+private:
+  void Stat(const char* name, struct stat& statbuf);
+
+private:
+  int fd = -1;
+
+#if defined(__linux__)
 private:
-  bool GetNext(MiKTeX::Core::DirectoryEntry2& direntry2, bool simple);
+  std::vector<char> buffer;
 
 private:
-  DIR * dir = nullptr;
+  std::size_t bufferPos = 0;
+
+private:
+  std::size_t bufferEnd = 0;
+#else
+private:
+  DIR* dir = nullptr;
+
+private:
+  std::size_t blockCount = 0;
+#endif
 
 private:
   MiKTeX::Core::PathName directory;
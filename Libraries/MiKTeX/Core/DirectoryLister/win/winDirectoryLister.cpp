@@ -32,6 +32,10 @@ using namespace std;
 
 using namespace MiKTeX::Core;
 
+// FindFirstFileExW() fetches entries in large chunks already: a block
+// just saves the per-entry call overhead
+constexpr size_t BLOCK_SIZE = 256;
+
 unique_ptr<DirectoryLister> DirectoryLister::Open(const PathName& directory)
 {
   return make_unique<winDirectoryLister>(directory, nullptr, (int)Options::None);
@@ -162,3 +166,25 @@ bool winDirectoryLister::GetNext(DirectoryEntry2& direntry2)
   }
   return true;
 }
+
+bool winDirectoryLister::GetNextBlock(vector<DirectoryEntry>& entries)
+{
+  entries.clear();
+  DirectoryEntry entry;
+  while (entries.size() < BLOCK_SIZE && GetNext(entry))
+  {
+    entries.push_back(entry);
+  }
+  return !entries.empty();
+}
+
+bool winDirectoryLister::GetNextBlock(vector<DirectoryEntry2>& entries)
+{
+  entries.clear();
+  DirectoryEntry2 entry;
+  while (entries.size() < BLOCK_SIZE && GetNext(entry))
+  {
+    entries.push_back(entry);
+  }
+  return !entries.empty();
+}
@@ -1,6 +1,6 @@
 /* winDirectoryLister.h: directory lister               -*- C++ -*-
 
-   Copyright (C) 1996-2018 Christian Schenk
+   Copyright (C) 1996-2020 Christian Schenk
 
    This file is part of the MiKTeX Core Library.
 
@@ -24,6 +24,8 @@
 #if !defined(F05A2700545C4487889CF7A396F930A1)
 #define F05A2700545C4487889CF7A396F930A1
 
+#include <vector>
+
 #include <miktex/Core/DirectoryLister>
 #include <miktex/Core/PathName>
 
@@ -41,6 +43,12 @@ public:
 public:
   bool MIKTEXTHISCALL GetNext(MiKTeX::Core::DirectoryEntry2& direntry2) override;
 
+public:
+  bool MIKTEXTHISCALL GetNextBlock(std::vector<MiKTeX::Core::DirectoryEntry>& entries) override;
+
+public:
+  bool MIKTEXTHISCALL GetNextBlock(std::vector<MiKTeX::Core::DirectoryEntry2>& entries) override;
+
 public:
   winDirectoryLister(const MiKTeX::Core::PathName& directory, const char* lpszPattern, int options);
 
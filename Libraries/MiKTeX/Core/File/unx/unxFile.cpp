@@ -252,6 +252,23 @@ void File::GetTimes(const PathName& path, time_t& creationTime, time_t& lastAcce
   lastWriteTime = stat_.st_mtime;
 }
 
+bool File::TryGetTimes(const PathName& path, time_t& creationTime, time_t& lastAccessTime, time_t& lastWriteTime)
+{
+  struct stat stat_;
+  if (stat(path.GetData(), &stat_) != 0)
+  {
+    if (errno == ENOENT || errno == ENOTDIR)
+    {
+      return false;
+    }
+    MIKTEX_FATAL_CRT_ERROR_2("stat", "path", path.ToString());
+  }
+  creationTime = stat_.st_ctime;
+  lastAccessTime = stat_.st_atime;
+  lastWriteTime = stat_.st_mtime;
+  return true;
+}
+
 void File::Delete(const PathName& path)
 {
   shared_ptr<SessionImpl> session = SessionImpl::TryGetSession();
@@ -313,6 +313,29 @@ void File::GetTimes(const PathName& path, time_t& creationTime, time_t& lastAcce
   lastWriteTime = FileTimeToUniversalCrtTime(findData.ftLastWriteTime);
 }
 
+bool File::TryGetTimes(const PathName& path, time_t& creationTime, time_t& lastAccessTime, time_t& lastWriteTime)
+{
+  WIN32_FIND_DATAW findData;
+  HANDLE findHandle = FindFirstFileW(path.ToExtendedLengthPathName().ToWideCharString().c_str(), &findData);
+  if (findHandle == INVALID_HANDLE_VALUE)
+  {
+    DWORD error = GetLastError();
+    if (error == ERROR_FILE_NOT_FOUND || error == ERROR_PATH_NOT_FOUND)
+    {
+      return false;
+    }
+    MIKTEX_FATAL_WINDOWS_ERROR_2("FindFirstFileW", "path", path.ToString());
+  }
+  if (!FindClose(findHandle))
+  {
+    MIKTEX_FATAL_WINDOWS_ERROR_2("FindClose", "path", path.ToString());
+  }
+  creationTime = FileTimeToUniversalCrtTime(findData.ftCreationTime);
+  lastAccessTime = FileTimeToUniversalCrtTime(findData.ftLastAccessTime);
+  lastWriteTime = FileTimeToUniversalCrtTime(findData.ftLastWriteTime);
+  return true;
+}
+
 void File::Delete(const PathName& path)
 {
   shared_ptr<SessionImpl> session = SessionImpl::TryGetSession();
@@ -287,6 +287,43 @@ bool FileNameDatabase::FileExists(const PathName& path)
   return false;
 }
 
+void FileNameDatabase::Enumerate(const PathName& directory, vector<Fndb::Record>& result)
+{
+  ApplyChangeFile();
+  PathName relativeDirectory = directory;
+  if (relativeDirectory.IsAbsolute())
+  {
+    const char* lpsz = Utils::GetRelativizedPath(directory.GetData(), rootDirectory.GetData());
+    if (lpsz == nullptr)
+    {
+      MIKTEX_FATAL_ERROR_2(T_("Directory is not covered by file name database."), "directory", directory.ToString());
+    }
+    relativeDirectory = lpsz;
+  }
+  string prefix = relativeDirectory.ToUnix().ToString();
+  while (!prefix.empty() && prefix.back() == '/')
+  {
+    prefix.pop_back();
+  }
+  if (prefix == ".")
+  {
+    prefix = "";
+  }
+  trace_fndb->WriteLine("core", fmt::format(T_("fndb enumerate: rootDirectory={0}, directory={1}"), Q_(rootDirectory), Q_(prefix)));
+  for (const auto& p : fileNames)
+  {
+    string recordDirectory = p.second.GetDirectory();
+    // the directory itself or one of its sub-directories
+    if (prefix.empty()
+      || (recordDirectory.length() >= prefix.length()
+        && PathName::Compare(recordDirectory.c_str(), prefix.c_str(), prefix.length()) == 0
+        && (recordDirectory.length() == prefix.length() || recordDirectory[prefix.length()] == '/')))
+    {
+      result.push_back({ rootDirectory / PathName(recordDirectory) / PathName(p.second.fileName), p.second.GetInfo() });
+    }
+  }
+}
+
 tuple<string, string> FileNameDatabase::SplitPath(const PathName& path_) const
 {
   PathName path = path_;
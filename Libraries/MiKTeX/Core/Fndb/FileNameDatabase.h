@@ -63,6 +63,9 @@ public:
 public:
   bool FileExists(const MiKTeX::Core::PathName& path);
 
+public:
+  void Enumerate(const MiKTeX::Core::PathName& directory, std::vector<MiKTeX::Core::Fndb::Record>& result);
+
 public:
   std::chrono::time_point<std::chrono::high_resolution_clock> GetLastAccessTime() const
   {
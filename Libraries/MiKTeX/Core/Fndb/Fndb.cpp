@@ -92,6 +92,19 @@ void Fndb::Remove(const vector<PathName>& paths)
   fndb->Remove(paths);
 }
 
+bool Fndb::Enumerate(const PathName& directory, vector<Fndb::Record>& result)
+{
+  shared_ptr<SessionImpl> session = SessionImpl::GetSession();
+  unsigned root = session->DeriveTEXMFRoot(directory);
+  shared_ptr<FileNameDatabase> fndb = session->GetFileNameDatabase(root);
+  if (fndb == nullptr)
+  {
+    return false;
+  }
+  fndb->Enumerate(directory, result);
+  return true;
+}
+
 bool Fndb::FileExists(const PathName& path)
 {
   shared_ptr<SessionImpl> session = SessionImpl::GetSession();
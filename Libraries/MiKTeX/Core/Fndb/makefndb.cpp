@@ -275,30 +275,34 @@ void FndbManager::ReadDirectory(const PathName& dirPath, vector<string>& subDire
   vector<string> filesToBeIgnored;
   GetIgnorableFiles(dirPath, filesToBeIgnored);
   unique_ptr<DirectoryLister> lister = DirectoryLister::Open(dirPath);
-  DirectoryEntry entry;
+  vector<DirectoryEntry> entries;
   vector<DirectoryEntry> toBeDeleted;
   PathName directory(Utils::GetRelativizedPath(dirPath.GetData(), rootPath.GetData()));
   directory = directory.ToUnix();
-  while (lister->GetNext(entry))
+  const string* pooledDirectory = &*stringPool.insert(directory.ToString()).first;
+  while (lister->GetNextBlock(entries))
   {
-    if (binary_search(filesToBeIgnored.begin(), filesToBeIgnored.end(), entry.name, StringComparerIgnoringCase()))
+    for (DirectoryEntry& entry : entries)
     {
-      continue;
-    }
-    if (doCleanUp && PathName(entry.name).HasExtension(MIKTEX_TO_BE_DELETED_FILE_SUFFIX))
-    {
-      toBeDeleted.push_back(entry);
-    }
-    else if (entry.isDirectory)
-    {
-      subDirectoryNames.push_back(entry.name);
-    }
-    else
-    {
-      FILENAMEINFO filenameinfo;
-      filenameinfo.FileName = entry.name;
-      filenameinfo.Directory = &*stringPool.insert(directory.ToString()).first;
-      fileNames.push_back(filenameinfo);
+      if (binary_search(filesToBeIgnored.begin(), filesToBeIgnored.end(), entry.name, StringComparerIgnoringCase()))
+      {
+        continue;
+      }
+      if (doCleanUp && PathName(entry.name).HasExtension(MIKTEX_TO_BE_DELETED_FILE_SUFFIX))
+      {
+        toBeDeleted.push_back(entry);
+      }
+      else if (entry.isDirectory)
+      {
+        subDirectoryNames.push_back(move(entry.name));
+      }
+      else
+      {
+        FILENAMEINFO filenameinfo;
+        filenameinfo.FileName = move(entry.name);
+        filenameinfo.Directory = pooledDirectory;
+        fileNames.push_back(filenameinfo);
+      }
     }
   }
   lister->Close();
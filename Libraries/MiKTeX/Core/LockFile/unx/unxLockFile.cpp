@@ -0,0 +1,387 @@
+/* unxLockFile.cpp: lock files
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/file.h>
+#if defined(__linux__)
+#include <sys/inotify.h>
+#endif
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/LockFile>
+#include <miktex/Core/Process>
+
+#include <miktex/Trace/Trace>
+#include <miktex/Trace/TraceStream>
+
+#include "internal.h"
+#include "Session/SessionImpl.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Trace;
+
+// The lock is a flock() lock on the lock file.  It belongs to the open
+// file description, so it is released by the kernel when the owner
+// dies.  Waiters without a timeout sleep in flock().  On Linux,
+// waiters with a timeout sleep in poll() on an inotify watch of the
+// file: the owner closes the file when it releases the lock, and the
+// kernel closes it when the owner dies.  Elsewhere, they poll.  The
+// owner of the last lock removes the file while still holding the
+// lock; a waiter which has opened the file before its removal notices
+// this when it gets the lock, and starts over.
+class unxLockFile :
+  public LockFile
+{
+public:
+  unxLockFile() = delete;
+
+public:
+  unxLockFile(const unxLockFile& other) = delete;
+
+public:
+  unxLockFile(unxLockFile&& other) = delete;
+
+public:
+  unxLockFile& operator=(const unxLockFile& other) = delete;
+
+public:
+  unxLockFile& operator=(unxLockFile&& other) = delete;
+
+public:
+  ~unxLockFile() override
+  {
+    try
+    {
+      if (fd >= 0)
+      {
+        Unlock();
+      }
+    }
+    catch (const exception&)
+    {
+    }
+  }
+
+public:
+  unxLockFile(const PathName& path) :
+    path(path)
+  {
+    shared_ptr<SessionImpl> session = SessionImpl::TryGetSession();
+    TraceCallback* callback = session == nullptr ? nullptr : session->GetInitInfo().GetTraceCallback();
+    trace_lockfile = TraceStream::Open(MIKTEX_TRACE_LOCKFILE, callback);
+  }
+
+public:
+  bool MIKTEXTHISCALL TryLock(chrono::milliseconds timeout) override
+  {
+    return TryLock(File::LockType::Exclusive, timeout);
+  }
+
+public:
+  bool MIKTEXTHISCALL TryLock(File::LockType lockType, chrono::milliseconds timeout) override;
+
+public:
+  void MIKTEXTHISCALL Unlock() override;
+
+private:
+  bool Acquire(int newFd, int operation, chrono::milliseconds timeout);
+
+private:
+  bool TryAcquire(int newFd, int operation);
+
+#if defined(__linux__)
+private:
+  bool AwaitRelease(int newFd, int notifyFd, int operation, chrono::steady_clock::time_point tryUntil);
+#endif
+
+private:
+  bool PollLock(int newFd, int operation, chrono::steady_clock::time_point tryUntil);
+
+private:
+  bool IsCurrent(int newFd);
+
+private:
+  void WriteOwner();
+
+private:
+  PathName path;
+
+private:
+  int fd = -1;
+
+private:
+  File::LockType lockType = File::LockType::Exclusive;
+
+private:
+  unique_ptr<TraceStream> trace_lockfile;
+};
+
+unique_ptr<LockFile> LockFile::Create(const PathName& path)
+{
+  return make_unique<unxLockFile>(path);
+}
+
+bool unxLockFile::TryLock(File::LockType lockType, chrono::milliseconds timeout)
+{
+  const char* lockTypeName = lockType == File::LockType::Exclusive ? "exclusive" : "shared";
+  trace_lockfile->WriteLine("core", fmt::format(T_("trying to acquire {0} lock {1}"), lockTypeName, Q_(path)));
+  if (fd >= 0)
+  {
+    MIKTEX_UNEXPECTED();
+  }
+  bool forever = timeout == chrono::milliseconds::max();
+  chrono::steady_clock::time_point tryUntil = forever ? chrono::steady_clock::time_point::max() : chrono::steady_clock::now() + timeout;
+  int operation = lockType == File::LockType::Exclusive ? LOCK_EX : LOCK_SH;
+  while (true)
+  {
+    int newFd = open(path.GetData(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+    if (newFd < 0 && errno == EACCES && lockType == File::LockType::Shared)
+    {
+      newFd = open(path.GetData(), O_RDONLY | O_CLOEXEC);
+    }
+    if (newFd < 0)
+    {
+      if (errno == EACCES)
+      {
+        trace_lockfile->WriteLine("core", fmt::format(T_("permission denied: {0}"), Q_(path)));
+        return false;
+      }
+      MIKTEX_FATAL_CRT_ERROR_2("open", "path", path.ToString());
+    }
+    chrono::milliseconds remaining = forever ? timeout : max(chrono::duration_cast<chrono::milliseconds>(tryUntil - chrono::steady_clock::now()), chrono::milliseconds(0));
+    if (!Acquire(newFd, operation, remaining))
+    {
+      trace_lockfile->WriteLine("core", fmt::format(T_("lock {0} is held by another process"), Q_(path)));
+      return false;
+    }
+    if (IsCurrent(newFd))
+    {
+      fd = newFd;
+      break;
+    }
+    close(newFd);
+    trace_lockfile->WriteLine("core", fmt::format(T_("lock file {0} has been removed by the previous owner"), Q_(path)));
+  }
+  this->lockType = lockType;
+  if (lockType == File::LockType::Exclusive)
+  {
+    WriteOwner();
+  }
+  trace_lockfile->WriteLine("core", fmt::format(T_("acquired {0} lock {1}"), lockTypeName, Q_(path)));
+  return true;
+}
+
+void unxLockFile::Unlock()
+{
+  trace_lockfile->WriteLine("core", fmt::format(T_("releasing lock {0}"), Q_(path)));
+  if (fd < 0)
+  {
+    MIKTEX_UNEXPECTED();
+  }
+  // a shared owner is the last one, if it can get the exclusive lock
+  bool isLastOwner = lockType == File::LockType::Exclusive || flock(fd, LOCK_EX | LOCK_NB) == 0;
+  if (isLastOwner)
+  {
+    trace_lockfile->WriteLine("core", fmt::format(T_("removing lock file {0}"), Q_(path)));
+    if (unlink(path.GetData()) != 0 && errno != ENOENT)
+    {
+      trace_lockfile->WriteLine("core", TraceLevel::Warning, fmt::format(T_("could not remove lock file {0}"), Q_(path)));
+    }
+  }
+  // closing the file releases the lock
+  close(fd);
+  fd = -1;
+}
+
+// Takes ownership of newFd: it is closed on failure.
+bool unxLockFile::Acquire(int newFd, int operation, chrono::milliseconds timeout)
+{
+  if (TryAcquire(newFd, operation))
+  {
+    return true;
+  }
+  if (timeout == chrono::milliseconds(0))
+  {
+    close(newFd);
+    return false;
+  }
+  if (timeout == chrono::milliseconds::max())
+  {
+    while (flock(newFd, operation) != 0)
+    {
+      if (errno != EINTR)
+      {
+        int error = errno;
+        close(newFd);
+        errno = error;
+        MIKTEX_FATAL_CRT_ERROR_2("flock", "path", path.ToString());
+      }
+    }
+    return true;
+  }
+  chrono::steady_clock::time_point tryUntil = chrono::steady_clock::now() + timeout;
+  bool acquired;
+#if defined(__linux__)
+  int notifyFd = inotify_init1(IN_CLOEXEC);
+  if (notifyFd >= 0)
+  {
+    try
+    {
+      acquired = AwaitRelease(newFd, notifyFd, operation, tryUntil);
+    }
+    catch (const exception&)
+    {
+      close(notifyFd);
+      throw;
+    }
+    close(notifyFd);
+  }
+  else
+#endif
+  {
+    acquired = PollLock(newFd, operation, tryUntil);
+  }
+  if (!acquired)
+  {
+    close(newFd);
+  }
+  return acquired;
+}
+
+// Makes a single non-blocking attempt.  On error, newFd is closed.
+bool unxLockFile::TryAcquire(int newFd, int operation)
+{
+  if (flock(newFd, operation | LOCK_NB) == 0)
+  {
+    return true;
+  }
+  if (errno != EWOULDBLOCK && errno != EINTR)
+  {
+    int error = errno;
+    close(newFd);
+    errno = error;
+    MIKTEX_FATAL_CRT_ERROR_2("flock", "path", path.ToString());
+  }
+  return false;
+}
+
+#if defined(__linux__)
+bool unxLockFile::AwaitRelease(int newFd, int notifyFd, int operation, chrono::steady_clock::time_point tryUntil)
+{
+  // the watch must be on the file newFd refers to; if the file has
+  // been removed meanwhile, its owner is about to release it
+  if (inotify_add_watch(notifyFd, path.GetData(), IN_CLOSE) < 0 || !IsCurrent(newFd))
+  {
+    return PollLock(newFd, operation, tryUntil);
+  }
+  while (true)
+  {
+    // a release before the watch has been added is not reported: try
+    // again before the first wait
+    if (TryAcquire(newFd, operation))
+    {
+      return true;
+    }
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    if (now >= tryUntil)
+    {
+      return false;
+    }
+    struct pollfd pollFd = { notifyFd, POLLIN, 0 };
+    int ready = poll(&pollFd, 1, static_cast<int>(chrono::duration_cast<chrono::milliseconds>(tryUntil - now).count()) + 1);
+    if (ready < 0 && errno != EINTR)
+    {
+      int error = errno;
+      close(newFd);
+      errno = error;
+      MIKTEX_FATAL_CRT_ERROR_2("poll", "path", path.ToString());
+    }
+    if (ready > 0)
+    {
+      // other waiters open and close the file, too: the events only
+      // tell that the lock might be free
+      alignas(struct inotify_event) char events[4096];
+      if (read(notifyFd, events, sizeof(events)) < 0 && errno != EINTR)
+      {
+        int error = errno;
+        close(newFd);
+        errno = error;
+        MIKTEX_FATAL_CRT_ERROR_2("read", "path", path.ToString());
+      }
+    }
+  }
+}
+#endif
+
+// flock() cannot time out: poll with a growing interval, so that a
+// short wait is noticed quickly and a long one costs little
+bool unxLockFile::PollLock(int newFd, int operation, chrono::steady_clock::time_point tryUntil)
+{
+  chrono::milliseconds interval(1);
+  const chrono::milliseconds maxInterval(10);
+  while (true)
+  {
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    if (now >= tryUntil)
+    {
+      return false;
+    }
+    this_thread::sleep_for(min(interval, chrono::duration_cast<chrono::milliseconds>(tryUntil - now) + chrono::milliseconds(1)));
+    interval = min(interval * 2, maxInterval);
+    if (TryAcquire(newFd, operation))
+    {
+      return true;
+    }
+  }
+}
+
+bool unxLockFile::IsCurrent(int newFd)
+{
+  struct stat fdStat;
+  struct stat pathStat;
+  return fstat(newFd, &fdStat) == 0
+    && stat(path.GetData(), &pathStat) == 0
+    && fdStat.st_dev == pathStat.st_dev
+    && fdStat.st_ino == pathStat.st_ino;
+}
+
+// for diagnostics only: the ID and the name of the owner process
+void unxLockFile::WriteOwner()
+{
+  string owner = fmt::format("{0}\n{1}\n", Process::GetCurrentProcess()->GetSystemId(), Process::GetCurrentProcess()->get_ProcessName());
+  if (ftruncate(fd, 0) != 0 || pwrite(fd, owner.c_str(), owner.length(), 0) != static_cast<ssize_t>(owner.length()))
+  {
+    trace_lockfile->WriteLine("core", TraceLevel::Warning, fmt::format(T_("could not write owner of lock file {0}"), Q_(path)));
+  }
+}
@@ -0,0 +1,338 @@
+/* winLockFile.cpp: lock files
+
+   Copyright (C) 2018-2020 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+   
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+
+#include "config.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/LockFile>
+#include <miktex/Core/Process>
+#include <miktex/Core/win/winAutoResource>
+
+#include <miktex/Trace/Trace>
+#include <miktex/Trace/TraceStream>
+
+#include "internal.h"
+#include "Session/SessionImpl.h"
+
+using namespace std;
+using namespace chrono_literals;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Trace;
+
+// Windows: the lock is a LockFileEx() lock on the lock file.  It
+// belongs to the file handle, so it is released by the system when
+// the owner dies.  Waiters sleep in the kernel: the lock request is
+// issued asynchronously, and it is cancelled when the timeout
+// expires.  The owner of the last lock deletes the file while still
+// holding the lock; a waiter which has opened the file before its
+// deletion notices this when it gets the lock, and starts over.
+class LockFileImpl :
+  public LockFile
+{
+public:
+  LockFileImpl() = delete;
+public:
+  LockFileImpl(const LockFileImpl& other) = delete;
+public:
+  LockFileImpl(LockFileImpl&& other) = delete;
+public:
+  LockFileImpl& operator=(const LockFileImpl& other) = delete;
+public:
+  LockFileImpl& operator=(LockFileImpl&& other) = delete;
+public:
+  ~LockFileImpl() override
+  {
+    try
+    {
+      if (hFile != INVALID_HANDLE_VALUE)
+      {
+        Unlock();
+      }
+    }
+    catch (const exception&)
+    {
+    }
+  }
+public:
+  LockFileImpl(const PathName& path) :
+    path(path)
+  {
+    shared_ptr<SessionImpl> session = SessionImpl::TryGetSession();
+    TraceCallback* callback = session == nullptr ? nullptr : session->GetInitInfo().GetTraceCallback();
+    trace_lockfile = TraceStream::Open(MIKTEX_TRACE_LOCKFILE, callback);
+  }
+public:
+  bool MIKTEXTHISCALL TryLock(chrono::milliseconds timeout) override
+  {
+    return TryLock(File::LockType::Exclusive, timeout);
+  }
+public:
+  bool MIKTEXTHISCALL TryLock(File::LockType lockType, chrono::milliseconds timeout) override;
+public:
+  void MIKTEXTHISCALL Unlock() override;
+private:
+  HANDLE Open(File::LockType lockType);
+private:
+  bool Acquire(HANDLE newHandle, File::LockType lockType, chrono::milliseconds timeout);
+private:
+  bool IsCurrent(HANDLE newHandle);
+private:
+  void Delete(HANDLE h);
+private:
+  void WriteOwner();
+private:
+  PathName path;
+private:
+  HANDLE hFile = INVALID_HANDLE_VALUE;
+private:
+  File::LockType lockType = File::LockType::Exclusive;
+private:
+  unique_ptr<TraceStream> trace_lockfile;
+};
+
+unique_ptr<MiKTeX::Core::LockFile> LockFile::Create(const PathName& path)
+{
+  return make_unique<LockFileImpl>(path);
+}
+
+bool LockFileImpl::TryLock(File::LockType lockType, chrono::milliseconds timeout)
+{
+  const char* lockTypeName = lockType == File::LockType::Exclusive ? "exclusive" : "shared";
+  trace_lockfile->WriteLine("core", fmt::format(T_("trying to acquire {0} lock {1}"), lockTypeName, Q_(path)));
+  if (hFile != INVALID_HANDLE_VALUE)
+  {
+    MIKTEX_UNEXPECTED();
+  }
+  bool forever = timeout == chrono::milliseconds::max();
+  chrono::steady_clock::time_point tryUntil = forever ? chrono::steady_clock::time_point::max() : chrono::steady_clock::now() + timeout;
+  // a deleted file cannot be opened until its last handle has been
+  // closed: access is denied meanwhile
+  chrono::steady_clock::time_point deniedUntil = chrono::steady_clock::time_point::max();
+  while (true)
+  {
+    HANDLE newHandle = Open(lockType);
+    if (newHandle == INVALID_HANDLE_VALUE)
+    {
+      chrono::steady_clock::time_point now = chrono::steady_clock::now();
+      if (deniedUntil == chrono::steady_clock::time_point::max())
+      {
+        deniedUntil = now + 100ms;
+      }
+      if (now >= min(tryUntil, deniedUntil))
+      {
+        trace_lockfile->WriteLine("core", fmt::format(T_("permission denied: {0}"), Q_(path)));
+        return false;
+      }
+      this_thread::sleep_for(1ms);
+      continue;
+    }
+    chrono::milliseconds remaining = forever ? timeout : max(chrono::duration_cast<chrono::milliseconds>(tryUntil - chrono::steady_clock::now()), chrono::milliseconds(0));
+    bool acquired;
+    try
+    {
+      acquired = Acquire(newHandle, lockType, remaining) && IsCurrent(newHandle);
+    }
+    catch (const exception&)
+    {
+      CloseHandle(newHandle);
+      throw;
+    }
+    if (acquired)
+    {
+      hFile = newHandle;
+      break;
+    }
+    CloseHandle(newHandle);
+    if (chrono::steady_clock::now() >= tryUntil)
+    {
+      trace_lockfile->WriteLine("core", fmt::format(T_("lock {0} is held by another process"), Q_(path)));
+      return false;
+    }
+    trace_lockfile->WriteLine("core", fmt::format(T_("lock file {0} has been removed by the previous owner"), Q_(path)));
+  }
+  this->lockType = lockType;
+  if (lockType == File::LockType::Exclusive)
+  {
+    WriteOwner();
+  }
+  trace_lockfile->WriteLine("core", fmt::format(T_("acquired {0} lock {1}"), lockTypeName, Q_(path)));
+  return true;
+}
+
+void MIKTEXTHISCALL LockFileImpl::Unlock()
+{
+  trace_lockfile->WriteLine("core", fmt::format(T_("releasing lock {0}"), Q_(path)));
+  if (hFile == INVALID_HANDLE_VALUE)
+  {
+    MIKTEX_UNEXPECTED();
+  }
+  AutoHANDLE autoClose(hFile);
+  hFile = INVALID_HANDLE_VALUE;
+  bool isLastOwner = lockType == File::LockType::Exclusive;
+  if (!isLastOwner)
+  {
+    // a shared owner is the last one, if it can get the exclusive lock
+    OVERLAPPED overlapped;
+    memset(&overlapped, 0, sizeof(overlapped));
+    isLastOwner = UnlockFileEx(autoClose.Get(), 0, MAXDWORD, MAXDWORD, &overlapped) && Acquire(autoClose.Get(), File::LockType::Exclusive, 0ms);
+  }
+  if (isLastOwner)
+  {
+    Delete(autoClose.Get());
+  }
+  // closing the handle releases the lock
+}
+
+HANDLE LockFileImpl::Open(File::LockType lockType)
+{
+  wstring fileName = path.ToExtendedLengthPathName().ToWideCharString();
+  const DWORD shareMode = FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE;
+  HANDLE h = CreateFileW(fileName.c_str(), GENERIC_READ | GENERIC_WRITE | DELETE, shareMode, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, nullptr);
+  if (h == INVALID_HANDLE_VALUE && GetLastError() == ERROR_ACCESS_DENIED && lockType == File::LockType::Shared)
+  {
+    h = CreateFileW(fileName.c_str(), GENERIC_READ, shareMode, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, nullptr);
+  }
+  if (h == INVALID_HANDLE_VALUE && GetLastError() != ERROR_ACCESS_DENIED && GetLastError() != ERROR_FILE_NOT_FOUND)
+  {
+    MIKTEX_FATAL_WINDOWS_ERROR_2("CreateFileW", "path", path.ToString());
+  }
+  return h;
+}
+
+bool LockFileImpl::Acquire(HANDLE newHandle, File::LockType lockType, chrono::milliseconds timeout)
+{
+  HANDLE hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+  if (hEvent == nullptr)
+  {
+    MIKTEX_FATAL_WINDOWS_ERROR("CreateEventW");
+  }
+  AutoHANDLE autoCloseEvent(hEvent);
+  OVERLAPPED overlapped;
+  memset(&overlapped, 0, sizeof(overlapped));
+  overlapped.hEvent = hEvent;
+  DWORD flags = (lockType == File::LockType::Exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0) | (timeout == 0ms ? LOCKFILE_FAIL_IMMEDIATELY : 0);
+  if (LockFileEx(newHandle, flags, 0, MAXDWORD, MAXDWORD, &overlapped))
+  {
+    return true;
+  }
+  DWORD error = GetLastError();
+  if (error == ERROR_LOCK_VIOLATION)
+  {
+    return false;
+  }
+  if (error != ERROR_IO_PENDING)
+  {
+    MIKTEX_FATAL_WINDOWS_ERROR_2("LockFileEx", "path", path.ToString());
+  }
+  DWORD milliseconds = timeout == chrono::milliseconds::max() ? INFINITE : static_cast<DWORD>(min<chrono::milliseconds::rep>(timeout.count(), INFINITE - 1));
+  DWORD waitResult = WaitForSingleObject(hEvent, milliseconds);
+  if (waitResult == WAIT_TIMEOUT)
+  {
+    CancelIoEx(newHandle, &overlapped);
+  }
+  else if (waitResult != WAIT_OBJECT_0)
+  {
+    MIKTEX_FATAL_WINDOWS_ERROR("WaitForSingleObject");
+  }
+  // the request might have been granted before it could be cancelled
+  DWORD bytesTransferred;
+  if (GetOverlappedResult(newHandle, &overlapped, &bytesTransferred, TRUE))
+  {
+    return true;
+  }
+  error = GetLastError();
+  if (error != ERROR_OPERATION_ABORTED && error != ERROR_LOCK_VIOLATION)
+  {
+    MIKTEX_FATAL_WINDOWS_ERROR_2("LockFileEx", "path", path.ToString());
+  }
+  return false;
+}
+
+bool LockFileImpl::IsCurrent(HANDLE newHandle)
+{
+  FILE_STANDARD_INFO standardInfo;
+  if (!GetFileInformationByHandleEx(newHandle, FileStandardInfo, &standardInfo, sizeof(standardInfo)) || standardInfo.DeletePending)
+  {
+    return false;
+  }
+  HANDLE h = CreateFileW(path.ToExtendedLengthPathName().ToWideCharString().c_str(), FILE_READ_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (h == INVALID_HANDLE_VALUE)
+  {
+    return false;
+  }
+  AutoHANDLE autoClose(h);
+  BY_HANDLE_FILE_INFORMATION handleInfo;
+  BY_HANDLE_FILE_INFORMATION pathInfo;
+  return GetFileInformationByHandle(newHandle, &handleInfo)
+    && GetFileInformationByHandle(h, &pathInfo)
+    && handleInfo.dwVolumeSerialNumber == pathInfo.dwVolumeSerialNumber
+    && handleInfo.nFileIndexHigh == pathInfo.nFileIndexHigh
+    && handleInfo.nFileIndexLow == pathInfo.nFileIndexLow;
+}
+
+void LockFileImpl::Delete(HANDLE h)
+{
+  trace_lockfile->WriteLine("core", fmt::format(T_("removing lock file {0}"), Q_(path)));
+  // POSIX semantics (Windows 10 1709 and later): the name is removed at
+  // once, so that the next owner does not have to wait for the last
+  // handle to be closed; FileDispositionInfoEx is not declared for
+  // older target versions
+  struct
+  {
+    DWORD Flags;
+  } dispositionInfoEx = { 0x00000001 /* FILE_DISPOSITION_FLAG_DELETE */ | 0x00000002 /* FILE_DISPOSITION_FLAG_POSIX_SEMANTICS */ };
+  if (SetFileInformationByHandle(h, static_cast<FILE_INFO_BY_HANDLE_CLASS>(21) /* FileDispositionInfoEx */, &dispositionInfoEx, sizeof(dispositionInfoEx)))
+  {
+    return;
+  }
+  FILE_DISPOSITION_INFO dispositionInfo = { TRUE };
+  if (!SetFileInformationByHandle(h, FileDispositionInfo, &dispositionInfo, sizeof(dispositionInfo)))
+  {
+    trace_lockfile->WriteLine("core", TraceLevel::Warning, fmt::format(T_("could not remove lock file {0}"), Q_(path)));
+  }
+}
+
+// for diagnostics only: the ID and the name of the owner process
+void LockFileImpl::WriteOwner()
+{
+  string owner = fmt::format("{0}\n{1}\n", Process::GetCurrentProcess()->GetSystemId(), Process::GetCurrentProcess()->get_ProcessName());
+  FILE_END_OF_FILE_INFO endOfFileInfo;
+  endOfFileInfo.EndOfFile.QuadPart = owner.length();
+  OVERLAPPED overlapped;
+  memset(&overlapped, 0, sizeof(overlapped));
+  DWORD written;
+  bool done = SetFileInformationByHandle(hFile, FileEndOfFileInfo, &endOfFileInfo, sizeof(endOfFileInfo))
+    && (WriteFile(hFile, owner.c_str(), static_cast<DWORD>(owner.length()), nullptr, &overlapped) || GetLastError() == ERROR_IO_PENDING)
+    && GetOverlappedResult(hFile, &overlapped, &written, TRUE)
+    && written == owner.length();
+  if (!done)
+  {
+    trace_lockfile->WriteLine("core", TraceLevel::Warning, fmt::format(T_("could not write owner of lock file {0}"), Q_(path)));
+  }
+}
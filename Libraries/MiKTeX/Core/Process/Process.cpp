@@ -21,6 +21,12 @@
 
 #include "config.h"
 
+#if defined(MIKTEX_UNIX)
+#  include <fcntl.h>
+#  include <poll.h>
+#  include <unistd.h>
+#endif
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
@@ -83,6 +89,68 @@ void Process::Start(const PathName& fileName, const vector<string>& arguments, F
   process->Close();
 }
 
+#if defined(MIKTEX_UNIX)
+// reads from a non-blocking pipe as data becomes available, passing
+// each chunk to the callback; returns the number of bytes read
+MIKTEXSTATICFUNC(size_t) PumpOutput(int fd, const PathName& fileName, function<bool(const void*, size_t)> callback)
+{
+  int flags = fcntl(fd, F_GETFL);
+  if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR_2("fcntl", "processFileName", fileName.ToString());
+  }
+  const size_t CHUNK_SIZE = 64 * 1024;
+  unique_ptr<char[]> buf(new char[CHUNK_SIZE]);
+  size_t total = 0;
+  struct pollfd pfd;
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  while (true)
+  {
+    pfd.revents = 0;
+    int ready = poll(&pfd, 1, -1);
+    if (ready < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      MIKTEX_FATAL_CRT_ERROR_2("poll", "processFileName", fileName.ToString());
+    }
+    // drain the pipe
+    while (true)
+    {
+      ssize_t n = read(fd, buf.get(), CHUNK_SIZE);
+      if (n > 0)
+      {
+        total += n;
+        if (!callback(buf.get(), n))
+        {
+          return total;
+        }
+      }
+      else if (n == 0)
+      {
+        // all writers have closed the pipe
+        return total;
+      }
+      else if (errno == EINTR)
+      {
+        continue;
+      }
+      else if (errno == EAGAIN || errno == EWOULDBLOCK)
+      {
+        break;
+      }
+      else
+      {
+        MIKTEX_FATAL_CRT_ERROR_2("read", "processFileName", fileName.ToString());
+      }
+    }
+  }
+}
+#endif
+
 bool Process::Run(const PathName& fileName, const vector<string>& arguments, function<bool(const void*, size_t)> callback, int* exitCode, MiKTeXException* miktexException, const char* workingDirectory)
 {
   MIKTEX_ASSERT_STRING_OR_NIL(workingDirectory);
@@ -117,10 +185,14 @@ bool Process::Run(const PathName& fileName, const vector<string>& arguments, fun
     {
       session->trace_process->WriteLine("core", "start reading the pipe");
     }
+    FileStream stdoutStream(process->get_StandardOutput());
+#if defined(MIKTEX_UNIX)
+    // stderr has been redirected to the same pipe
+    size_t total = PumpOutput(fileno(stdoutStream.GetFile()), fileName, callback);
+#else
     const size_t CHUNK_SIZE = 64;
     char buf[CHUNK_SIZE];
     bool cancelled = false;
-    FileStream stdoutStream(process->get_StandardOutput());
     size_t total = 0;
     while (!cancelled && feof(stdoutStream.GetFile()) == 0)
     {
@@ -134,6 +206,7 @@ bool Process::Run(const PathName& fileName, const vector<string>& arguments, fun
       total += n;
       cancelled = !callback(buf, n);
     }
+#endif
     if (session != nullptr)
     {
       session->trace_process->WriteLine("core", fmt::format("read {0} bytes from the pipe", total));
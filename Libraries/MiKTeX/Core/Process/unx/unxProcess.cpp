@@ -28,6 +28,10 @@
 #include <sys/wait.h>
 #include <unistd.h>
 
+#if defined(HAVE_POSIX_SPAWN)
+#  include <spawn.h>
+#endif
+
 #if defined(__APPLE__)
 #  include <libproc.h>
 #  include <sys/proc.h>
@@ -44,6 +48,9 @@
 #   include <fcntl.h>
 #endif
 
+#include <cstring>
+#include <map>
+#include <set>
 #include <thread>
 
 #include <miktex/Core/Directory>
@@ -192,6 +199,172 @@ private:
   int twofd[2] = { -1, -1 };
 };
 
+extern "C" char** environ;
+
+// the environment of a child process: the environment of this process
+// plus the given variables; building it does not modify the
+// environment of this process, which other threads may be reading
+class unxProcess::Envp
+{
+public:
+  Envp(const vector<pair<string, string>>& variables)
+  {
+    map<string, string> overrides;
+    for (const auto& v : variables)
+    {
+      overrides[v.first] = v.second;
+    }
+    for (char** p = environ; *p != nullptr; ++p)
+    {
+      const char* eq = strchr(*p, '=');
+      if (eq == nullptr || overrides.find(string(*p, eq - *p)) == overrides.end())
+      {
+        strings.push_back(*p);
+      }
+    }
+    for (const auto& v : overrides)
+    {
+      strings.push_back(v.first + "=" + v.second);
+    }
+    for (const string& s : strings)
+    {
+      envp.push_back(const_cast<char*>(s.c_str()));
+    }
+    envp.push_back(nullptr);
+  }
+
+public:
+  Envp(const Envp& other) = delete;
+
+public:
+  Envp& operator=(const Envp& other) = delete;
+
+public:
+  char* const* GetEnvp() const
+  {
+    return envp.data();
+  }
+
+private:
+  vector<string> strings;
+
+private:
+  vector<char*> envp;
+};
+
+#if defined(HAVE_POSIX_SPAWN)
+
+class SpawnFileActions
+{
+public:
+  SpawnFileActions()
+  {
+    int err = posix_spawn_file_actions_init(&fileActions);
+    if (err != 0)
+    {
+      MIKTEX_FATAL_CRT_ERROR_2("posix_spawn_file_actions_init", "errno", std::to_string(err));
+    }
+  }
+
+public:
+  SpawnFileActions(const SpawnFileActions& other) = delete;
+
+public:
+  SpawnFileActions& operator=(const SpawnFileActions& other) = delete;
+
+public:
+  ~SpawnFileActions() noexcept
+  {
+    posix_spawn_file_actions_destroy(&fileActions);
+  }
+
+public:
+  void AddDup2(int fd, int fd2)
+  {
+    int err = posix_spawn_file_actions_adddup2(&fileActions, fd, fd2);
+    if (err != 0)
+    {
+      MIKTEX_FATAL_CRT_ERROR_2("posix_spawn_file_actions_adddup2", "errno", std::to_string(err));
+    }
+  }
+
+public:
+  void AddClose(int fd)
+  {
+    int err = posix_spawn_file_actions_addclose(&fileActions, fd);
+    if (err != 0)
+    {
+      MIKTEX_FATAL_CRT_ERROR_2("posix_spawn_file_actions_addclose", "errno", std::to_string(err));
+    }
+  }
+
+#if defined(HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP)
+public:
+  void AddChdir(const string& path)
+  {
+    int err = posix_spawn_file_actions_addchdir_np(&fileActions, path.c_str());
+    if (err != 0)
+    {
+      MIKTEX_FATAL_CRT_ERROR_2("posix_spawn_file_actions_addchdir_np", "path", path, "errno", std::to_string(err));
+    }
+  }
+#endif
+
+public:
+  const posix_spawn_file_actions_t* Get() const
+  {
+    return &fileActions;
+  }
+
+private:
+  posix_spawn_file_actions_t fileActions;
+};
+
+class SpawnAttributes
+{
+public:
+  SpawnAttributes()
+  {
+    int err = posix_spawnattr_init(&attributes);
+    if (err != 0)
+    {
+      MIKTEX_FATAL_CRT_ERROR_2("posix_spawnattr_init", "errno", std::to_string(err));
+    }
+  }
+
+public:
+  SpawnAttributes(const SpawnAttributes& other) = delete;
+
+public:
+  SpawnAttributes& operator=(const SpawnAttributes& other) = delete;
+
+public:
+  ~SpawnAttributes() noexcept
+  {
+    posix_spawnattr_destroy(&attributes);
+  }
+
+public:
+  void SetFlags(short flags)
+  {
+    int err = posix_spawnattr_setflags(&attributes, flags);
+    if (err != 0)
+    {
+      MIKTEX_FATAL_CRT_ERROR_2("posix_spawnattr_setflags", "errno", std::to_string(err));
+    }
+  }
+
+public:
+  const posix_spawnattr_t* Get() const
+  {
+    return &attributes;
+  }
+
+private:
+  posix_spawnattr_t attributes;
+};
+#endif
+
 unique_ptr<Process> Process::Start(const ProcessStartInfo& startinfo)
 {
   return make_unique<unxProcess>(startinfo);
@@ -264,18 +437,149 @@ void unxProcess::Create()
   }
 
   tmpFile = TemporaryFile::Create();
-  tmpEnv.Set(MIKTEX_ENV_EXCEPTION_PATH, tmpFile->GetPathName().ToString());
+
+  vector<pair<string, string>> variables;
+  if (session != nullptr)
+  {
+    variables = session->GetEnvironmentVariables();
+  }
+  variables.push_back({ MIKTEX_ENV_EXCEPTION_PATH, tmpFile->GetPathName().ToString() });
+  Envp envp(variables);
+
+  // the file descriptors of the child's standard streams; all other
+  // descriptors created here must be closed in the child
+  int fdStdin = pipeStdin.GetReadEnd() >= 0 ? pipeStdin.GetReadEnd() : fdChildStdin;
+  int fdStdout = pipeStdout.GetWriteEnd();
+  int fdStderr = pipeStderr.GetWriteEnd() >= 0 ? pipeStderr.GetWriteEnd() : fdChildStderr;
+  vector<int> fdsToClose{
+    pipeStdout.GetReadEnd(), pipeStdout.GetWriteEnd(),
+    pipeStderr.GetReadEnd(), pipeStderr.GetWriteEnd(),
+    pipeStdin.GetReadEnd(), pipeStdin.GetWriteEnd(),
+    fdChildStdin, fdChildStderr
+  };
+
+#if defined(HAVE_POSIX_SPAWN)
+  if (CanSpawn())
+  {
+    Spawn(fileName, argv, envp, fdStdin, fdStdout, fdStderr, fdsToClose);
+  }
+  else
+#endif
+  {
+    ForkAndExec(fileName, argv, envp, fdStdin, fdStdout, fdStderr, fdsToClose);
+  }
+
+  MIKTEX_ASSERT(pid > 0);
+
+  if (startinfo.RedirectStandardOutput)
+  {
+    fdStandardOutput = pipeStdout.StealReadEnd();
+  }
+
+  if (startinfo.RedirectStandardError)
+  {
+    fdStandardError = pipeStderr.StealReadEnd();
+  }
+
+  if (startinfo.RedirectStandardInput)
+  {
+    fdStandardInput = pipeStdin.StealWriteEnd();
+  }
+
+  if (fdChildStderr >= 0)
+  {
+    ::Close_(fdChildStderr);
+  }
+
+  pipeStdout.Dispose();
+  pipeStderr.Dispose();
+  pipeStdin.Dispose();
+}
+
+#if defined(HAVE_POSIX_SPAWN)
+bool unxProcess::CanSpawn() const
+{
+#if !defined(HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP)
+  if (!startinfo.WorkingDirectory.empty())
+  {
+    return false;
+  }
+#endif
+#if !defined(POSIX_SPAWN_SETSID)
+  if (startinfo.Daemonize)
+  {
+    return false;
+  }
+#endif
+  return true;
+}
+
+void unxProcess::Spawn(const PathName& fileName, const Argv& argv, const Envp& envp, int fdChildStdin, int fdChildStdout, int fdChildStderr, const vector<int>& fdsToClose)
+{
+  shared_ptr<SessionImpl> session = SessionImpl::TryGetSession();
+
+  SpawnFileActions fileActions;
+  if (fdChildStdin >= 0)
+  {
+    fileActions.AddDup2(fdChildStdin, filenoStdin);
+  }
+  if (fdChildStdout >= 0)
+  {
+    fileActions.AddDup2(fdChildStdout, filenoStdout);
+  }
+  if (fdChildStderr >= 0)
+  {
+    fileActions.AddDup2(fdChildStderr, filenoStderr);
+  }
+  // pipe ends are inherited, unless closed explicitly
+  set<int> closed;
+  for (int fd : fdsToClose)
+  {
+    if (fd > filenoStderr && closed.insert(fd).second)
+    {
+      fileActions.AddClose(fd);
+    }
+  }
+#if defined(HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP)
+  if (!startinfo.WorkingDirectory.empty())
+  {
+    fileActions.AddChdir(startinfo.WorkingDirectory);
+  }
+#endif
+
+  SpawnAttributes attributes;
+#if defined(POSIX_SPAWN_SETSID)
+  if (startinfo.Daemonize)
+  {
+    attributes.SetFlags(POSIX_SPAWN_SETSID);
+  }
+#endif
+
+  if (session != nullptr)
+  {
+    session->trace_process->WriteLine("core", TraceLevel::Info, fmt::format("posix_spawn: {0}", fileName));
+  }
+
+  int err = posix_spawn(&pid, fileName.GetData(), fileActions.Get(), attributes.Get(), const_cast<char* const*>(argv.GetArgv()), envp.GetEnvp());
+  if (err != 0)
+  {
+    pid = -1;
+    errno = err;
+    MIKTEX_FATAL_CRT_ERROR_2("posix_spawn", "fileName", fileName.ToString());
+  }
+}
+#endif
+
+void unxProcess::ForkAndExec(const PathName& fileName, const Argv& argv, const Envp& envp, int fdChildStdin, int fdChildStdout, int fdChildStderr, const vector<int>& fdsToClose)
+{
+  shared_ptr<SessionImpl> session = SessionImpl::TryGetSession();
 
   // fork
   if (session != nullptr)
   {
     session->trace_process->WriteLine("core", TraceLevel::Info, "forking...");
   }
-  if (pipeStdout.GetReadEnd() >= 0
-    || pipeStderr.GetReadEnd() >= 0
-    || pipeStdin.GetReadEnd() >= 0
-    || fdChildStdin >= 0
-    || fdChildStderr >= 0)
+  if (fdChildStdin >= 0 || fdChildStdout >= 0 || fdChildStderr >= 0)
   {
     pid = FORK();
   }
@@ -293,34 +597,25 @@ void unxProcess::Create()
     try
     {
       // I'm a child
-      if (pipeStdout.GetWriteEnd() >= 0)
+      if (fdChildStdout >= 0)
       {
-        Dup2(pipeStdout.GetWriteEnd(), filenoStdout);
+        Dup2(fdChildStdout, filenoStdout);
       }
-      if (pipeStderr.GetWriteEnd() >= 0)
-      {
-        Dup2(pipeStderr.GetWriteEnd(), filenoStderr);
-      }
-      else if (fdChildStderr >= 0)
+      if (fdChildStderr >= 0)
       {
         Dup2(fdChildStderr, filenoStderr);
-        ::Close_(fdChildStderr);
-      }
-      if (pipeStdin.GetReadEnd() >= 0)
-      {
-        Dup2(pipeStdin.GetReadEnd(), filenoStdin);
       }
-      else if (fdChildStdin >= 0)
+      if (fdChildStdin >= 0)
       {
         Dup2(fdChildStdin, filenoStdin);
-        ::Close_(fdChildStdin);
       }
-      pipeStdout.Dispose();
-      pipeStderr.Dispose();
-      pipeStdin.Dispose();
-      if (session != nullptr)
+      set<int> closed;
+      for (int fd : fdsToClose)
       {
-        session->SetEnvironmentVariables();
+        if (fd > filenoStderr && closed.insert(fd).second)
+        {
+          ::Close_(fd);
+        }
       }
       if (!startinfo.WorkingDirectory.empty())
       {
@@ -344,42 +639,16 @@ void unxProcess::Create()
             args += ", ";
           }
         }
-        session->trace_process->WriteLine("core", TraceLevel::Info, fmt::format("execv: \"{0}\", [ {1} ]", fileName, args));
+        session->trace_process->WriteLine("core", TraceLevel::Info, fmt::format("execve: \"{0}\", [ {1} ]", fileName, args));
       }
-      execv(fileName.GetData(), const_cast<char*const*>(argv.GetArgv()));
-      perror("execv failed");
+      execve(fileName.GetData(), const_cast<char*const*>(argv.GetArgv()), envp.GetEnvp());
+      perror("execve failed");
     }
     catch (const exception&)
     {
     }
     _exit(127);
   }
-
-  MIKTEX_ASSERT(pid > 0);
-
-  if (startinfo.RedirectStandardOutput)
-  {
-    fdStandardOutput = pipeStdout.StealReadEnd();
-  }
-
-  if (startinfo.RedirectStandardError)
-  {
-    fdStandardError = pipeStderr.StealReadEnd();
-  }
-
-  if (startinfo.RedirectStandardInput)
-  {
-    fdStandardInput = pipeStdin.StealWriteEnd();
-  }
-
-  if (fdChildStderr >= 0)
-  {
-    ::Close_(fdChildStderr);
-  }
-
-  pipeStdout.Dispose();
-  pipeStderr.Dispose();
-  pipeStdin.Dispose();
 }
 
 unxProcess::unxProcess(const ProcessStartInfo& startinfo) :
@@ -419,7 +688,6 @@ void unxProcess::Close()
   this->pid = -1;
   if (tmpFile != nullptr)
   {
-    tmpEnv.Restore();
     tmpFile->Delete();
     tmpFile = nullptr;
   }
@@ -25,12 +25,12 @@
 #define B6278A08DFEE4038A08449DD17C4E3D3
 
 #include <memory>
+#include <vector>
 
+#include <miktex/Core/CommandLineBuilder>
 #include <miktex/Core/Process>
 #include <miktex/Core/TemporaryFile>
 
-#include "Utils/AutoEnv.h"
-
 CORE_INTERNAL_BEGIN_NAMESPACE;
 
 class unxProcess :
@@ -86,9 +86,23 @@ public:
 public:
   ~unxProcess() override;
 
+private:
+  class Envp;
+
 private:
   void Create();
 
+#if defined(HAVE_POSIX_SPAWN)
+private:
+  bool CanSpawn() const;
+
+private:
+  void Spawn(const MiKTeX::Core::PathName& fileName, const MiKTeX::Core::Argv& argv, const Envp& envp, int fdChildStdin, int fdChildStdout, int fdChildStderr, const std::vector<int>& fdsToClose);
+#endif
+
+private:
+  void ForkAndExec(const MiKTeX::Core::PathName& fileName, const MiKTeX::Core::Argv& argv, const Envp& envp, int fdChildStdin, int fdChildStdout, int fdChildStderr, const std::vector<int>& fdsToClose);
+
 private:
   MiKTeX::Core::ProcessStartInfo startinfo;
 
@@ -111,9 +125,6 @@ private:
 private:
   std::unique_ptr<MiKTeX::Core::TemporaryFile> tmpFile;
 
-private:
-  AutoEnv tmpEnv;
-
 private:
   friend class MiKTeX::Core::Process;
 };
@@ -753,6 +753,9 @@ private:
   MiKTeX::Core::PathName atmFontDir;
 #endif
 
+private:
+  std::string GetCWDList();
+
 private:
   void SetCWDEnv();
 
@@ -808,6 +811,9 @@ private:
 private:
   std::deque<MiKTeX::Core::PathName> inputDirectories;
 
+public:
+  std::vector<std::pair<std::string, std::string>> GetEnvironmentVariables();
+
 public:
   void SetEnvironmentVariables();
 
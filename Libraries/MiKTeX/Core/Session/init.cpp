@@ -931,13 +931,15 @@ void SessionImpl::Reset()
   this->onFinishScript = move(onFinishScript);
 }
 
-void SessionImpl::SetEnvironmentVariables()
+vector<pair<string, string>> SessionImpl::GetEnvironmentVariables()
 {
+  vector<pair<string, string>> result;
+
 #if MIKTEX_WINDOWS
-  Utils::SetEnvironmentString("TEXSYSTEM", "miktex");
+  result.push_back({ "TEXSYSTEM", "miktex" });
 
   // Ghostscript
-  Utils::SetEnvironmentString("GSC", MIKTEX_GS_EXE);
+  result.push_back({ "GSC", MIKTEX_GS_EXE });
 #endif
 
   vector<string> gsDirectories;
@@ -970,7 +972,7 @@ void SessionImpl::SetEnvironmentVariables()
   MIKTEX_ASSERT(!gsDirectories.Empty());
 
 #if defined(MIKTEX_WINDOWS)
-  Utils::SetEnvironmentString("MIKTEX_GS_LIB", StringUtil::Flatten(gsDirectories, PathNameUtil::PathNameDelimiter));
+  result.push_back({ "MIKTEX_GS_LIB", StringUtil::Flatten(gsDirectories, PathNameUtil::PathNameDelimiter) });
 #else
   string origGsLib;
   if (Utils::GetEnvironmentString("GS_LIB", origGsLib))
@@ -985,37 +987,37 @@ void SessionImpl::SetEnvironmentVariables()
       }
     }
   }
-  Utils::SetEnvironmentString("GS_LIB", StringUtil::Flatten(gsDirectories, PathNameUtil::PathNameDelimiter));
+  result.push_back({ "GS_LIB", StringUtil::Flatten(gsDirectories, PathNameUtil::PathNameDelimiter) });
 #endif
 
   PathName path = GetTempDirectory();
 
   if (!HaveEnvironmentString("TEMPDIR") || IsMiKTeXPortable())
   {
-    Utils::SetEnvironmentString("TEMPDIR", path.ToString());
+    result.push_back({ "TEMPDIR", path.ToString() });
   }
 
   if (!HaveEnvironmentString("TMPDIR") || IsMiKTeXPortable())
   {
-    Utils::SetEnvironmentString("TMPDIR", path.ToString());
+    result.push_back({ "TMPDIR", path.ToString() });
   }
 
   if (!HaveEnvironmentString("TEMP") || IsMiKTeXPortable())
   {
-    Utils::SetEnvironmentString("TEMP", path.ToString());
+    result.push_back({ "TEMP", path.ToString() });
   }
 
   if (!HaveEnvironmentString("TMP") || IsMiKTeXPortable())
   {
-    Utils::SetEnvironmentString("TMP", path.ToString());
+    result.push_back({ "TMP", path.ToString() });
   }
 
   if (!HaveEnvironmentString("HOME"))
   {
-    Utils::SetEnvironmentString("HOME", GetHomeDirectory().ToString());
+    result.push_back({ "HOME", GetHomeDirectory().ToString() });
   }
 
-  SetCWDEnv();
+  result.push_back({ MIKTEX_ENV_CWD_LIST, GetCWDList() });
 
   if (!initInfo.GetOptions()[InitOption::NoFixPath])
   {
@@ -1029,18 +1031,28 @@ void SessionImpl::SetEnvironmentVariables()
     auto p = TryGetBinDirectory(true);
     if (p.first && FixProgramSearchPath(envPath, p.second, false, newEnvPath, competition))
     {
-      Utils::SetEnvironmentString("PATH", newEnvPath);
+      result.push_back({ "PATH", newEnvPath });
       envPath = newEnvPath;
     }
 #if !defined(MIKTEX_MACOS_BUNDLE)
     p = TryGetBinDirectory(false);
     if (p.first && FixProgramSearchPath(envPath, p.second, false, newEnvPath, competition))
     {
-      Utils::SetEnvironmentString("PATH", newEnvPath);
+      result.push_back({ "PATH", newEnvPath });
       envPath = newEnvPath;
     }
 #endif
   }
+
+  return result;
+}
+
+void SessionImpl::SetEnvironmentVariables()
+{
+  for (const auto& v : GetEnvironmentVariables())
+  {
+    Utils::SetEnvironmentString(v.first, v.second);
+  }
 }
 
 void SessionImpl::SetTheNameOfTheGame(const string& name)
@@ -180,6 +180,8 @@ void SessionImpl::WriteLanguagesIni()
   {
     Fndb::Add({ { pathLocalLanguagesIni } });
   }
+  // language.dat must be rebuilt
+  RecordMaintenance();
 }
 
 void SessionImpl::SetLanguageInfo(const LanguageInfo& languageInfo)
@@ -664,7 +664,7 @@ MIKTEXINTERNALFUNC(RSA_ptr) LoadPublicKey_OpenSSL(const PathName& publicKeyFile)
 }
 #endif
 
-void SessionImpl::SetCWDEnv()
+string SessionImpl::GetCWDList()
 {
   string str;
   str.reserve(256);
@@ -676,7 +676,12 @@ void SessionImpl::SetCWDEnv()
     }
     str += dir.ToString();
   }
-  Utils::SetEnvironmentString(MIKTEX_ENV_CWD_LIST, str);
+  return str;
+}
+
+void SessionImpl::SetCWDEnv()
+{
+  Utils::SetEnvironmentString(MIKTEX_ENV_CWD_LIST, GetCWDList());
 }
 
 void SessionImpl::AddInputDirectory(const PathName& path, bool atEnd)
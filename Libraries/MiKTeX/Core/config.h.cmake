@@ -1,6 +1,6 @@
 /* config.h (created from config.h.cmake)               -*- C++ -*-
 
-   Copyright (C) 1996-2018 Christian Schenk
+   Copyright (C) 1996-2020 Christian Schenk
 
    This file is part of the MiKTeX Core Library.
 
@@ -39,6 +39,8 @@
 #cmakedefine HAVE_FORK 1
 #cmakedefine HAVE_FUTIMES 1
 #cmakedefine HAVE_MMAP 1
+#cmakedefine HAVE_POSIX_SPAWN 1
+#cmakedefine HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP 1
 #cmakedefine HAVE_STATVFS 1
 #cmakedefine HAVE_UNAME_SYSCALL 1
 #cmakedefine HAVE_VFORK 1
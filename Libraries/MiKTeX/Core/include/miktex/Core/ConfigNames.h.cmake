@@ -59,6 +59,7 @@ constexpr auto MIKTEX_CONFIG_VALUE_ENVVARS = "${MIKTEX_CONFIG_VALUE_ENVVARS}";
 constexpr auto MIKTEX_CONFIG_VALUE_EXTENSIONS = "${MIKTEX_CONFIG_VALUE_EXTENSIONS}";
 constexpr auto MIKTEX_CONFIG_VALUE_FORCE_LOCAL_SERVER = "${MIKTEX_CONFIG_VALUE_FORCE_LOCAL_SERVER}";
 constexpr auto MIKTEX_CONFIG_VALUE_GUI_FRAMEWORK = "${MIKTEX_CONFIG_VALUE_GUI_FRAMEWORK}";
+constexpr auto MIKTEX_CONFIG_VALUE_HUGE_PAGES = "${MIKTEX_CONFIG_VALUE_HUGE_PAGES}";
 constexpr auto MIKTEX_CONFIG_VALUE_LAST_ADMIN_DIAGNOSE = "${MIKTEX_CONFIG_VALUE_LAST_ADMIN_DIAGNOSE}";
 constexpr auto MIKTEX_CONFIG_VALUE_LAST_ADMIN_MAINTENANCE = "${MIKTEX_CONFIG_VALUE_LAST_ADMIN_MAINTENANCE}";
 constexpr auto MIKTEX_CONFIG_VALUE_LAST_ADMIN_UPDATE = "${MIKTEX_CONFIG_VALUE_LAST_ADMIN_UPDATE}";
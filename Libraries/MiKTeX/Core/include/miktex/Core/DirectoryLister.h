@@ -1,6 +1,6 @@
 /* miktex/Core/DirectoryLister.h:                       -*- C++ -*-
 
-   Copyright (C) 1996-2019 Christian Schenk
+   Copyright (C) 1996-2020 Christian Schenk
 
    This file is part of the MiKTeX Core Library.
 
@@ -29,6 +29,7 @@
 #include <cstddef>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "PathName.h"
 
@@ -91,6 +92,22 @@ public:
 public:
   virtual bool MIKTEXTHISCALL GetNext(DirectoryEntry2& direntry2) = 0;
 
+  /// Gets the next block of entries.
+  /// A block holds the entries which the operating system returns in one
+  /// request; reading blocks is faster than reading single entries.
+  /// @param[out] entries The next block of entries.
+  /// @return Returns `true`, if the next block could be retrieved. Returns `false`, if
+  /// there are no more entries.
+public:
+  virtual bool MIKTEXTHISCALL GetNextBlock(std::vector<DirectoryEntry>& entries) = 0;
+
+  /// Gets the next block of entries.
+  /// @param[out] entries The next block of entries.
+  /// @return Returns `true`, if the next block could be retrieved. Returns `false`, if
+  /// there are no more entries.
+public:
+  virtual bool MIKTEXTHISCALL GetNextBlock(std::vector<DirectoryEntry2>& entries) = 0;
+
   /// Creates a new `DirectoryLister` instance.
   /// @param directory File system path to the directory.
   /// @return Returns a smart pointer to the `DirectoryLister` interface.
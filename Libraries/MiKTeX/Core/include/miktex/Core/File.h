@@ -425,6 +425,27 @@ public:
     return lastWriteTime;
   }
 
+  /// Tries to get file timestamps.
+  /// @param path The file system path to the file.
+  /// @param[out] creationTime Creation timestamp.
+  /// @param[out] lastAccessTime Last access timestamp.
+  /// @param[out] lastWriteTime Last modification timestamp.
+  /// @return Returns `false`, if the file does not exist.
+public:
+  static MIKTEXCORECEEAPI(bool) TryGetTimes(const PathName& path, time_t& creationTime, time_t& lastAccessTime, time_t& lastWriteTime);
+
+  /// Tries to get the modification timestamp of a file.
+  /// @param path The file system path to the file.
+  /// @param[out] lastWriteTime Last modification timestamp.
+  /// @return Returns `false`, if the file does not exist.
+public:
+  static bool TryGetLastWriteTime(const PathName& path, time_t& lastWriteTime)
+  {
+    time_t creationTime;
+    time_t lastAccessTime;
+    return TryGetTimes(path, creationTime, lastAccessTime, lastWriteTime);
+  }
+
   /// Reads a file.
   /// @param path The file system path to the file.
   /// @return Returns the file contents.
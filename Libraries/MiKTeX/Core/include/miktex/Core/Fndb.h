@@ -87,6 +87,9 @@ public:
 public:
   static MIKTEXCORECEEAPI(bool) FileExists(const PathName& path);
 
+public:
+  static MIKTEXCORECEEAPI(bool) Enumerate(const PathName& directory, std::vector<Record>& result);
+
 public:
   static MIKTEXCORECEEAPI(bool) Refresh(const PathName& path, ICreateFndbCallback* callback);
 
@@ -1,6 +1,6 @@
 /* miktex/Core/LockFile.h:                              -*- C++ -*-
 
-   Copyright (C) 2018-2019 Christian Schenk
+   Copyright (C) 2018-2020 Christian Schenk
 
    This file is part of the MiKTeX Core Library.
 
@@ -31,6 +31,7 @@
 #include <chrono>
 #include <memory>
 
+#include "File.h"
 #include "PathName.h"
 
 MIKTEX_CORE_BEGIN_NAMESPACE;
@@ -47,7 +48,16 @@ public:
 public:
   virtual bool MIKTEXTHISCALL TryLock(std::chrono::milliseconds timeout) = 0;
 
-  /// Removes the lock file.
+  /// Tries to lock the lock file.
+  /// @param lockType The requested lock type. A shared lock can be held
+  /// by several owners at the same time.
+  /// @param timeout The maximum time waited for the lock. Pass
+  /// `std::chrono::milliseconds::max()` to wait without a time limit.
+  /// @return Returns `true`, if the lock has been acquired.
+public:
+  virtual bool MIKTEXTHISCALL TryLock(File::LockType lockType, std::chrono::milliseconds timeout) = 0;
+
+  /// Releases the lock. The last owner removes the lock file.
 public:
   virtual void MIKTEXTHISCALL Unlock() = 0;
 
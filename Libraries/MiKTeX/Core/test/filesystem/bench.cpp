@@ -0,0 +1,181 @@
+/* bench.cpp: directory enumeration benchmark
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <miktex/Core/Test>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/DirectoryLister>
+#include <miktex/Core/File>
+#include <miktex/Core/PathName>
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Test;
+using namespace std;
+
+BEGIN_TEST_SCRIPT("filesystem-bench");
+
+const int DIRECTORIES = 50;
+const int FILES = 400;
+
+struct WalkResult
+{
+  size_t files = 0;
+  size_t directories = 0;
+  size_t bytes = 0;
+};
+
+void WalkEntries(const PathName& directory, WalkResult& result)
+{
+  unique_ptr<DirectoryLister> lister = DirectoryLister::Open(directory);
+  DirectoryEntry2 entry;
+  while (lister->GetNext(entry))
+  {
+    if (entry.isDirectory)
+    {
+      result.directories += 1;
+      WalkEntries(directory / PathName(entry.name), result);
+    }
+    else
+    {
+      result.files += 1;
+      result.bytes += entry.size;
+    }
+  }
+}
+
+void WalkBlocks(const PathName& directory, WalkResult& result)
+{
+  unique_ptr<DirectoryLister> lister = DirectoryLister::Open(directory);
+  vector<DirectoryEntry2> entries;
+  while (lister->GetNextBlock(entries))
+  {
+    for (const DirectoryEntry2& entry : entries)
+    {
+      if (entry.isDirectory)
+      {
+        result.directories += 1;
+        WalkBlocks(directory / PathName(entry.name), result);
+      }
+      else
+      {
+        result.files += 1;
+        result.bytes += entry.size;
+      }
+    }
+  }
+}
+
+void WalkNames(const PathName& directory, WalkResult& result)
+{
+  unique_ptr<DirectoryLister> lister = DirectoryLister::Open(directory);
+  vector<DirectoryEntry> entries;
+  while (lister->GetNextBlock(entries))
+  {
+    for (const DirectoryEntry& entry : entries)
+    {
+      if (entry.isDirectory)
+      {
+        result.directories += 1;
+        WalkNames(directory / PathName(entry.name), result);
+      }
+      else
+      {
+        result.files += 1;
+      }
+    }
+  }
+}
+
+void Report(const string& what, const WalkResult& result, chrono::steady_clock::time_point start)
+{
+  auto elapsed = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+  size_t n = result.files + result.directories;
+  cout << what << ": " << n << " entries in " << elapsed / 1000 << "ms (" << elapsed * 1000 / n << "ns per entry)" << endl;
+}
+
+// create a tree with 20,000 files
+BEGIN_TEST_FUNCTION(1);
+{
+  for (int i = 0; i < DIRECTORIES; ++i)
+  {
+    PathName directory = PathName("tree") / PathName(to_string(i));
+    TESTX(Directory::Create(directory));
+    for (int j = 0; j < FILES; ++j)
+    {
+      TESTX(File::WriteBytes(directory / PathName(to_string(j) + ".tex"), vector<unsigned char>(j % 7, 'x')));
+    }
+  }
+}
+END_TEST_FUNCTION();
+
+// walk the tree entry by entry and block by block
+BEGIN_TEST_FUNCTION(2);
+{
+  size_t bytes = 0;
+  for (int j = 0; j < FILES; ++j)
+  {
+    bytes += j % 7;
+  }
+  bytes *= DIRECTORIES;
+  auto start = chrono::steady_clock::now();
+  WalkResult entries;
+  TESTX(WalkEntries(PathName("tree"), entries));
+  Report("entries", entries, start);
+  TEST(entries.directories == DIRECTORIES && entries.files == DIRECTORIES * FILES && entries.bytes == bytes);
+  start = chrono::steady_clock::now();
+  WalkResult blocks;
+  TESTX(WalkBlocks(PathName("tree"), blocks));
+  Report("blocks", blocks, start);
+  TEST(blocks.directories == DIRECTORIES && blocks.files == DIRECTORIES * FILES && blocks.bytes == bytes);
+  start = chrono::steady_clock::now();
+  WalkResult names;
+  TESTX(WalkNames(PathName("tree"), names));
+  Report("names", names, start);
+  TEST(names.directories == DIRECTORIES && names.files == DIRECTORIES * FILES);
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(3);
+{
+  TESTX(Directory::Delete(PathName("tree"), true));
+  TEST(!Directory::Exists(PathName("tree")));
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_PROGRAM();
+{
+  CALL_TEST_FUNCTION(1);
+  CALL_TEST_FUNCTION(2);
+  CALL_TEST_FUNCTION(3);
+}
+END_TEST_PROGRAM();
+
+END_TEST_SCRIPT();
+
+RUN_TEST_SCRIPT();
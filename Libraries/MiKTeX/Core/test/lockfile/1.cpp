@@ -95,12 +95,35 @@ BEGIN_TEST_FUNCTION(4);
 }
 END_TEST_FUNCTION();
 
+BEGIN_TEST_FUNCTION(5);
+{
+  unique_ptr<MiKTeX::Core::LockFile> reader1 = LockFile::Create(PathName("lockfile-1-5"));
+  unique_ptr<MiKTeX::Core::LockFile> reader2 = LockFile::Create(PathName("lockfile-1-5"));
+  unique_ptr<MiKTeX::Core::LockFile> writer = LockFile::Create(PathName("lockfile-1-5"));
+  TEST(reader1->TryLock(File::LockType::Shared, 0s));
+  TEST(reader2->TryLock(File::LockType::Shared, 0s));
+  TEST(!writer->TryLock(0s));
+  reader1->Unlock();
+  TEST(File::Exists(PathName("lockfile-1-5")));
+  TEST(!writer->TryLock(100ms));
+  reader2->Unlock();
+  TEST(!File::Exists(PathName("lockfile-1-5")));
+  TEST(writer->TryLock(0s));
+  TEST(!reader1->TryLock(File::LockType::Shared, 0s));
+  writer->Unlock();
+  TEST(!File::Exists(PathName("lockfile-1-5")));
+}
+END_TEST_FUNCTION();
+
 BEGIN_TEST_PROGRAM();
 {
   CALL_TEST_FUNCTION(1);
   CALL_TEST_FUNCTION(2);
   CALL_TEST_FUNCTION(3);
   CALL_TEST_FUNCTION(4);
+#if !defined(MIKTEX_WINDOWS)
+  CALL_TEST_FUNCTION(5);
+#endif
 }
 END_TEST_PROGRAM();
 
@@ -0,0 +1,80 @@
+/* 2-1.cpp:
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+   
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+
+#include <miktex/Core/File>
+#include <miktex/Core/LockFile>
+#include <miktex/Core/PathName>
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+
+// a contending child: reads the counter under a shared lock and
+// increments it under an exclusive lock; every other acquisition has
+// a timeout, as in production code
+int main(int argc, char** argv)
+{
+  long n = argc > 1 ? strtol(argv[1], nullptr, 10) : 0;
+  try
+  {
+    for (long i = 0; i < n; ++i)
+    {
+      File::LockType lockType = i % 4 == 0 ? File::LockType::Shared : File::LockType::Exclusive;
+      unique_ptr<LockFile> lockFile = LockFile::Create(PathName("lockfile-2"));
+      chrono::milliseconds timeout = i % 2 == 0 ? chrono::milliseconds::max() : chrono::milliseconds(chrono::seconds(60));
+      if (!lockFile->TryLock(lockType, timeout))
+      {
+        return 1;
+      }
+      FILE* file = fopen("lockfile-2.counter", "r+");
+      if (file == nullptr)
+      {
+        return 1;
+      }
+      long counter;
+      bool ok = fscanf(file, "%ld", &counter) == 1;
+      if (ok && lockType == File::LockType::Exclusive)
+      {
+        rewind(file);
+        ok = fprintf(file, "%ld\n", counter + 1) > 0;
+      }
+      ok = fclose(file) == 0 && ok;
+      lockFile->Unlock();
+      if (!ok)
+      {
+        return 1;
+      }
+    }
+  }
+  catch (const exception&)
+  {
+    return 1;
+  }
+  return 0;
+}
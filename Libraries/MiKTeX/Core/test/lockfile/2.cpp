@@ -0,0 +1,88 @@
+/* 2.cpp:
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <miktex/Core/Test>
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <miktex/Core/File>
+#include <miktex/Core/PathName>
+#include <miktex/Core/Paths>
+#include <miktex/Core/Process>
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Test;
+
+BEGIN_TEST_SCRIPT("lockfile-2");
+
+// 16 processes contend for one lock: every fourth acquisition is
+// shared, the others are exclusive and increment a counter
+BEGIN_TEST_FUNCTION(1);
+{
+  const int N = 16;
+  const int M = 200;
+  PathName pathExe = pSession->GetMyLocation(false);
+  pathExe /= "core_lockfile_test2-1" MIKTEX_EXE_FILE_SUFFIX;
+  FILE* file = fopen("lockfile-2.counter", "w");
+  TEST(file != nullptr && fputs("0\n", file) >= 0 && fclose(file) == 0);
+  auto start = chrono::steady_clock::now();
+  vector<unique_ptr<Process>> children;
+  for (int i = 0; i < N; ++i)
+  {
+    ProcessStartInfo startInfo;
+    startInfo.FileName = pathExe.ToString();
+    startInfo.Arguments = { pathExe.ToString(), std::to_string(M) };
+    children.push_back(Process::Start(startInfo));
+  }
+  for (const unique_ptr<Process>& child : children)
+  {
+    child->WaitForExit();
+    TEST(child->get_ExitCode() == 0);
+  }
+  auto elapsed = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+  cout << "contention: " << N * M << " acquisitions by " << N << " processes in " << elapsed / 1000 << "ms (" << elapsed / (N * M) << "us per acquisition)" << endl;
+  long counter = -1;
+  file = fopen("lockfile-2.counter", "r");
+  TEST(file != nullptr && fscanf(file, "%ld", &counter) == 1 && fclose(file) == 0);
+  TEST(counter == N * (M - (M + 3) / 4));
+  TEST(!File::Exists(PathName("lockfile-2")));
+  TESTX(File::Delete(PathName("lockfile-2.counter")));
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_PROGRAM();
+{
+  CALL_TEST_FUNCTION(1);
+}
+END_TEST_PROGRAM();
+
+END_TEST_SCRIPT();
+
+RUN_TEST_SCRIPT();
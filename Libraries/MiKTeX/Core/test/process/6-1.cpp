@@ -0,0 +1,38 @@
+/* 6-1.cpp:
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+   
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+
+#include <cstdio>
+#include <cstdlib>
+
+// a trivial child: writes the requested number of bytes to stdout
+int main(int argc, char** argv)
+{
+  long n = argc > 1 ? strtol(argv[1], nullptr, 10) : 0;
+  for (long i = 0; i < n; ++i)
+  {
+    if (putchar('0' + i % 10) == EOF)
+    {
+      return 1;
+    }
+  }
+  return fflush(stdout) == 0 ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+/* 6.cpp:
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+   
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+
+#include "config.h"
+
+#include <string>
+
+#include <miktex/Core/Test>
+
+#include <miktex/Core/Paths>
+#include <miktex/Core/Process>
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Test;
+using namespace std;
+
+BEGIN_TEST_SCRIPT("process-6");
+
+class CountingOutput :
+  public IRunProcessCallback
+{
+public:
+  bool MIKTEXTHISCALL OnProcessOutput(const void* bytes, size_t nBytes) override
+  {
+    const char* p = reinterpret_cast<const char*>(bytes);
+    for (size_t i = 0; i < nBytes; ++i)
+    {
+      if (p[i] != '0' + total % 10)
+      {
+        ok = false;
+      }
+      ++total;
+    }
+    return true;
+  }
+public:
+  size_t total = 0;
+public:
+  bool ok = true;
+};
+
+PathName GetChild(shared_ptr<Session> session)
+{
+  PathName pathExe = session->GetMyLocation(false);
+  pathExe /= "core_process_test6-1" MIKTEX_EXE_FILE_SUFFIX;
+  return pathExe;
+}
+
+// launch children and capture their output
+BEGIN_TEST_FUNCTION(1);
+{
+  PathName pathExe = GetChild(pSession);
+  for (int i = 0; i < 10; ++i)
+  {
+    CountingOutput output;
+    int exitCode;
+    TEST(Process::Run(pathExe, { pathExe.ToString(), std::to_string(i * 100) }, &output, &exitCode, nullptr));
+    TEST(exitCode == 0);
+    TEST(output.ok && output.total == i * 100);
+  }
+}
+END_TEST_FUNCTION();
+
+// capture output which exceeds the pipe buffer
+BEGIN_TEST_FUNCTION(2);
+{
+  PathName pathExe = GetChild(pSession);
+  CountingOutput output;
+  int exitCode;
+  TEST(Process::Run(pathExe, { pathExe.ToString(), "4000000" }, &output, &exitCode, nullptr));
+  TEST(exitCode == 0);
+  TEST(output.ok && output.total == 4000000);
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_PROGRAM();
+{
+  CALL_TEST_FUNCTION(1);
+  CALL_TEST_FUNCTION(2);
+}
+END_TEST_PROGRAM();
+
+END_TEST_SCRIPT();
+
+RUN_TEST_SCRIPT();
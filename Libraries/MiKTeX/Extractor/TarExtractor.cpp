@@ -1,6 +1,6 @@
 /* TarExtractor.cpp:
 
-   Copyright (C) 2001-2018 Christian Schenk
+   Copyright (C) 2001-2020 Christian Schenk
 
    This file is part of MiKTeX Extractor.
 
@@ -21,6 +21,11 @@
 
 #include "config.h"
 
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <unordered_set>
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
@@ -31,6 +36,7 @@
 #include "internal.h"
 
 #include "TarExtractor.h"
+#include "WriteBehind.h"
 
 using namespace std;
 
@@ -41,6 +47,14 @@ using namespace MiKTeX::Util;
 
 const size_t BLOCKSIZE = 512;
 
+// files up to this size are handed over to the write-behind workers
+const size_t MAX_WRITE_BEHIND_FILE_SIZE = 4 * 1024 * 1024;
+
+// the amount of file data the workers may lag behind
+const size_t MAX_WRITE_BEHIND_BYTES = 32 * 1024 * 1024;
+
+const unsigned MAX_WRITE_BEHIND_WORKERS = 4;
+
 struct Header
 {
 private:
@@ -308,6 +322,7 @@ void TarExtractor::Extract(Stream* streamIn_, const PathName& destDir, bool make
   {
     streamIn = streamIn_;
     totalBytesRead = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
 
     traceStream->WriteLine(TRACE_FACILITY, fmt::format(T_("extracting to {0} ({1})"), Q_(destDir), (makeDirectories ? T_("make directories") : T_("don't make directories"))));
 
@@ -315,12 +330,17 @@ void TarExtractor::Extract(Stream* streamIn_, const PathName& destDir, bool make
     Header header;
     size_t prefixLen = prefix.length();
     unsigned fileCount = 0;
+    size_t totalFileSize = 0;
 
     bool checkHeader = true;
 
     CharBuffer<char> buffer;
     buffer.Reserve(1024 * 1024);
 
+    WriteBehind writeBehind(max(1u, min(thread::hardware_concurrency(), MAX_WRITE_BEHIND_WORKERS)), MAX_WRITE_BEHIND_BYTES);
+
+    unordered_set<PathName> directories;
+
     while ((len = Read(&header, sizeof(header))) > 0)
     {
       // read next header
@@ -397,32 +417,52 @@ void TarExtractor::Extract(Stream* streamIn_, const PathName& destDir, bool make
       }
 
       // create the destination directory
-      Directory::Create(PathName(path).RemoveFileSpec());
-
-      // remove the existing file
-      if (File::Exists(path))
+      PathName dir = PathName(path).RemoveFileSpec();
+      if (directories.insert(dir).second)
       {
-        File::Delete(path, { FileDeleteOption::TryHard });
+        Directory::Create(dir);
       }
 
       // extract the file
-      FileStream streamOut(File::Open(path, FileMode::Create, FileAccess::Write, false));
+      time_t time = header.GetLastModificationTime();
       size_t bytesRead = 0;
-      while (bytesRead < size)
+      if (size <= MAX_WRITE_BEHIND_FILE_SIZE)
       {
-        size_t remaining = size - bytesRead;
-        size_t n = (remaining > buffer.GetCapacity() ? buffer.GetCapacity() : remaining);
-        if (Read(buffer.GetData(), n) != n)
+        vector<char> data(size);
+        if (size > 0 && Read(data.data(), size) != size)
         {
           MIKTEX_UNEXPECTED();
         }
-        streamOut.Write(buffer.GetData(), n);
-        bytesRead += n;
+        bytesRead = size;
+        writeBehind.Submit(path, move(data), time);
+      }
+      else
+      {
+        writeBehind.WaitFor(path);
+        if (File::Exists(path))
+        {
+          File::Delete(path, { FileDeleteOption::TryHard });
+        }
+        FileStream streamOut(File::Open(path, FileMode::Create, FileAccess::Write, false));
+        while (bytesRead < size)
+        {
+          size_t remaining = size - bytesRead;
+          size_t n = (remaining > buffer.GetCapacity() ? buffer.GetCapacity() : remaining);
+          if (Read(buffer.GetData(), n) != n)
+          {
+            MIKTEX_UNEXPECTED();
+          }
+          streamOut.Write(buffer.GetData(), n);
+          bytesRead += n;
+        }
+        if (fflush(streamOut.GetFile()) != 0)
+        {
+          MIKTEX_FATAL_CRT_ERROR_2("fflush", "path", path.ToString());
+        }
+        // set time when the file was created
+        File::SetTimes(streamOut.GetFile(), time, time, time);
+        streamOut.Close();
       }
-      // set time when the file was created
-      time_t time = header.GetLastModificationTime();
-      File::SetTimes(streamOut.GetFile(), time, time, time);
-      streamOut.Close();
 
       // skip extra bytes
       if (bytesRead % sizeof(Header) > 0)
@@ -431,6 +471,7 @@ void TarExtractor::Extract(Stream* streamIn_, const PathName& destDir, bool make
       }
 
       fileCount += 1;
+      totalFileSize += size;
 
 #if 0
       // set file attributes
@@ -444,7 +485,11 @@ void TarExtractor::Extract(Stream* streamIn_, const PathName& destDir, bool make
       }
     }
 
+    writeBehind.Finish();
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
     traceStream->WriteLine(TRACE_FACILITY, fmt::format(T_("extracted {0} file(s)"), fileCount));
+    traceStream->WriteLine(TRACE_FACILITY, fmt::format(T_("{0} bytes in {1:.3f} seconds ({2:.1f} MB/s, {3:.0f} files/s)"), totalFileSize, seconds, seconds > 0 ? totalFileSize / seconds / 1000000 : 0.0, seconds > 0 ? fileCount / seconds : 0.0));
   }
   catch (const exception&)
   {
@@ -0,0 +1,174 @@
+/* WriteBehind.cpp: write extracted files on worker threads
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of MiKTeX Extractor.
+
+   MiKTeX Extractor is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   MiKTeX Extractor is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with MiKTeX Extractor; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA. */
+
+#include "config.h"
+
+#include <cstdio>
+
+#include <miktex/Core/File>
+#include <miktex/Core/FileStream>
+#include <miktex/Core/Session>
+
+#include "internal.h"
+
+#include "WriteBehind.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+
+WriteBehind::WriteBehind(unsigned numWorkers, size_t maxPendingBytes) :
+  maxPendingBytes(maxPendingBytes)
+{
+  for (unsigned i = 0; i < numWorkers; ++i)
+  {
+    workers.push_back(thread(&WriteBehind::Work, this));
+  }
+}
+
+WriteBehind::~WriteBehind()
+{
+  Stop();
+}
+
+void WriteBehind::Submit(const PathName& path, vector<char>&& data, time_t time)
+{
+  unique_lock<mutex> lock(mtx);
+  // a file larger than the limit is accepted when nothing else is pending
+  jobDone.wait(lock, [this, &path, &data]() {
+    return error != nullptr
+      || (pendingPaths.find(path) == pendingPaths.end() && (pendingBytes == 0 || pendingBytes + data.size() <= maxPendingBytes));
+  });
+  ThrowIfFailed();
+  pendingBytes += data.size();
+  pendingPaths.insert(path);
+  jobs.push_back(Job{ path, move(data), time });
+  lock.unlock();
+  jobAvailable.notify_one();
+}
+
+void WriteBehind::WaitFor(const PathName& path)
+{
+  unique_lock<mutex> lock(mtx);
+  jobDone.wait(lock, [this, &path]() { return pendingPaths.find(path) == pendingPaths.end(); });
+  ThrowIfFailed();
+}
+
+void WriteBehind::Finish()
+{
+  unique_lock<mutex> lock(mtx);
+  jobDone.wait(lock, [this]() { return pendingPaths.empty(); });
+  ThrowIfFailed();
+}
+
+void WriteBehind::WriteFile(const PathName& path, const void* data, size_t size, time_t time)
+{
+  // remove the existing file
+  if (File::Exists(path))
+  {
+    File::Delete(path, { FileDeleteOption::TryHard });
+  }
+  FileStream streamOut(File::Open(path, FileMode::Create, FileAccess::Write, false));
+  if (size > 0)
+  {
+    streamOut.Write(data, size);
+  }
+  // flush first: writing the buffer would touch the file again
+  if (fflush(streamOut.GetFile()) != 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR_2("fflush", "path", path.ToString());
+  }
+  // set time when the file was created
+  File::SetTimes(streamOut.GetFile(), time, time, time);
+  streamOut.Close();
+}
+
+void WriteBehind::Work()
+{
+  while (true)
+  {
+    Job job;
+    bool skip;
+    {
+      unique_lock<mutex> lock(mtx);
+      jobAvailable.wait(lock, [this]() { return stopping || !jobs.empty(); });
+      if (jobs.empty())
+      {
+        return;
+      }
+      job = move(jobs.front());
+      jobs.pop_front();
+      // after the first error, the remaining files are dropped
+      skip = error != nullptr;
+    }
+    exception_ptr jobError;
+    if (!skip)
+    {
+      try
+      {
+        WriteFile(job.path, job.data.data(), job.data.size(), job.time);
+      }
+      catch (const exception&)
+      {
+        jobError = current_exception();
+      }
+    }
+    {
+      lock_guard<mutex> lock(mtx);
+      pendingBytes -= job.data.size();
+      pendingPaths.erase(job.path);
+      if (jobError != nullptr && error == nullptr)
+      {
+        error = jobError;
+      }
+    }
+    jobDone.notify_all();
+  }
+}
+
+void WriteBehind::Stop()
+{
+  {
+    lock_guard<mutex> lock(mtx);
+    stopping = true;
+    // we get here without Finish() if the extraction has failed
+    for (const Job& job : jobs)
+    {
+      pendingBytes -= job.data.size();
+      pendingPaths.erase(job.path);
+    }
+    jobs.clear();
+  }
+  jobAvailable.notify_all();
+  for (thread& worker : workers)
+  {
+    worker.join();
+  }
+  workers.clear();
+}
+
+void WriteBehind::ThrowIfFailed()
+{
+  if (error != nullptr)
+  {
+    rethrow_exception(error);
+  }
+}
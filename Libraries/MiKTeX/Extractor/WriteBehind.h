@@ -0,0 +1,133 @@
+/* WriteBehind.h:                                       -*- C++ -*-
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of MiKTeX Extractor.
+
+   MiKTeX Extractor is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   MiKTeX Extractor is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with MiKTeX Extractor; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA. */
+
+#pragma once
+
+#if !defined(C5E2A1F4B8D34E6A9F07B1D2E3C4A5F6)
+#define C5E2A1F4B8D34E6A9F07B1D2E3C4A5F6
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <ctime>
+
+#include <miktex/Core/PathName>
+
+BEGIN_INTERNAL_NAMESPACE;
+
+// Writes extracted files on worker threads, so that the extractor can
+// go on decoding the archive while files are created.  The memory held
+// by pending files is bounded; a file which is still pending is not
+// written a second time before the first write has completed.
+class WriteBehind
+{
+public:
+  WriteBehind(unsigned numWorkers, std::size_t maxPendingBytes);
+
+public:
+  WriteBehind(const WriteBehind& other) = delete;
+
+public:
+  WriteBehind& operator=(const WriteBehind& other) = delete;
+
+public:
+  WriteBehind(WriteBehind&& other) = delete;
+
+public:
+  WriteBehind& operator=(WriteBehind&& other) = delete;
+
+public:
+  ~WriteBehind();
+
+  // queues a file; blocks while too much data is pending; rethrows the
+  // first error of a worker
+public:
+  void Submit(const MiKTeX::Core::PathName& path, std::vector<char>&& data, time_t time);
+
+  // waits until a pending write of the file has completed
+public:
+  void WaitFor(const MiKTeX::Core::PathName& path);
+
+  // waits until all files have been written; rethrows the first error of
+  // a worker
+public:
+  void Finish();
+
+public:
+  static void WriteFile(const MiKTeX::Core::PathName& path, const void* data, std::size_t size, time_t time);
+
+private:
+  struct Job
+  {
+    MiKTeX::Core::PathName path;
+    std::vector<char> data;
+    time_t time;
+  };
+
+private:
+  void Work();
+
+private:
+  void Stop();
+
+private:
+  void ThrowIfFailed();
+
+private:
+  std::size_t maxPendingBytes;
+
+private:
+  std::size_t pendingBytes = 0;
+
+private:
+  std::deque<Job> jobs;
+
+private:
+  std::unordered_set<MiKTeX::Core::PathName> pendingPaths;
+
+private:
+  std::vector<std::thread> workers;
+
+private:
+  std::mutex mtx;
+
+private:
+  std::condition_variable jobAvailable;
+
+private:
+  std::condition_variable jobDone;
+
+private:
+  bool stopping = false;
+
+private:
+  std::exception_ptr error;
+};
+
+END_INTERNAL_NAMESPACE;
+
+#endif
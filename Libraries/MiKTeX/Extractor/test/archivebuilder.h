@@ -0,0 +1,91 @@
+/* archivebuilder.h: build tar archives for testing
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of MiKTeX Extractor.
+
+   MiKTeX Extractor is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   MiKTeX Extractor is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with MiKTeX Extractor; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA. */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <miktex/Core/PathName>
+
+// the modification time of all archive members
+const time_t MTIME = 1577836800;
+
+// builds a ustar archive which looks like a package archive: many
+// small files spread over a few directories, and a few large ones
+class ArchiveBuilder
+{
+public:
+  void AddFile(const std::string& name, size_t size)
+  {
+    char header[512] = { 0 };
+    memcpy(header, name.c_str(), std::min(name.length(), size_t(99)));
+    sprintf(header + 100, "%07o", 0644);
+    sprintf(header + 108, "%07o", 0);
+    sprintf(header + 116, "%07o", 0);
+    sprintf(header + 124, "%011lo", static_cast<unsigned long>(size));
+    sprintf(header + 136, "%011lo", static_cast<unsigned long>(MTIME));
+    header[156] = '0';
+    memcpy(header + 257, "ustar", 6);
+    memcpy(header + 263, "00", 2);
+    memset(header + 148, ' ', 8);
+    unsigned checkSum = 0;
+    for (size_t i = 0; i < sizeof(header); ++i)
+    {
+      checkSum += static_cast<unsigned char>(header[i]);
+    }
+    sprintf(header + 148, "%06o", checkSum);
+    data.insert(data.end(), header, header + sizeof(header));
+    for (size_t i = 0; i < size; ++i)
+    {
+      data.push_back(ContentAt(name, i));
+    }
+    data.resize((data.size() + 511) / 512 * 512, 0);
+  }
+
+  // the byte at offset i of the member name
+public:
+  static char ContentAt(const std::string& name, size_t i)
+  {
+    return static_cast<char>('a' + (i + name.length()) % 26);
+  }
+
+public:
+  void Save(const MiKTeX::Core::PathName& path)
+  {
+    data.resize(data.size() + 1024, 0);
+    std::ofstream stream(path.ToString(), std::ios::binary);
+    stream.write(data.data(), data.size());
+    if (!stream)
+    {
+      throw std::runtime_error("cannot write " + path.ToString());
+    }
+  }
+
+private:
+  std::vector<char> data;
+};
@@ -0,0 +1,119 @@
+/* extractbench.cpp: measure tar extraction
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of MiKTeX Extractor.
+
+   MiKTeX Extractor is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   MiKTeX Extractor is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with MiKTeX Extractor; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA. */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/Exceptions>
+#include <miktex/Core/File>
+#include <miktex/Extractor/Extractor>
+
+#include "archivebuilder.h"
+
+using namespace std;
+using namespace std::chrono;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Extractor;
+
+int main(int argc, char* argv[])
+{
+  int numFiles = argc > 1 ? atoi(argv[1]) : 5000;
+  if (numFiles < 1 || argc > 3)
+  {
+    cerr << "usage: " << argv[0] << " [FILES [DIR]]" << endl;
+    return 1;
+  }
+  try
+  {
+    PathName workDir(argc > 2 ? argv[2] : "extractbench");
+    Directory::Create(workDir);
+    PathName archivePath = workDir / PathName("synthetic.tar");
+    PathName destDir = workDir / PathName("texmf");
+
+    // sizes from 100 bytes to about 16 KB, and every 500th file is 2 MB
+    ArchiveBuilder builder;
+    size_t totalSize = 0;
+    srand(1);
+    for (int i = 0; i < numFiles; ++i)
+    {
+      size_t size = i % 500 == 499 ? 2 * 1024 * 1024 : 100 + rand() % (16 * 1024);
+      builder.AddFile("tex/latex/package" + to_string(i % 50) + "/file" + to_string(i) + ".sty", size);
+      totalSize += size;
+    }
+    builder.Save(archivePath);
+
+    unique_ptr<Extractor> extractor = Extractor::CreateExtractor(ArchiveFileType::Tar);
+    duration<double> best = duration<double>::max();
+    const int runs = 3;
+    for (int run = 0; run < runs; ++run)
+    {
+      if (Directory::Exists(destDir))
+      {
+        Directory::Delete(destDir, true);
+      }
+      auto start = steady_clock::now();
+      extractor->Extract(archivePath, destDir, true);
+      best = min(best, duration<double>(steady_clock::now() - start));
+    }
+
+    // spot-check the result
+    for (int i : { 0, numFiles / 2, numFiles - 1 })
+    {
+      PathName path = destDir / PathName("tex/latex/package" + to_string(i % 50)) / PathName("file" + to_string(i) + ".sty");
+      if (File::GetLastWriteTime(path) != MTIME)
+      {
+        cerr << path << ": wrong modification time" << endl;
+        return 1;
+      }
+    }
+
+    cout << fixed << setprecision(3)
+      << "files:   " << numFiles << "\n"
+      << "bytes:   " << totalSize << "\n"
+      << "time:    " << best.count() * 1000 << " ms (best of " << runs << ")" << "\n"
+      << "rate:    " << totalSize / best.count() / (1024 * 1024) << " MiB/s" << "\n"
+      << "files/s: " << numFiles / best.count() << endl;
+    return 0;
+  }
+  catch (const MiKTeXException& ex)
+  {
+    cerr << ex.GetErrorMessage() << endl;
+    return 1;
+  }
+  catch (const exception& ex)
+  {
+    cerr << ex.what() << endl;
+    return 1;
+  }
+}
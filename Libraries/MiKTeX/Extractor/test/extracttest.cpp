@@ -0,0 +1,140 @@
+/* extracttest.cpp: test tar extraction
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of MiKTeX Extractor.
+
+   MiKTeX Extractor is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   MiKTeX Extractor is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with MiKTeX Extractor; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA. */
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/Exceptions>
+#include <miktex/Core/File>
+#include <miktex/Extractor/Extractor>
+
+#include "archivebuilder.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Extractor;
+
+// checks the contents and the modification time of an extracted file
+bool Check(const PathName& destDir, const string& name, size_t size)
+{
+  PathName path = destDir / PathName(name);
+  vector<unsigned char> bytes = File::ReadAllBytes(path);
+  if (bytes.size() != size)
+  {
+    cerr << path << ": expected " << size << " bytes, got " << bytes.size() << endl;
+    return false;
+  }
+  for (size_t i = 0; i < size; ++i)
+  {
+    if (bytes[i] != static_cast<unsigned char>(ArchiveBuilder::ContentAt(name, i)))
+    {
+      cerr << path << ": wrong contents at offset " << i << endl;
+      return false;
+    }
+  }
+  if (File::GetLastWriteTime(path) != MTIME)
+  {
+    cerr << path << ": wrong modification time" << endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc > 2)
+  {
+    cerr << "usage: " << argv[0] << " [DIR]" << endl;
+    return 1;
+  }
+  try
+  {
+    PathName workDir(argc > 1 ? argv[1] : "extracttest");
+    if (Directory::Exists(workDir))
+    {
+      Directory::Delete(workDir, true);
+    }
+    Directory::Create(workDir);
+    PathName archivePath = workDir / PathName("test.tar");
+    PathName destDir = workDir / PathName("texmf");
+
+    // small files are written behind, files larger than 4 MB inline;
+    // the 3 MB files exceed the limit of pending data
+    ArchiveBuilder builder;
+    map<string, size_t> expected;
+    auto add = [&builder, &expected](const string& name, size_t size) {
+      builder.AddFile(name, size);
+      expected[name] = size;
+    };
+    srand(1);
+    for (int i = 0; i < 500; ++i)
+    {
+      add("tex/latex/package" + to_string(i % 20) + "/file" + to_string(i) + ".sty", rand() % (16 * 1024));
+    }
+    add("tex/latex/empty/empty.sty", 0);
+    for (int i = 0; i < 12; ++i)
+    {
+      add("fonts/type1/large" + to_string(i) + ".pfb", 3 * 1024 * 1024);
+    }
+    add("fonts/opentype/huge.otf", 5 * 1024 * 1024 + 17);
+    // members which replace earlier ones of the same path: one is
+    // written inline, one behind
+    add("tex/latex/package0/file0.sty", 6 * 1024 * 1024);
+    add("tex/latex/package1/file1.sty", 1000);
+    builder.Save(archivePath);
+
+    unique_ptr<Extractor> extractor = Extractor::CreateExtractor(ArchiveFileType::Tar);
+    extractor->Extract(archivePath, destDir, true);
+
+    int failures = 0;
+    for (const auto& member : expected)
+    {
+      if (!Check(destDir, member.first, member.second))
+      {
+        failures += 1;
+      }
+    }
+    if (failures > 0)
+    {
+      cerr << failures << " of " << expected.size() << " files are wrong" << endl;
+      return 1;
+    }
+    Directory::Delete(workDir, true);
+    return 0;
+  }
+  catch (const MiKTeXException& ex)
+  {
+    cerr << ex.GetErrorMessage() << endl;
+    return 1;
+  }
+  catch (const exception& ex)
+  {
+    cerr << ex.what() << endl;
+    return 1;
+  }
+}
@@ -0,0 +1,237 @@
+/* FileDigestCache.cpp:
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of MiKTeX Package Manager.
+
+   MiKTeX Package Manager is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   MiKTeX Package Manager is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with MiKTeX Package Manager; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <ctime>
+#include <atomic>
+#include <fstream>
+#include <future>
+#include <sstream>
+#include <thread>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+
+#include "internal.h"
+
+#include "FileDigestCache.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+
+using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
+
+#define CACHE_HEADER "# MiKTeX file digest cache 1"
+
+void FileDigestCache::Load(const PathName& path)
+{
+  this->path = path;
+  loaded = true;
+  modified = false;
+  entries.clear();
+  time_t cacheTime;
+  if (!File::TryGetLastWriteTime(path, cacheTime))
+  {
+    return;
+  }
+  ifstream stream = File::CreateInputStream(path);
+  string line;
+  if (!getline(stream, line) || line != CACHE_HEADER)
+  {
+    // unknown format: start from scratch
+    modified = true;
+    return;
+  }
+  // <digest> <size> <mtime> <ctime> <serial> <path>
+  while (getline(stream, line))
+  {
+    istringstream fields(line);
+    string digest;
+    Entry entry;
+    if (!(fields >> digest >> entry.status.size >> entry.status.lastWriteTime >> entry.status.statusChangeTime >> entry.status.serialNumber) || fields.get() != ' ')
+    {
+      modified = true;
+      continue;
+    }
+    string fileName;
+    if (!getline(fields, fileName) || fileName.empty() || digest.length() != 2 * entry.digest.size())
+    {
+      modified = true;
+      continue;
+    }
+    entry.digest = MD5::Parse(digest);
+    entry.racy = entry.status.lastWriteTime >= cacheTime;
+    entries[fileName] = entry;
+  }
+}
+
+void FileDigestCache::Save()
+{
+  if (!loaded || !modified)
+  {
+    return;
+  }
+  WriteFileAtomically(path, ios_base::out, [this](ostream& stream)
+  {
+    stream << CACHE_HEADER << "\n";
+    for (const auto& kv : entries)
+    {
+      const Entry& entry = kv.second;
+      // the time stamp of the cache file can't tell whether the file
+      // was modified after the digest was calculated
+      if (entry.racy)
+      {
+        continue;
+      }
+      stream << entry.digest << " " << entry.status.size << " " << entry.status.lastWriteTime << " " << entry.status.statusChangeTime << " " << entry.status.serialNumber << " " << kv.first << "\n";
+    }
+  });
+  modified = false;
+}
+
+bool FileDigestCache::TryGetFileDigest(const PathName& path, MD5& digest)
+{
+  MIKTEX_ASSERT(loaded);
+  FileStatus status;
+  string key = path.ToString();
+  if (!TryGetFileStatus(path, status))
+  {
+    if (entries.erase(key) > 0)
+    {
+      modified = true;
+    }
+    return false;
+  }
+  if (!TryGetCachedDigest(key, status, digest))
+  {
+    time_t digestTime = time(nullptr);
+    digest = MD5::FromFile(path);
+    Put(key, status, digest, digestTime);
+  }
+  return true;
+}
+
+void FileDigestCache::Prefetch(const vector<PathName>& paths)
+{
+  MIKTEX_ASSERT(loaded);
+  struct Job
+  {
+    PathName path;
+    FileStatus status;
+    MD5 digest;
+    bool done = false;
+  };
+  vector<Job> jobs;
+  MD5 digest;
+  for (const PathName& path : paths)
+  {
+    Job job;
+    if (TryGetFileStatus(path, job.status) && !TryGetCachedDigest(path.ToString(), job.status, digest))
+    {
+      job.path = path;
+      jobs.push_back(job);
+    }
+  }
+  if (jobs.empty())
+  {
+    return;
+  }
+  time_t digestTime = time(nullptr);
+  size_t numWorkers = min(static_cast<size_t>(max(thread::hardware_concurrency(), 1u)), jobs.size());
+  atomic_size_t nextJob(0);
+  vector<future<void>> workers;
+  for (size_t w = 0; w < numWorkers; ++w)
+  {
+    workers.push_back(async(launch::async, [&jobs, &nextJob]()
+    {
+      for (size_t j = nextJob++; j < jobs.size(); j = nextJob++)
+      {
+        try
+        {
+          jobs[j].digest = MD5::FromFile(jobs[j].path);
+          jobs[j].done = true;
+        }
+        catch (const exception&)
+        {
+          // will be reported when the digest is requested
+        }
+      }
+    }));
+  }
+  for (future<void>& worker : workers)
+  {
+    worker.get();
+  }
+  for (const Job& job : jobs)
+  {
+    if (job.done)
+    {
+      Put(job.path.ToString(), job.status, job.digest, digestTime);
+    }
+  }
+}
+
+bool FileDigestCache::TryGetFileStatus(const PathName& path, FileStatus& status)
+{
+#if defined(MIKTEX_WINDOWS)
+  struct _stat64 statbuf;
+  if (_wstat64(path.ToExtendedLengthPathName().ToWideCharString().c_str(), &statbuf) != 0)
+  {
+    return false;
+  }
+#else
+  struct stat statbuf;
+  if (stat(path.GetData(), &statbuf) != 0)
+  {
+    return false;
+  }
+#endif
+  status.size = statbuf.st_size;
+  status.lastWriteTime = statbuf.st_mtime;
+  status.statusChangeTime = statbuf.st_ctime;
+  status.serialNumber = statbuf.st_ino;
+  return true;
+}
+
+bool FileDigestCache::TryGetCachedDigest(const string& key, const FileStatus& status, MD5& digest) const
+{
+  auto it = entries.find(key);
+  if (it == entries.end() || it->second.racy || !(it->second.status == status))
+  {
+    return false;
+  }
+  digest = it->second.digest;
+  return true;
+}
+
+void FileDigestCache::Put(const string& key, const FileStatus& status, const MD5& digest, time_t digestTime)
+{
+  entries[key] = { status, digest, status.lastWriteTime >= digestTime };
+  modified = true;
+}
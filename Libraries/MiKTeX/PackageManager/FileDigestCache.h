@@ -0,0 +1,125 @@
+/* FileDigestCache.h:                                   -*- C++ -*-
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of MiKTeX Package Manager.
+
+   MiKTeX Package Manager is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   MiKTeX Package Manager is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with MiKTeX Package Manager; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#pragma once
+
+#if !defined(E3F0C1A7B25D4C6E9A8D7F5B4C3E2A10)
+#define E3F0C1A7B25D4C6E9A8D7F5B4C3E2A10
+
+#include <cstdint>
+#include <ctime>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <miktex/Core/MD5>
+#include <miktex/Core/PathName>
+
+#include "internal.h"
+
+MPM_INTERNAL_BEGIN_NAMESPACE;
+
+/// @brief A persistent cache of file digests.
+///
+/// A cached digest remains valid as long as the size, the
+/// modification time, the status change time and the file serial
+/// number of the file are unchanged.  Time stamps have a resolution
+/// of one second: a digest is not trusted if the file was modified
+/// in the second in which the digest was calculated or later.
+class FileDigestCache
+{
+  /// Reads the cache file, if it exists.
+  /// @param path Path to the cache file.
+public:
+  void Load(const MiKTeX::Core::PathName& path);
+
+public:
+  bool IsLoaded() const
+  {
+    return loaded;
+  }
+
+  /// Writes the cache file, if the cache has been modified.
+public:
+  void Save();
+
+  /// Gets the digest of a file. The digest is calculated, if it is
+  /// not cached.
+  /// @param path Path to the file.
+  /// @param[out] digest The digest of the file.
+  /// @return Returns `false`, if the file does not exist.
+public:
+  bool TryGetFileDigest(const MiKTeX::Core::PathName& path, MiKTeX::Core::MD5& digest);
+
+  /// Calculates the digests of files which are not cached. The work
+  /// is distributed over several threads.
+  /// @param paths Paths to the files.
+public:
+  void Prefetch(const std::vector<MiKTeX::Core::PathName>& paths);
+
+private:
+  struct FileStatus
+  {
+    std::uint64_t size = 0;
+    std::time_t lastWriteTime = 0;
+    std::time_t statusChangeTime = 0;
+    std::uint64_t serialNumber = 0;
+    bool operator==(const FileStatus& other) const
+    {
+      return size == other.size && lastWriteTime == other.lastWriteTime && statusChangeTime == other.statusChangeTime && serialNumber == other.serialNumber;
+    }
+  };
+
+private:
+  struct Entry
+  {
+    FileStatus status;
+    MiKTeX::Core::MD5 digest;
+    // the file may have been modified after the digest was calculated
+    bool racy = false;
+  };
+
+private:
+  static bool TryGetFileStatus(const MiKTeX::Core::PathName& path, FileStatus& status);
+
+private:
+  bool TryGetCachedDigest(const std::string& key, const FileStatus& status, MiKTeX::Core::MD5& digest) const;
+
+private:
+  void Put(const std::string& key, const FileStatus& status, const MiKTeX::Core::MD5& digest, std::time_t digestTime);
+
+private:
+  MiKTeX::Core::PathName path;
+
+private:
+  bool loaded = false;
+
+private:
+  bool modified = false;
+
+private:
+  std::unordered_map<std::string, Entry> entries;
+};
+
+MPM_INTERNAL_END_NAMESPACE;
+
+#endif
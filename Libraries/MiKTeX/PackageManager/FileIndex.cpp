@@ -0,0 +1,279 @@
+/* FileIndex.cpp:
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of MiKTeX Package Manager.
+
+   MiKTeX Package Manager is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   MiKTeX Package Manager is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with MiKTeX Package Manager; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include <miktex/Core/File>
+
+#include "internal.h"
+
+#include "FileIndex.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Packages;
+
+using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
+
+#define INDEX_HEADER "# MiKTeX package file index 2"
+#define SIGNATURE_PREFIX "signature="
+
+void FileIndex::Load(const PathName& path)
+{
+  this->path = path;
+  Unload();
+  loaded = true;
+  haveNameIndex = true;
+  if (path.Empty() || !File::Exists(path))
+  {
+    return;
+  }
+  // # MiKTeX package file index 2
+  // signature=<signature>
+  // <file>\t<package>[\t<package>...]
+  // ...
+  ifstream stream = File::CreateInputStream(path);
+  string line;
+  if (!getline(stream, line) || line != INDEX_HEADER
+    || !getline(stream, line) || line.compare(0, sizeof(SIGNATURE_PREFIX) - 1, SIGNATURE_PREFIX) != 0)
+  {
+    // unknown format: the index will be rebuilt
+    return;
+  }
+  signature = line.substr(sizeof(SIGNATURE_PREFIX) - 1);
+  while (getline(stream, line))
+  {
+    if (line.empty())
+    {
+      continue;
+    }
+    size_t start = line.find('\t');
+    if (start == string::npos)
+    {
+      Unload();
+      loaded = true;
+      return;
+    }
+    Entry entry;
+    entry.fileName = line.substr(0, start);
+    while (start != string::npos)
+    {
+      size_t end = line.find('\t', start + 1);
+      entry.packages.push_back(line.substr(start + 1, end == string::npos ? string::npos : end - start - 1));
+      start = end;
+    }
+    PathName file(entry.fileName);
+    file.TransformForComparison();
+    vector<string>& packages = packagesByName[file.GetFileName().ToString()];
+    packages.insert(packages.end(), entry.packages.begin(), entry.packages.end());
+    entries[file.ToString()] = move(entry);
+  }
+}
+
+void FileIndex::Unload()
+{
+  loaded = false;
+  modified = false;
+  signature = "";
+  entries.clear();
+  haveNameIndex = false;
+  packagesByName.clear();
+  havePackageIndex = false;
+  filesByPackage.clear();
+}
+
+void FileIndex::Save()
+{
+  if (!loaded || !modified || path.Empty())
+  {
+    return;
+  }
+  vector<const Entry*> sortedEntries;
+  sortedEntries.reserve(entries.size());
+  for (const auto& kv : entries)
+  {
+    sortedEntries.push_back(&kv.second);
+  }
+  sort(sortedEntries.begin(), sortedEntries.end(), [](const Entry* a, const Entry* b) { return a->fileName < b->fileName; });
+  WriteFileAtomically(path, ios_base::out, [this, &sortedEntries](ostream& stream)
+  {
+    stream << INDEX_HEADER << "\n";
+    stream << SIGNATURE_PREFIX << signature << "\n";
+    for (const Entry* entry : sortedEntries)
+    {
+      stream << entry->fileName;
+      for (const string& packageId : entry->packages)
+      {
+        stream << "\t" << packageId;
+      }
+      stream << "\n";
+    }
+  });
+  modified = false;
+}
+
+void FileIndex::SetSignature(const string& signature)
+{
+  if (this->signature != signature)
+  {
+    this->signature = signature;
+    modified = true;
+  }
+}
+
+void FileIndex::Clear()
+{
+  entries.clear();
+  filesByPackage.clear();
+  havePackageIndex = true;
+  Modified();
+}
+
+void FileIndex::SetPackage(const PackageInfo& packageInfo)
+{
+  RemovePackage(packageInfo.id);
+  for (const vector<string>* files : { &packageInfo.runFiles, &packageInfo.docFiles, &packageInfo.sourceFiles })
+  {
+    for (const string& fileName : *files)
+    {
+      AddFile(fileName, packageInfo.id);
+    }
+  }
+  Modified();
+}
+
+void FileIndex::RemovePackage(const string& packageId)
+{
+  NeedPackageIndex();
+  auto it = filesByPackage.find(packageId);
+  if (it == filesByPackage.end())
+  {
+    return;
+  }
+  for (const string& key : it->second)
+  {
+    auto entry = entries.find(key);
+    if (entry == entries.end())
+    {
+      continue;
+    }
+    vector<string>& packages = entry->second.packages;
+    packages.erase(remove(packages.begin(), packages.end(), packageId), packages.end());
+    if (packages.empty())
+    {
+      entries.erase(entry);
+    }
+  }
+  filesByPackage.erase(it);
+  Modified();
+}
+
+vector<string> FileIndex::GetPackages(const string& fileName)
+{
+  PathName key(fileName);
+  if (key.GetFileName() == key)
+  {
+    NeedNameIndex();
+    auto it = packagesByName.find(key.TransformForComparison().ToString());
+    return it == packagesByName.end() ? vector<string>() : it->second;
+  }
+  string unprefixed;
+  if (!PackageManager::StripTeXMFPrefix(fileName, unprefixed))
+  {
+    key = PathName(TEXMF_PREFIX_DIRECTORY) / key;
+  }
+  auto it = entries.find(key.TransformForComparison().ToString());
+  return it == entries.end() ? vector<string>() : it->second.packages;
+}
+
+map<string, vector<string>> FileIndex::GetConflicts() const
+{
+  map<string, vector<string>> filesAndPackages;
+  for (const auto& kv : entries)
+  {
+    if (kv.second.packages.size() > 1)
+    {
+      filesAndPackages[kv.first] = kv.second.packages;
+    }
+  }
+  return filesAndPackages;
+}
+
+void FileIndex::AddFile(const string& fileName, const string& packageId)
+{
+  PathName file(fileName);
+  file.TransformForComparison();
+  string key = file.ToString();
+  Entry& entry = entries[key];
+  if (entry.fileName.empty())
+  {
+    entry.fileName = fileName;
+  }
+  if (find(entry.packages.begin(), entry.packages.end(), packageId) == entry.packages.end())
+  {
+    entry.packages.push_back(packageId);
+    if (havePackageIndex)
+    {
+      filesByPackage[packageId].push_back(key);
+    }
+  }
+}
+
+void FileIndex::Modified()
+{
+  modified = true;
+  haveNameIndex = false;
+  packagesByName.clear();
+}
+
+void FileIndex::NeedNameIndex()
+{
+  if (haveNameIndex)
+  {
+    return;
+  }
+  for (const auto& kv : entries)
+  {
+    vector<string>& packages = packagesByName[PathName(kv.first).GetFileName().ToString()];
+    packages.insert(packages.end(), kv.second.packages.begin(), kv.second.packages.end());
+  }
+  haveNameIndex = true;
+}
+
+void FileIndex::NeedPackageIndex()
+{
+  if (havePackageIndex)
+  {
+    return;
+  }
+  for (const auto& kv : entries)
+  {
+    for (const string& packageId : kv.second.packages)
+    {
+      filesByPackage[packageId].push_back(kv.first);
+    }
+  }
+  havePackageIndex = true;
+}
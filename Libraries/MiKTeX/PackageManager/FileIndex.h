@@ -0,0 +1,172 @@
+/* FileIndex.h:                                         -*- C++ -*-
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of MiKTeX Package Manager.
+
+   MiKTeX Package Manager is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   MiKTeX Package Manager is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with MiKTeX Package Manager; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#pragma once
+
+#if !defined(A6B1D3F08E2C4F7A9B5E1C0D2F4A6B8C)
+#define A6B1D3F08E2C4F7A9B5E1C0D2F4A6B8C
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <miktex/Core/PathName>
+
+#include <miktex/PackageManager/PackageManager>
+
+#include "internal.h"
+
+MPM_INTERNAL_BEGIN_NAMESPACE;
+
+/// @brief A persistent index of the files contained in packages.
+///
+/// The index maps files to the packages which contain them; this
+/// table is what is stored (alongside `package-manifests.ini`), so
+/// that lookups do not have to invert the package manifests.  It is
+/// tagged with a signature of the package manifests from which it was
+/// built.
+class FileIndex
+{
+  /// An entry of the index.
+public:
+  struct Entry
+  {
+    /// The (prefixed) file name, as found in the package manifest.
+    std::string fileName;
+    /// The IDs of the packages which contain the file.
+    std::vector<std::string> packages;
+  };
+
+  /// Reads the index file, if it exists.
+  /// @param path Path to the index file. An empty path denotes an
+  /// index which is not persistent.
+public:
+  void Load(const MiKTeX::Core::PathName& path);
+
+public:
+  bool IsLoaded() const
+  {
+    return loaded;
+  }
+
+  /// Forgets the contents of the index.
+public:
+  void Unload();
+
+  /// Writes the index file, if the index has been modified.
+public:
+  void Save();
+
+public:
+  const std::string& GetSignature() const
+  {
+    return signature;
+  }
+
+public:
+  void SetSignature(const std::string& signature);
+
+  /// Removes all packages from the index.
+public:
+  void Clear();
+
+  /// Adds a package to the index, replacing the existing entry.
+  /// @param packageInfo The package record.
+public:
+  void SetPackage(const MiKTeX::Packages::PackageInfo& packageInfo);
+
+  /// Removes a package from the index.
+  /// @param packageId The package ID.
+public:
+  void RemovePackage(const std::string& packageId);
+
+  /// Gets the packages which contain a file.
+  /// @param fileName The file, either a path relative to the TEXMF
+  /// root directory or a file name.
+  /// @return Returns the package IDs.
+public:
+  std::vector<std::string> GetPackages(const std::string& fileName);
+
+  /// Gets the files which are contained in more than one package.
+  /// @return Returns the files (transformed for comparison) and the
+  /// package IDs.
+public:
+  std::map<std::string, std::vector<std::string>> GetConflicts() const;
+
+  /// Gets the entries of the index.
+  /// @return Returns a map from files (transformed for comparison) to
+  /// index entries.
+public:
+  const std::unordered_map<std::string, Entry>& GetEntries() const
+  {
+    return entries;
+  }
+
+private:
+  void AddFile(const std::string& fileName, const std::string& packageId);
+
+private:
+  void Modified();
+
+private:
+  void NeedNameIndex();
+
+private:
+  void NeedPackageIndex();
+
+private:
+  MiKTeX::Core::PathName path;
+
+private:
+  bool loaded = false;
+
+private:
+  bool modified = false;
+
+private:
+  std::string signature;
+
+  /// The persistent part: files (transformed for comparison) and the
+  /// packages containing them.
+private:
+  std::unordered_map<std::string, Entry> entries;
+
+  /// File names (transformed for comparison) and the packages
+  /// containing them; derived from `entries` while loading.
+private:
+  std::unordered_map<std::string, std::vector<std::string>> packagesByName;
+
+private:
+  bool haveNameIndex = false;
+
+  /// Packages and their files (keys of `entries`); derived from
+  /// `entries` when the index is modified.
+private:
+  std::unordered_map<std::string, std::vector<std::string>> filesByPackage;
+
+private:
+  bool havePackageIndex = false;
+};
+
+MPM_INTERNAL_END_NAMESPACE;
+
+#endif
@@ -36,7 +36,9 @@
 #include "internal.h"
 
 #include "PackageDataStore.h"
+#include "PackageGraph.h"
 #include "PackageManagerImpl.h"
+#include "PackageManifestsSnapshot.h"
 #include "TpmParser.h"
 
 using namespace std;
@@ -48,6 +50,9 @@ using namespace MiKTeX::Util;
 
 using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
 
+#define OBSOLETE_CONTAINER_ID "_miktex-obsolete"
+#define UNCATEGORIZED_CONTAINER_ID "_miktex-all-the-rest"
+
 PackageDataStore::PackageDataStore() :
   // TODO: trace callback
   trace_mpm(TraceStream::Open(MIKTEX_TRACE_MPM)),
@@ -68,7 +73,7 @@ void PackageDataStore::LoadAllPackageManifests(const PathName& packageManifestsP
   unique_ptr<Cfg> cfg = Cfg::Create();
   cfg->Read(packageManifestsPath, mustBeSigned);
 
-  Load(*cfg);
+  Load(*cfg, PathName(), PathName(), "");
 
   loadedAllPackageManifests = true;
 }
@@ -81,7 +86,12 @@ void PackageDataStore::SaveVarData()
 void PackageDataStore::Clear()
 {
   packageTable.clear();
+  incompleteRecords.clear();
+  snapshot.Close();
+  dependencyGraph.Clear();
+  haveDependencyGraph = false;
   installedFileInfoTable.clear();
+  haveFileRefCounts = false;
   loadedAllPackageManifests = false;
   comboCfg.Clear();
 }
@@ -96,12 +106,17 @@ tuple<bool, PackageInfo> PackageDataStore::TryGetPackage(const string& packageId
   }
   else
   {
-    return make_tuple(true, it->second);
+    return make_tuple(true, Complete(it->second));
   }
 }
 
 void PackageDataStore::SetTimeInstalled(const string& packageId, time_t timeInstalled)
 {
+  // the file reference counts depend on the installation state
+  if (loadedAllPackageManifests)
+  {
+    NeedFileRefCounts();
+  }
   (*this)[packageId].SetTimeInstalled(timeInstalled, session->IsAdminMode() ? ConfigurationScope::Common : ConfigurationScope::User);
   if (IsValidTimeT(timeInstalled))
   {
@@ -128,18 +143,19 @@ void PackageDataStore::SetReleaseState(const string& packageId, RepositoryReleas
 PackageDataStore::iterator PackageDataStore::begin()
 {
   MIKTEX_EXPECT(loadedAllPackageManifests);
-  return iterator(packageTable.begin());
+  return iterator(this, packageTable.begin());
 }
 
 PackageDataStore::iterator PackageDataStore::end()
 {
   MIKTEX_EXPECT(loadedAllPackageManifests);
-  return iterator(packageTable.end());
+  return iterator(this, packageTable.end());
 }
 
 void PackageDataStore::DefinePackage(const PackageInfo& packageInfo)
 {
   pair<PackageDefinitionTable::iterator, bool> p = packageTable.insert(make_pair(packageInfo.id, packageInfo));
+  haveDependencyGraph = false;
   if (session->IsMiKTeXDirect())
   {
     // installed from the start
@@ -163,15 +179,40 @@ void PackageDataStore::DefinePackage(const PackageInfo& packageInfo)
 
 void PackageDataStore::IncrementFileRefCounts(const string& packageId)
 {
+  if (!haveFileRefCounts)
+  {
+    // will be counted on demand
+    return;
+  }
   const PackageInfo& package = (*this)[packageId];
   IncrementFileRefCounts(package.runFiles);
   IncrementFileRefCounts(package.docFiles);
   IncrementFileRefCounts(package.sourceFiles);
 }
 
-unsigned long PackageDataStore::GetFileRefCount(const PathName& path)
+void PackageDataStore::NeedFileRefCounts()
 {
   MIKTEX_EXPECT(loadedAllPackageManifests);
+  if (haveFileRefCounts)
+  {
+    return;
+  }
+  for (auto& kv : packageTable)
+  {
+    if (kv.second.IsInstalled())
+    {
+      const PackageInfo& package = Complete(kv.second);
+      IncrementFileRefCounts(package.runFiles);
+      IncrementFileRefCounts(package.docFiles);
+      IncrementFileRefCounts(package.sourceFiles);
+    }
+  }
+  haveFileRefCounts = true;
+}
+
+unsigned long PackageDataStore::GetFileRefCount(const PathName& path)
+{
+  NeedFileRefCounts();
   InstalledFileInfoTable::const_iterator it = installedFileInfoTable.find(path.ToString());
   if (it == installedFileInfoTable.end())
   {
@@ -182,7 +223,7 @@ unsigned long PackageDataStore::GetFileRefCount(const PathName& path)
 
 unsigned long PackageDataStore::DecrementFileRefCount(const PathName& path)
 {
-  MIKTEX_EXPECT(loadedAllPackageManifests);
+  NeedFileRefCounts();
   InstalledFileInfoTable::iterator it = installedFileInfoTable.find(path.ToString());
   if (it == installedFileInfoTable.end() || it->second.refCount == 0)
   {
@@ -234,93 +275,219 @@ PackageDataStore& PackageDataStore::Load()
   }
   unique_ptr<StopWatch> stopWatch = StopWatch::Start(trace_stopwatch.get(), TRACE_FACILITY, "loading all package manifests");
   NeedPackageManifestsIni();
+  PathName graphPath = session->GetSpecialPath(SpecialPath::InstallRoot) / PathName(MIKTEX_PATH_PACKAGE_GRAPH);
+  PathName snapshotPath = session->GetSpecialPath(SpecialPath::InstallRoot) / PathName(MIKTEX_PATH_PACKAGE_MANIFESTS_SNAPSHOT);
+  string signature = GetPackageManifestsSignature();
+  if (LoadSnapshot(snapshotPath, graphPath, signature))
+  {
+    loadedAllPackageManifests = true;
+    return *this;
+  }
   unique_ptr<Cfg> cfg = Cfg::Create();
+  vector<PathName> packageManifestsFiles = GetPackageManifestsFiles();
+  for (size_t idx = 0; idx < packageManifestsFiles.size(); ++idx)
+  {
+    if (idx > 0)
+    {
+      cfg->SetOptions({ Cfg::Option::NoOverwriteKeys });
+    }
+    cfg->Read(packageManifestsFiles[idx]);
+  }
+  Load(*cfg, graphPath, snapshotPath, signature);
+  loadedAllPackageManifests = true;
+  return *this;
+}
+
+vector<PathName> PackageDataStore::GetPackageManifestsFiles()
+{
+  vector<PathName> result;
   if (!session->IsAdminMode())
   {
     PathName userPath = session->GetSpecialPath(SpecialPath::UserInstallRoot) / PathName(MIKTEX_PATH_PACKAGE_MANIFESTS_INI);
     if (File::Exists(userPath))
     {
-      cfg->Read(userPath);
+      result.push_back(userPath);
     }
   }
   PathName commonPath = session->GetSpecialPath(SpecialPath::CommonInstallRoot) / PathName(MIKTEX_PATH_PACKAGE_MANIFESTS_INI);
   if ((session->IsAdminMode() || session->GetSpecialPath(SpecialPath::UserInstallRoot).Canonicalize() != session->GetSpecialPath(SpecialPath::CommonInstallRoot).Canonicalize()) && File::Exists(commonPath))
   {
-    cfg->SetOptions({ Cfg::Option::NoOverwriteKeys });
-    cfg->Read(commonPath);
+    result.push_back(commonPath);
   }
-  Load(*cfg);
-  loadedAllPackageManifests = true;
-  return *this;
+  return result;
 }
 
-void PackageDataStore::Load(Cfg& cfg)
+string PackageDataStore::GetPackageManifestsSignature()
 {
-  unsigned count = 0;
+  string signature;
+  for (const PathName& path : GetPackageManifestsFiles())
+  {
+    signature += fmt::format("{0}:{1}:{2};", path.ToUnix(), File::GetLastWriteTime(path), File::GetSize(path));
+  }
+  return signature;
+}
+
+void PackageDataStore::Load(Cfg& cfg, const PathName& graphPath, const PathName& snapshotPath, const string& signature)
+{
+  vector<PackageInfo> packages;
   for (const auto& key : cfg)
   {
-    // ignore redefinition
-    if (packageTable.find(key->GetName()) != packageTable.end())
+    packages.push_back(PackageManager::GetPackageManifest(cfg, key->GetName(), TEXMF_PREFIX_DIRECTORY));
+  }
+
+  if (!snapshotPath.Empty())
+  {
+    // a mapped snapshot cannot be replaced on Windows
+    snapshot.Close();
+    incompleteRecords.clear();
+    try
     {
-      continue;
+      PackageManifestsSnapshot::Write(snapshotPath, signature, packages);
     }
+    catch (const MiKTeXException& e)
+    {
+      trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("the package manifests snapshot could not be saved: {0}"), e.GetErrorMessage()));
+    }
+  }
 
-    PackageInfo packageInfo = PackageManager::GetPackageManifest(cfg, key->GetName(), TEXMF_PREFIX_DIRECTORY);
+  unsigned count = 0;
+  for (const PackageInfo& packageInfo : packages)
+  {
+    if (DefinePackageManifest(packageInfo))
+    {
+      count += 1;
+    }
+  }
 
-#if IGNORE_OTHER_SYSTEMS
-    string targetSystems = packageInfo.targetSystem;
-    if (targetSystems != "" && !StringUtil::Contains(targetSystems.c_str(), MIKTEX_SYSTEM_TAG))
+  trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("found {0} package manifests"), count));
+
+  DetermineDependencies(graphPath, signature);
+}
+
+bool PackageDataStore::LoadSnapshot(const PathName& snapshotPath, const PathName& graphPath, const string& signature)
+{
+  if (!snapshot.Open(snapshotPath, signature))
+  {
+    return false;
+  }
+  trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("loading package manifests snapshot ({0})"), Q_(snapshotPath)));
+  unsigned count = 0;
+  for (PackageManifestsSnapshot::Index idx = 0; idx < snapshot.GetCount(); ++idx)
+  {
+    // the file lists are retrieved on demand
+    PackageInfo packageInfo = snapshot.GetPackageInfo(idx, false);
+    if (DefinePackageManifest(packageInfo))
     {
-      continue;
+      incompleteRecords[packageInfo.id] = idx;
+      count += 1;
     }
+  }
+  trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("found {0} package manifests"), count));
+  DetermineDependencies(graphPath, signature);
+  return true;
+}
+
+bool PackageDataStore::DefinePackageManifest(const PackageInfo& packageInfo)
+{
+  // ignore redefinition
+  if (packageTable.find(packageInfo.id) != packageTable.end())
+  {
+    return false;
+  }
+
+#if IGNORE_OTHER_SYSTEMS
+  string targetSystems = packageInfo.targetSystem;
+  if (targetSystems != "" && !StringUtil::Contains(targetSystems.c_str(), MIKTEX_SYSTEM_TAG))
+  {
+    return false;
+  }
 #endif
 
-    count += 1;
+  // insert into database
+  DefinePackage(packageInfo);
 
-    // insert into database
-    DefinePackage(packageInfo);
+  return true;
+}
 
-    // increment file ref counts, if package is installed
-    if (packageInfo.IsInstalled())
+PackageInfo& PackageDataStore::Complete(PackageInfo& packageInfo)
+{
+  if (!incompleteRecords.empty())
+  {
+    auto it = incompleteRecords.find(packageInfo.id);
+    if (it != incompleteRecords.end())
     {
-      IncrementFileRefCounts(packageInfo.runFiles);
-      IncrementFileRefCounts(packageInfo.docFiles);
-      IncrementFileRefCounts(packageInfo.sourceFiles);
+      snapshot.GetFiles(it->second, packageInfo);
+      incompleteRecords.erase(it);
     }
   }
+  return packageInfo;
+}
 
-  trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("found {0} package manifests"), count));
+bool PackageDataStore::IsPureContainer(const PackageInfo& packageInfo)
+{
+  auto it = incompleteRecords.find(packageInfo.id);
+  unsigned long numFiles = it == incompleteRecords.end() ? packageInfo.GetNumFiles() : snapshot.GetNumFiles(it->second);
+  return packageInfo.IsContainer() && numFiles <= 1;
+}
 
-  // determine dependencies
-  for (auto& kv : packageTable)
+void PackageDataStore::DetermineDependencies(const PathName& graphPath, const string& signature)
+{
+  // the dependency graph is cached alongside the package manifests
+  if (!graphPath.Empty() && dependencyGraph.Load(graphPath, signature))
   {
-    PackageInfo& pkg = kv.second;
+    haveDependencyGraph = dependencyGraph.GetSize() == packageTable.size();
+    for (PackageGraph::Node node = 0; haveDependencyGraph && node < dependencyGraph.GetSize(); ++node)
+    {
+      haveDependencyGraph = packageTable.find(dependencyGraph.GetPackageId(node)) != packageTable.end();
+    }
+  }
+  if (!haveDependencyGraph)
+  {
+    BuildDependencyGraph();
+    if (!graphPath.Empty())
+    {
+      try
+      {
+        dependencyGraph.Save(graphPath, signature);
+      }
+      catch (const MiKTeXException& e)
+      {
+        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("the dependency graph could not be saved: {0}"), e.GetErrorMessage()));
+      }
+    }
+  }
+
+  // determine dependencies; in topological order, the installation
+  // times of required containers are known before they are used
+  vector<PackageInfo*> packages;
+  packages.reserve(dependencyGraph.GetSize());
+  for (PackageGraph::Node node = 0; node < dependencyGraph.GetSize(); ++node)
+  {
+    packages.push_back(&packageTable[dependencyGraph.GetPackageId(node)]);
+  }
+  for (PackageGraph::Node node = 0; node < dependencyGraph.GetSize(); ++node)
+  {
+    PackageInfo& pkg = *packages[node];
     // FIXME
     time_t timeInstalledMin = static_cast<time_t>(0xffffffffffffffffULL);
     time_t timeInstalledMax = 0;
-    for (const string& req : pkg.requiredPackages)
+    auto required = dependencyGraph.GetRequired(node);
+    for (const PackageGraph::Node* req = required.first; req != required.second; ++req)
     {
-      PackageDefinitionTable::iterator it3 = packageTable.find(req);
-      if (it3 == packageTable.end())
+      PackageInfo& reqPkg = *packages[*req];
+      reqPkg.requiredBy.push_back(pkg.id);
+      if (reqPkg.GetTimeInstalled() < timeInstalledMin)
       {
-        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("dependancy problem: {0} is required by {1}"), req, pkg.id));
+        timeInstalledMin = reqPkg.GetTimeInstalled();
       }
-      else
+      if (reqPkg.GetTimeInstalled() > timeInstalledMax)
       {
-        it3->second.requiredBy.push_back(pkg.id);
-        if (it3->second.GetTimeInstalled() < timeInstalledMin)
-        {
-          timeInstalledMin = it3->second.GetTimeInstalled();
-        }
-        if (it3->second.GetTimeInstalled() > timeInstalledMax)
-        {
-          timeInstalledMax = it3->second.GetTimeInstalled();
-        }
+        timeInstalledMax = reqPkg.GetTimeInstalled();
       }
     }
     if (timeInstalledMin > 0)
     {
-      if (pkg.IsPureContainer() || (pkg.IsInstalled() && pkg.GetTimeInstalled() < timeInstalledMax))
+      if (IsPureContainer(pkg) || (pkg.IsInstalled() && pkg.GetTimeInstalled() < timeInstalledMax))
       {
         if (session->IsAdminMode())
         {
@@ -336,7 +503,7 @@ void PackageDataStore::Load(Cfg& cfg)
 
   // create "Obsolete" container
   PackageInfo piObsolete;
-  piObsolete.id = "_miktex-obsolete";
+  piObsolete.id = OBSOLETE_CONTAINER_ID;
   piObsolete.displayName = T_("Obsolete");
   piObsolete.title = T_("Obsolete packages");
   piObsolete.description = T_("Packages that were removed from the MiKTeX package repository.");
@@ -357,7 +524,7 @@ void PackageDataStore::Load(Cfg& cfg)
 
   // create "Uncategorized" container
   PackageInfo piOther;
-  piOther.id = "_miktex-all-the-rest";
+  piOther.id = UNCATEGORIZED_CONTAINER_ID;
   piOther.displayName = T_("Uncategorized");
   piOther.title = T_("Uncategorized packages");
   for (auto& kv : packageTable)
@@ -374,6 +541,45 @@ void PackageDataStore::Load(Cfg& cfg)
     // insert "Other" into the database
     DefinePackage(piOther);
   }
+
+  // the containers created above are not part of the dependency graph
+  haveDependencyGraph = true;
+}
+
+void PackageDataStore::BuildDependencyGraph()
+{
+  unique_ptr<StopWatch> stopWatch = StopWatch::Start(trace_stopwatch.get(), TRACE_FACILITY, "building the dependency graph");
+  vector<pair<string, vector<string>>> packages;
+  packages.reserve(packageTable.size());
+  for (const auto& kv : packageTable)
+  {
+    if (kv.first != OBSOLETE_CONTAINER_ID && kv.first != UNCATEGORIZED_CONTAINER_ID)
+    {
+      packages.push_back(make_pair(kv.first, kv.second.requiredPackages));
+    }
+  }
+  for (const auto& p : dependencyGraph.Build(packages))
+  {
+    trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("dependancy problem: {0} is required by {1}"), p.second, p.first));
+  }
+  haveDependencyGraph = true;
+}
+
+const PackageGraph& PackageDataStore::GetDependencyGraph()
+{
+  MIKTEX_EXPECT(loadedAllPackageManifests);
+  if (!haveDependencyGraph)
+  {
+    BuildDependencyGraph();
+  }
+  return dependencyGraph;
+}
+
+bool PackageDataStore::IsInstalled(const string& packageId)
+{
+  MIKTEX_EXPECT(loadedAllPackageManifests);
+  auto it = packageTable.find(packageId);
+  return it != packageTable.end() && it->second.IsInstalled();
 }
 
 void PackageDataStore::LoadVarData()
@@ -394,7 +600,7 @@ PackageInfo& PackageDataStore::operator[](const string& packageId)
   {
     MIKTEX_FATAL_ERROR_2(T_("The requested package is unknown."), "name", packageId);
   }
-  return it->second;
+  return Complete(it->second);
 }
 
 time_t PackageDataStore::GetTimeInstalled(const string& packageId, ConfigurationScope scope)
@@ -30,6 +30,7 @@
 #include <string>
 #include <tuple>
 #include <unordered_map>
+#include <vector>
 
 #include <miktex/Core/PathName>
 #include <miktex/Core/Session>
@@ -40,6 +41,8 @@
 #include <miktex/PackageManager/PackageManager>
 
 #include "ComboCfg.h"
+#include "PackageGraph.h"
+#include "PackageManifestsSnapshot.h"
 
 MPM_INTERNAL_BEGIN_NAMESPACE;
 
@@ -48,6 +51,10 @@ MPM_INTERNAL_BEGIN_NAMESPACE;
 /// The record data is retrieved from two sources:
 /// - `miktex/config/package-manifests.ini`: immutable package manifests
 /// - `miktex/config/packages.ini`: mutable package data such as installation timestamps
+///
+/// The package manifests are also stored in a binary snapshot
+/// (`miktex/config/package-manifests.bin`), which is used instead of
+/// the INI file as long as it is up to date.
 class PackageDataStore
 {
 public:
@@ -59,8 +66,8 @@ public:
   /// - mutable data from a given INI file
   /// - immutable package data from `miktex/config/packages.ini`
   /// 
-  /// In addition, package dependencies and file reference counts are
-  /// calculated.
+  /// In addition, package dependencies are calculated. File reference
+  /// counts are calculated on demand.
   ///
   /// @param path Path to the INI file.
 public:
@@ -110,8 +117,22 @@ public:
   void SetPackage(const MiKTeX::Packages::PackageInfo& packageInfo)
   {
     (*this)[packageInfo.id] = packageInfo;
+    haveDependencyGraph = false;
   }
 
+  /// Tests whether a package is installed.
+  /// @param packageId The package ID.
+  /// @return Returns `false`, if the package is not installed or unknown.
+public:
+  bool IsInstalled(const std::string& packageId);
+
+  /// Gets the dependency graph of the known packages.
+  ///
+  /// The graph does not include the containers which are created by
+  /// the data store (obsolete and uncategorized packages).
+public:
+  const PackageGraph& GetDependencyGraph();
+
   /// @brief Sets the package installation timestamp.
   ///
   /// If the timestamp is zero (`InvalidTimeT`), the mutable package
@@ -140,14 +161,15 @@ public:
   class iterator
   {
   public:
-    iterator(PackageDefinitionTable::iterator it) :
+    iterator(PackageDataStore* store, PackageDefinitionTable::iterator it) :
+      store(store),
       it(it)
     {
     }
   public:
     MiKTeX::Packages::PackageInfo& operator*()
     {
-      return it->second;
+      return store->Complete(it->second);
     }
   public:
     iterator& operator++()
@@ -165,6 +187,8 @@ public:
     {
       return it != rhs.it;
     }
+  private:
+    PackageDataStore* store;
   private:
     PackageDefinitionTable::iterator it;
   };
@@ -182,6 +206,12 @@ public:
 public:
   void IncrementFileRefCounts(const std::string& packageId);
 
+  /// Counts the file references of the installed packages, if this
+  /// hasn't been done yet. Must be called before the installation
+  /// state of a package changes.
+public:
+  void NeedFileRefCounts();
+
   /// Gets the reference count of a file.
   /// @param path The path to the file.
   /// @return Returns reference count of the file.
@@ -194,6 +224,17 @@ public:
 public:
   unsigned long DecrementFileRefCount(const MiKTeX::Core::PathName& path);
 
+  /// Gets the package manifest files which are read by `Load()`.
+  /// @return Returns the paths, in order of precedence.
+public:
+  std::vector<MiKTeX::Core::PathName> GetPackageManifestsFiles();
+
+  /// Gets a signature of the package manifest files.
+  /// @return Returns a string which changes when the package
+  /// manifest files are modified.
+public:
+  std::string GetPackageManifestsSignature();
+
   /// Migrates TPM files into a single INI file.
   ///
   /// If the INI file `miktex/config/package-manifests.ini` does not
@@ -210,7 +251,32 @@ public:
   std::size_t GetNumberOfInstalledPackages(bool userScope);
   
 private:
-  void Load(MiKTeX::Core::Cfg& cfg);
+  void Load(MiKTeX::Core::Cfg& cfg, const MiKTeX::Core::PathName& graphPath, const MiKTeX::Core::PathName& snapshotPath, const std::string& signature);
+
+  /// Loads the package manifests from the snapshot file, if it is up
+  /// to date.
+private:
+  bool LoadSnapshot(const MiKTeX::Core::PathName& snapshotPath, const MiKTeX::Core::PathName& graphPath, const std::string& signature);
+
+private:
+  bool DefinePackageManifest(const MiKTeX::Packages::PackageInfo& packageInfo);
+
+  /// Calculates package dependencies and creates the containers for
+  /// obsolete and uncategorized packages.
+private:
+  void DetermineDependencies(const MiKTeX::Core::PathName& graphPath, const std::string& signature);
+
+  /// Retrieves the file lists of a record which has been loaded from
+  /// the snapshot.
+private:
+  MiKTeX::Packages::PackageInfo& Complete(MiKTeX::Packages::PackageInfo& packageInfo);
+
+private:
+  bool IsPureContainer(const MiKTeX::Packages::PackageInfo& packageInfo);
+
+  /// Builds the dependency graph from the package table.
+private:
+  void BuildDependencyGraph();
 
 private:
   void LoadVarData();
@@ -248,6 +314,9 @@ private:
 private:
   InstalledFileInfoTable installedFileInfoTable;
 
+private:
+  bool haveFileRefCounts = false;
+
 private:
   ComboCfg comboCfg;
 
@@ -260,6 +329,19 @@ private:
 private:
   std::unique_ptr<MiKTeX::Trace::TraceStream> trace_stopwatch;
 
+private:
+  PackageManifestsSnapshot snapshot;
+
+  // records without file lists, by package ID
+private:
+  std::unordered_map<std::string, PackageManifestsSnapshot::Index, MiKTeX::Core::hash_icase, MiKTeX::Core::equal_icase> incompleteRecords;
+
+private:
+  PackageGraph dependencyGraph;
+
+private:
+  bool haveDependencyGraph = false;
+
 private:
   bool loadedAllPackageManifests = false;
 
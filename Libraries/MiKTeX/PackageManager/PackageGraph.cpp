@@ -0,0 +1,328 @@
+/* PackageGraph.cpp:
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of MiKTeX Package Manager.
+
+   MiKTeX Package Manager is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   MiKTeX Package Manager is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with MiKTeX Package Manager; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include <miktex/Core/File>
+
+#include "internal.h"
+
+#include "PackageGraph.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+
+using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
+
+#define GRAPH_HEADER "# MiKTeX package dependency graph 1"
+#define SIGNATURE_PREFIX "signature="
+
+constexpr PackageGraph::Node PackageGraph::npos;
+
+vector<pair<string, string>> PackageGraph::Build(const vector<pair<string, vector<string>>>& packages)
+{
+  Clear();
+
+  // number the packages in alphabetical order, so that the result does
+  // not depend on the order of the input
+  vector<size_t> sorted(packages.size());
+  for (size_t idx = 0; idx < sorted.size(); ++idx)
+  {
+    sorted[idx] = idx;
+  }
+  sort(sorted.begin(), sorted.end(), [&packages](size_t a, size_t b) { return packages[a].first < packages[b].first; });
+  unordered_map<string, Node, hash_icase, equal_icase> tmpNodeById;
+  vector<size_t> tmpNodes;
+  for (size_t idx : sorted)
+  {
+    if (tmpNodeById.insert(make_pair(packages[idx].first, static_cast<Node>(tmpNodes.size()))).second)
+    {
+      tmpNodes.push_back(idx);
+    }
+  }
+
+  // resolve the dependencies
+  vector<pair<string, string>> unresolved;
+  vector<vector<Node>> tmpRequired(tmpNodes.size());
+  for (Node tmp = 0; tmp < tmpNodes.size(); ++tmp)
+  {
+    const auto& package = packages[tmpNodes[tmp]];
+    for (const string& req : package.second)
+    {
+      auto it = tmpNodeById.find(req);
+      if (it == tmpNodeById.end())
+      {
+        unresolved.push_back(make_pair(package.first, req));
+      }
+      else if (it->second != tmp && find(tmpRequired[tmp].begin(), tmpRequired[tmp].end(), it->second) == tmpRequired[tmp].end())
+      {
+        tmpRequired[tmp].push_back(it->second);
+      }
+    }
+  }
+
+  // depth-first search: a package is numbered after the packages it
+  // requires; edges into the current path (cycles) are ignored
+  enum class State { New, Active, Done };
+  vector<State> state(tmpNodes.size(), State::New);
+  vector<Node> order;
+  order.reserve(tmpNodes.size());
+  vector<pair<Node, size_t>> stack;
+  for (Node root = 0; root < tmpNodes.size(); ++root)
+  {
+    if (state[root] != State::New)
+    {
+      continue;
+    }
+    state[root] = State::Active;
+    stack.push_back(make_pair(root, 0));
+    while (!stack.empty())
+    {
+      Node tmp = stack.back().first;
+      size_t& next = stack.back().second;
+      if (next < tmpRequired[tmp].size())
+      {
+        Node req = tmpRequired[tmp][next++];
+        if (state[req] == State::New)
+        {
+          state[req] = State::Active;
+          stack.push_back(make_pair(req, 0));
+        }
+      }
+      else
+      {
+        state[tmp] = State::Done;
+        order.push_back(tmp);
+        stack.pop_back();
+      }
+    }
+  }
+
+  vector<Node> nodeByTmp(tmpNodes.size());
+  for (Node node = 0; node < order.size(); ++node)
+  {
+    nodeByTmp[order[node]] = node;
+  }
+  ids.reserve(order.size());
+  edgeOffsets.reserve(order.size() + 1);
+  edgeOffsets.push_back(0);
+  for (Node tmp : order)
+  {
+    ids.push_back(packages[tmpNodes[tmp]].first);
+    for (Node req : tmpRequired[tmp])
+    {
+      edges.push_back(nodeByTmp[req]);
+    }
+    edgeOffsets.push_back(static_cast<uint32_t>(edges.size()));
+  }
+
+  Compile();
+
+  return unresolved;
+}
+
+bool PackageGraph::Load(const PathName& path, const string& signature)
+{
+  Clear();
+  if (!File::Exists(path))
+  {
+    return false;
+  }
+  // # MiKTeX package dependency graph 1
+  // signature=<signature>
+  // <package> <required node> ...
+  // ...
+  ifstream stream = File::CreateInputStream(path);
+  string line;
+  if (!getline(stream, line) || line != GRAPH_HEADER
+    || !getline(stream, line) || line != SIGNATURE_PREFIX + signature)
+  {
+    return false;
+  }
+  edgeOffsets.push_back(0);
+  while (getline(stream, line))
+  {
+    istringstream fields(line);
+    string packageId;
+    if (!(fields >> packageId))
+    {
+      continue;
+    }
+    ids.push_back(packageId);
+    Node req;
+    while (fields >> req)
+    {
+      edges.push_back(req);
+    }
+    edgeOffsets.push_back(static_cast<uint32_t>(edges.size()));
+  }
+  for (Node req : edges)
+  {
+    if (req >= ids.size())
+    {
+      Clear();
+      return false;
+    }
+  }
+  Compile();
+  return true;
+}
+
+void PackageGraph::Save(const PathName& path, const string& signature) const
+{
+  WriteFileAtomically(path, ios_base::out, [this, &signature](ostream& stream)
+  {
+    stream << GRAPH_HEADER << "\n";
+    stream << SIGNATURE_PREFIX << signature << "\n";
+    for (Node node = 0; node < ids.size(); ++node)
+    {
+      stream << ids[node];
+      for (uint32_t idx = edgeOffsets[node]; idx < edgeOffsets[node + 1]; ++idx)
+      {
+        stream << " " << edges[idx];
+      }
+      stream << "\n";
+    }
+  });
+}
+
+void PackageGraph::Clear()
+{
+  ids.clear();
+  edgeOffsets.clear();
+  edges.clear();
+  nodeById.clear();
+  reachableIndex.clear();
+  reachable.clear();
+}
+
+PackageGraph::Node PackageGraph::Find(const string& packageId) const
+{
+  auto it = nodeById.find(packageId);
+  return it == nodeById.end() ? npos : it->second;
+}
+
+bool PackageGraph::Reaches(Node from, Node to) const
+{
+  if (from == to)
+  {
+    return true;
+  }
+  const Bitset* bits = GetReachable(from);
+  return bits != nullptr && ((*bits)[to / 64] & (uint64_t(1) << (to % 64))) != 0;
+}
+
+vector<PackageGraph::Node> PackageGraph::GetClosure(const vector<Node>& nodes) const
+{
+  Bitset closure((ids.size() + 63) / 64, 0);
+  for (Node node : nodes)
+  {
+    const Bitset* bits = GetReachable(node);
+    if (bits == nullptr)
+    {
+      closure[node / 64] |= uint64_t(1) << (node % 64);
+    }
+    else
+    {
+      for (size_t word = 0; word < closure.size(); ++word)
+      {
+        closure[word] |= (*bits)[word];
+      }
+    }
+  }
+  vector<Node> result;
+  for (Node node = 0; node < ids.size(); ++node)
+  {
+    if ((closure[node / 64] & (uint64_t(1) << (node % 64))) != 0)
+    {
+      result.push_back(node);
+    }
+  }
+  return result;
+}
+
+void PackageGraph::Compile()
+{
+  nodeById.reserve(ids.size());
+  for (Node node = 0; node < ids.size(); ++node)
+  {
+    nodeById[ids[node]] = node;
+  }
+
+  // the reachability bitsets of the collections; in topological order,
+  // the bitsets of the required packages are complete, except for
+  // dependency cycles, which need further passes
+  size_t words = (ids.size() + 63) / 64;
+  reachableIndex.assign(ids.size(), npos);
+  bool haveCycles = false;
+  for (Node node = 0; node < ids.size(); ++node)
+  {
+    if (edgeOffsets[node] == edgeOffsets[node + 1])
+    {
+      continue;
+    }
+    reachableIndex[node] = static_cast<Node>(reachable.size());
+    reachable.push_back(Bitset(words, 0));
+    reachable.back()[node / 64] |= uint64_t(1) << (node % 64);
+    for (uint32_t idx = edgeOffsets[node]; idx < edgeOffsets[node + 1]; ++idx)
+    {
+      haveCycles = haveCycles || edges[idx] > node;
+    }
+  }
+  bool changed = true;
+  while (changed)
+  {
+    changed = false;
+    for (Node node = 0; node < ids.size(); ++node)
+    {
+      if (reachableIndex[node] == npos)
+      {
+        continue;
+      }
+      Bitset& bits = reachable[reachableIndex[node]];
+      for (uint32_t idx = edgeOffsets[node]; idx < edgeOffsets[node + 1]; ++idx)
+      {
+        Node req = edges[idx];
+        if (reachableIndex[req] == npos)
+        {
+          uint64_t mask = uint64_t(1) << (req % 64);
+          changed = changed || (bits[req / 64] & mask) == 0;
+          bits[req / 64] |= mask;
+          continue;
+        }
+        const Bitset& reqBits = reachable[reachableIndex[req]];
+        for (size_t word = 0; word < words; ++word)
+        {
+          uint64_t merged = bits[word] | reqBits[word];
+          changed = changed || merged != bits[word];
+          bits[word] = merged;
+        }
+      }
+    }
+    // without cycles, the first pass is conclusive
+    changed = changed && haveCycles;
+  }
+}
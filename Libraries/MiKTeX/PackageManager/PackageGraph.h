@@ -0,0 +1,156 @@
+/* PackageGraph.h:                                      -*- C++ -*-
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of MiKTeX Package Manager.
+
+   MiKTeX Package Manager is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   MiKTeX Package Manager is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with MiKTeX Package Manager; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#pragma once
+
+#if !defined(F2C84D0A6E3B4B1D9A7C5E8F1B3D5A70)
+#define F2C84D0A6E3B4B1D9A7C5E8F1B3D5A70
+
+#include <cstdint>
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <miktex/Core/PathName>
+#include <miktex/Core/equal_icase>
+#include <miktex/Core/hash_icase>
+
+#include "internal.h"
+
+MPM_INTERNAL_BEGIN_NAMESPACE;
+
+/// @brief The compiled dependency graph of the known packages.
+///
+/// Packages are numbered in topological order: the packages required
+/// by a package have smaller numbers than the package itself (unless
+/// they are part of a dependency cycle). For each package which
+/// requires other packages (a collection), the set of reachable
+/// packages is kept as a bitset.
+///
+/// The graph can be stored in a file, tagged with a signature of the
+/// package manifests from which it was built.
+class PackageGraph
+{
+public:
+  typedef std::uint32_t Node;
+
+public:
+  static constexpr Node npos = static_cast<Node>(-1);
+
+  /// Builds the graph.
+  /// @param packages The package IDs and the IDs of the required
+  /// packages. Unknown required packages are ignored.
+  /// @return Returns the dependencies which could not be resolved, as
+  /// pairs of (package ID, required package ID).
+public:
+  std::vector<std::pair<std::string, std::string>> Build(const std::vector<std::pair<std::string, std::vector<std::string>>>& packages);
+
+  /// Reads the graph from a file.
+  /// @param path Path to the file.
+  /// @param signature The expected signature.
+  /// @return Returns `false`, if the file does not exist or if it has
+  /// a different signature.
+public:
+  bool Load(const MiKTeX::Core::PathName& path, const std::string& signature);
+
+  /// Writes the graph to a file.
+  /// @param path Path to the file.
+  /// @param signature The signature to be stored.
+public:
+  void Save(const MiKTeX::Core::PathName& path, const std::string& signature) const;
+
+  /// Forgets the graph.
+public:
+  void Clear();
+
+public:
+  std::size_t GetSize() const
+  {
+    return ids.size();
+  }
+
+  /// Gets the node of a package.
+  /// @param packageId The package ID.
+  /// @return Returns `npos`, if the package is unknown.
+public:
+  Node Find(const std::string& packageId) const;
+
+public:
+  const std::string& GetPackageId(Node node) const
+  {
+    return ids[node];
+  }
+
+  /// Gets the packages directly required by a package.
+public:
+  std::pair<const Node*, const Node*> GetRequired(Node node) const
+  {
+    return std::make_pair(edges.data() + edgeOffsets[node], edges.data() + edgeOffsets[node + 1]);
+  }
+
+  /// Tests whether a package is required by another package, directly
+  /// or indirectly.
+public:
+  bool Reaches(Node from, Node to) const;
+
+  /// Gets the packages which are required by a set of packages,
+  /// directly or indirectly, including the packages themselves.
+  /// @param nodes The set of packages.
+  /// @return Returns the packages in topological order.
+public:
+  std::vector<Node> GetClosure(const std::vector<Node>& nodes) const;
+
+private:
+  typedef std::vector<std::uint64_t> Bitset;
+
+private:
+  void Compile();
+
+private:
+  const Bitset* GetReachable(Node node) const
+  {
+    return reachableIndex[node] == npos ? nullptr : &reachable[reachableIndex[node]];
+  }
+
+private:
+  std::vector<std::string> ids;
+
+private:
+  std::vector<std::uint32_t> edgeOffsets;
+
+private:
+  std::vector<Node> edges;
+
+private:
+  std::unordered_map<std::string, Node, MiKTeX::Core::hash_icase, MiKTeX::Core::equal_icase> nodeById;
+
+private:
+  std::vector<Node> reachableIndex;
+
+private:
+  std::vector<Bitset> reachable;
+};
+
+MPM_INTERNAL_END_NAMESPACE;
+
+#endif
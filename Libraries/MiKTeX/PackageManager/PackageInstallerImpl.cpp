@@ -44,6 +44,7 @@
 #include <miktex/PackageManager/PackageManager>
 
 #include "internal.h"
+#include "PackageGraph.h"
 #include "PackageInstallerImpl.h"
 #include "PackageIteratorImpl.h"
 #include "TpmParser.h"
@@ -255,6 +256,7 @@ void PackageInstallerImpl::OnBeginFileExtraction(const string& fileName, size_t
 
   if (!fileName.empty())
   {
+    JournalFileChange(PathName(fileName));
     installedFiles.insert(PathName(fileName));
   }
 
@@ -443,6 +445,20 @@ void PackageInstallerImpl::FindUpdatesNoLock()
 
   updates.clear();
 
+  // calculate the file digests of the installed MiKTeX packages in one go
+  vector<string> toBeVerified;
+  for (string packageId = repositoryManifest.FirstPackage(); !packageId.empty(); packageId = repositoryManifest.NextPackage())
+  {
+    bool knownPackage;
+    PackageInfo package;
+    tie(knownPackage, package) = packageDataStore->TryGetPackage(packageId);
+    if (knownPackage && package.IsInstalled() && IsMiKTeXPackage(packageId))
+    {
+      toBeVerified.push_back(packageId);
+    }
+  }
+  packageManager->PrefetchFileDigests(toBeVerified);
+
   for (string packageId = repositoryManifest.FirstPackage(); !packageId.empty(); packageId = repositoryManifest.NextPackage())
   {
     Notify();
@@ -568,6 +584,8 @@ void PackageInstallerImpl::FindUpdatesNoLock()
     updates.push_back(updateInfo);
   }
 
+  packageManager->SaveFileDigestCache();
+
   auto iter = make_unique<PackageIteratorImpl>(packageManager, true);
   iter->AddFilter({ PackageFilter::Obsolete });
   PackageInfo package;
@@ -755,7 +773,10 @@ void PackageInstallerImpl::RemoveFiles(const vector<string>& toBeRemoved, bool s
       // remove the file
       try
       {
-        File::Delete(path, { FileDeleteOption::TryHard });
+        if (!JournalFileChange(path))
+        {
+          File::Delete(path, { FileDeleteOption::TryHard });
+        }
         removedFiles.insert(path);
         done = true;
       }
@@ -803,15 +824,28 @@ void PackageInstallerImpl::RemovePackage(const string& packageId, Cfg& packageMa
     MIKTEX_UNEXPECTED();
   }
 
+  // the reference counts must include the package which is about to be
+  // removed: files shared with other packages must be kept
+  packageDataStore->NeedFileRefCounts();
+
   // clear the installTime value => package is not installed
   packageDataStore->SetTimeInstalled(packageId, InvalidTimeT);
-  packageDataStore->SaveVarData();
+  if (!inTransaction)
+  {
+    packageDataStore->SaveVarData();
+  }
 
   // remove the files
   trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("going to remove {0} file(s)"), package.runFiles.size() + package.docFiles.size() + package.sourceFiles.size()));
+  removedFiles.clear();
   RemoveFiles(package.runFiles);
   RemoveFiles(package.docFiles);
   RemoveFiles(package.sourceFiles);
+  if (inTransaction)
+  {
+    UpdateFndb({}, removedFiles, "");
+    transactionPackages.push_back(packageId);
+  }
 
   trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("package {0} successfully removed"), Q_(packageId)));
 
@@ -827,6 +861,8 @@ void PackageInstallerImpl::RemovePackage(const string& packageId, Cfg& packageMa
 
 void PackageInstallerImpl::MyCopyFile(const PathName& source, const PathName& dest, size_t& size)
 {
+  JournalFileChange(dest);
+
   // reset the read-only attribute, if the destination file exists
   if (File::Exists(dest))
   {
@@ -1011,6 +1047,26 @@ MPMSTATICFUNC(unordered_set<PathName>) GetFiles(const PathName& rootDir, const P
 
 void PackageInstallerImpl::UpdateFndb(const unordered_set<PathName>& installedFiles, const unordered_set<PathName>& removedFiles, const string& packageId)
 {
+  if (inTransaction)
+  {
+    // stage the changes; the last change of a file wins
+    for (const PathName& f : removedFiles)
+    {
+      if (installedFiles.find(f) == installedFiles.end())
+      {
+        FndbChanges& changes = stagedFndbChanges[session->DeriveTEXMFRoot(f)];
+        changes.added.erase(f);
+        changes.removed.insert(f);
+      }
+    }
+    for (const PathName& f : installedFiles)
+    {
+      FndbChanges& changes = stagedFndbChanges[session->DeriveTEXMFRoot(f)];
+      changes.removed.erase(f);
+      changes.added[f] = packageId;
+    }
+    return;
+  }
   vector<PathName> toBeRemoved;
   for (const PathName& f : removedFiles)
   {
@@ -1037,6 +1093,217 @@ void PackageInstallerImpl::UpdateFndb(const unordered_set<PathName>& installedFi
   }
 }
 
+// the transaction journal: one line per entry
+//
+//   package <package>        a package which is going to be changed
+//   created <path>           a file which did not exist
+//   saved <n> <path>         a file which has been moved to backup <n>
+//   commit                   the changes are being committed
+
+void PackageInstallerImpl::BeginTransaction(const vector<string>& packages)
+{
+  MIKTEX_ASSERT(!inTransaction);
+  RecoverInterruptedTransaction();
+  // the journal exists as long as the transaction is running
+  PathName journal = session->GetSpecialPath(SpecialPath::InstallRoot) / PathName(MIKTEX_PATH_PACKAGE_TRANSACTION_JOURNAL);
+  Directory::Create(PathName(journal).RemoveFileSpec());
+  journalStream = File::CreateOutputStream(journal);
+  for (const string& packageId : packages)
+  {
+    WriteJournal("package " + packageId);
+  }
+  journaledFiles.clear();
+  numBackups = 0;
+  stagedFndbChanges.clear();
+  transactionPackages.clear();
+  transactionSignature = packageDataStore->GetPackageManifestsSignature();
+  inTransaction = true;
+}
+
+void PackageInstallerImpl::WriteJournal(const string& line)
+{
+  journalStream << line << "\n";
+  journalStream.flush();
+  if (!journalStream)
+  {
+    MIKTEX_FATAL_ERROR_2(T_("The transaction journal could not be written."), "path", (session->GetSpecialPath(SpecialPath::InstallRoot) / PathName(MIKTEX_PATH_PACKAGE_TRANSACTION_JOURNAL)).ToString());
+  }
+}
+
+bool PackageInstallerImpl::JournalFileChange(const PathName& path)
+{
+  if (!inTransaction || !journaledFiles.insert(path).second)
+  {
+    return false;
+  }
+  if (!File::Exists(path))
+  {
+    WriteJournal("created " + path.ToString());
+    return false;
+  }
+  // the entry is written first: a backup which is missing is not
+  // restored
+  string backupName = std::to_string(numBackups++);
+  WriteJournal("saved " + backupName + " " + path.ToString());
+  PathName backupDir = session->GetSpecialPath(SpecialPath::InstallRoot) / PathName(MIKTEX_PATH_PACKAGE_TRANSACTION_BACKUP_DIR);
+  Directory::Create(backupDir);
+  File::Move(path, backupDir / PathName(backupName));
+  return true;
+}
+
+void PackageInstallerImpl::CommitTransaction(Cfg& packageManifests, const PathName& packageManifestsIni)
+{
+  MIKTEX_ASSERT(inTransaction);
+  inTransaction = false;
+
+  unique_ptr<StopWatch> stopWatch = StopWatch::Start(trace_stopwatch.get(), TRACE_FACILITY, "committing package changes");
+
+  // from now on, an interrupted transaction is rolled forward
+  WriteJournal("commit");
+
+  if (File::Exists(packageManifestsIni))
+  {
+    packageManifests.Write(packageManifestsIni);
+  }
+
+  // one batch of file name database changes per root directory
+  for (const auto& kv : stagedFndbChanges)
+  {
+    const FndbChanges& changes = kv.second;
+    // the files which are known to the file name database
+    vector<Fndb::Record> records;
+    unordered_set<PathName> known;
+    if (Fndb::Enumerate(session->GetRootDirectoryPath(kv.first), records))
+    {
+      known.reserve(records.size());
+      for (const Fndb::Record& record : records)
+      {
+        known.insert(record.path);
+      }
+    }
+    records.clear();
+    vector<PathName> toBeRemoved;
+    for (const PathName& f : changes.removed)
+    {
+      if (known.find(f) != known.end())
+      {
+        toBeRemoved.push_back(f);
+      }
+    }
+    if (!toBeRemoved.empty())
+    {
+      Fndb::Remove(toBeRemoved);
+    }
+    vector<Fndb::Record> toBeAdded;
+    for (const auto& added : changes.added)
+    {
+      if (known.find(added.first) == known.end())
+      {
+        toBeAdded.push_back({ added.first, added.second });
+      }
+    }
+    if (!toBeAdded.empty())
+    {
+      Fndb::Add(toBeAdded);
+    }
+  }
+  stagedFndbChanges.clear();
+
+  packageDataStore->SaveVarData();
+
+  // keep the file index in sync with package-manifests.ini
+  packageManager->UpdateFileIndexNoLock(transactionPackages, transactionSignature);
+  transactionPackages.clear();
+
+  // the saved files are not needed anymore
+  journalStream.close();
+  journaledFiles.clear();
+  PathName backupDir = session->GetSpecialPath(SpecialPath::InstallRoot) / PathName(MIKTEX_PATH_PACKAGE_TRANSACTION_BACKUP_DIR);
+  if (Directory::Exists(backupDir))
+  {
+    Directory::Delete(backupDir, true);
+  }
+  File::Delete(session->GetSpecialPath(SpecialPath::InstallRoot) / PathName(MIKTEX_PATH_PACKAGE_TRANSACTION_JOURNAL));
+}
+
+void PackageInstallerImpl::RecoverInterruptedTransaction()
+{
+  PathName journal = session->GetSpecialPath(SpecialPath::InstallRoot) / PathName(MIKTEX_PATH_PACKAGE_TRANSACTION_JOURNAL);
+  if (!File::Exists(journal))
+  {
+    return;
+  }
+  PathName backupDir = session->GetSpecialPath(SpecialPath::InstallRoot) / PathName(MIKTEX_PATH_PACKAGE_TRANSACTION_BACKUP_DIR);
+  // the file changes and how to undo them: (file, backup); an empty
+  // backup path denotes a file which did not exist
+  vector<pair<PathName, PathName>> undo;
+  bool committing = false;
+  ifstream stream = File::CreateInputStream(journal);
+  string line;
+  while (getline(stream, line))
+  {
+    if (line == "commit")
+    {
+      committing = true;
+    }
+    else if (line.compare(0, 8, "created ") == 0)
+    {
+      undo.push_back({ PathName(line.substr(8)), PathName() });
+    }
+    else if (line.compare(0, 6, "saved ") == 0)
+    {
+      size_t pos = line.find(' ', 6);
+      if (pos != string::npos)
+      {
+        undo.push_back({ PathName(line.substr(pos + 1)), backupDir / PathName(line.substr(6, pos - 6)) });
+      }
+    }
+  }
+  stream.close();
+  if (committing)
+  {
+    // the run was interrupted while committing: the package data may
+    // have been written in part; the file name databases are rebuilt
+    // to match the files which are there
+    trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, T_("an earlier installation has been interrupted while committing; rebuilding the file name databases"));
+    if (!session->UnloadFilenameDatabase())
+    {
+      MIKTEX_FATAL_ERROR(T_("The file name database could not be unloaded."));
+    }
+    Fndb::Refresh(session->GetSpecialPath(SpecialPath::InstallRoot), nullptr);
+    packageManager->CreateMpmFndbNoLock();
+  }
+  else
+  {
+    // nothing has been committed: the package data and the file name
+    // databases still describe the state before the run; the files
+    // are restored, last change first
+    trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, T_("an earlier installation has been interrupted; rolling back"));
+    for (auto it = undo.rbegin(); it != undo.rend(); ++it)
+    {
+      const PathName& path = it->first;
+      const PathName& backup = it->second;
+      if (backup.Empty())
+      {
+        if (File::Exists(path))
+        {
+          File::Delete(path, { FileDeleteOption::TryHard });
+        }
+      }
+      else if (File::Exists(backup))
+      {
+        Directory::Create(PathName(path).RemoveFileSpec());
+        File::Move(backup, path, { FileMoveOption::ReplaceExisting });
+      }
+    }
+  }
+  if (Directory::Exists(backupDir))
+  {
+    Directory::Delete(backupDir, true);
+  }
+  File::Delete(journal);
+}
+
 void PackageInstallerImpl::InstallPackage(const string& packageId, Cfg& packageManifests)
 {
   trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Info, fmt::format(T_("installing package {0}"), Q_(packageId)));
@@ -1111,7 +1378,10 @@ void PackageInstallerImpl::InstallPackage(const string& packageId, Cfg& packageM
     RemoveFiles(package.sourceFiles, true);
     // temporarily set the status to "not installed"
     packageDataStore->SetTimeInstalled(packageId, InvalidTimeT);
-    packageDataStore->SaveVarData();
+    if (!inTransaction)
+    {
+      packageDataStore->SaveVarData();
+    }
   }
 
   if (repositoryType == RepositoryType::Remote || repositoryType == RepositoryType::Local)
@@ -1160,7 +1430,10 @@ void PackageInstallerImpl::InstallPackage(const string& packageId, Cfg& packageM
   newPackage.SetTimeInstalled(now, session->IsAdminMode() ? ConfigurationScope::Common : ConfigurationScope::User);
   packageDataStore->SetTimeInstalled(packageId, now);
   packageDataStore->SetReleaseState(packageId, repositoryReleaseState);
-  packageDataStore->SaveVarData();
+  if (!inTransaction)
+  {
+    packageDataStore->SaveVarData();
+  }
 
   // update package info table
   packageDataStore->SetPackage(newPackage);
@@ -1168,6 +1441,11 @@ void PackageInstallerImpl::InstallPackage(const string& packageId, Cfg& packageM
   // increment file ref counts
   packageDataStore->IncrementFileRefCounts(packageId);
 
+  if (inTransaction)
+  {
+    transactionPackages.push_back(packageId);
+  }
+
   // update progress info
   {
     lock_guard<mutex> lockGuard(progressIndicatorMutex);
@@ -1570,26 +1848,35 @@ void PackageInstallerImpl::RunIniTeXMF(const vector<string>& extraArguments)
   Process::Run(initexmf, arguments, this);
 }
 
-void PackageInstallerImpl::CheckDependencies(set<string>& packages, const string& packageId, bool force, int level)
+vector<string> PackageInstallerImpl::PlanInstallation(const vector<string>& packages, bool force)
 {
-  if (level > 10)
-  {
-    MIKTEX_UNEXPECTED();
-  }
-  bool knownPackage;
-  PackageInfo package;
-  tie(knownPackage, package) = packageDataStore->TryGetPackage(packageId);
-  if (knownPackage)
+  const PackageGraph& graph = packageDataStore->GetDependencyGraph();
+  vector<PackageGraph::Node> nodes;
+  vector<string> unknownPackages;
+  for (const string& p : packages)
   {
-    for (const string& p : package.requiredPackages)
+    PackageGraph::Node node = graph.Find(p);
+    if (node != PackageGraph::npos)
+    {
+      nodes.push_back(node);
+    }
+    else if (force && find(unknownPackages.begin(), unknownPackages.end(), p) == unknownPackages.end())
     {
-      CheckDependencies(packages, p, force, level + 1);
+      // not yet known: the package manifest is part of the archive file
+      unknownPackages.push_back(p);
     }
   }
-  if (force || (knownPackage && !package.IsInstalled()))
+  vector<string> result;
+  for (PackageGraph::Node node : graph.GetClosure(nodes))
   {
-    packages.insert(packageId);
+    const string& packageId = graph.GetPackageId(node);
+    if (force || !packageDataStore->IsInstalled(packageId))
+    {
+      result.push_back(packageId);
+    }
   }
+  result.insert(result.end(), unknownPackages.begin(), unknownPackages.end());
+  return result;
 }
 
 // FIXME: duplicate code
@@ -1748,12 +2035,7 @@ void PackageInstallerImpl::InstallRemove(Role role)
     }
 
     // check dependencies
-    set<string> tmp;
-    for (const string& p : toBeInstalled)
-    {
-      CheckDependencies(tmp, p, true, 0);
-    }
-    toBeInstalled.assign(tmp.begin(), tmp.end());
+    toBeInstalled = PlanInstallation(toBeInstalled, true);
 
     // calculate total size and more
     CalculateExpenditure();
@@ -1767,41 +2049,56 @@ void PackageInstallerImpl::InstallRemove(Role role)
       packageManifests->Read(packageManifestsIni);
     }
 
-    // install packages
-    for (const string& p : toBeInstalled)
-    {
-      InstallPackage(p, *packageManifests);
-    }
+    // changes are committed once, when all packages have been processed
+    vector<string> packages(toBeInstalled);
+    packages.insert(packages.end(), toBeRemoved.begin(), toBeRemoved.end());
+    BeginTransaction(packages);
 
-    // remove packages
-    for (const string& p : toBeRemoved)
+    try
     {
-      RemovePackage(p, *packageManifests);
-    }
+      // install packages
+      for (const string& p : toBeInstalled)
+      {
+        InstallPackage(p, *packageManifests);
+      }
 
-    if (role == Role::Updater)
-    {
-      session->SetConfigValue(
-        MIKTEX_CONFIG_SECTION_MPM,
-        session->IsAdminMode() ? MIKTEX_CONFIG_VALUE_LAST_ADMIN_UPDATE : MIKTEX_CONFIG_VALUE_LAST_USER_UPDATE,
-        ConfigValue(std::to_string(time(nullptr))));
-    }
+      // remove packages
+      for (const string& p : toBeRemoved)
+      {
+        RemovePackage(p, *packageManifests);
+      }
 
-    // check dependencies (install missing required packages)
-    tmp.clear();
-    for (const string& p : toBeInstalled)
-    {
-      CheckDependencies(tmp, p, false, 0);
+      if (role == Role::Updater)
+      {
+        session->SetConfigValue(
+          MIKTEX_CONFIG_SECTION_MPM,
+          session->IsAdminMode() ? MIKTEX_CONFIG_VALUE_LAST_ADMIN_UPDATE : MIKTEX_CONFIG_VALUE_LAST_USER_UPDATE,
+          ConfigValue(std::to_string(time(nullptr))));
+      }
+
+      // check dependencies (install missing required packages)
+      for (const string& p : PlanInstallation(toBeInstalled, false))
+      {
+        InstallPackage(p, *packageManifests);
+      }
     }
-    for (const string& p : tmp)
+    catch (const exception&)
     {
-      InstallPackage(p, *packageManifests);
+      // commit the packages which have been completed: a package which
+      // failed is left in the "not installed" state
+      try
+      {
+        CommitTransaction(*packageManifests, packageManifestsIni);
+      }
+      catch (const exception& e)
+      {
+        // the journal is left behind: the next run will recover
+        trace_error->WriteLine(TRACE_FACILITY, TraceLevel::Error, fmt::format(T_("the completed packages could not be committed: {0}"), e.what()));
+      }
+      throw;
     }
 
-    if (File::Exists(packageManifestsIni))
-    {
-      packageManifests->Write(packageManifestsIni);
-    }
+    CommitTransaction(*packageManifests, packageManifestsIni);
 
     packageManifests = nullptr;
   }
@@ -22,10 +22,14 @@
 #if !defined(BF24CACAD93E4429BB9357433BBA2B22)
 #define BF24CACAD93E4429BB9357433BBA2B22
 
+#include <fstream>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <set>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <miktex/Core/Cfg>
@@ -211,6 +215,68 @@ private:
 private:
   void UpdateFndb(const std::unordered_set<MiKTeX::Core::PathName>& installedFiles, const std::unordered_set<MiKTeX::Core::PathName>& removedFiles, const std::string& packageId);
 
+  /// Starts staging the changes of an installation run.
+  /// @param packages The packages which are going to be installed
+  /// or removed.
+private:
+  void BeginTransaction(const std::vector<std::string>& packages);
+
+  /// Writes the package manifests, the file name database changes
+  /// and the package variable data of the completed packages.
+private:
+  void CommitTransaction(MiKTeX::Core::Cfg& packageManifests, const MiKTeX::Core::PathName& packageManifestsIni);
+
+  /// Finishes an earlier installation run which has been interrupted.
+  /// A run which did not start to commit is rolled back: the files it
+  /// has extracted are deleted, the files it has overwritten or
+  /// removed are restored. A run which has been interrupted while
+  /// committing is rolled forward: the file name databases are
+  /// rebuilt.
+private:
+  void RecoverInterruptedTransaction();
+
+private:
+  void WriteJournal(const std::string& line);
+
+  /// Records in the transaction journal how to undo the change of a
+  /// file which is about to be written or removed. An existing file
+  /// is moved to the backup directory.
+  /// @param path The file.
+  /// @return Returns `true`, if the file has been moved away.
+private:
+  bool JournalFileChange(const MiKTeX::Core::PathName& path);
+
+private:
+  struct FndbChanges
+  {
+    std::unordered_map<MiKTeX::Core::PathName, std::string> added;
+    std::unordered_set<MiKTeX::Core::PathName> removed;
+  };
+
+private:
+  bool inTransaction = false;
+
+  // staged file name database changes, by root directory
+private:
+  std::map<unsigned, FndbChanges> stagedFndbChanges;
+
+  // packages which have been installed or removed in the transaction
+private:
+  std::vector<std::string> transactionPackages;
+
+private:
+  std::string transactionSignature;
+
+private:
+  std::ofstream journalStream;
+
+  // files which have been recorded in the journal
+private:
+  std::unordered_set<MiKTeX::Core::PathName> journaledFiles;
+
+private:
+  unsigned numBackups = 0;
+
 private:
   void CalculateExpenditure(bool downloadOnly = false);
 
@@ -414,8 +480,13 @@ private:
 private:
   bool CheckArchiveFile(const std::string& packageId, const MiKTeX::Core::PathName& archiveFileName, bool mustBeOk);
 
+  /// Determines the packages which have to be installed, including
+  /// the required packages.
+  /// @param packages The packages to be installed.
+  /// @param force Indicates whether installed packages are included.
+  /// @return Returns the packages, required packages first.
 private:
-  void CheckDependencies(std::set<std::string>& packages, const std::string& packageId, bool force, int level);
+  std::vector<std::string> PlanInstallation(const std::vector<std::string>& packages, bool force);
 
 #if defined(MIKTEX_WINDOWS) && USE_LOCAL_SERVER
 private:
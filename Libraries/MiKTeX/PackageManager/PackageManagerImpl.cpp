@@ -35,6 +35,7 @@
 #include <miktex/Core/DirectoryLister>
 #include <miktex/Core/Environment>
 #include <miktex/Core/PathNameParser>
+#include <miktex/Core/Process>
 #include <miktex/Core/TemporaryDirectory>
 #include <miktex/Core/Uri>
 #include <miktex/Core/Utils>
@@ -173,12 +174,19 @@ void PackageManagerImpl::LoadDatabase(const PathName& path, bool isArchive)
 
   // load "package-manifests.ini"
   packageDataStore.Clear();
+  fileIndex.Unload();
+  foreignDatabase = true;
   packageDataStore.LoadAllPackageManifests(packageManifestsPath, mustBeSigned);
 }
 
 void PackageManagerImpl::ClearAll()
 {
   packageDataStore.Clear();
+  if (foreignDatabase)
+  {
+    fileIndex.Unload();
+    foreignDatabase = false;
+  }
 }
 
 void PackageManagerImpl::UnloadDatabase()
@@ -509,19 +517,11 @@ bool PackageManagerImpl::OnProgress(unsigned level, const PathName& directory)
 void PackageManagerImpl::CreateMpmFndbNoLock()
 {
   // collect the file names
-  for (const PackageInfo& pi : packageDataStore)
+  for (const auto& kv : GetFileIndexNoLock().GetEntries())
   {
-    for (const string& file : pi.runFiles)
-    {
-      RememberFileNameInfo(file, pi.id);
-    }
-    for (const string& file : pi.docFiles)
+    for (const string& packageId : kv.second.packages)
     {
-      RememberFileNameInfo(file, pi.id);
-    }
-    for (const string& file : pi.sourceFiles)
-    {
-      RememberFileNameInfo(file, pi.id);
+      RememberFileNameInfo(kv.second.fileName, packageId);
     }
   }
 
@@ -532,6 +532,94 @@ void PackageManagerImpl::CreateMpmFndbNoLock()
   directoryInfoTable.clear();
 }
 
+bool PackageManagerImpl::IsFileIndexUpToDate()
+{
+  if (foreignDatabase)
+  {
+    return fileIndex.IsLoaded();
+  }
+  if (!fileIndex.IsLoaded())
+  {
+    fileIndex.Load(session->GetSpecialPath(SpecialPath::InstallRoot) / PathName(MIKTEX_PATH_PACKAGE_FILES_INDEX));
+  }
+  return fileIndex.GetSignature() == packageDataStore.GetPackageManifestsSignature();
+}
+
+FileIndex& PackageManagerImpl::GetFileIndexNoLock()
+{
+  if (IsFileIndexUpToDate())
+  {
+    return fileIndex;
+  }
+  unique_ptr<StopWatch> stopWatch = StopWatch::Start(trace_stopwatch.get(), TRACE_FACILITY, "building the file index");
+  trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Info, T_("building the file index"));
+  string signature;
+  if (foreignDatabase)
+  {
+    // the index of a foreign database lives in memory only
+    fileIndex.Load(PathName());
+  }
+  else
+  {
+    signature = packageDataStore.GetPackageManifestsSignature();
+    packageDataStore.Load();
+  }
+  fileIndex.Clear();
+  for (const PackageInfo& packageInfo : packageDataStore)
+  {
+    fileIndex.SetPackage(packageInfo);
+  }
+  fileIndex.SetSignature(signature);
+  SaveFileIndex();
+  return fileIndex;
+}
+
+void PackageManagerImpl::UpdateFileIndexNoLock(const vector<string>& packageIds, const string& oldSignature)
+{
+  if (foreignDatabase)
+  {
+    return;
+  }
+  if (!fileIndex.IsLoaded())
+  {
+    fileIndex.Load(session->GetSpecialPath(SpecialPath::InstallRoot) / PathName(MIKTEX_PATH_PACKAGE_FILES_INDEX));
+  }
+  if (fileIndex.GetSignature() != oldSignature)
+  {
+    // the index is out of date anyway; it will be rebuilt when needed
+    return;
+  }
+  for (const string& packageId : packageIds)
+  {
+    bool knownPackage;
+    PackageInfo packageInfo;
+    tie(knownPackage, packageInfo) = packageDataStore.TryGetPackage(packageId);
+    if (knownPackage)
+    {
+      fileIndex.SetPackage(packageInfo);
+    }
+    else
+    {
+      fileIndex.RemovePackage(packageId);
+    }
+  }
+  fileIndex.SetSignature(packageDataStore.GetPackageManifestsSignature());
+  SaveFileIndex();
+}
+
+void PackageManagerImpl::SaveFileIndex()
+{
+  try
+  {
+    fileIndex.Save();
+  }
+  catch (const MiKTeXException& e)
+  {
+    // the index will be rebuilt next time
+    trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("file index could not be saved: {0}"), e.GetErrorMessage()));
+  }
+}
+
 bool PackageManager::IsLocalPackageRepository(const PathName& path)
 {
   if (!Directory::Exists(path))
@@ -1092,21 +1180,24 @@ bool PackageManagerImpl::TryGetFileDigest(const PathName& prefix, const string&
   }
   PathName path = prefix;
   path /= unprefixed;
-  if (!File::Exists(path))
-  {
-    trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("package verification failed: file {0} does not exist"), Q_(path)));
-    return false;
-  }
   if (path.HasExtension(MIKTEX_PACKAGE_MANIFEST_FILE_SUFFIX))
   {
     haveDigest = false;
+    if (File::Exists(path))
+    {
+      return true;
+    }
   }
   else
   {
-    digest = MD5::FromFile(path);
-    haveDigest = true;
+    haveDigest = GetFileDigestCache().TryGetFileDigest(path, digest);
+    if (haveDigest)
+    {
+      return true;
+    }
   }
-  return true;
+  trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("package verification failed: file {0} does not exist"), Q_(path)));
+  return false;
 }
 
 bool PackageManagerImpl::TryCollectFileDigests(const PathName& prefix, const vector<string>& files, FileDigestTable& fileDigests)
@@ -1127,21 +1218,80 @@ bool PackageManagerImpl::TryCollectFileDigests(const PathName& prefix, const vec
   return true;
 }
 
-bool PackageManagerImpl::TryVerifyInstalledPackageNoLock(const string& packageId)
+PathName PackageManagerImpl::GetInstallPrefix(const PackageInfo& packageInfo)
 {
-  PackageInfo packageInfo = packageDataStore.GetPackage(packageId);
+  if (!session->IsAdminMode() && packageInfo.IsInstalled(ConfigurationScope::User))
+  {
+    return session->GetSpecialPath(SpecialPath::UserInstallRoot);
+  }
+  return session->GetSpecialPath(SpecialPath::CommonInstallRoot);
+}
+
+FileDigestCache& PackageManagerImpl::GetFileDigestCache()
+{
+  if (!fileDigestCache.IsLoaded())
+  {
+    fileDigestCache.Load(session->GetSpecialPath(SpecialPath::DataRoot) / PathName(MIKTEX_PATH_FILE_DIGEST_CACHE));
+  }
+  return fileDigestCache;
+}
 
-  PathName prefix;
+void PackageManagerImpl::PrefetchFileDigests(const vector<string>& packageIds)
+{
+  unique_ptr<StopWatch> stopWatch = StopWatch::Start(trace_stopwatch.get(), TRACE_FACILITY, "collecting file digests");
+  vector<PathName> paths;
+  for (const string& packageId : packageIds)
+  {
+    PackageInfo packageInfo = packageDataStore.GetPackage(packageId);
+    PathName prefix = GetInstallPrefix(packageInfo);
+    for (const vector<string>* files : { &packageInfo.runFiles, &packageInfo.docFiles, &packageInfo.sourceFiles })
+    {
+      for (const string& fileName : *files)
+      {
+        string unprefixed;
+        if (StripTeXMFPrefix(fileName, unprefixed) && !PathName(unprefixed).HasExtension(MIKTEX_PACKAGE_MANIFEST_FILE_SUFFIX))
+        {
+          paths.push_back(prefix / PathName(unprefixed));
+        }
+      }
+    }
+  }
+  GetFileDigestCache().Prefetch(paths);
+}
 
-  if (!session->IsAdminMode() && packageInfo.IsInstalled(ConfigurationScope::User))
+void PackageManagerImpl::SaveFileDigestCache()
+{
+  try
+  {
+    fileDigestCache.Save();
+  }
+  catch (const MiKTeXException& e)
   {
-    prefix = session->GetSpecialPath(SpecialPath::UserInstallRoot);
+    // the cache is an optimization
+    trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("file digest cache could not be saved: {0}"), e.GetErrorMessage()));
   }
+}
 
-  if (prefix.Empty())
+vector<string> PackageManagerImpl::VerifyInstalledPackagesNoLock(const vector<string>& packageIds)
+{
+  PrefetchFileDigests(packageIds);
+  vector<string> brokenPackages;
+  for (const string& packageId : packageIds)
   {
-    prefix = session->GetSpecialPath(SpecialPath::CommonInstallRoot);
+    if (!TryVerifyInstalledPackageNoLock(packageId))
+    {
+      brokenPackages.push_back(packageId);
+    }
   }
+  SaveFileDigestCache();
+  return brokenPackages;
+}
+
+bool PackageManagerImpl::TryVerifyInstalledPackageNoLock(const string& packageId)
+{
+  PackageInfo packageInfo = packageDataStore.GetPackage(packageId);
+
+  PathName prefix = GetInstallPrefix(packageInfo);
 
   FileDigestTable fileDigests;
 
@@ -1269,4 +1419,31 @@ string MakeUrl(const string& base, const string& rel)
   return url;
 }
 
+void WriteFileAtomically(const PathName& path, ios_base::openmode mode, const function<void(ostream&)>& write)
+{
+  Directory::Create(PathName(path).RemoveFileSpec());
+  PathName tmpPath(fmt::format("{0}.{1}.tmp", path.ToString(), Process::GetCurrentProcess()->GetSystemId()));
+  try
+  {
+    ofstream stream = File::CreateOutputStream(tmpPath, mode);
+    write(stream);
+    stream.close();
+    File::Move(tmpPath, path, { FileMoveOption::ReplaceExisting });
+  }
+  catch (const exception&)
+  {
+    try
+    {
+      if (File::Exists(tmpPath))
+      {
+        File::Delete(tmpPath);
+      }
+    }
+    catch (const exception&)
+    {
+    }
+    throw;
+  }
+}
+
 MPM_INTERNAL_END_NAMESPACE;
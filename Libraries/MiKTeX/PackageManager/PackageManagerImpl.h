@@ -34,6 +34,8 @@
 
 #include "internal.h"
 
+#include "FileDigestCache.h"
+#include "FileIndex.h"
 #include "PackageDataStore.h"
 #include "PackageRepositoryDataStore.h"
 #include "WebSession.h"
@@ -71,14 +73,7 @@ public:
 public:
   void MIKTEXTHISCALL CreateMpmFndb() override
   {
-    if (!packageDataStore.LoadedAllPackageManifests())
-    {
-      MPM_LOCK_BEGIN(this)
-      {
-        packageDataStore.Load();
-      }
-      MPM_LOCK_END();
-    }
+    NeedFileIndex();
     return CreateMpmFndbNoLock();
   }
 
@@ -165,12 +160,37 @@ public:
       }
       MPM_LOCK_END();
     }
-    return TryVerifyInstalledPackageNoLock(packageId);
+    bool ok = TryVerifyInstalledPackageNoLock(packageId);
+    SaveFileDigestCache();
+    return ok;
   }
 
 public:
   bool MIKTEXTHISCALL TryVerifyInstalledPackageNoLock(const std::string& packageId);
 
+public:
+  std::vector<std::string> MIKTEXTHISCALL VerifyInstalledPackages(const std::vector<std::string>& packageIds) override
+  {
+    if (!packageDataStore.LoadedAllPackageManifests())
+    {
+      MPM_LOCK_BEGIN(this)
+      {
+        packageDataStore.Load();
+      }
+      MPM_LOCK_END();
+    }
+    return VerifyInstalledPackagesNoLock(packageIds);
+  }
+
+public:
+  std::vector<std::string> VerifyInstalledPackagesNoLock(const std::vector<std::string>& packageIds);
+
+public:
+  void PrefetchFileDigests(const std::vector<std::string>& packageIds);
+
+public:
+  void SaveFileDigestCache();
+
 public:
   std::string MIKTEXTHISCALL GetContainerPath(const std::string& packageId, bool useDisplayNames) override
   {
@@ -188,6 +208,30 @@ public:
 public:
   std::string MIKTEXTHISCALL GetContainerPathNoLock(const std::string& packageId, bool useDisplayNames);
 
+public:
+  std::vector<std::string> MIKTEXTHISCALL FindPackagesContainingFile(const std::string& fileName) override
+  {
+    NeedFileIndex();
+    return GetFileIndexNoLock().GetPackages(fileName);
+  }
+
+public:
+  std::map<std::string, std::vector<std::string>> MIKTEXTHISCALL FindFileConflicts() override
+  {
+    NeedFileIndex();
+    return GetFileIndexNoLock().GetConflicts();
+  }
+
+  /// Gets the file index; the index is rebuilt, if it is out of date.
+public:
+  FileIndex& GetFileIndexNoLock();
+
+  /// Updates the index entries of packages.
+  /// @param packageIds The packages which have been (re-)installed or removed.
+  /// @param oldSignature The signature of the package manifests before the changes.
+public:
+  void UpdateFileIndexNoLock(const std::vector<std::string>& packageIds, const std::string& oldSignature);
+
 public:
   InstallationSummary MIKTEXTHISCALL GetInstallationSummary(bool userScope) override;
 
@@ -203,6 +247,31 @@ public:
 public:
   void ClearAll();
 
+private:
+  bool IsFileIndexUpToDate();
+
+private:
+  void NeedFileIndex()
+  {
+    if (!IsFileIndexUpToDate())
+    {
+      MPM_LOCK_BEGIN(this)
+      {
+        GetFileIndexNoLock();
+      }
+      MPM_LOCK_END();
+    }
+  }
+
+private:
+  void SaveFileIndex();
+
+private:
+  MiKTeX::Core::PathName GetInstallPrefix(const MiKTeX::Packages::PackageInfo& packageInfo);
+
+private:
+  FileDigestCache& GetFileDigestCache();
+
 private:
   bool TryGetFileDigest(const MiKTeX::Core::PathName& prefix, const std::string& fileName, bool& haveDigest, MiKTeX::Core::MD5& digest);
 
@@ -251,6 +320,16 @@ public:
 private:
   PackageRepositoryDataStore repositories;
 
+private:
+  FileDigestCache fileDigestCache;
+
+private:
+  FileIndex fileIndex;
+
+  // true, if the data store has been loaded by LoadDatabase()
+private:
+  bool foreignDatabase = false;
+
 public:
   static std::string proxyUser;
 
@@ -0,0 +1,332 @@
+/* PackageManifestsSnapshot.cpp:
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of MiKTeX Package Manager.
+
+   MiKTeX Package Manager is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   MiKTeX Package Manager is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with MiKTeX Package Manager; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <cstring>
+
+#include <unordered_map>
+
+#include <miktex/Core/File>
+
+#include "internal.h"
+
+#include "PackageManifestsSnapshot.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Packages;
+
+using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
+
+// increment when the layout changes
+const uint32_t SNAPSHOT_VERSION = 1;
+
+// detects snapshots written on a machine with a different byte order
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+const char SNAPSHOT_MAGIC[8] = { 'M', 'P', 'M', 'S', 'N', 'A', 'P', '\0' };
+
+struct PackageManifestsSnapshot::Header
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrderMark;
+  uint64_t size;
+  StringRef signature;
+  uint32_t count;
+  uint32_t recordsOffset;
+  uint32_t listsOffset;
+  uint32_t stringsOffset;
+};
+
+struct PackageManifestsSnapshot::Record
+{
+  StringRef id;
+  StringRef displayName;
+  StringRef title;
+  StringRef version;
+  StringRef targetSystem;
+  StringRef description;
+  StringRef creator;
+  StringRef ctanPath;
+  StringRef licenseType;
+  StringRef copyrightOwner;
+  StringRef copyrightYear;
+  StringRef versionDate;
+  ListRef requiredPackages;
+  ListRef runFiles;
+  ListRef docFiles;
+  ListRef sourceFiles;
+  uint64_t sizeRunFiles;
+  uint64_t sizeDocFiles;
+  uint64_t sizeSourceFiles;
+  uint64_t archiveFileSize;
+  int64_t timePackaged;
+  uint8_t digest[16];
+};
+
+template<typename T> static void Append(vector<uint8_t>& buffer, const T& value)
+{
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+  buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+void PackageManifestsSnapshot::Write(const PathName& path, const string& signature, const vector<PackageInfo>& packages)
+{
+  // string table with shared duplicates
+  string strings;
+  unordered_map<string, StringRef> stringRefs;
+  auto addString = [&strings, &stringRefs](const string& s)
+  {
+    auto it = stringRefs.find(s);
+    if (it != stringRefs.end())
+    {
+      return it->second;
+    }
+    StringRef ref = { static_cast<uint32_t>(strings.length()), static_cast<uint32_t>(s.length()) };
+    strings += s;
+    stringRefs[s] = ref;
+    return ref;
+  };
+  vector<StringRef> lists;
+  auto addList = [&lists, &addString](const vector<string>& v)
+  {
+    ListRef ref = { static_cast<uint32_t>(lists.size()), static_cast<uint32_t>(v.size()) };
+    for (const string& s : v)
+    {
+      lists.push_back(addString(s));
+    }
+    return ref;
+  };
+
+  vector<Record> records;
+  records.reserve(packages.size());
+  for (const PackageInfo& packageInfo : packages)
+  {
+    Record record;
+    memset(&record, 0, sizeof(record));
+    record.id = addString(packageInfo.id);
+    record.displayName = addString(packageInfo.displayName);
+    record.title = addString(packageInfo.title);
+    record.version = addString(packageInfo.version);
+    record.targetSystem = addString(packageInfo.targetSystem);
+    record.description = addString(packageInfo.description);
+    record.creator = addString(packageInfo.creator);
+    record.ctanPath = addString(packageInfo.ctanPath);
+    record.licenseType = addString(packageInfo.licenseType);
+    record.copyrightOwner = addString(packageInfo.copyrightOwner);
+    record.copyrightYear = addString(packageInfo.copyrightYear);
+    record.versionDate = addString(packageInfo.versionDate);
+    record.requiredPackages = addList(packageInfo.requiredPackages);
+    record.runFiles = addList(packageInfo.runFiles);
+    record.docFiles = addList(packageInfo.docFiles);
+    record.sourceFiles = addList(packageInfo.sourceFiles);
+    record.sizeRunFiles = packageInfo.sizeRunFiles;
+    record.sizeDocFiles = packageInfo.sizeDocFiles;
+    record.sizeSourceFiles = packageInfo.sizeSourceFiles;
+    record.archiveFileSize = packageInfo.archiveFileSize;
+    record.timePackaged = packageInfo.timePackaged;
+    memcpy(record.digest, packageInfo.digest.data(), sizeof(record.digest));
+    records.push_back(record);
+  }
+
+  Header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+  header.version = SNAPSHOT_VERSION;
+  header.byteOrderMark = BYTE_ORDER_MARK;
+  header.signature = addString(signature);
+  header.count = static_cast<uint32_t>(records.size());
+  header.recordsOffset = sizeof(Header);
+  header.listsOffset = header.recordsOffset + static_cast<uint32_t>(records.size() * sizeof(Record));
+  header.stringsOffset = header.listsOffset + static_cast<uint32_t>(lists.size() * sizeof(StringRef));
+  header.size = header.stringsOffset + strings.length();
+
+  vector<uint8_t> buffer;
+  buffer.reserve(header.size);
+  Append(buffer, header);
+  for (const Record& record : records)
+  {
+    Append(buffer, record);
+  }
+  for (const StringRef& ref : lists)
+  {
+    Append(buffer, ref);
+  }
+  buffer.insert(buffer.end(), strings.begin(), strings.end());
+
+  WriteFileAtomically(path, ios_base::out | ios_base::binary, [&buffer](ostream& stream)
+  {
+    stream.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+  });
+}
+
+bool PackageManifestsSnapshot::Open(const PathName& path, const string& signature)
+{
+  Close();
+  if (!File::Exists(path))
+  {
+    return false;
+  }
+  mmap.reset(MemoryMappedFile::Create());
+  try
+  {
+    data = reinterpret_cast<const uint8_t*>(mmap->Open(path, false));
+    size = mmap->GetSize();
+  }
+  catch (const MiKTeXException&)
+  {
+    Close();
+    return false;
+  }
+  const Header& header = *reinterpret_cast<const Header*>(data);
+  bool valid = size >= sizeof(Header)
+    && memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) == 0
+    && header.version == SNAPSHOT_VERSION
+    && header.byteOrderMark == BYTE_ORDER_MARK
+    && header.size == size
+    && header.recordsOffset == sizeof(Header)
+    && header.listsOffset == header.recordsOffset + static_cast<uint64_t>(header.count) * sizeof(Record)
+    && header.stringsOffset >= header.listsOffset
+    && (header.stringsOffset - header.listsOffset) % sizeof(StringRef) == 0
+    && header.stringsOffset <= size
+    && IsValid(header.signature)
+    && GetString(header.signature) == signature;
+  // check the references once, so that the accessors can trust them
+  for (uint32_t idx = header.listsOffset; valid && idx < header.stringsOffset; idx += sizeof(StringRef))
+  {
+    valid = IsValid(*reinterpret_cast<const StringRef*>(data + idx));
+  }
+  for (Index idx = 0; valid && idx < header.count; ++idx)
+  {
+    const Record& record = GetRecord(idx);
+    valid = IsValid(record.id) && IsValid(record.displayName) && IsValid(record.title) && IsValid(record.version)
+      && IsValid(record.targetSystem) && IsValid(record.description) && IsValid(record.creator) && IsValid(record.ctanPath)
+      && IsValid(record.licenseType) && IsValid(record.copyrightOwner) && IsValid(record.copyrightYear) && IsValid(record.versionDate)
+      && IsValid(record.requiredPackages) && IsValid(record.runFiles) && IsValid(record.docFiles) && IsValid(record.sourceFiles);
+  }
+  if (!valid)
+  {
+    Close();
+  }
+  return valid;
+}
+
+void PackageManifestsSnapshot::Close()
+{
+  if (mmap != nullptr)
+  {
+    mmap->Close();
+    mmap = nullptr;
+  }
+  data = nullptr;
+  size = 0;
+}
+
+PackageManifestsSnapshot::Index PackageManifestsSnapshot::GetCount() const
+{
+  MIKTEX_ASSERT(IsOpen());
+  return reinterpret_cast<const Header*>(data)->count;
+}
+
+PackageInfo PackageManifestsSnapshot::GetPackageInfo(Index idx, bool withFiles) const
+{
+  const Record& record = GetRecord(idx);
+  PackageInfo packageInfo;
+  packageInfo.id = GetString(record.id);
+  packageInfo.displayName = GetString(record.displayName);
+  packageInfo.title = GetString(record.title);
+  packageInfo.version = GetString(record.version);
+  packageInfo.targetSystem = GetString(record.targetSystem);
+  packageInfo.description = GetString(record.description);
+  packageInfo.creator = GetString(record.creator);
+  packageInfo.ctanPath = GetString(record.ctanPath);
+  packageInfo.licenseType = GetString(record.licenseType);
+  packageInfo.copyrightOwner = GetString(record.copyrightOwner);
+  packageInfo.copyrightYear = GetString(record.copyrightYear);
+  packageInfo.versionDate = GetString(record.versionDate);
+  packageInfo.requiredPackages = GetStrings(record.requiredPackages);
+  packageInfo.sizeRunFiles = static_cast<size_t>(record.sizeRunFiles);
+  packageInfo.sizeDocFiles = static_cast<size_t>(record.sizeDocFiles);
+  packageInfo.sizeSourceFiles = static_cast<size_t>(record.sizeSourceFiles);
+  packageInfo.archiveFileSize = static_cast<size_t>(record.archiveFileSize);
+  packageInfo.timePackaged = static_cast<time_t>(record.timePackaged);
+  memcpy(packageInfo.digest.data(), record.digest, sizeof(record.digest));
+  if (withFiles)
+  {
+    GetFiles(idx, packageInfo);
+  }
+  return packageInfo;
+}
+
+void PackageManifestsSnapshot::GetFiles(Index idx, PackageInfo& packageInfo) const
+{
+  const Record& record = GetRecord(idx);
+  packageInfo.runFiles = GetStrings(record.runFiles);
+  packageInfo.docFiles = GetStrings(record.docFiles);
+  packageInfo.sourceFiles = GetStrings(record.sourceFiles);
+}
+
+unsigned long PackageManifestsSnapshot::GetNumFiles(Index idx) const
+{
+  const Record& record = GetRecord(idx);
+  return record.runFiles.count + record.docFiles.count + record.sourceFiles.count;
+}
+
+const PackageManifestsSnapshot::Record& PackageManifestsSnapshot::GetRecord(Index idx) const
+{
+  MIKTEX_ASSERT(IsOpen() && idx < GetCount());
+  const Header& header = *reinterpret_cast<const Header*>(data);
+  return reinterpret_cast<const Record*>(data + header.recordsOffset)[idx];
+}
+
+string PackageManifestsSnapshot::GetString(const StringRef& ref) const
+{
+  const Header& header = *reinterpret_cast<const Header*>(data);
+  return string(reinterpret_cast<const char*>(data + header.stringsOffset + ref.offset), ref.length);
+}
+
+vector<string> PackageManifestsSnapshot::GetStrings(const ListRef& ref) const
+{
+  const Header& header = *reinterpret_cast<const Header*>(data);
+  const StringRef* refs = reinterpret_cast<const StringRef*>(data + header.listsOffset) + ref.offset;
+  vector<string> result;
+  result.reserve(ref.count);
+  for (uint32_t idx = 0; idx < ref.count; ++idx)
+  {
+    result.push_back(GetString(refs[idx]));
+  }
+  return result;
+}
+
+bool PackageManifestsSnapshot::IsValid(const StringRef& ref) const
+{
+  const Header& header = *reinterpret_cast<const Header*>(data);
+  return static_cast<uint64_t>(header.stringsOffset) + ref.offset + ref.length <= size;
+}
+
+bool PackageManifestsSnapshot::IsValid(const ListRef& ref) const
+{
+  const Header& header = *reinterpret_cast<const Header*>(data);
+  return static_cast<uint64_t>(ref.offset) + ref.count <= (header.stringsOffset - header.listsOffset) / sizeof(StringRef);
+}
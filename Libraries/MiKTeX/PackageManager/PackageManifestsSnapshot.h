@@ -0,0 +1,148 @@
+/* PackageManifestsSnapshot.h:                          -*- C++ -*-
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of MiKTeX Package Manager.
+
+   MiKTeX Package Manager is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   MiKTeX Package Manager is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with MiKTeX Package Manager; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#pragma once
+
+#if !defined(C7A1E5F3B9D24E6A8F0B2D4C6E8A1B3D)
+#define C7A1E5F3B9D24E6A8F0B2D4C6E8A1B3D
+
+#include <cstdint>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <miktex/Core/MemoryMappedFile>
+#include <miktex/Core/PathName>
+
+#include <miktex/PackageManager/PackageManager>
+
+#include "internal.h"
+
+MPM_INTERNAL_BEGIN_NAMESPACE;
+
+/// @brief A binary snapshot of the package manifests.
+///
+/// The snapshot consists of fixed-size package records, which refer
+/// to a table of string lists and to a string table. The file is
+/// mapped into memory; package records are converted into `PackageInfo`
+/// objects on request.
+///
+/// The snapshot is tagged with a signature of the package manifest
+/// files from which it was created.
+class PackageManifestsSnapshot
+{
+public:
+  typedef std::uint32_t Index;
+
+  /// Creates a snapshot file.
+  /// @param path Path to the snapshot file.
+  /// @param signature The signature to be stored.
+  /// @param packages The package manifests.
+public:
+  static void Write(const MiKTeX::Core::PathName& path, const std::string& signature, const std::vector<MiKTeX::Packages::PackageInfo>& packages);
+
+  /// Maps a snapshot file into memory.
+  /// @param path Path to the snapshot file.
+  /// @param signature The expected signature.
+  /// @return Returns `false`, if the file does not exist, if it is not
+  /// valid or if it has a different signature.
+public:
+  bool Open(const MiKTeX::Core::PathName& path, const std::string& signature);
+
+public:
+  void Close();
+
+public:
+  bool IsOpen() const
+  {
+    return mmap != nullptr;
+  }
+
+public:
+  Index GetCount() const;
+
+  /// Gets a package manifest.
+  /// @param idx The record index.
+  /// @param withFiles Indicates whether the file lists are to be
+  /// retrieved.
+public:
+  MiKTeX::Packages::PackageInfo GetPackageInfo(Index idx, bool withFiles) const;
+
+  /// Retrieves the file lists of a package manifest.
+  /// @param idx The record index.
+  /// @param packageInfo The package record to be completed.
+public:
+  void GetFiles(Index idx, MiKTeX::Packages::PackageInfo& packageInfo) const;
+
+  /// Gets the number of files in a package.
+  /// @param idx The record index.
+public:
+  unsigned long GetNumFiles(Index idx) const;
+
+private:
+  struct StringRef
+  {
+    std::uint32_t offset;
+    std::uint32_t length;
+  };
+
+private:
+  struct ListRef
+  {
+    std::uint32_t offset;
+    std::uint32_t count;
+  };
+
+private:
+  struct Header;
+
+private:
+  struct Record;
+
+private:
+  const Record& GetRecord(Index idx) const;
+
+private:
+  std::string GetString(const StringRef& ref) const;
+
+private:
+  std::vector<std::string> GetStrings(const ListRef& ref) const;
+
+private:
+  bool IsValid(const StringRef& ref) const;
+
+private:
+  bool IsValid(const ListRef& ref) const;
+
+private:
+  std::unique_ptr<MiKTeX::Core::MemoryMappedFile> mmap;
+
+private:
+  const std::uint8_t* data = nullptr;
+
+private:
+  std::size_t size = 0;
+};
+
+MPM_INTERNAL_END_NAMESPACE;
+
+#endif
@@ -30,6 +30,7 @@
 
 #include <ctime>
 
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -168,13 +169,24 @@ public:
   /// @brief Verifies an installed package.
   ///
   /// This method reads all files in order to verify the integrity of
-  /// the package.
+  /// the package. File digests are cached for files which have not
+  /// changed since the last verification.
   /// 
   /// @param packageId Identifies the package.
   /// @return Returns `true`, if the package is correctly installed.
 public:
   virtual bool MIKTEXTHISCALL TryVerifyInstalledPackage(const std::string& packageId) = 0;
 
+  /// @brief Verifies installed packages.
+  ///
+  /// Like `TryVerifyInstalledPackage()`, but files which are not in
+  /// the digest cache are read in parallel.
+  ///
+  /// @param packageIds Identifies the packages.
+  /// @return Returns the packages which are not correctly installed.
+public:
+  virtual std::vector<std::string> MIKTEXTHISCALL VerifyInstalledPackages(const std::vector<std::string>& packageIds) = 0;
+
   /// Builds the container path of a package.
   /// @param packageId Identifies the package.
   /// @param useDisplayNames Indicates whether to use user friendly names.
@@ -182,6 +194,19 @@ public:
 public:
   virtual std::string MIKTEXTHISCALL GetContainerPath(const std::string& packageId, bool useDisplayNames) = 0;
 
+  /// Finds the packages which contain a file.
+  /// @param fileName The file, either a path relative to the TEXMF
+  /// root directory or a file name.
+  /// @return Returns the package IDs.
+public:
+  virtual std::vector<std::string> MIKTEXTHISCALL FindPackagesContainingFile(const std::string& fileName) = 0;
+
+  /// Finds files which are contained in more than one package.
+  /// @return Returns the files and the IDs of the packages which
+  /// contain them.
+public:
+  virtual std::map<std::string, std::vector<std::string>> MIKTEXTHISCALL FindFileConflicts() = 0;
+
   /// Gets the installation summary.
   /// @param common Indicates whether to retrieve a summary for the current user.
   /// @return Returns the installation summary.
@@ -24,6 +24,9 @@
 
 #include <ctime>
 
+#include <functional>
+#include <ios>
+#include <ostream>
 #include <string>
 
 #include <miktex/Core/PathName>
@@ -118,6 +121,10 @@ bool IsUrl(const std::string& url);
 
 std::string MakeUrl(const std::string& base, const std::string& rel);
 
+// writes a private file and moves it into place, so that readers never
+// see a partially written file
+void WriteFileAtomically(const MiKTeX::Core::PathName& path, std::ios_base::openmode mode, const std::function<void(std::ostream&)>& write);
+
 MPM_INTERNAL_END_NAMESPACE;
 
 #endif
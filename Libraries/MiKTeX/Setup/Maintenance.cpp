@@ -0,0 +1,297 @@
+/* Maintenance.cpp:
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 2, or (at your
+   option) any later version.
+
+   This file is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this file; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA. */
+
+#include "config.h"
+
+#include "internal.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Packages;
+using namespace MiKTeX::Setup;
+using namespace MiKTeX::Util;
+
+#define MAINTENANCE_SECTION "inputs"
+
+BEGIN_ANONYMOUS_NAMESPACE;
+
+// the roots whose file name databases are maintained in this mode
+bool IsMaintainedRoot(shared_ptr<Session> session, unsigned r)
+{
+  if (session->IsAdminMode())
+  {
+    return session->IsCommonRootDirectory(r);
+  }
+  return !session->IsCommonRootDirectory(r) || session->IsMiKTeXPortable();
+}
+
+time_t GetLastWriteTimeOrZero(const PathName& path)
+{
+  time_t time;
+  return File::TryGetLastWriteTime(path, time) ? time : 0;
+}
+
+vector<PathName> GetPackageManifests(shared_ptr<Session> session)
+{
+  vector<PathName> packageManifests{ session->GetSpecialPath(SpecialPath::CommonInstallRoot) / PathName(MIKTEX_PATH_PACKAGE_MANIFESTS_INI) };
+  if (!session->IsAdminMode())
+  {
+    packageManifests.push_back(session->GetSpecialPath(SpecialPath::UserInstallRoot) / PathName(MIKTEX_PATH_PACKAGE_MANIFESTS_INI));
+  }
+  return packageManifests;
+}
+
+// the inputs of a task: its configuration files plus the package
+// manifests (which change when packages are installed); the file name
+// databases can't be used because the tasks modify them
+string MakeSignature(shared_ptr<Session> session, const vector<string>& configFiles)
+{
+  string signature;
+  for (const string& configFile : configFiles)
+  {
+    vector<PathName> paths;
+    if (session->FindFile(configFile, MIKTEX_PATH_TEXMF_PLACEHOLDER, { Session::FindFileOption::All }, paths))
+    {
+      for (const PathName& path : paths)
+      {
+        signature += path.ToUnix().ToString() + ":" + std::to_string(GetLastWriteTimeOrZero(path)) + ";";
+      }
+    }
+  }
+  for (const PathName& path : GetPackageManifests(session))
+  {
+    signature += std::to_string(GetLastWriteTimeOrZero(path)) + ";";
+  }
+  return signature;
+}
+
+bool RefreshFndb(shared_ptr<Session> session, shared_ptr<PackageManager> packageManager, bool force)
+{
+  bool done = false;
+  for (unsigned r = 0; r < session->GetNumberOfTEXMFRoots(); ++r)
+  {
+    if (!IsMaintainedRoot(session, r))
+    {
+      continue;
+    }
+    // files may have been added to the root behind MiKTeX's back: its
+    // file name database is rebuilt (as initexmf --update-fndb does)
+    PathName fndbPath = session->GetFilenameDatabasePathName(r);
+    if (!session->UnloadFilenameDatabase())
+    {
+      MIKTEX_FATAL_ERROR(T_("The file name database could not be unloaded."));
+    }
+    Fndb::Create(fndbPath, session->GetRootDirectoryPath(r), nullptr);
+    done = true;
+  }
+  PackageInfo packageInfo;
+  if (!packageManager->TryGetPackageInfo("miktex-tex", packageInfo))
+  {
+    return done;
+  }
+  // the MPM file name database is derived from the package database and
+  // depends on the configuration of an admin
+  time_t mpmFndbTime = GetLastWriteTimeOrZero(session->GetMpmDatabasePathName());
+  bool mustCreateMpmFndb = force || mpmFndbTime == 0;
+  if (!session->IsAdminMode())
+  {
+    mustCreateMpmFndb = mustCreateMpmFndb || session->GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_LAST_ADMIN_MAINTENANCE, ConfigValue("0")).GetTimeT() > mpmFndbTime;
+  }
+  for (const PathName& path : GetPackageManifests(session))
+  {
+    mustCreateMpmFndb = mustCreateMpmFndb || GetLastWriteTimeOrZero(path) > mpmFndbTime;
+  }
+  if (mustCreateMpmFndb)
+  {
+    packageManager->CreateMpmFndb();
+    done = true;
+  }
+  return done;
+}
+
+void MakeMaps(shared_ptr<Session> session, const MaintenanceOptions& options)
+{
+  PathName mkfntmap;
+  if (!session->FindFile("mkfntmap", FileType::EXE, mkfntmap))
+  {
+    MIKTEX_FATAL_ERROR(T_("The mkfntmap executable could not be found."));
+  }
+  vector<string> arguments{ "mkfntmap" };
+  if (session->IsAdminMode())
+  {
+    arguments.push_back("--admin");
+  }
+  if (options.force)
+  {
+    arguments.push_back("--force");
+  }
+  switch (options.enableInstaller)
+  {
+  case TriState::True:
+    arguments.push_back("--enable-installer");
+    break;
+  case TriState::False:
+    arguments.push_back("--disable-installer");
+    break;
+  default:
+    break;
+  }
+  arguments.push_back("--miktex-disable-maintenance");
+  arguments.push_back("--miktex-disable-diagnose");
+  int exitCode;
+  if (!Process::Run(mkfntmap, arguments, nullptr, &exitCode, nullptr))
+  {
+    MIKTEX_FATAL_ERROR_2(T_("mkfntmap did not succeed."), "exitCode", std::to_string(exitCode));
+  }
+}
+
+void MakeLanguageDat(shared_ptr<Session> session)
+{
+  PathName languageDatPath = session->GetSpecialPath(SpecialPath::ConfigRoot) / PathName(MIKTEX_PATH_LANGUAGE_DAT);
+  ofstream languageDat = File::CreateOutputStream(languageDatPath);
+
+  PathName languageDatLuaPath = session->GetSpecialPath(SpecialPath::ConfigRoot) / PathName(MIKTEX_PATH_LANGUAGE_DAT_LUA);
+  ofstream languageDatLua = File::CreateOutputStream(languageDatLuaPath);
+
+  PathName languageDefPath = session->GetSpecialPath(SpecialPath::ConfigRoot) / PathName(MIKTEX_PATH_LANGUAGE_DEF);
+  ofstream languageDef = File::CreateOutputStream(languageDefPath);
+
+  languageDatLua << "return {" << "\n";
+  languageDef << "%% e-TeX V2.2" << "\n";
+
+  for (const LanguageInfo& languageInfo : session->GetLanguages())
+  {
+    if (languageInfo.exclude)
+    {
+      continue;
+    }
+
+    PathName loaderPath;
+    if (!session->FindFile(languageInfo.loader, "%r/tex//", loaderPath))
+    {
+      continue;
+    }
+
+    // language.dat
+    languageDat << languageInfo.key << " " << languageInfo.loader << "\n";
+    for (const string& synonym : StringUtil::Split(languageInfo.synonyms, ','))
+    {
+      languageDat << "=" << synonym << "\n";
+    }
+
+    // language.def
+    languageDef << "\\addlanguage{" << languageInfo.key << "}{" << languageInfo.loader << "}{}{" << languageInfo.lefthyphenmin << "}{" << languageInfo.righthyphenmin << "}" << "\n";
+
+    // language.dat.lua
+    languageDatLua << "\t['" << languageInfo.key << "'] = {" << "\n";
+    languageDatLua << "\t\tloader='" << languageInfo.loader << "'," << "\n";
+    languageDatLua << "\t\tlefthyphenmin=" << languageInfo.lefthyphenmin << "," << "\n";
+    languageDatLua << "\t\trighthyphenmin=" << languageInfo.righthyphenmin << "," << "\n";
+    languageDatLua << "\t\tsynonyms={ ";
+    int nSyn = 0;
+    for (const string& synonym : StringUtil::Split(languageInfo.synonyms, ','))
+    {
+      languageDatLua << (nSyn > 0 ? "," : "") << "'" << synonym << "'";
+      nSyn++;
+    }
+    languageDatLua << " }," << "\n";
+    languageDatLua << "\t\tpatterns='" << languageInfo.patterns << "'," << "\n";
+    languageDatLua << "\t\thyphenation='" << languageInfo.hyphenation << "'," << "\n";
+    if (!languageInfo.luaspecial.empty())
+    {
+      languageDatLua << "\t\tspecial='" << languageInfo.luaspecial << "'," << "\n";
+    }
+    languageDatLua << "\t}," << "\n";
+  }
+
+  languageDatLua << "}" << "\n";
+
+  languageDatLua.close();
+  Fndb::Add({ {languageDatLuaPath} });
+
+  languageDef.close();
+  Fndb::Add({ {languageDefPath} });
+
+  languageDat.close();
+  Fndb::Add({ {languageDatPath} });
+}
+
+END_ANONYMOUS_NAMESPACE;
+
+MaintenanceTaskSet SetupService::RunMaintenance(const MaintenanceOptions& options)
+{
+  shared_ptr<Session> session = Session::Get();
+  shared_ptr<PackageManager> packageManager = options.packageManager;
+  if (packageManager == nullptr)
+  {
+    packageManager = PackageManager::Create();
+  }
+
+  // the signatures of the inputs of the previous runs
+  PathName maintenanceIni = session->GetSpecialPath(SpecialPath::DataRoot) / PathName(MIKTEX_PATH_MAINTENANCE_INI);
+  unique_ptr<Cfg> inputs(Cfg::Create());
+  if (File::Exists(maintenanceIni))
+  {
+    inputs->Read(maintenanceIni);
+  }
+
+  MaintenanceTaskSet done;
+
+  // FNDB first: the other tasks search files
+  if (options.tasks[MaintenanceTask::RefreshFndb] && RefreshFndb(session, packageManager, options.force))
+  {
+    done += MaintenanceTask::RefreshFndb;
+  }
+
+  string oldSignature;
+
+  if (options.tasks[MaintenanceTask::MakeMaps])
+  {
+    string signature = MakeSignature(session, { MIKTEX_PATH_MKFNTMAP_CFG, MIKTEX_PATH_UPDMAP_CFG, MIKTEX_PATH_WEB2C_DIR MIKTEX_PATH_DIRECTORY_DELIMITER_STRING MIKTEX_UPDMAP_CFG_FILENAME });
+    if (options.force || !inputs->TryGetValueAsString(MAINTENANCE_SECTION, "maps", oldSignature) || oldSignature != signature)
+    {
+      MakeMaps(session, options);
+      inputs->PutValue(MAINTENANCE_SECTION, "maps", signature);
+      done += MaintenanceTask::MakeMaps;
+    }
+  }
+
+  if (options.tasks[MaintenanceTask::MakeLanguageDat])
+  {
+    string signature = MakeSignature(session, { MIKTEX_PATH_LANGUAGES_INI });
+    if (options.force
+      || !inputs->TryGetValueAsString(MAINTENANCE_SECTION, "languages", oldSignature)
+      || oldSignature != signature
+      || !File::Exists(session->GetSpecialPath(SpecialPath::ConfigRoot) / PathName(MIKTEX_PATH_LANGUAGE_DAT)))
+    {
+      MakeLanguageDat(session);
+      inputs->PutValue(MAINTENANCE_SECTION, "languages", signature);
+      done += MaintenanceTask::MakeLanguageDat;
+    }
+  }
+
+  if (inputs->IsModified())
+  {
+    Directory::Create(PathName(maintenanceIni).RemoveFileSpec());
+    inputs->Write(maintenanceIni);
+  }
+
+  return done;
+}
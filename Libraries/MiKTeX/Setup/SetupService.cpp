@@ -2104,24 +2104,26 @@ vector<Issue> SetupService::FindIssues(bool checkPath, bool checkPackageIntegrit
   {
     unique_ptr<PackageIterator> pkgIter(packageManager->CreateIterator());
     PackageInfo packageInfo;
-    for (int idx = 0; pkgIter->GetNext(packageInfo); ++idx)
+    vector<string> toBeVerified;
+    while (pkgIter->GetNext(packageInfo))
     {
       if (!packageInfo.IsPureContainer()
         && packageInfo.IsInstalled()
         && packageInfo.id.compare(0, 7, "miktex-") == 0)
       {
-        if (!(packageManager->TryVerifyInstalledPackage(packageInfo.id)))
-        {
-          result.push_back({
-            IssueType::PackageDamaged,
-            IssueSeverity::Critical,
-            fmt::format(T_("Package {0} has been tampered with."), packageInfo.id),
-            T_("") // TODO
-          });
-        }
+        toBeVerified.push_back(packageInfo.id);
       }
     }
     pkgIter->Dispose();
+    for (const string& packageId : packageManager->VerifyInstalledPackages(toBeVerified))
+    {
+      result.push_back({
+        IssueType::PackageDamaged,
+        IssueSeverity::Critical,
+        fmt::format(T_("Package {0} has been tampered with."), packageId),
+        T_("") // TODO
+      });
+    }
   }
   PathName issuesJson = session->GetSpecialPath(SpecialPath::ConfigRoot) / PathName(MIKTEX_PATH_ISSUES_JSON);
   Directory::Create(issuesJson.GetDirectoryName());
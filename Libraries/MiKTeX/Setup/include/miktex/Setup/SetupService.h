@@ -99,6 +99,30 @@ enum class ReportOption
 
 typedef MiKTeX::Core::OptionSet<ReportOption> ReportOptionSet;
 
+enum class MaintenanceTask
+{
+  RefreshFndb,
+  MakeMaps,
+  MakeLanguageDat
+};
+
+typedef MiKTeX::Core::OptionSet<MaintenanceTask> MaintenanceTaskSet;
+
+struct MaintenanceOptions
+{
+  /// The tasks to be run.
+  MaintenanceTaskSet tasks;
+
+  /// Run the tasks even if their inputs have not changed.
+  bool force = false;
+
+  /// Passed on to the programs run by a task.
+  MiKTeX::Core::TriState enableInstaller = MiKTeX::Core::TriState::Undetermined;
+
+  /// Package manager to be used; a new one is created if null.
+  std::shared_ptr<MiKTeX::Packages::PackageManager> packageManager;
+};
+
 enum class IssueType
 {
   Path,
@@ -448,6 +472,14 @@ public:
 
 public:
   static MIKTEXSETUPCEEAPI(std::vector<Issue>) GetIssues();
+
+  /// Runs maintenance tasks in this process, using the current session.
+  /// A task is skipped if its inputs have not changed since the
+  /// last run.
+  /// @param options Specifies the tasks.
+  /// @return Returns the tasks which have actually been run.
+public:
+  static MIKTEXSETUPCEEAPI(MaintenanceTaskSet) RunMaintenance(const MaintenanceOptions& options);
 };
 
 MIKTEX_SETUP_END_NAMESPACE;
@@ -45,6 +45,7 @@
 #include <miktex/Core/File>
 #include <miktex/Core/FileStream>
 #include <miktex/Core/FileType>
+#include <miktex/Core/Fndb>
 #include <miktex/Core/Paths>
 #include <miktex/Core/Process>
 #include <miktex/Core/Quoter>
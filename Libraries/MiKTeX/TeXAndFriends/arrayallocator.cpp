@@ -0,0 +1,360 @@
+/* arrayallocator.cpp: allocator for dynamic arrays
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of the MiKTeX TeXMF Library.
+
+   The MiKTeX TeXMF Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX TeXMF Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX TeXMF Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#if defined(MIKTEX_WINDOWS)
+#  include <Windows.h>
+#else
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+
+#include <cstdint>
+#include <cstring>
+
+#include <miktex/Core/Session>
+
+#if defined(MIKTEX_TEXMF_SHARED)
+#  define MIKTEXMFEXPORT MIKTEXDLLEXPORT
+#else
+#  define MIKTEXMFEXPORT
+#endif
+#define B8C7815676699B4EA2DE96F0BD727276
+#include "miktex/TeXAndFriends/ArrayAllocator.h"
+
+#include "internal.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::TeXAndFriends;
+
+// arrays smaller than this live on the heap
+constexpr size_t MIN_MAPPED_SIZE = 256 * 1024;
+
+// minimum address space reserved for an array; address space is cheap
+// on 64-bit systems, but not on 32-bit systems
+constexpr size_t MIN_RESERVATION = sizeof(void*) >= 8 ? 64 * 1024 * 1024 : 0;
+
+// alignment of reservations, so that huge pages can be used
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// An array in reserved address space: the first `committed` bytes are
+// accessible, the remainder of the reservation is not.
+struct Region
+{
+  string arrayName;
+  char* base = nullptr;
+  size_t reserved = 0;
+  size_t committed = 0;
+  unsigned growCount = 0;
+  unsigned moveCount = 0;
+};
+
+class ArrayAllocator::impl
+{
+public:
+  Region Reserve(const string& arrayName, size_t amount);
+
+public:
+  void Release(Region& region);
+
+public:
+  void Commit(Region& region, size_t amount);
+
+public:
+  size_t GetResidentSize(const Region& region) const;
+
+public:
+  size_t RoundUp(size_t n, size_t alignment) const
+  {
+    return (n + alignment - 1) / alignment * alignment;
+  }
+
+public:
+  size_t pageSize = 0;
+
+public:
+  bool hugePages = false;
+
+public:
+  map<const void*, Region> regions;
+
+public:
+  unordered_map<string, size_t> heapArrays;
+};
+
+#if defined(MIKTEX_WINDOWS)
+
+Region ArrayAllocator::impl::Reserve(const string& arrayName, size_t amount)
+{
+  Region region;
+  region.arrayName = arrayName;
+  region.reserved = RoundUp(max(amount * 2, MIN_RESERVATION), HUGE_PAGE_SIZE);
+  region.base = reinterpret_cast<char*>(VirtualAlloc(nullptr, region.reserved, MEM_RESERVE, PAGE_NOACCESS));
+  if (region.base == nullptr)
+  {
+    MIKTEX_FATAL_WINDOWS_ERROR_2("VirtualAlloc", "arrayName", arrayName);
+  }
+  return region;
+}
+
+void ArrayAllocator::impl::Release(Region& region)
+{
+  if (!VirtualFree(region.base, 0, MEM_RELEASE))
+  {
+    MIKTEX_FATAL_WINDOWS_ERROR_2("VirtualFree", "arrayName", region.arrayName);
+  }
+  region.base = nullptr;
+}
+
+void ArrayAllocator::impl::Commit(Region& region, size_t amount)
+{
+  size_t committed = RoundUp(amount, pageSize);
+  if (committed > region.committed)
+  {
+    if (VirtualAlloc(region.base + region.committed, committed - region.committed, MEM_COMMIT, PAGE_READWRITE) == nullptr)
+    {
+      MIKTEX_FATAL_WINDOWS_ERROR_2("VirtualAlloc", "arrayName", region.arrayName);
+    }
+  }
+  else if (committed < region.committed)
+  {
+    if (!VirtualFree(region.base + committed, region.committed - committed, MEM_DECOMMIT))
+    {
+      MIKTEX_FATAL_WINDOWS_ERROR_2("VirtualFree", "arrayName", region.arrayName);
+    }
+  }
+  region.committed = committed;
+}
+
+// committed pages do not materialize before they are touched, but
+// finding out which ones have been touched is expensive
+size_t ArrayAllocator::impl::GetResidentSize(const Region& region) const
+{
+  return region.committed;
+}
+
+#else
+
+Region ArrayAllocator::impl::Reserve(const string& arrayName, size_t amount)
+{
+  Region region;
+  region.arrayName = arrayName;
+  region.reserved = RoundUp(max(amount * 2, MIN_RESERVATION), HUGE_PAGE_SIZE);
+  // over-allocate, so that the reservation can be aligned
+  size_t size = region.reserved + HUGE_PAGE_SIZE;
+  void* ptr = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (ptr == MAP_FAILED)
+  {
+    MIKTEX_FATAL_CRT_ERROR_2("mmap", "arrayName", arrayName);
+  }
+  char* start = reinterpret_cast<char*>(ptr);
+  region.base = reinterpret_cast<char*>(RoundUp(reinterpret_cast<uintptr_t>(start), HUGE_PAGE_SIZE));
+  size_t head = region.base - start;
+  size_t tail = size - head - region.reserved;
+  if ((head > 0 && munmap(start, head) != 0) || (tail > 0 && munmap(region.base + region.reserved, tail) != 0))
+  {
+    MIKTEX_FATAL_CRT_ERROR_2("munmap", "arrayName", arrayName);
+  }
+#if defined(MADV_HUGEPAGE)
+  if (hugePages)
+  {
+    // only a hint: the kernel may not support transparent huge pages
+    madvise(region.base, region.reserved, MADV_HUGEPAGE);
+  }
+#endif
+  return region;
+}
+
+void ArrayAllocator::impl::Release(Region& region)
+{
+  if (munmap(region.base, region.reserved) != 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR_2("munmap", "arrayName", region.arrayName);
+  }
+  region.base = nullptr;
+}
+
+void ArrayAllocator::impl::Commit(Region& region, size_t amount)
+{
+  size_t committed = RoundUp(amount, pageSize);
+  if (committed > region.committed)
+  {
+    if (mprotect(region.base + region.committed, committed - region.committed, PROT_READ | PROT_WRITE) != 0)
+    {
+      MIKTEX_FATAL_CRT_ERROR_2("mprotect", "arrayName", region.arrayName);
+    }
+  }
+  else if (committed < region.committed)
+  {
+    // replacing the pages gives them back to the system
+    if (mmap(region.base + committed, region.committed - committed, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0) == MAP_FAILED)
+    {
+      MIKTEX_FATAL_CRT_ERROR_2("mmap", "arrayName", region.arrayName);
+    }
+  }
+  region.committed = committed;
+}
+
+size_t ArrayAllocator::impl::GetResidentSize(const Region& region) const
+{
+  size_t numPages = region.committed / pageSize;
+#if defined(MIKTEX_MACOS)
+  vector<char> pages(numPages);
+#else
+  vector<unsigned char> pages(numPages);
+#endif
+  if (numPages == 0 || mincore(region.base, region.committed, pages.data()) != 0)
+  {
+    return 0;
+  }
+  return count_if(pages.begin(), pages.end(), [](unsigned char page) { return (page & 1) != 0; }) * pageSize;
+}
+
+#endif
+
+ArrayAllocator::ArrayAllocator() :
+  pimpl(make_unique<impl>())
+{
+#if defined(MIKTEX_WINDOWS)
+  SYSTEM_INFO systemInfo;
+  GetSystemInfo(&systemInfo);
+  pimpl->pageSize = systemInfo.dwPageSize;
+#else
+  pimpl->pageSize = sysconf(_SC_PAGESIZE);
+#endif
+}
+
+ArrayAllocator::~ArrayAllocator() noexcept
+{
+  try
+  {
+    for (auto& r : pimpl->regions)
+    {
+      pimpl->Release(r.second);
+    }
+  }
+  catch (const exception&)
+  {
+  }
+}
+
+void* ArrayAllocator::Reallocate(const string& arrayName, void* ptr, size_t amount, const SourceLocation& sourceLocation)
+{
+  auto it = pimpl->regions.find(ptr);
+#if defined(MIKTEX_DEBUG)
+  // keep the heap pointer assertions valid
+  bool useHeap = true;
+#else
+  // a heap block stays on the heap: its size is not known
+  bool useHeap = it == pimpl->regions.end() && (ptr != nullptr || amount < MIN_MAPPED_SIZE);
+#endif
+  if (useHeap)
+  {
+    ptr = MiKTeX::Debug::Realloc(ptr, amount, sourceLocation);
+    if (amount == 0)
+    {
+      pimpl->heapArrays.erase(arrayName);
+    }
+    else
+    {
+      pimpl->heapArrays[arrayName] = amount;
+    }
+    return ptr;
+  }
+  if (it == pimpl->regions.end())
+  {
+    Region region = pimpl->Reserve(arrayName, amount);
+    pimpl->Commit(region, amount);
+    ptr = region.base;
+    pimpl->regions[ptr] = region;
+    return ptr;
+  }
+  Region& region = it->second;
+  if (amount == 0)
+  {
+    pimpl->Release(region);
+    pimpl->regions.erase(it);
+    return nullptr;
+  }
+  if (amount <= region.reserved)
+  {
+    if (amount > region.committed)
+    {
+      region.growCount++;
+    }
+    pimpl->Commit(region, amount);
+    return ptr;
+  }
+  // the array has outgrown its reservation
+  Region newRegion = pimpl->Reserve(arrayName, amount);
+  pimpl->Commit(newRegion, amount);
+  memcpy(newRegion.base, region.base, region.committed);
+  newRegion.growCount = region.growCount + 1;
+  newRegion.moveCount = region.moveCount + 1;
+  pimpl->Release(region);
+  pimpl->regions.erase(it);
+  ptr = newRegion.base;
+  pimpl->regions[ptr] = newRegion;
+  return ptr;
+}
+
+bool ArrayAllocator::Owns(const void* ptr) const
+{
+  return pimpl->regions.find(ptr) != pimpl->regions.end();
+}
+
+void ArrayAllocator::EnableHugePages(bool enable)
+{
+  pimpl->hugePages = enable;
+}
+
+vector<ArrayUsage> ArrayAllocator::GetUsage() const
+{
+  vector<ArrayUsage> result;
+  for (const auto& r : pimpl->regions)
+  {
+    ArrayUsage usage;
+    usage.arrayName = r.second.arrayName;
+    usage.mapped = true;
+    usage.reserved = r.second.reserved;
+    usage.committed = r.second.committed;
+    usage.resident = pimpl->GetResidentSize(r.second);
+    usage.growCount = r.second.growCount;
+    usage.moveCount = r.second.moveCount;
+    result.push_back(usage);
+  }
+  for (const auto& a : pimpl->heapArrays)
+  {
+    ArrayUsage usage;
+    usage.arrayName = a.first;
+    usage.reserved = a.second;
+    usage.committed = a.second;
+    usage.resident = a.second;
+    result.push_back(usage);
+  }
+  sort(result.begin(), result.end(), [](const ArrayUsage& a, const ArrayUsage& b) { return a.committed > b.committed; });
+  return result;
+}
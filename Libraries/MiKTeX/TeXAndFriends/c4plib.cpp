@@ -55,7 +55,7 @@ void C4P_text::DiscardLine()
   }
 }
 
-inline bool C4P_text::IsTerminal()
+bool FileRoot::CheckTerminal() const
 {
   int fd = fileno(file);
   if (fd < 0)
@@ -81,6 +81,11 @@ char C4P_text::GetChar()
   AssertValid();
   if (!IsPascalFileIO())
   {
+    if (IsTerminal())
+    {
+      // the prompt must be visible before we wait for the user
+      fflush(stdout);
+    }
     PascalFileIO(true);
     bufref() = GetC(file);
   }
@@ -157,6 +162,10 @@ bool FileRoot::Open(const PathName& path, FileMode mode, FileAccess access, bool
     }
   }
   Attach(file, true);
+  if (access == FileAccess::Write)
+  {
+    setvbuf(file, nullptr, _IOFBF, OUTPUT_BUFFER_SIZE);
+  }
   return true;
 }
 
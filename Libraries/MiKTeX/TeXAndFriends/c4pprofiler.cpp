@@ -0,0 +1,245 @@
+/* c4pprofiler.cpp: C4P routine profiler
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of the MiKTeX TeXMF Library.
+
+   The MiKTeX TeXMF Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX TeXMF Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX TeXMF Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#if defined(MIKTEX_TEXMF_SHARED)
+#  define C4PEXPORT MIKTEXDLLEXPORT
+#else
+#  define C4PEXPORT
+#endif
+#define C1F0C63F01D5114A90DDF8FC10FF410B
+#include "miktex/C4P/C4P.h"
+
+#include "internal.h"
+
+#if defined(MIKTEX_C4P_PROFILING)
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+
+using namespace C4P;
+
+class RoutineProfiler::impl
+{
+public:
+  void Sample();
+
+public:
+  void StopSampling();
+
+public:
+  void WriteTable(ostream& stream);
+
+public:
+  void WriteFoldedStacks(ostream& stream);
+
+public:
+  RoutineStack stack;
+
+public:
+  vector<string> routineNames;
+
+public:
+  PathName outputPath;
+
+public:
+  chrono::microseconds interval;
+
+public:
+  chrono::steady_clock::time_point startTime;
+
+public:
+  chrono::steady_clock::time_point stopTime;
+
+public:
+  map<vector<int>, uint64_t> samples;
+
+public:
+  uint64_t sampleCount = 0;
+
+public:
+  mutex mtx;
+
+public:
+  condition_variable stopCondition;
+
+public:
+  bool stopRequested = false;
+
+public:
+  thread sampler;
+};
+
+RoutineProfiler::RoutineProfiler(const char* const* routineNames, size_t count, const PathName& outputPath, unsigned intervalMicroseconds) :
+  pimpl(make_unique<impl>())
+{
+  MIKTEX_ASSERT(count > 0);
+  pimpl->routineNames.assign(routineNames, routineNames + count);
+  pimpl->outputPath = outputPath;
+  pimpl->interval = chrono::microseconds(max(intervalMicroseconds, 1u));
+  pimpl->stack.calls.resize(count);
+  for (auto& h : pimpl->stack.handles)
+  {
+    h.store(0, memory_order_relaxed);
+  }
+  pimpl->startTime = chrono::steady_clock::now();
+  pimpl->sampler = thread(&impl::Sample, pimpl.get());
+}
+
+RoutineProfiler::~RoutineProfiler()
+{
+  pimpl->StopSampling();
+}
+
+RoutineStack& RoutineProfiler::GetStack()
+{
+  return pimpl->stack;
+}
+
+void RoutineProfiler::impl::StopSampling()
+{
+  if (!sampler.joinable())
+  {
+    return;
+  }
+  {
+    lock_guard<mutex> lock(mtx);
+    stopRequested = true;
+  }
+  stopCondition.notify_one();
+  sampler.join();
+  stopTime = chrono::steady_clock::now();
+}
+
+void RoutineProfiler::impl::Sample()
+{
+  vector<int> snapshot;
+  unique_lock<mutex> lock(mtx);
+  while (!stopCondition.wait_for(lock, interval, [this] { return stopRequested; }))
+  {
+    // the snapshot may be torn, which is acceptable for a statistical profile
+    int depth = min(stack.depth.load(memory_order_acquire), RoutineStack::MAX_DEPTH);
+    snapshot.clear();
+    for (int idx = 0; idx < depth; ++idx)
+    {
+      int handle = stack.handles[idx].load(memory_order_relaxed);
+      if (handle > 0 && handle < static_cast<int>(routineNames.size()))
+      {
+        snapshot.push_back(handle);
+      }
+    }
+    samples[snapshot] += 1;
+    sampleCount += 1;
+  }
+}
+
+void RoutineProfiler::WriteReport()
+{
+  pimpl->StopSampling();
+  ofstream stream = File::CreateOutputStream(pimpl->outputPath);
+  if (pimpl->outputPath.HasExtension(".folded"))
+  {
+    pimpl->WriteFoldedStacks(stream);
+  }
+  else
+  {
+    pimpl->WriteTable(stream);
+  }
+  stream.close();
+}
+
+void RoutineProfiler::impl::WriteTable(ostream& stream)
+{
+  size_t count = routineNames.size();
+  vector<uint64_t> self(count, 0);
+  vector<uint64_t> total(count, 0);
+  vector<const vector<int>*> lastSeen(count, nullptr);
+  for (const auto& s : samples)
+  {
+    int top = s.first.empty() ? 0 : s.first.back();
+    self[top] += s.second;
+    total[0] += s.second;
+    for (int handle : s.first)
+    {
+      // count recursive routines once per sample
+      if (lastSeen[handle] != &s.first)
+      {
+        lastSeen[handle] = &s.first;
+        total[handle] += s.second;
+      }
+    }
+  }
+  stack.calls[0] = 1;
+
+  vector<size_t> order;
+  for (size_t handle = 0; handle < count; ++handle)
+  {
+    if (stack.calls[handle] > 0 || total[handle] > 0)
+    {
+      order.push_back(handle);
+    }
+  }
+  sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return self[a] != self[b] ? self[a] > self[b] : total[a] != total[b] ? total[a] > total[b] : stack.calls[a] > stack.calls[b];
+  });
+
+  double elapsed = chrono::duration<double, milli>(stopTime - startTime).count();
+  double msPerSample = sampleCount > 0 ? elapsed / sampleCount : 0.0;
+  double percentPerSample = sampleCount > 0 ? 100.0 / sampleCount : 0.0;
+  stream << fmt::format("{0}: {1} samples in {2:.3f} s ({3:.3f} ms per sample)\n\n", routineNames[0], sampleCount, elapsed / 1000.0, msPerSample);
+  stream << fmt::format("{0:>14} {1:>11} {2:>7} {3:>11} {4:>7}  {5}\n", "calls", "self ms", "self %", "total ms", "total %", "routine");
+  for (size_t handle : order)
+  {
+    stream << fmt::format("{0:>14} {1:>11.1f} {2:>7.2f} {3:>11.1f} {4:>7.2f}  {5}\n",
+      stack.calls[handle],
+      self[handle] * msPerSample,
+      self[handle] * percentPerSample,
+      total[handle] * msPerSample,
+      total[handle] * percentPerSample,
+      routineNames[handle]);
+  }
+}
+
+void RoutineProfiler::impl::WriteFoldedStacks(ostream& stream)
+{
+  for (const auto& s : samples)
+  {
+    stream << routineNames[0];
+    for (int handle : s.first)
+    {
+      stream << ';' << routineNames[handle];
+    }
+    stream << ' ' << s.second << '\n';
+  }
+}
+
+#endif
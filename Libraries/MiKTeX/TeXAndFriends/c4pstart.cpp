@@ -21,11 +21,6 @@
 
 #if defined(MIKTEX_WINDOWS)
 #include <Windows.h>
-#include <io.h>
-#endif
-
-#if defined(MIKTEX_UNIX)
-#include <unistd.h>
 #endif
 
 #include <fmt/format.h>
@@ -84,11 +79,17 @@ public:
 #if defined(MIKTEX_WINDOWS)
 public:
   bool utf8ConsoleIssue = false;
+public:
+  UINT consoleOutputCP = 0;
 #endif
 public:
   bool terminalIssue = false;
 public:
   Runtime runtime;
+#if defined(MIKTEX_C4P_PROFILING)
+public:
+  unique_ptr<RoutineProfiler> profiler;
+#endif
 };
 
 C4P::ProgramBase::ProgramBase() :
@@ -141,6 +142,17 @@ void C4P::ProgramBase::Initialize(const char* programName, int argc, char* argv[
   pimpl->runtime.standardTextFiles[0].Attach(stdin, false);
   pimpl->runtime.standardTextFiles[1].Attach(stdout, false);
   pimpl->runtime.standardTextFiles[2].Attach(stderr, false);
+#if defined(MIKTEX_WINDOWS)
+  pimpl->consoleOutputCP = GetConsoleOutputCP();
+#else
+  if (pimpl->runtime.standardTextFiles[1].IsTerminal())
+  {
+    // a line buffered terminal costs a write per line; the program
+    // flushes its terminal output at interaction points (break(term_out))
+    fflush(stdout);
+    setvbuf(stdout, nullptr, _IOFBF, OUTPUT_BUFFER_SIZE);
+  }
+#endif
   *input = '\n';
   *output = '\0';
   *c4perroroutput = '\0';
@@ -149,6 +161,15 @@ void C4P::ProgramBase::Initialize(const char* programName, int argc, char* argv[
 
 C4PTHISAPI(void) C4P::ProgramBase::Finish()
 {
+  fflush(stdout);
+#if defined(MIKTEX_C4P_PROFILING)
+  if (pimpl->profiler != nullptr)
+  {
+    routineStack = nullptr;
+    unique_ptr<RoutineProfiler> profiler = std::move(pimpl->profiler);
+    profiler->WriteReport();
+  }
+#endif
 #if defined(MIKTEX_WINDOWS)
   if (pimpl->utf8ConsoleIssue)
   {
@@ -165,6 +186,25 @@ C4PTHISAPI(void) C4P::ProgramBase::Finish()
   pimpl->runtime.programName = "";
 }
 
+#if defined(MIKTEX_C4P_PROFILING)
+C4PTHISAPI(void) C4P::ProgramBase::StartProfiler(const char* const* routineNames, size_t count)
+{
+  string outputPath;
+  if (pimpl->profiler != nullptr || !Utils::GetEnvironmentString("MIKTEX_C4P_PROFILE", outputPath) || outputPath.empty())
+  {
+    return;
+  }
+  unsigned interval = 1000;
+  string intervalString;
+  if (Utils::GetEnvironmentString("MIKTEX_C4P_PROFILE_INTERVAL", intervalString))
+  {
+    interval = std::stoul(intervalString);
+  }
+  pimpl->profiler = make_unique<RoutineProfiler>(routineNames, count, PathName(outputPath), interval);
+  routineStack = &pimpl->profiler->GetStack();
+}
+#endif
+
 C4PTHISAPI(void) C4P::ProgramBase::SetParent(Application* parent)
 {
   pimpl->parent = parent;
@@ -274,44 +314,29 @@ C4P::C4P_text* C4P::ProgramBase::GetStdFilePtr(unsigned idx)
   return &pimpl->runtime.standardTextFiles[idx];
 }
 
-void C4P::ProgramBase::WriteChar(int ch, FILE* file)
+void C4P::ProgramBase::WriteCharToTerminal(int ch, FILE* file)
 {
   constexpr char FAILCHAR = '?';
-  int fd = fileno(file);
-  if (fd < 0)
+  if (file == stderr)
   {
-    MIKTEX_FATAL_CRT_ERROR("fileno");
+    // keep the order of terminal output and error output
+    fflush(stdout);
   }
-  int fdStdOut = (stdout != nullptr ? fileno(stdout) : -1);
-  int fdStdErr = (stderr != nullptr ? fileno(stderr) : -1);
-  bool isTerminal = (fd == fdStdOut || fd == fdStdErr);
 #if defined(MIKTEX_WINDOWS)
-  isTerminal = isTerminal && _isatty(fd);
-#else
-  isTerminal = isTerminal && isatty(fd);
-#endif
-#if defined(MIKTEX_WINDOWS)
-  if (static_cast<unsigned char>(ch) > 127 && isTerminal && GetConsoleOutputCP() != 65001)
+  if (static_cast<unsigned char>(ch) > 127 && pimpl->consoleOutputCP != 65001)
   {
     pimpl->utf8ConsoleIssue = true;
     ch = FAILCHAR;
   }
 #endif
-  if (putc(ch, file) == EOF)
+  if (PutChar(ch, file) == EOF)
   {
     int errCode = errno;
-    if (!isTerminal)
-    {
-      MIKTEX_FATAL_CRT_ERROR("putc");
-    }
-    else
+    pimpl->parent->LogWarn(fmt::format("could not write &#{0} to the terminal: errno {1}: {2}", ch, errCode, strerror(errCode)));
+    pimpl->terminalIssue = true;
+    if (ch != FAILCHAR)
     {
-      pimpl->parent->LogWarn(fmt::format("could not write &#{0} to the terminal: errno {1}: {2}", ch, errCode, strerror(errCode)));
-      pimpl->terminalIssue = true;
-      if (ch != FAILCHAR)
-      {
-        putc(FAILCHAR, file);
-      }
+      PutChar(FAILCHAR, file);
     }
   }
 }
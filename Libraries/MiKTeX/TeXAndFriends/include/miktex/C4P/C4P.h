@@ -37,6 +37,10 @@
 
 #include <exception>
 #include <memory>
+#if defined(MIKTEX_C4P_PROFILING)
+#include <atomic>
+#include <cstdint>
+#endif
 #include <string>
 #include <vector>
 
@@ -80,13 +84,32 @@ typedef double C4P_longreal;
 // assert (sizeof(bool) == 1)
 typedef bool C4P_boolean;
 
+/// Writes a character without locking the stream.
+///
+/// The files of a Pascal program are used by the program's thread only.
+inline int PutChar(int ch, FILE* file)
+{
+#if defined(_MSC_VER)
+  return _putc_nolock(ch, file);
+#elif defined(MIKTEX_UNIX)
+  return putc_unlocked(ch, file);
+#else
+  return putc(ch, file);
+#endif
+}
+
 struct FileRoot
 {
 protected:
   FILE* file = nullptr;
 
 protected:
-  enum { NotOwner = 0x00000001 };
+  enum
+  {
+    NotOwner = 0x00000001,
+    TerminalKnown = 0x00000002,
+    Terminal = 0x00000004
+  };
   
 protected:
   unsigned flags = 0;
@@ -97,6 +120,22 @@ public:
     MIKTEX_ASSERT(file != nullptr);
   }
 
+  /// Tests whether the file is a terminal.
+  ///
+  /// The result is cached until another stream is attached.
+public:
+  bool IsTerminal()
+  {
+    if ((flags & TerminalKnown) == 0)
+    {
+      flags |= TerminalKnown | (CheckTerminal() ? Terminal : 0);
+    }
+    return (flags & Terminal) != 0;
+  }
+
+private:
+  C4PTHISAPI(bool) CheckTerminal() const;
+
 public:
   C4PTHISAPI(bool) Open(const MiKTeX::Core::PathName& path, MiKTeX::Core::FileMode mode, MiKTeX::Core::FileAccess access, bool text, bool mustExist);
 
@@ -324,9 +363,6 @@ public:
 struct C4P_text :
   BufferedFile<char>
 {
-public:
-  C4PTHISAPI(bool) IsTerminal();
-
 public:
   C4PTHISAPI(void) DiscardLine();
 
@@ -350,6 +386,80 @@ public:
 #define output (*(GetStdFilePtr(1)))
 #define c4perroroutput (*(GetStdFilePtr(2)))
 
+#if defined(MIKTEX_C4P_PROFILING)
+/// Shadow stack of the running Pascal routines.
+///
+/// The generated code pushes and pops routine handles; a sampling thread
+/// takes snapshots of the stack.
+class RoutineStack
+{
+public:
+  static constexpr int MAX_DEPTH = 1024;
+
+public:
+  void Enter(int handle)
+  {
+    calls[handle] += 1;
+    int d = depth.load(std::memory_order_relaxed);
+    if (d < MAX_DEPTH)
+    {
+      handles[d].store(handle, std::memory_order_relaxed);
+    }
+    depth.store(d + 1, std::memory_order_release);
+  }
+
+public:
+  void Leave()
+  {
+    depth.store(depth.load(std::memory_order_relaxed) - 1, std::memory_order_release);
+  }
+
+public:
+  std::atomic<int> depth{ 0 };
+
+public:
+  std::atomic<int> handles[MAX_DEPTH];
+
+public:
+  std::vector<std::uint64_t> calls;
+};
+
+/// Keeps a routine on the shadow stack while it runs.
+///
+/// The frame is left on every way out of the routine, including the
+/// exceptions thrown by c4pthrow.
+class RoutineFrame
+{
+public:
+  RoutineFrame(RoutineStack* stack, int handle) :
+    stack(stack)
+  {
+    if (stack != nullptr)
+    {
+      stack->Enter(handle);
+    }
+  }
+
+public:
+  RoutineFrame(const RoutineFrame& other) = delete;
+
+public:
+  RoutineFrame& operator=(const RoutineFrame& other) = delete;
+
+public:
+  ~RoutineFrame()
+  {
+    if (stack != nullptr)
+    {
+      stack->Leave();
+    }
+  }
+
+private:
+  RoutineStack* stack;
+};
+#endif
+
 class C4PTYPEAPI(ProgramBase)
 {
 public:
@@ -434,14 +544,67 @@ protected:
   }
 
 private:
-  C4PTHISAPI(void) WriteChar(int ch, FILE* file);
+  C4PTHISAPI(void) WriteCharToTerminal(int ch, FILE* file);
+
+private:
+  // writes v like fprintf(file, "%*.*ld", width, precision, v)
+  void WriteInteger(C4P_longinteger v, int width, int precision, FILE* file)
+  {
+    char buf[64];
+    char* end = buf + sizeof(buf);
+    char* p = end;
+    C4P_unsigned64 u = v < 0 ? 0 - static_cast<C4P_unsigned64>(v) : static_cast<C4P_unsigned64>(v);
+    for (; u != 0; u /= 10)
+    {
+      *--p = static_cast<char>('0' + u % 10);
+    }
+    if (precision < 0)
+    {
+      precision = 1;
+    }
+    while (end - p < precision && p > buf + 1)
+    {
+      *--p = '0';
+    }
+    if (v < 0)
+    {
+      *--p = '-';
+    }
+    int len = static_cast<int>(end - p);
+    bool leftAligned = width < 0;
+    width = leftAligned ? -width : width;
+    bool failed = false;
+    for (int pad = width - len; !leftAligned && pad > 0; --pad)
+    {
+      failed |= PutChar(' ', file) == EOF;
+    }
+    for (; p != end; ++p)
+    {
+      failed |= PutChar(*p, file) == EOF;
+    }
+    for (int pad = width - len; leftAligned && pad > 0; --pad)
+    {
+      failed |= PutChar(' ', file) == EOF;
+    }
+    if (failed)
+    {
+      MIKTEX_FATAL_CRT_ERROR("putc");
+    }
+  }
 
 protected:
   template<class Vt, class Ft>
   void c4p_write_c(Vt v, Ft& f)
   {
     f.AssertValid();
-    WriteChar(v, f);
+    if (f.IsTerminal())
+    {
+      WriteCharToTerminal(v, f);
+    }
+    else if (PutChar(v, f) == EOF)
+    {
+      MIKTEX_FATAL_CRT_ERROR("putc");
+    }
   }
 
 protected:
@@ -456,10 +619,7 @@ protected:
   void c4p_write_i(Vt v, Ft& f)
   {
     f.AssertValid();
-    if (fprintf(f, "%ld", static_cast<long>(v)) < 0)
-    {
-      MIKTEX_FATAL_CRT_ERROR("fprintf");
-    }
+    WriteInteger(static_cast<C4P_longinteger>(v), 0, 1, f);
   }
 
 protected:
@@ -467,10 +627,7 @@ protected:
   void c4p_write_i1(Vt v, int w1, Ft& f)
   {
     f.AssertValid();
-    if (fprintf(f, "%*ld", static_cast<int>(w1), static_cast<long>(v)) < 0)
-    {
-      MIKTEX_FATAL_CRT_ERROR("fprintf");
-    }
+    WriteInteger(static_cast<C4P_longinteger>(v), w1, 1, f);
   }
 
 protected:
@@ -478,10 +635,7 @@ protected:
   void c4p_write_i2(Vt v, int w1, int w2, Ft& f)
   {
     f.AssertValid();
-    if (fprintf(f, "%*.*ld", static_cast<int>(w1), static_cast<int>(w2), static_cast<long>(v)) < 0)
-    {
-      MIKTEX_FATAL_CRT_ERROR("fprintf");
-    }
+    WriteInteger(static_cast<C4P_longinteger>(v), w1, w2, f);
   }
 
 protected:
@@ -570,7 +724,7 @@ protected:
   void c4p_writeln()
   {
     output.AssertValid();
-    if (putc('\n', output) == EOF)
+    if (PutChar('\n', output) == EOF)
     {
       MIKTEX_FATAL_CRT_ERROR("putc");
     }
@@ -597,7 +751,7 @@ protected:
   void c4pputc(T& f)
   {
     f.AssertValid();
-    if (putc(*f, f) == EOF)
+    if (PutChar(*f, f) == EOF)
     {
       MIKTEX_FATAL_CRT_ERROR("putc");
     }
@@ -873,6 +1027,17 @@ protected:
   {
   }
 
+#if defined(MIKTEX_C4P_PROFILING)
+protected:
+  /// Starts the routine profiler, if MIKTEX_C4P_PROFILE names an output file.
+  /// @param routineNames The names of the Pascal routines, indexed by handle.
+  /// @param count The number of names.
+  C4PTHISAPI(void) StartProfiler(const char* const* routineNames, std::size_t count);
+
+protected:
+  RoutineStack* routineStack = nullptr;
+#endif
+
 protected:
   const int c4pcur = SEEK_CUR;
   const int c4pend = SEEK_END;
@@ -943,7 +1108,7 @@ private:
 #define C4P_WRITELN_BEGIN() C4P_WRITE_BEGIN()
 
 #define C4P_WRITE_END(f) }
-#define C4P_WRITELN_END(f) putc('\n', f); }
+#define C4P_WRITELN_END(f) C4P::PutChar('\n', f); }
 
 #define c4preturn() goto C4P_LABEL_PROC_EXIT
 #define c4pbreakloop() break
@@ -957,9 +1122,34 @@ private:
 #define c4pminute GetMinute()
 #define c4psecond GetSecond()
 
+#if defined(MIKTEX_C4P_PROFILING)
+#define C4P_PROC_ENTRY(handle) c4p_proc_entry<handle>(); C4P::RoutineFrame c4p_routine_frame(routineStack, handle);
+#else
 #define C4P_PROC_ENTRY(handle) c4p_proc_entry<handle>();
+#endif
 #define C4P_PROC_EXIT(handle) C4P_LABEL_PROC_EXIT: c4p_proc_exit<handle>();
 
+/// The type of a routine-local alias of a global array (c4p --specialize).
+/// Arrays are referenced; dynamically allocated arrays are copied, so
+/// that the compiler can keep the pointer in a register.
+template<class T> struct CachedGlobal
+{
+  typedef T& type;
+};
+
+template<class T> struct CachedGlobal<T*>
+{
+  typedef T* type;
+};
+
+// C++ code calls the routines, too: `used` makes the compiler emit the
+// external definition, even if every Pascal call has been inlined
+#if defined(__GNUC__)
+#define C4P_INLINE inline __attribute__((used))
+#else
+#define C4P_INLINE
+#endif
+
 C4PCEEAPI(C4P_integer) Round(double r);
 
 C4P_END_NAMESPACE;
@@ -60,6 +60,8 @@
 #cmakedefine HAVE_ROUND 1
 #cmakedefine HAVE_TRUNC 1
 
+#cmakedefine MIKTEX_C4P_PROFILING 1
+
 #if defined(__clang__)
 #pragma clang diagnostic ignored "-Wdangling-else"
 #pragma clang diagnostic ignored "-Wparentheses-equality"
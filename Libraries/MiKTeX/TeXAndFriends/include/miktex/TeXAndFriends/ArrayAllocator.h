@@ -0,0 +1,113 @@
+/* miktex/TeXAndFriends/ArrayAllocator.h:               -*- C++ -*-
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 2, or (at your
+   option) any later version.
+
+   This file is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this file; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA. */
+
+#pragma once
+
+#if !defined(A3D91E2B6F8C4E0B9C1D5E7F20B4A681)
+#define A3D91E2B6F8C4E0B9C1D5E7F20B4A681
+
+#include <miktex/TeXAndFriends/config.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+
+#include <miktex/Core/Debug>
+
+MIKTEX_TEXMF_BEGIN_NAMESPACE;
+
+/// Memory usage of a dynamic array.
+struct ArrayUsage
+{
+  /// The name of the array.
+  std::string arrayName;
+  /// `true`, if the array lives in reserved address space.
+  bool mapped = false;
+  /// Size of the reserved address space (in bytes).
+  std::size_t reserved = 0;
+  /// Size of the committed memory (in bytes).
+  std::size_t committed = 0;
+  /// Size of the memory which has been touched (in bytes).
+  std::size_t resident = 0;
+  /// Number of times the array has grown.
+  unsigned growCount = 0;
+  /// Number of times the array had to be moved.
+  unsigned moveCount = 0;
+};
+
+/// Allocator for the dynamic arrays of TeX & Friends.
+///
+/// Large arrays are placed in reserved address space: memory is committed
+/// as the array grows and pages materialize on first touch, so that
+/// growing an array does not copy it.  Small arrays live on the heap.
+class MIKTEXMFTYPEAPI(ArrayAllocator)
+{
+public:
+  MIKTEXMFEXPORT MIKTEXTHISCALL ArrayAllocator();
+
+public:
+  ArrayAllocator(const ArrayAllocator& other) = delete;
+
+public:
+  ArrayAllocator& operator=(const ArrayAllocator& other) = delete;
+
+public:
+  ArrayAllocator(ArrayAllocator&& other) = delete;
+
+public:
+  ArrayAllocator& operator=(ArrayAllocator&& other) = delete;
+
+public:
+  virtual MIKTEXMFEXPORT MIKTEXTHISCALL ~ArrayAllocator() noexcept;
+
+  /// Resizes an array.
+  /// @param arrayName The name of the array.
+  /// @param ptr The array; `nullptr` allocates a new array.
+  /// @param amount The new size (in bytes); `0` frees the array.
+  /// @param sourceLocation The caller.
+  /// @return Returns the (possibly moved) array.
+public:
+  MIKTEXMFTHISAPI(void*) Reallocate(const std::string& arrayName, void* ptr, std::size_t amount, const MiKTeX::Core::SourceLocation& sourceLocation);
+
+  /// Tests whether an array lives in reserved address space.
+  /// @param ptr The array.
+  /// @return Returns `true`, if the array is not a heap block.
+public:
+  MIKTEXMFTHISAPI(bool) Owns(const void* ptr) const;
+
+  /// Asks the system to back reserved address space with huge pages.
+  /// @param enable `true` to use huge pages for arrays allocated hereafter.
+public:
+  MIKTEXMFTHISAPI(void) EnableHugePages(bool enable);
+
+  /// Gets the memory usage of all live arrays.
+  /// @return Returns the usage records, largest array first.
+public:
+  MIKTEXMFTHISAPI(std::vector<ArrayUsage>) GetUsage() const;
+
+private:
+  class impl;
+  std::unique_ptr<impl> pimpl;
+};
+
+MIKTEX_TEXMF_END_NAMESPACE;
+
+#endif
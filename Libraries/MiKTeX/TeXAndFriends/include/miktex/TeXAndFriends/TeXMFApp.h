@@ -42,6 +42,7 @@
 #include <miktex/Util/StringUtil>
 #include <miktex/Util/inliners.h>
 
+#include "ArrayAllocator.h"
 #include "WebAppInputLine.h"
 
 MIKTEX_TEXMF_BEGIN_NAMESPACE;
@@ -380,6 +381,9 @@ public:
 public:
   MIKTEXMFTHISAPI(ITeXMFMemoryHandler*) GetTeXMFMemoryHandler() const;
 
+public:
+  MIKTEXMFTHISAPI(ArrayAllocator&) GetArrayAllocator() const;
+
 private:
   class impl;
   std::unique_ptr<impl> pimpl;
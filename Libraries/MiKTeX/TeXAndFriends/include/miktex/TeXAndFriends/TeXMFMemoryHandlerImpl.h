@@ -272,8 +272,12 @@ public:
       // one extra element because Pascal arrays are 1-based
       amount = (numElem + 1) * elemSize;
     }
-    trace_mem->WriteLine("libtexmf", "reallocate " + arrayName + ": ptr == " + std::string(ptr == nullptr ? "nullptr" : "...") + ", elementSize == " + std::to_string(elemSize) + ", nElements == " + std::to_string(numElem));
-    ptr = MiKTeX::Debug::Realloc(ptr, amount, sourceLocation);
+    if (trace_mem->IsEnabled("libtexmf", MiKTeX::Trace::TraceLevel::Trace))
+    {
+      trace_mem->WriteLine("libtexmf", "reallocate " + arrayName + ": ptr == " + std::string(ptr == nullptr ? "nullptr" : "...") + ", elementSize == " + std::to_string(elemSize) + ", nElements == " + std::to_string(numElem));
+    }
+    // large arrays grow in place
+    ptr = texmfapp.GetArrayAllocator().Reallocate(arrayName, ptr, amount, sourceLocation);
     return ptr;
   }
 };
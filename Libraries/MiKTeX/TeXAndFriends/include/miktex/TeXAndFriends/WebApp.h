@@ -324,6 +324,8 @@ public:
     }
     catch (const MiKTeX::Core::MiKTeXException& ex)
     {
+      // the program's terminal output comes first
+      fflush(stdout);
       MiKTeX::App::Application::Sorry(argv[0], ex);
       app.Finalize2(1);
       ex.Save();
@@ -331,6 +333,7 @@ public:
     }
     catch (const std::exception& ex)
     {
+      fflush(stdout);
       MiKTeX::App::Application::Sorry(argv[0], ex);
       app.Finalize2(1);
       return 1;
@@ -316,6 +316,7 @@ bool WebAppInputLine::OpenOutputFile(C4P::FileRoot& f, const PathName& fileName,
     file = session->TryOpenFile(PathName(lpszPath), FileMode::Create, FileAccess::Write, false);
     if (file != nullptr)
     {
+      setvbuf(file, nullptr, _IOFBF, OUTPUT_BUFFER_SIZE);
       outPath = lpszPath;
     }
   }
@@ -34,6 +34,30 @@
 
 #define Q_(x) MiKTeX::Core::Quoter<char>(x).GetData()
 
+// stdio buffer size of output files and of the terminal
+const std::size_t OUTPUT_BUFFER_SIZE = 64 * 1024;
+
+#if defined(MIKTEX_C4P_PROFILING)
+class RoutineProfiler
+{
+public:
+  RoutineProfiler(const char* const* routineNames, std::size_t count, const MiKTeX::Core::PathName& outputPath, unsigned intervalMicroseconds);
+
+public:
+  ~RoutineProfiler();
+
+public:
+  C4P::RoutineStack& GetStack();
+
+public:
+  void WriteReport();
+
+private:
+  class impl;
+  std::unique_ptr<impl> pimpl;
+};
+#endif
+
 inline int GetC(FILE* file)
 {
   MIKTEX_ASSERT(file != nullptr);
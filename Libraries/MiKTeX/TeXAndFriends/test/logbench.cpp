@@ -0,0 +1,129 @@
+/* logbench.cpp: measure C4P text output
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of the MiKTeX TeXMF Library.
+
+   The MiKTeX TeXMF Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX TeXMF Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX TeXMF Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+
+#include <miktex/C4P/C4P>
+#include <miktex/Core/Exceptions>
+
+using namespace std;
+using namespace std::chrono;
+
+using namespace MiKTeX::Core;
+
+// writes box and glue traces the way TeX writes its transcript: one
+// character at a time, with the occasional integer
+class LogBench :
+  public C4P::ProgramBase
+{
+public:
+  duration<double> Run(const char* argv0, FILE* file, int lines)
+  {
+    char* argv[] = { const_cast<char*>(argv0), nullptr };
+    Initialize("logbench", 1, argv);
+    C4P::C4P_text f;
+    f.Attach(file, true);
+    auto start = steady_clock::now();
+    for (int i = 0; i < lines; ++i)
+    {
+      C4P_WRITELN_BEGIN();
+      Print("\\glue(\\baselineskip) ", f);
+      c4p_write_i(i % 1000, f);
+      c4p_write_c('.', f);
+      c4p_write_i1(i % 100000, 5, f);
+      Print(" plus ", f);
+      c4p_write_i(-i, f);
+      Print("fil", f);
+      C4P_WRITELN_END(f);
+    }
+    fflush(file);
+    duration<double> elapsed = steady_clock::now() - start;
+    Finish();
+    return elapsed;
+  }
+
+private:
+  void Print(const char* s, C4P::C4P_text& f)
+  {
+    for (; *s != 0; ++s)
+    {
+      c4p_write_c(*s, f);
+    }
+  }
+};
+
+int main(int argc, char* argv[])
+{
+  int lines = argc > 1 ? atoi(argv[1]) : 1000000;
+  if (lines < 1 || argc > 3)
+  {
+    cerr << "usage: " << argv[0] << " [LINES [FILE]]" << endl;
+    return 1;
+  }
+  // FILE "-" writes to the terminal
+  bool toTerminal = argc > 2 && strcmp(argv[2], "-") == 0;
+  try
+  {
+    FILE* file = toTerminal ? stdout : fopen(argc > 2 ? argv[2] : "logbench.log", "wb");
+    if (file == nullptr)
+    {
+      cerr << argv[0] << ": cannot open output file" << endl;
+      return 1;
+    }
+    if (!toTerminal)
+    {
+      // the size TeXMF programs use for their output files
+      setvbuf(file, nullptr, _IOFBF, 64 * 1024);
+    }
+    LogBench bench;
+    duration<double> elapsed = bench.Run(argv[0], file, lines);
+    long bytes = ftell(file);
+    if (!toTerminal)
+    {
+      fclose(file);
+    }
+    (toTerminal ? cerr : cout) << fixed << setprecision(3)
+      << "lines:    " << lines << "\n"
+      << "time:     " << elapsed.count() * 1000 << " ms" << "\n"
+      << "per line: " << elapsed.count() * 1e9 / lines << " ns" << "\n";
+    if (bytes > 0)
+    {
+      (toTerminal ? cerr : cout) << "rate:     " << bytes / elapsed.count() / (1024 * 1024) << " MiB/s" << endl;
+    }
+    return 0;
+  }
+  catch (const MiKTeXException& ex)
+  {
+    cerr << ex.GetErrorMessage() << endl;
+    return 1;
+  }
+  catch (const exception& ex)
+  {
+    cerr << ex.what() << endl;
+    return 1;
+  }
+}
@@ -0,0 +1,146 @@
+/* writetest.cpp: test C4P text output
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of the MiKTeX TeXMF Library.
+
+   The MiKTeX TeXMF Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX TeXMF Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX TeXMF Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <string>
+
+#include <miktex/C4P/C4P>
+#include <miktex/Core/Exceptions>
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+
+// compares the integer formatter of C4P with printf()
+class WriteTest :
+  public C4P::ProgramBase
+{
+public:
+  int Run(const char* argv0)
+  {
+    char* argv[] = { const_cast<char*>(argv0), nullptr };
+    Initialize("writetest", 1, argv);
+    const int64_t values[] = {
+      0, 1, -1, 9, 10, -10, 42, -42, 99999, 100000, -123456789,
+      numeric_limits<C4P::C4P_integer>::max(),
+      numeric_limits<C4P::C4P_integer>::min(),
+      numeric_limits<int64_t>::max(),
+      numeric_limits<int64_t>::min()
+    };
+    const int widths[] = { 0, 1, 2, 5, 12, 25, -1, -6, -25 };
+    const int precisions[] = { 0, 1, 3, 8, 30 };
+    int failures = 0;
+    for (int64_t v : values)
+    {
+      char expected[128];
+      snprintf(expected, sizeof(expected), "%" PRId64, v);
+      failures += Compare(expected, [this, v](C4P::C4P_text& f) { c4p_write_i(v, f); }, "write(" + to_string(v) + ")");
+      for (int w : widths)
+      {
+        snprintf(expected, sizeof(expected), "%*" PRId64, w, v);
+        failures += Compare(expected, [this, v, w](C4P::C4P_text& f) { c4p_write_i1(v, w, f); }, "write(" + to_string(v) + ":" + to_string(w) + ")");
+        for (int p : precisions)
+        {
+          snprintf(expected, sizeof(expected), "%*.*" PRId64, w, p, v);
+          failures += Compare(expected, [this, v, w, p](C4P::C4P_text& f) { c4p_write_i2(v, w, p, f); }, "write(" + to_string(v) + ":" + to_string(w) + ":" + to_string(p) + ")");
+        }
+      }
+    }
+    failures += Compare("\\hbox(-1.5+0.0)x42\n", [this](C4P::C4P_text& f) {
+      C4P_WRITELN_BEGIN();
+      for (const char* s = "\\hbox("; *s != 0; ++s)
+      {
+        c4p_write_c(*s, f);
+      }
+      c4p_write_i(-1, f);
+      c4p_write_c('.', f);
+      c4p_write_i(5, f);
+      c4p_write_c('+', f);
+      c4p_write_i2(0, 1, 1, f);
+      c4p_write_c('.', f);
+      c4p_write_i(0, f);
+      c4p_write_c(')', f);
+      c4p_write_c('x', f);
+      c4p_write_i1(42, 1, f);
+      C4P_WRITELN_END(f);
+    }, "writeln");
+    Finish();
+    return failures;
+  }
+
+  // runs write on a temporary file; compares what has been written
+private:
+  template<typename Func> int Compare(const string& expected, Func write, const string& what)
+  {
+    FILE* file = tmpfile();
+    if (file == nullptr)
+    {
+      MIKTEX_FATAL_CRT_ERROR("tmpfile");
+    }
+    C4P::C4P_text f;
+    f.Attach(file, true);
+    write(f);
+    fflush(file);
+    rewind(file);
+    string actual;
+    for (int ch; (ch = getc(file)) != EOF; )
+    {
+      actual += static_cast<char>(ch);
+    }
+    fclose(file);
+    if (actual == expected)
+    {
+      return 0;
+    }
+    cerr << what << ": expected \"" << expected << "\", got \"" << actual << "\"" << endl;
+    return 1;
+  }
+};
+
+int main(int argc, char* argv[])
+{
+  try
+  {
+    WriteTest test;
+    int failures = test.Run(argv[0]);
+    if (failures > 0)
+    {
+      cerr << failures << " check(s) failed" << endl;
+      return 1;
+    }
+    return 0;
+  }
+  catch (const MiKTeXException& ex)
+  {
+    cerr << ex.GetErrorMessage() << endl;
+    return 1;
+  }
+  catch (const exception& ex)
+  {
+    cerr << ex.what() << endl;
+    return 1;
+  }
+}
@@ -433,6 +433,9 @@ TeXApp::Write18Result TeXApp::Write18(const string& command, int& exitCode) cons
 #if defined(MIKTEX_WINDOWS)
   std::replace(toBeExecuted.begin(), toBeExecuted.end(), '\'', '"');
 #endif
+  // stdout may be fully buffered (see C4P::ProgramBase::Initialize());
+  // what we have written so far must precede the output of the command
+  fflush(stdout);
   Process::ExecuteSystemCommand(toBeExecuted, &exitCode);
   LogInfo(fmt::format("write18 exit code: {0}", exitCode));
   return examineResult == Session::ExamineCommandLineResult::ProbablySafe ? Write18Result::ExecutedAllowed : Write18Result::Executed;
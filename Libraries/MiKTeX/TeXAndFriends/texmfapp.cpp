@@ -50,6 +50,10 @@
 
 #include "miktex/texmfapp.defaults.h"
 
+#if !defined(MIKTEX_WINDOWS)
+#  include <sys/resource.h>
+#endif
+
 using namespace std;
 
 using namespace MiKTeX::Core;
@@ -66,10 +70,16 @@ public:
   string memoryDumpFileName;
 public:
   unique_ptr<TraceStream> trace_time;
+public:
+  unique_ptr<TraceStream> trace_mem;
 public:
   clock_t clockStart;
 public:
   bool timeStatistics;
+public:
+  bool memoryStatistics;
+public:
+  ArrayAllocator arrayAllocator;
 public:
   bool parseFirstLine;
 public:
@@ -148,11 +158,47 @@ STATICFUNC(void) TraceExecutionTime(TraceStream* trace_time, clock_t clockStart)
 #endif // MIKTEX_WINDOWS
 }
 
+STATICFUNC(void) TraceMemoryUsage(TraceStream* trace_mem, const ArrayAllocator& arrayAllocator)
+{
+  const size_t KB = 1024;
+  size_t totalCommitted = 0;
+  size_t totalResident = 0;
+  for (const ArrayUsage& usage : arrayAllocator.GetUsage())
+  {
+    string line = fmt::format(T_("{0}: {1} KB committed, {2} KB resident"), usage.arrayName, usage.committed / KB, usage.resident / KB);
+    if (usage.mapped)
+    {
+      line += fmt::format(T_(" ({0} KB reserved, grown {1} times, moved {2} times)"), usage.reserved / KB, usage.growCount, usage.moveCount);
+    }
+    trace_mem->WriteLine("libtexmf", line);
+    cerr << line << endl;
+    totalCommitted += usage.committed;
+    totalResident += usage.resident;
+  }
+  trace_mem->WriteLine("libtexmf", fmt::format(T_("arrays: {0} KB committed, {1} KB resident"), totalCommitted / KB, totalResident / KB));
+  cerr << fmt::format(T_("arrays: {0} KB committed, {1} KB resident"), totalCommitted / KB, totalResident / KB) << endl;
+#if !defined(MIKTEX_WINDOWS)
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+  {
+    return;
+  }
+#if defined(MIKTEX_MACOS)
+  size_t maxResident = usage.ru_maxrss / KB;
+#else
+  size_t maxResident = usage.ru_maxrss;
+#endif
+  trace_mem->WriteLine("libtexmf", fmt::format(T_("peak resident set size: {0} KB"), maxResident));
+  cerr << fmt::format(T_("peak resident set size: {0} KB"), maxResident) << endl;
+#endif
+}
+
 void TeXMFApp::Init(vector<char*>& args)
 {
   WebAppInputLine::Init(args);
 
   pimpl->trace_time = TraceStream::Open(MIKTEX_TRACE_TIME);
+  pimpl->trace_mem = TraceStream::Open(MIKTEX_TRACE_MEM);
 
   pimpl->userParams.clear();
 
@@ -167,6 +213,9 @@ void TeXMFApp::Init(vector<char*>& args)
   pimpl->setJobTime = false;
   pimpl->showFileLineErrorMessages = false;
   pimpl->timeStatistics = false;
+  pimpl->memoryStatistics = false;
+
+  pimpl->arrayAllocator.EnableHugePages(GetSession()->GetConfigValue(MIKTEX_CONFIG_SECTION_TEXANDFRIENDS, MIKTEX_CONFIG_VALUE_HUGE_PAGES, ConfigValue(false)).GetBool());
 }
 
 void TeXMFApp::Finalize()
@@ -176,6 +225,11 @@ void TeXMFApp::Finalize()
     pimpl->trace_time->Close();
     pimpl->trace_time = nullptr;
   }
+  if (pimpl->trace_mem != nullptr)
+  {
+    pimpl->trace_mem->Close();
+    pimpl->trace_mem = nullptr;
+  }
   pimpl->memoryDumpFileName = "";
   pimpl->jobName = "";
   WebAppInputLine::Finalize();
@@ -226,6 +280,10 @@ void TeXMFApp::OnTeXMFFinishJob()
   {
     TraceExecutionTime(pimpl->trace_time.get(), pimpl->clockStart);
   }
+  if (pimpl->memoryStatistics)
+  {
+    TraceMemoryUsage(pimpl->trace_mem.get(), pimpl->arrayAllocator);
+  }
 }
 
 enum {
@@ -247,6 +305,7 @@ enum {
   OPT_MAIN_MEMORY,
   OPT_MAX_PRINT_LINE,
   OPT_MAX_STRINGS,
+  OPT_MEMORY_STATISTICS,
   OPT_NO_C_STYLE_ERRORS,
   OPT_OUTPUT_DIRECTORY,
   OPT_PARAM_SIZE,
@@ -311,6 +370,7 @@ void TeXMFApp::AddOptions()
   AddOption(T_("main-memory\0Set main_memory to N."), FIRST_OPTION_VAL + pimpl->optBase + OPT_MAIN_MEMORY, POPT_ARG_STRING, "N");
   AddOption(T_("max-print-line\0Set max_print_line to N."), FIRST_OPTION_VAL + pimpl->optBase + OPT_MAX_PRINT_LINE, POPT_ARG_STRING, "N");
   AddOption(T_("max-strings\0Set max_strings to N."), FIRST_OPTION_VAL + pimpl->optBase + OPT_MAX_STRINGS, POPT_ARG_STRING, "N");
+  AddOption(T_("memory-statistics\0Show memory usage statistics."), FIRST_OPTION_VAL + pimpl->optBase + OPT_MEMORY_STATISTICS);
   AddOption(T_("no-c-style-errors\0Disable file:line:error style messages."), FIRST_OPTION_VAL + pimpl->optBase + OPT_NO_C_STYLE_ERRORS);
   AddOption(T_("output-directory\0Use DIR as the directory to write output files to."), FIRST_OPTION_VAL + pimpl->optBase + OPT_OUTPUT_DIRECTORY, POPT_ARG_STRING, "DIR");
   AddOption(T_("param-size\0Set param_size to N."), FIRST_OPTION_VAL + pimpl->optBase + OPT_PARAM_SIZE, POPT_ARG_STRING, "N");
@@ -510,6 +570,10 @@ bool TeXMFApp::ProcessOption(int opt, const string& optArg)
     pimpl->userParams["max_strings"] = std::stoi(optArg);
     break;
 
+  case OPT_MEMORY_STATISTICS:
+    pimpl->memoryStatistics = true;
+    break;
+
   case OPT_TIME_STATISTICS:
     pimpl->timeStatistics = true;
     break;
@@ -1005,6 +1069,11 @@ ITeXMFMemoryHandler* TeXMFApp::GetTeXMFMemoryHandler() const
   return pimpl->memoryHandler;
 }
 
+ArrayAllocator& TeXMFApp::GetArrayAllocator() const
+{
+  return pimpl->arrayAllocator;
+}
+
 TeXMFApp::UserParams& TeXMFApp::GetUserParams() const
 {
   return pimpl->userParams;
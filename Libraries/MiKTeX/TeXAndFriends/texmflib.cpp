@@ -71,6 +71,8 @@ STATICFUNC(bool) OpenFontFile(bytefile* file, const string& fontName, FileType f
     arguments.push_back("--verbose");
     arguments.push_back(baseName.ToString());
     int exitCode;
+    // the generator writes to our terminal
+    fflush(stdout);
     if (!(Process::Run(generatorExecutable, arguments, nullptr, &exitCode, nullptr) && exitCode == 0))
     {
       return false;
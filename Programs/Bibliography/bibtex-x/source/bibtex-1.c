@@ -61,6 +61,8 @@
 **          check_command_execution
 **          check_field_overflow
 **          cite_key_disappeared_confusion
+**          compile_fn
+**          compile_fn_ref
 **          compress_bib_white
 **          decr_brace_level
 **          eat_bib_print
@@ -2799,6 +2801,104 @@ END
 
 
 
+/***************************************************************************
+ * WEB section number:	N/A
+ * ~~~~~~~~~~~~~~~~~~~
+ * This procedure compiles a function into the |ex_code| arrays the first
+ * time it is executed and records where its code starts.  The code of a
+ * |wiz_defined| function has one instruction per element of its
+ * definition (a |quote_next_fn| marker and the function after it make up
+ * one |ex_push_fn| instruction); the code of any other function is just
+ * the one instruction that executes it.  Either is terminated by
+ * |ex_end|.  Since a function can only refer to functions defined before
+ * it, the code never has to change once it has been compiled.
+ ***************************************************************************/
+ExCodeLoc_T       compile_fn (HashLoc_T fn_loc)
+BEGIN
+  ExCodeLoc_T     code_start;
+  WizFnLoc_T      wiz_ptr;
+
+  code_start = ex_code_ptr;
+  if (fn_type[fn_loc] == WIZ_DEFINED)
+  BEGIN
+    wiz_ptr = FN_INFO[fn_loc];
+    while (wiz_functions[wiz_ptr] != END_OF_DEF)
+    BEGIN
+      if (wiz_functions[wiz_ptr] != QUOTE_NEXT_FN)
+      BEGIN
+	compile_fn_ref (wiz_functions[wiz_ptr]);
+      END
+      else
+      BEGIN
+	INCR (wiz_ptr);
+	EMIT_EX_CODE (EX_PUSH_FN, wiz_functions[wiz_ptr],
+		      wiz_functions[wiz_ptr]);
+      END
+      INCR (wiz_ptr);
+    END
+  END
+  else
+  BEGIN
+    compile_fn_ref (fn_loc);
+  END
+  EMIT_EX_CODE (EX_END, 0, fn_loc);
+  ex_code_start[fn_loc] = code_start;
+  return (code_start);
+END
+
+
+
+
+/***************************************************************************
+ * WEB section number:	N/A
+ * ~~~~~~~~~~~~~~~~~~~
+ * This procedure emits the instruction that executes the function
+ * |fn_loc|, looking up its operand now rather than every time the
+ * instruction is executed.  Only the value of an |int_global_var| can
+ * change, so that instruction keeps the hash location.  A
+ * |wiz_defined| function becomes an |ex_call| instruction; its own code
+ * is compiled when the call is first executed.
+ ***************************************************************************/
+void          compile_fn_ref (HashLoc_T fn_loc)
+BEGIN
+  switch (fn_type[fn_loc])
+  BEGIN
+    case BUILT_IN:
+      EMIT_EX_CODE (FN_INFO[fn_loc], 0, fn_loc);
+      break;
+    case WIZ_DEFINED:
+      EMIT_EX_CODE (EX_CALL, fn_loc, fn_loc);
+      break;
+    case INT_LITERAL:
+      EMIT_EX_CODE (EX_INT_LITERAL, FN_INFO[fn_loc], fn_loc);
+      break;
+    case STR_LITERAL:
+      EMIT_EX_CODE (EX_STR_LITERAL, hash_text[fn_loc], fn_loc);
+      break;
+    case FIELD:
+      EMIT_EX_CODE (EX_FIELD, FN_INFO[fn_loc], fn_loc);
+      break;
+    case INT_ENTRY_VAR:
+      EMIT_EX_CODE (EX_INT_ENTRY_VAR, FN_INFO[fn_loc], fn_loc);
+      break;
+    case STR_ENTRY_VAR:
+      EMIT_EX_CODE (EX_STR_ENTRY_VAR, FN_INFO[fn_loc], fn_loc);
+      break;
+    case INT_GLOBAL_VAR:
+      EMIT_EX_CODE (EX_INT_GLOBAL_VAR, fn_loc, fn_loc);
+      break;
+    case STR_GLOBAL_VAR:
+      EMIT_EX_CODE (EX_STR_GLOBAL_VAR, FN_INFO[fn_loc], fn_loc);
+      break;
+    default:
+      unknwn_function_class_confusion ();
+      break;
+  END
+END
+
+
+
+
 /***************************************************************************
  * WEB section number:	 252
  * ~~~~~~~~~~~~~~~~~~~
@@ -28,6 +28,7 @@
 **
 **      The functions defined in this module are:
 **
+**	    execute_code
 **	    execute_fn
 **	    figure_out_the_formatted_name
 **	    find_cite_locs_for_this_cite_ke
@@ -144,13 +145,15 @@
 
 
 /***************************************************************************
- * WEB section number:	 325
+ * WEB section number:	N/A
  * ~~~~~~~~~~~~~~~~~~~
- * This procedure executes a single specified function; it is the single
- * execution-primitive that does everything (except windows, and it takes
- * Tuesdays off).
+ * This procedure runs compiled code (see |compile_fn|) until it hits
+ * |ex_end|; it is the single execution-primitive that does everything
+ * |execute_fn| used to do.  Each instruction carries its operand, so
+ * the classes of the functions needn't be looked at again.  Only
+ * |ex_call|, call.type$, if$, and while$ do a recursive call.
  ***************************************************************************/
-void          execute_fn (HashLoc_T ex_fn_loc)
+void          execute_code (ExCodeLoc_T code_ptr)
 BEGIN
 
 /***************************************************************************
@@ -166,59 +169,61 @@ BEGIN
 		    r_pop_tp2;
 /*^^^^^^^^^^^^^^^^^^^^^^^^^^ END OF SECTION 343 ^^^^^^^^^^^^^^^^^^^^^^^^^^^*/
 
-  WizFnLoc_T        wiz_ptr;
+  ExOpcode_T        ex_op;
+  ExCodeLoc_T       callee_ptr;
+  StrEntLoc_T       ent_chr_ptr;
+
+  LOOP
+  BEGIN
+    ex_op = ex_code_op[code_ptr];
 
 #ifdef TRACE
-  if (Flag_trace) {
-    TRACE_PR ("execute_fn `");
-    TRACE_PR_POOL_STR (hash_text[ex_fn_loc]);
-    TRACE_PR_LN ("'");
-  }
+    if (Flag_trace && (ex_op != EX_PUSH_FN) && (ex_op != EX_END)) {
+      TRACE_PR ("execute_fn `");
+      TRACE_PR_POOL_STR (hash_text[ex_code_loc[code_ptr]]);
+      TRACE_PR_LN ("'");
+    }
 #endif                      			/* TRACE */
 
-  switch (fn_type[ex_fn_loc])
-  BEGIN
-    case BUILT_IN:
+#ifdef STAT
+    if (Flag_stats && (ex_op < NUM_BLT_IN_FNS))
+      INCR (execution_count[ex_op]);
+#endif                      			/* STAT */
+
+    switch (ex_op)
+    BEGIN
+
 /***************************************************************************
  * WEB section number:	341
  * ~~~~~~~~~~~~~~~~~~~
  * This module branches to the code for the appropriate |built_in|
  * function.  Only three---call.type$, if$, and while$---do a recursive call.
  ***************************************************************************/
-      BEGIN
-
-#ifdef STAT
-        if (Flag_stats)
-          INCR (execution_count[FN_INFO[ex_fn_loc]]);
-#endif                      			/* STAT */
-
-	switch (FN_INFO[ex_fn_loc])
-	BEGIN
-	  case N_EQUALS:
-	    x_equals ();
-	    break;
-	  case N_GREATER_THAN:
-	    x_greater_than ();
-	    break;
-	  case N_LESS_THAN:
-	    x_less_than ();
-	    break;
-	  case N_PLUS:
-	    x_plus ();
-	    break;
-	  case N_MINUS:
-	    x_minus ();
-	    break;
-	  case N_CONCATENATE:
-	    x_concatenate ();
-	    break;
-	  case N_GETS:
-	    x_gets ();
-	    break;
-	  case N_ADD_PERIOD:
-	    x_add_period ();
-	    break;
-	  case N_CALL_TYPE:
+      case N_EQUALS:
+	x_equals ();
+	break;
+      case N_GREATER_THAN:
+	x_greater_than ();
+	break;
+      case N_LESS_THAN:
+	x_less_than ();
+	break;
+      case N_PLUS:
+	x_plus ();
+	break;
+      case N_MINUS:
+	x_minus ();
+	break;
+      case N_CONCATENATE:
+	x_concatenate ();
+	break;
+      case N_GETS:
+	x_gets ();
+	break;
+      case N_ADD_PERIOD:
+	x_add_period ();
+	break;
+      case N_CALL_TYPE:
 
 /***************************************************************************
  * WEB section number:	363
@@ -229,46 +234,46 @@ BEGIN
  * in the .bst file, or unless it's |empty|, in which case it does
  * nothing.
  ***************************************************************************/
-	    BEGIN
-	      if ( ! mess_with_entries)
-	      BEGIN
-		bst_cant_mess_with_entries_prin ();
-	      END
-	      else if (type_list[cite_ptr] == UNDEFINED)
-	      BEGIN
-		execute_fn (b_default);
-	      END
-	      else if (type_list[cite_ptr] == EMPTY)
-	      BEGIN
-		DO_NOTHING;
-	      END
-	      else
-	      BEGIN
-		execute_fn (type_list[cite_ptr]);
-	      END
-	    END
+	BEGIN
+	  if ( ! mess_with_entries)
+	  BEGIN
+	    bst_cant_mess_with_entries_prin ();
+	  END
+	  else if (type_list[cite_ptr] == UNDEFINED)
+	  BEGIN
+	    execute_fn (b_default);
+	  END
+	  else if (type_list[cite_ptr] == EMPTY)
+	  BEGIN
+	    DO_NOTHING;
+	  END
+	  else
+	  BEGIN
+	    execute_fn (type_list[cite_ptr]);
+	  END
+	END
 /*^^^^^^^^^^^^^^^^^^^^^^^^^^ END OF SECTION 363 ^^^^^^^^^^^^^^^^^^^^^^^^^^^*/
 
-	    break;
-	  case N_CHANGE_CASE:
-	    x_change_case ();
-	    break;
-	  case N_CHR_TO_INT:
-	    x_chr_to_int ();
-	    break;
-	  case N_CITE:
-	    x_cite ();
-	    break;
-	  case N_DUPLICATE:
-	    x_duplicate ();
-	    break;
-	  case N_EMPTY:
-	    x_empty ();
-	    break;
-	  case N_FORMAT_NAME:
-	    x_format_name ();
-	    break;
-	  case N_IF:
+	break;
+      case N_CHANGE_CASE:
+	x_change_case ();
+	break;
+      case N_CHR_TO_INT:
+	x_chr_to_int ();
+	break;
+      case N_CITE:
+	x_cite ();
+	break;
+      case N_DUPLICATE:
+	x_duplicate ();
+	break;
+      case N_EMPTY:
+	x_empty ();
+	break;
+      case N_FORMAT_NAME:
+	x_format_name ();
+	break;
+      case N_IF:
 
 /***************************************************************************
  * WEB section number:	421
@@ -279,44 +284,44 @@ BEGIN
  * executes the first.  If any of the types is incorrect, it complains
  * but does nothing else.
  ***************************************************************************/
-	    BEGIN
-	      pop_lit_stk (&pop_lit1, &pop_typ1);
-	      pop_lit_stk (&pop_lit2, &pop_typ2);
-	      pop_lit_stk (&pop_lit3, &pop_typ3);
-	      if (pop_typ1 != STK_FN)
-	      BEGIN
-		print_wrong_stk_lit (pop_lit1, pop_typ1, STK_FN);
-	      END
-	      else if (pop_typ2 != STK_FN)
-	      BEGIN
-		print_wrong_stk_lit (pop_lit2, pop_typ2, STK_FN);
-	      END
-	      else if (pop_typ3 != STK_INT)
-	      BEGIN
-		print_wrong_stk_lit (pop_lit3, pop_typ3, STK_INT);
-	      END
-	      else if (pop_lit3 > 0)
-	      BEGIN
-		execute_fn (pop_lit2);
-	      END
-	      else
-	      BEGIN
-		execute_fn (pop_lit1);
-	      END
-	    END
+	BEGIN
+	  pop_lit_stk (&pop_lit1, &pop_typ1);
+	  pop_lit_stk (&pop_lit2, &pop_typ2);
+	  pop_lit_stk (&pop_lit3, &pop_typ3);
+	  if (pop_typ1 != STK_FN)
+	  BEGIN
+	    print_wrong_stk_lit (pop_lit1, pop_typ1, STK_FN);
+	  END
+	  else if (pop_typ2 != STK_FN)
+	  BEGIN
+	    print_wrong_stk_lit (pop_lit2, pop_typ2, STK_FN);
+	  END
+	  else if (pop_typ3 != STK_INT)
+	  BEGIN
+	    print_wrong_stk_lit (pop_lit3, pop_typ3, STK_INT);
+	  END
+	  else if (pop_lit3 > 0)
+	  BEGIN
+	    execute_fn (pop_lit2);
+	  END
+	  else
+	  BEGIN
+	    execute_fn (pop_lit1);
+	  END
+	END
 /*^^^^^^^^^^^^^^^^^^^^^^^^^^ END OF SECTION 421 ^^^^^^^^^^^^^^^^^^^^^^^^^^^*/
 
-	    break;
-	  case N_INT_TO_CHR:
-	    x_int_to_chr ();
-	    break;
-	  case N_INT_TO_STR:
-	    x_int_to_str ();
-	    break;
-	  case N_MISSING:
-	    x_missing ();
-	    break;
-	  case N_NEWLINE:
+	break;
+      case N_INT_TO_CHR:
+	x_int_to_chr ();
+	break;
+      case N_INT_TO_STR:
+	x_int_to_str ();
+	break;
+      case N_MISSING:
+	x_missing ();
+	break;
+      case N_NEWLINE:
 
 /***************************************************************************
  * WEB section number:	425
@@ -324,16 +329,16 @@ BEGIN
  * The |built_in| function newline$ writes whatever has
  * accumulated in the output buffer |out_buf| onto the .bbl file.
  ***************************************************************************/
-	    BEGIN
-	      output_bbl_line ();
-	    END
+	BEGIN
+	  output_bbl_line ();
+	END
 /*^^^^^^^^^^^^^^^^^^^^^^^^^^ END OF SECTION 425 ^^^^^^^^^^^^^^^^^^^^^^^^^^^*/
 
-	    break;
-	  case N_NUM_NAMES:
-	    x_num_names ();
-	    break;
-	  case N_POP:
+	break;
+      case N_NUM_NAMES:
+	x_num_names ();
+	break;
+      case N_POP:
 
 /***************************************************************************
  * WEB section number:	428
@@ -341,35 +346,35 @@ BEGIN
  * The |built_in| function pop$ pops the top of the stack but
  * doesn't print it.
  ***************************************************************************/
-	    BEGIN
-	      pop_lit_stk (&pop_lit1, &pop_typ1);
-	    END
+	BEGIN
+	  pop_lit_stk (&pop_lit1, &pop_typ1);
+	END
 /*^^^^^^^^^^^^^^^^^^^^^^^^^^ END OF SECTION 428 ^^^^^^^^^^^^^^^^^^^^^^^^^^^*/
 
-	    break;
-	  case N_PREAMBLE:
-	    x_preamble ();
-	    break;
-	  case N_PURIFY:
-	    x_purify ();
-	    break;
-	  case N_QUOTE:
-	    x_quote ();
-	    break;
-	  case N_SKIP:
+	break;
+      case N_PREAMBLE:
+	x_preamble ();
+	break;
+      case N_PURIFY:
+	x_purify ();
+	break;
+      case N_QUOTE:
+	x_quote ();
+	break;
+      case N_SKIP:
 
 /***************************************************************************
  * WEB section number:	435
  * ~~~~~~~~~~~~~~~~~~~
  * The |built_in| function skip$ is a no-op.
  ***************************************************************************/
-	    BEGIN
-	      DO_NOTHING;
-	    END
+	BEGIN
+	  DO_NOTHING;
+	END
 /*^^^^^^^^^^^^^^^^^^^^^^^^^^ END OF SECTION 435 ^^^^^^^^^^^^^^^^^^^^^^^^^^^*/
 
-	    break;
-	  case N_STACK:
+	break;
+      case N_STACK:
 
 /***************************************************************************
  * WEB section number:	436
@@ -377,25 +382,25 @@ BEGIN
  * The |built_in| function stack$ pops and prints the whole stack; it's
  * meant to be used for style designers while debugging.
  ***************************************************************************/
-	    BEGIN
-	      pop_whole_stack ();
-	    END
+	BEGIN
+	  pop_whole_stack ();
+	END
 /*^^^^^^^^^^^^^^^^^^^^^^^^^^ END OF SECTION 436 ^^^^^^^^^^^^^^^^^^^^^^^^^^^*/
 
-	    break;
-	  case N_SUBSTRING:
-	    x_substring ();
-	    break;
-	  case N_SWAP:
-	    x_swap ();
-	    break;
-	  case N_TEXT_LENGTH:
-	    x_text_length ();
-	    break;
-	  case N_TEXT_PREFIX:
-	    x_text_prefix ();
-	    break;
-	  case N_TOP_STACK:
+	break;
+      case N_SUBSTRING:
+	x_substring ();
+	break;
+      case N_SWAP:
+	x_swap ();
+	break;
+      case N_TEXT_LENGTH:
+	x_text_length ();
+	break;
+      case N_TEXT_PREFIX:
+	x_text_prefix ();
+	break;
+      case N_TOP_STACK:
 
 /***************************************************************************
  * WEB section number:	446
@@ -403,19 +408,19 @@ BEGIN
  * The |built_in| function top$ pops and prints the top of the
  * stack.
  ***************************************************************************/
-	    BEGIN
-	      pop_top_and_print ();
-	    END
+	BEGIN
+	  pop_top_and_print ();
+	END
 /*^^^^^^^^^^^^^^^^^^^^^^^^^^ END OF SECTION 446 ^^^^^^^^^^^^^^^^^^^^^^^^^^^*/
 
-	    break;
-	  case N_TYPE:
-	    x_type ();
-	    break;
-	  case N_WARNING:
-	    x_warning ();
-	    break;
-	  case N_WHILE:
+	break;
+      case N_TYPE:
+	x_type ();
+	break;
+      case N_WARNING:
+	x_warning ();
+	break;
+      case N_WHILE:
 
 /***************************************************************************
  * WEB section number:	449
@@ -425,58 +430,52 @@ BEGIN
  * value left on the stack by executing the first is greater than 0.  If
  * either type is incorrect, it complains but does nothing else.
  ***************************************************************************/
+	BEGIN
+	  pop_lit_stk (&r_pop_lt1, &r_pop_tp1);
+	  pop_lit_stk (&r_pop_lt2, &r_pop_tp2);
+	  if (r_pop_tp1 != STK_FN)
+	  BEGIN
+	    print_wrong_stk_lit (r_pop_lt1, r_pop_tp1, STK_FN);
+	  END
+	  else if (r_pop_tp2 != STK_FN)
+	  BEGIN
+	    print_wrong_stk_lit (r_pop_lt2, r_pop_tp2, STK_FN);
+	  END
+	  else
+	  BEGIN
+	    LOOP
 	    BEGIN
-	      pop_lit_stk (&r_pop_lt1, &r_pop_tp1);
-	      pop_lit_stk (&r_pop_lt2, &r_pop_tp2);
-	      if (r_pop_tp1 != STK_FN)
+	      execute_fn (r_pop_lt2);
+	      pop_lit_stk (&pop_lit1, &pop_typ1);
+	      if (pop_typ1 != STK_INT)
 	      BEGIN
-		print_wrong_stk_lit (r_pop_lt1, r_pop_tp1, STK_FN);
+		print_wrong_stk_lit (pop_lit1, pop_typ1, STK_INT);
+		goto End_While_Label;
 	      END
-	      else if (r_pop_tp2 != STK_FN)
+	      else if (pop_lit1 > 0)
 	      BEGIN
-		print_wrong_stk_lit (r_pop_lt2, r_pop_tp2, STK_FN);
+		execute_fn (r_pop_lt1);
 	      END
 	      else
 	      BEGIN
-		LOOP
-		BEGIN
-		  execute_fn (r_pop_lt2);
-		  pop_lit_stk (&pop_lit1, &pop_typ1);
-		  if (pop_typ1 != STK_INT)
-		  BEGIN
-		    print_wrong_stk_lit (pop_lit1, pop_typ1, STK_INT);
-		    goto End_While_Label;
-		  END
-		  else if (pop_lit1 > 0)
-		  BEGIN
-		    execute_fn (r_pop_lt1);
-		  END
-		  else
-		  BEGIN
-		    goto End_While_Label;
-		  END
-		END
+		goto End_While_Label;
 	      END
-End_While_Label: DO_NOTHING;
 	    END
+	  END
+End_While_Label: DO_NOTHING;
+	END
 /*^^^^^^^^^^^^^^^^^^^^^^^^^^ END OF SECTION 449 ^^^^^^^^^^^^^^^^^^^^^^^^^^^*/
 
-	    break;
-	  case N_WIDTH:
-	    x_width ();
-	    break;
-	  case N_WRITE:
-	    x_write ();
-	    break;
-	  default:
-	    CONFUSION ("Unknown built-in function");
-	    break;
-	END
-      END
+	break;
+      case N_WIDTH:
+	x_width ();
+	break;
+      case N_WRITE:
+	x_write ();
+	break;
 /*^^^^^^^^^^^^^^^^^^^^^^^^^^ END OF SECTION 341 ^^^^^^^^^^^^^^^^^^^^^^^^^^^*/
 
-      break;
-    case WIZ_DEFINED:
+      case EX_CALL:
 
 /***************************************************************************
  * WEB section number:	326
@@ -484,33 +483,30 @@ End_While_Label: DO_NOTHING;
  * To execute a |wiz_defined| function, we just execute all those
  * functions in its definition, except that the special marker
  * |quote_next_fn| means we push the next function onto the stack.
+ * Here the definition has been compiled, and |quote_next_fn| has become
+ * |ex_push_fn|.
  ***************************************************************************/
-      BEGIN
-	wiz_ptr = FN_INFO[ex_fn_loc];
-	while (wiz_functions[wiz_ptr] != END_OF_DEF)
 	BEGIN
-	  if (wiz_functions[wiz_ptr] != QUOTE_NEXT_FN)
+	  callee_ptr = ex_code_start[ex_code_arg[code_ptr]];
+	  if (callee_ptr == NOT_COMPILED)
 	  BEGIN
-	    execute_fn (wiz_functions[wiz_ptr]);
+	    callee_ptr = compile_fn (ex_code_arg[code_ptr]);
 	  END
-	  else
-	  BEGIN
-	    INCR (wiz_ptr);
-	    push_lit_stk (wiz_functions[wiz_ptr], STK_FN);
-	  END
-	  INCR (wiz_ptr);
+	  execute_code (callee_ptr);
 	END
-      END
 /*^^^^^^^^^^^^^^^^^^^^^^^^^^ END OF SECTION 326 ^^^^^^^^^^^^^^^^^^^^^^^^^^^*/
 
-      break;
-    case INT_LITERAL:
-      push_lit_stk (FN_INFO[ex_fn_loc], STK_INT);
-      break;
-    case STR_LITERAL:
-      push_lit_stk (hash_text[ex_fn_loc], STK_STR);
-      break;
-    case FIELD:
+	break;
+      case EX_PUSH_FN:
+	push_lit_stk (ex_code_arg[code_ptr], STK_FN);
+	break;
+      case EX_INT_LITERAL:
+	push_lit_stk (ex_code_arg[code_ptr], STK_INT);
+	break;
+      case EX_STR_LITERAL:
+	push_lit_stk (ex_code_arg[code_ptr], STK_STR);
+	break;
+      case EX_FIELD:
 
 /***************************************************************************
  * WEB section number:	327
@@ -519,28 +515,28 @@ End_While_Label: DO_NOTHING;
  * stack unless it's |missing|, in which case it pushes a special value
  * onto the stack.
  ***************************************************************************/
-      BEGIN
-	if ( ! mess_with_entries)
-	BEGIN
-	  bst_cant_mess_with_entries_prin ();
-	END
-	else
 	BEGIN
-	  field_ptr = (cite_ptr * num_fields) + FN_INFO[ex_fn_loc];
-	  if (field_info[field_ptr] == MISSING)
+	  if ( ! mess_with_entries)
 	  BEGIN
-	    push_lit_stk (hash_text[ex_fn_loc], STK_FIELD_MISSING);
+	    bst_cant_mess_with_entries_prin ();
 	  END
 	  else
 	  BEGIN
-	    push_lit_stk (field_info[field_ptr], STK_STR);
+	    field_ptr = (cite_ptr * num_fields) + ex_code_arg[code_ptr];
+	    if (field_info[field_ptr] == MISSING)
+	    BEGIN
+	      push_lit_stk (hash_text[ex_code_loc[code_ptr]], STK_FIELD_MISSING);
+	    END
+	    else
+	    BEGIN
+	      push_lit_stk (field_info[field_ptr], STK_STR);
+	    END
 	  END
 	END
-      END
 /*^^^^^^^^^^^^^^^^^^^^^^^^^^ END OF SECTION 327 ^^^^^^^^^^^^^^^^^^^^^^^^^^^*/
 
-      break;
-    case INT_ENTRY_VAR:
+	break;
+      case EX_INT_ENTRY_VAR:
 
 /***************************************************************************
  * WEB section number:	328
@@ -548,52 +544,59 @@ End_While_Label: DO_NOTHING;
  * This module pushes the integer given by an |int_entry_var| onto the
  * literal stack.
  ***************************************************************************/
-      BEGIN
-	if ( ! mess_with_entries)
 	BEGIN
-	  bst_cant_mess_with_entries_prin ();
-	END
-	else
-	BEGIN
-	  push_lit_stk (entry_ints[(cite_ptr * num_ent_ints)
-				   + FN_INFO[ex_fn_loc]], STK_INT);
+	  if ( ! mess_with_entries)
+	  BEGIN
+	    bst_cant_mess_with_entries_prin ();
+	  END
+	  else
+	  BEGIN
+	    push_lit_stk (entry_ints[(cite_ptr * num_ent_ints)
+				     + ex_code_arg[code_ptr]], STK_INT);
+	  END
 	END
-      END
 /*^^^^^^^^^^^^^^^^^^^^^^^^^^ END OF SECTION 328 ^^^^^^^^^^^^^^^^^^^^^^^^^^^*/
 
-      break;
-    case STR_ENTRY_VAR:
+	break;
+      case EX_STR_ENTRY_VAR:
 
 /***************************************************************************
  * WEB section number:	329
  * ~~~~~~~~~~~~~~~~~~~
  * This module adds the string given by a |str_entry_var| to |str_pool|
- * via the execution buffer and pushes it onto the literal stack.
+ * and pushes it onto the literal stack.  The string goes straight into
+ * the pool, not via the execution buffer.
  ***************************************************************************/
-      BEGIN
-	if ( ! mess_with_entries)
-	BEGIN
-	  bst_cant_mess_with_entries_prin  ();
-	END
-	else
 	BEGIN
-	  str_ent_ptr = (cite_ptr * num_ent_strs) + FN_INFO[ex_fn_loc];
-	  ex_buf_ptr = 0;
-	  while (ENTRY_STRS(str_ent_ptr, ex_buf_ptr) != END_OF_STRING)
+	  if ( ! mess_with_entries)
 	  BEGIN
-	    APPEND_EX_BUF_CHAR (ENTRY_STRS(str_ent_ptr, ex_buf_ptr));
+	    bst_cant_mess_with_entries_prin  ();
+	  END
+	  else
+	  BEGIN
+	    str_ent_ptr = (cite_ptr * num_ent_strs) + ex_code_arg[code_ptr];
+	    ent_chr_ptr = 0;
+	    while (ENTRY_STRS(str_ent_ptr, ent_chr_ptr) != END_OF_STRING)
+	    BEGIN
+	      INCR (ent_chr_ptr);
+	    END
+	    STR_ROOM (ent_chr_ptr);
+	    ent_chr_ptr = 0;
+	    while (ENTRY_STRS(str_ent_ptr, ent_chr_ptr) != END_OF_STRING)
+	    BEGIN
+	      APPEND_CHAR (ENTRY_STRS(str_ent_ptr, ent_chr_ptr));
+	      INCR (ent_chr_ptr);
+	    END
+	    push_lit_stk (make_string (), STK_STR);
 	  END
-	  ex_buf_length = ex_buf_ptr;
-	  add_pool_buf_and_push ();
 	END
-      END
 /*^^^^^^^^^^^^^^^^^^^^^^^^^^ END OF SECTION 329 ^^^^^^^^^^^^^^^^^^^^^^^^^^^*/
 
-      break;
-    case INT_GLOBAL_VAR:
-      push_lit_stk (FN_INFO[ex_fn_loc], STK_INT);
-      break;
-    case STR_GLOBAL_VAR:
+	break;
+      case EX_INT_GLOBAL_VAR:
+	push_lit_stk (FN_INFO[ex_code_arg[code_ptr]], STK_INT);
+	break;
+      case EX_STR_GLOBAL_VAR:
 
 /***************************************************************************
  * WEB section number:	330
@@ -604,31 +607,72 @@ End_While_Label: DO_NOTHING;
  * string is static (that is, if the string isn't at the top, temporary
  * part of the string pool).
  ***************************************************************************/
-      BEGIN
-	str_glb_ptr = FN_INFO[ex_fn_loc];
-	if (glb_str_ptr[str_glb_ptr] > 0)
 	BEGIN
-	  push_lit_stk (glb_str_ptr[str_glb_ptr], STK_STR);
-	END
-	else
-	BEGIN
-	  STR_ROOM (glb_str_end[str_glb_ptr]);
-	  glob_chr_ptr = 0;
-	  while (glob_chr_ptr < glb_str_end[str_glb_ptr])
+	  str_glb_ptr = ex_code_arg[code_ptr];
+	  if (glb_str_ptr[str_glb_ptr] > 0)
+	  BEGIN
+	    push_lit_stk (glb_str_ptr[str_glb_ptr], STK_STR);
+	  END
+	  else
 	  BEGIN
-	    APPEND_CHAR (GLOBAL_STRS(str_glb_ptr, glob_chr_ptr));
-	    INCR (glob_chr_ptr);
+	    STR_ROOM (glb_str_end[str_glb_ptr]);
+	    glob_chr_ptr = 0;
+	    while (glob_chr_ptr < glb_str_end[str_glb_ptr])
+	    BEGIN
+	      APPEND_CHAR (GLOBAL_STRS(str_glb_ptr, glob_chr_ptr));
+	      INCR (glob_chr_ptr);
+	    END
+	    push_lit_stk (make_string (), STK_STR);
 	  END
-	  push_lit_stk (make_string (), STK_STR);
 	END
-      END
 /*^^^^^^^^^^^^^^^^^^^^^^^^^^ END OF SECTION 330 ^^^^^^^^^^^^^^^^^^^^^^^^^^^*/
 
-      break;
-    default:
-      unknwn_function_class_confusion ();
-      break;
+	break;
+      case EX_END:
+	goto Exit_Label;
+      default:
+	CONFUSION ("Unknown built-in function");
+	break;
+    END
+    INCR (code_ptr);
+  END
+Exit_Label: DO_NOTHING;
+END
+
+
+
+
+/***************************************************************************
+ * WEB section number:	 325
+ * ~~~~~~~~~~~~~~~~~~~
+ * This procedure executes a single specified function; it is the single
+ * execution-primitive that does everything (except windows, and it takes
+ * Tuesdays off).  The function is compiled the first time round; the
+ * work is done by |execute_code|.
+ ***************************************************************************/
+void          execute_fn (HashLoc_T ex_fn_loc)
+BEGIN
+  ExCodeLoc_T       code_ptr;
+
+  code_ptr = ex_code_start[ex_fn_loc];
+  if (code_ptr == NOT_COMPILED)
+  BEGIN
+    code_ptr = compile_fn (ex_fn_loc);
   END
+
+  /*
+  ** The code of any other function is a single instruction that traces
+  ** itself.
+  */
+#ifdef TRACE
+  if (Flag_trace && (fn_type[ex_fn_loc] == WIZ_DEFINED)) {
+    TRACE_PR ("execute_fn `");
+    TRACE_PR_POOL_STR (hash_text[ex_fn_loc]);
+    TRACE_PR_LN ("'");
+  }
+#endif                      			/* TRACE */
+
+  execute_code (code_ptr);
 END
 /*^^^^^^^^^^^^^^^^^^^^^^^^^^ END OF SECTION 325 ^^^^^^^^^^^^^^^^^^^^^^^^^^^*/
 
@@ -2666,6 +2710,17 @@ BEGIN
     hash_used = HASH_MAX + 1;
 /*^^^^^^^^^^^^^^^^^^^^^^^^^^ END OF SECTION 67 ^^^^^^^^^^^^^^^^^^^^^^^^^^^*/
 
+/***************************************************************************
+ * WEB section number:	N/A
+ * ~~~~~~~~~~~~~~~~~~~
+ * No function has been compiled yet; code location 0 is never used.
+ ***************************************************************************/
+    for (k=HASH_BASE; k<=HASH_MAX; k++)
+    BEGIN
+        ex_code_start[k] = NOT_COMPILED;
+    END
+    ex_code_ptr = NOT_COMPILED + 1;
+
 /***************************************************************************
  * WEB section number:	72
  * ~~~~~~~~~~~~~~~~~~~
@@ -282,6 +282,7 @@
 
 #define MIN_CROSSREFS               2
 #define WIZ_FN_SPACE                3000
+#define EX_CODE_SPACE               3000
 #define SINGLE_FN_SPACE             50
 #define ENT_STR_SIZE                100
 #define GLOB_STR_SIZE               1000
@@ -861,6 +862,46 @@
 #define FN_INFO                     ilk_info
 #define MISSING                     EMPTY
 
+/***************************************************************************
+ * WEB section number:  N/A
+ * ~~~~~~~~~~~~~~~~~~~
+ * Before a function is executed for the first time, it is compiled into
+ * the |ex_code| arrays: each element of a |wiz_defined| definition
+ * becomes one instruction whose operand has already been looked up, so
+ * that |execute_code| needn't go through |fn_type| and |fn_info| for
+ * every function it executes.  The opcode of a |built_in| function is
+ * its |blt_in_num|; the other opcodes follow.  Code location 0 means
+ * ``not yet compiled''.
+ ***************************************************************************/
+#define EX_CALL                     (NUM_BLT_IN_FNS + 0)
+#define EX_PUSH_FN                  (NUM_BLT_IN_FNS + 1)
+#define EX_INT_LITERAL              (NUM_BLT_IN_FNS + 2)
+#define EX_STR_LITERAL              (NUM_BLT_IN_FNS + 3)
+#define EX_FIELD                    (NUM_BLT_IN_FNS + 4)
+#define EX_INT_ENTRY_VAR            (NUM_BLT_IN_FNS + 5)
+#define EX_STR_ENTRY_VAR            (NUM_BLT_IN_FNS + 6)
+#define EX_INT_GLOBAL_VAR           (NUM_BLT_IN_FNS + 7)
+#define EX_STR_GLOBAL_VAR           (NUM_BLT_IN_FNS + 8)
+#define EX_END                      (NUM_BLT_IN_FNS + 9)
+#define NOT_COMPILED                0
+
+#define EMIT_EX_CODE(OP, ARG, LOC) \
+            {\
+                if (ex_code_ptr > Ex_Code_Space)\
+                BEGIN\
+                    BIB_XRETALLOC_NOSET ("ex_code_arg", ex_code_arg, Integer_T,\
+                                         Ex_Code_Space, Ex_Code_Space + EX_CODE_SPACE);\
+                    BIB_XRETALLOC_NOSET ("ex_code_loc", ex_code_loc, HashLoc_T,\
+                                         Ex_Code_Space, Ex_Code_Space + EX_CODE_SPACE);\
+                    BIB_XRETALLOC ("ex_code_op", ex_code_op, ExOpcode_T,\
+                                   Ex_Code_Space, Ex_Code_Space + EX_CODE_SPACE);\
+                END\
+                ex_code_op[ex_code_ptr] = (OP);\
+                ex_code_arg[ex_code_ptr] = (ARG);\
+                ex_code_loc[ex_code_ptr] = (LOC);\
+                INCR (ex_code_ptr);\
+            }
+
 /***************************************************************************
  * WEB section number:  166
  * ~~~~~~~~~~~~~~~~~~~
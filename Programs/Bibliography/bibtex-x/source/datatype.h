@@ -149,6 +149,8 @@ typedef Integer16_T         BltInRange_T;
 typedef Integer16_T         BufPointer_T;
 typedef ASCIICode_T        *BufType_T;
 typedef Integer16_T         CiteNumber_T;
+typedef Integer32_T         ExCodeLoc_T;
+typedef UChar_T             ExOpcode_T;
 typedef Integer16_T         FieldLoc_T;
 typedef Integer8_T          FnClass_T;
 
@@ -186,6 +186,8 @@ void                    check_cite_overflow (CiteNumber_T lastcite);
 void                    check_command_execution (void);
 void                    check_field_overflow (Integer_T totalfields);
 void                    cite_key_disappeared_confusion (void);
+ExCodeLoc_T             compile_fn (HashLoc_T fnloc);
+void                    compile_fn_ref (HashLoc_T fnloc);
 Boolean_T               compress_bib_white (void);
 
 void                    decr_brace_level (StrNumber_T poplitvar);
@@ -196,6 +198,7 @@ void                    eat_bst_print (void);
 Boolean_T               eat_bst_white_space (void);
 Boolean_T               enough_text_chars (BufPointer_T enoughchars);
 Boolean_T               eoln (const AlphaFile_T file_pointer);
+void                    execute_code (ExCodeLoc_T codeptr);
 void                    execute_fn (HashLoc_T exfnloc);
 
 void                    figure_out_the_formatted_name (void);
@@ -202,6 +202,7 @@ __EXTERN__ HashLoc_T                    entry_type_loc;
 __EXTERN__ Integer_T                    err_count;
 __EXTERN__ BufPointer_T                 ex_buf_length;
 __EXTERN__ BufPointer_T                 ex_buf_ptr;
+__EXTERN__ ExCodeLoc_T                  ex_code_ptr;
 __EXTERN__ BufPointer_T                 ex_buf_xptr;
 __EXTERN__ BufPointer_T                 ex_buf_yptr;
 __EXTERN__ LongJumpBuf_T                Exit_Program_Flag;
@@ -394,6 +395,10 @@ __EXTERN__ Boolean_T                   *entry_exists;
 __EXTERN__ Integer_T                   *entry_ints;
 __EXTERN__ ASCIICode_T                 *entry_strs;
 __EXTERN__ ASCIICode_T                 *ex_buf;
+__EXTERN__ Integer_T                   *ex_code_arg;
+__EXTERN__ HashLoc_T                   *ex_code_loc;
+__EXTERN__ ExOpcode_T                  *ex_code_op;
+__EXTERN__ ExCodeLoc_T                 *ex_code_start;
 __EXTERN__ StrNumber_T                 *field_info;
 __EXTERN__ FnClass_T                   *fn_type;
 __EXTERN__ Integer_T                   *glb_str_end;
@@ -452,6 +457,7 @@ __EXTERN__ char                        *Str_csfile;
 */
 __EXTERN__ Integer_T                    Buf_Size;
 __EXTERN__ Integer_T                    Ent_Str_Size;
+__EXTERN__ Integer_T                    Ex_Code_Space;
 __EXTERN__ Integer_T                    Glob_Str_Size;
 __EXTERN__ Integer_T                    Hash_Prime;
 __EXTERN__ Integer_T                    Hash_Size;
@@ -262,6 +262,10 @@ static int              sort_weight;
 **	Integer_T       entry_ints[Max_Ent_Ints + 1];
 **	ASCIICode_T	entry_strs[Max_Ent_Strs + 1][Ent_Str_Size + 1];
 **	ASCIICode_T     ex_buf[Buf_Size + 1];
+**	Integer_T       ex_code_arg[Ex_Code_Space + 1];
+**	HashLoc_T       ex_code_loc[Ex_Code_Space + 1];
+**	ExOpcode_T      ex_code_op[Ex_Code_Space + 1];
+**	ExCodeLoc_T     ex_code_start[Hash_Size + 1];
 **	StrNumber_T     field_info[Max_Fields + 1];
 **	FnClass_T       fn_type[Hash_Size + 1];
 **      Integer_T       glb_str_end[Max_Glob_Strs];
@@ -344,6 +348,30 @@ static void allocate_arrays (void)
     bytes_required = (Buf_Size + 1) * (unsigned long) sizeof (ASCIICode_T);
     ex_buf = (ASCIICode_T *) mymalloc (bytes_required, "ex_buf");
 
+    /*
+    ** Integer_T ex_code_arg[Ex_Code_Space + 1];
+    */
+    bytes_required = (Ex_Code_Space + 1) * (unsigned long) sizeof (Integer_T);
+    ex_code_arg = (Integer_T *) mymalloc (bytes_required, "ex_code_arg");
+
+    /*
+    ** HashLoc_T ex_code_loc[Ex_Code_Space + 1];
+    */
+    bytes_required = (Ex_Code_Space + 1) * (unsigned long) sizeof (HashLoc_T);
+    ex_code_loc = (HashLoc_T *) mymalloc (bytes_required, "ex_code_loc");
+
+    /*
+    ** ExOpcode_T ex_code_op[Ex_Code_Space + 1];
+    */
+    bytes_required = (Ex_Code_Space + 1) * (unsigned long) sizeof (ExOpcode_T);
+    ex_code_op = (ExOpcode_T *) mymalloc (bytes_required, "ex_code_op");
+
+    /*
+    ** ExCodeLoc_T ex_code_start[Hash_Size + 1];
+    */
+    bytes_required = (Hash_Size + 1) * (unsigned long) sizeof (ExCodeLoc_T);
+    ex_code_start = (ExCodeLoc_T *) mymalloc (bytes_required, "ex_code_start");
+
     /*
     ** StrNumber_T field_info[Max_Fields + 1];
     */
@@ -1425,6 +1453,7 @@ static void compute_hash_prime (void)
 **    Max_Strings     Y        4,000      10,000      19,000      30,000
 **    Pool_Size       *** initialy 65,000, increased as required ***
 **    Wiz_Fn_Space    *** initialy 3000, increased as required ***
+**    Ex_Code_Space   *** initialy 3000, increased as required ***
 **    ------------------------------------------------------------------
 **
 **============================================================================
@@ -1454,6 +1483,8 @@ void set_array_sizes (void)
 
     Wiz_Fn_Space = WIZ_FN_SPACE;
 
+    Ex_Code_Space = EX_CODE_SPACE;
+
 
     allocate_arrays ();
     compute_hash_prime ();
@@ -0,0 +1,743 @@
+/* miktex/t4ht.h:
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 2, or (at your
+   option) any later version.
+
+   This file is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this file; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA.  */
+
+#pragma once
+
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <miktex/Core/File>
+#include <miktex/Core/PathName>
+#include <miktex/Core/Process>
+
+/* The commands which generate an image (the dvigif script, followed
+   by the move and chmod scripts) are collected into a job.  Jobs are
+   run by a pool of worker threads; their output is printed in the
+   order in which the images appear in the .lg file.
+
+   Jobs which write the same file are not run at the same time.  A
+   temporary file, which a job writes and then reads (zz%%4.ps in the
+   stock scripts), gets a name of its own in each job instead.  The
+   standard error of the commands goes to the same pipe as their
+   standard output, so that diagnostics are printed with their job.
+
+   An image is not generated again, if its target file exists and
+   neither the commands nor the .idv page have changed since the
+   previous run (see <job>.4ic). */
+
+namespace miktex_t4ht {
+
+  struct Job
+  {
+    std::vector<std::string> commands;
+    // files written by shell redirections; jobs writing the same file
+    // are not run at the same time
+    std::set<std::string> outputs;
+    // renamed temporary files; removed when the job is done
+    std::vector<std::string> temporaries;
+    std::string imageName;
+    std::uint64_t digest = 0;
+    std::string log;
+    bool running = false;
+    bool done = false;
+    bool succeeded = false;
+  };
+
+  /* The pages of an .idv file. */
+  class IdvFile
+  {
+  public:
+    bool Load(const std::string& path)
+    {
+      pages.clear();
+      try
+      {
+        bytes = MiKTeX::Core::File::ReadAllBytes(MiKTeX::Core::PathName(path));
+      }
+      catch (const MiKTeX::Core::MiKTeXException&)
+      {
+        return false;
+      }
+      // post_post: q[4] i[1] 223 223 223 223 ...
+      std::size_t end = bytes.size();
+      while (end > 0 && bytes[end - 1] == 223)
+      {
+        end--;
+      }
+      if (end < 6 || bytes.size() - end < 4 || bytes[end - 6] != 249)
+      {
+        return false;
+      }
+      std::size_t post = GetUnsigned(end - 5);
+      if (post + 29 > end - 6 || bytes[post] != 248)
+      {
+        return false;
+      }
+      fontDefsBegin = post + 29;
+      fontDefsEnd = end - 6;
+      // bop: c0[4] ... c9[4] p[4]
+      std::size_t pageEnd = post;
+      std::uint32_t bop = GetUnsigned(post + 1);
+      while (bop != 0xffffffff)
+      {
+        if (bop + 45 > pageEnd || bytes[bop] != 139)
+        {
+          pages.clear();
+          return false;
+        }
+        pages[static_cast<std::int32_t>(GetUnsigned(bop + 1))] = std::make_pair(bop + 45, pageEnd);
+        pageEnd = bop;
+        bop = GetUnsigned(bop + 41);
+      }
+      return true;
+    }
+
+  public:
+    template<typename Func> bool ForPage(long pageNo, Func func) const
+    {
+      auto it = pages.find(static_cast<std::int32_t>(pageNo));
+      if (it == pages.end())
+      {
+        return false;
+      }
+      func(&bytes[it->second.first], it->second.second - it->second.first);
+      func(&bytes[fontDefsBegin], fontDefsEnd - fontDefsBegin);
+      return true;
+    }
+
+  private:
+    std::uint32_t GetUnsigned(std::size_t offset) const
+    {
+      return (std::uint32_t(bytes[offset]) << 24) | (std::uint32_t(bytes[offset + 1]) << 16) | (std::uint32_t(bytes[offset + 2]) << 8) | std::uint32_t(bytes[offset + 3]);
+    }
+
+  private:
+    std::vector<unsigned char> bytes;
+
+  private:
+    std::map<std::int32_t, std::pair<std::size_t, std::size_t>> pages;
+
+  private:
+    std::size_t fontDefsBegin = 0;
+
+  private:
+    std::size_t fontDefsEnd = 0;
+  };
+
+  class Scheduler
+  {
+  public:
+    ~Scheduler()
+    {
+      Finish();
+    }
+
+  public:
+    void Initialize(const std::string& jobName, int maxJobs, bool alwaysCallSys)
+    {
+      cachePath = jobName + ".4ic";
+      this->maxJobs = maxJobs < 1 ? 1 : maxJobs;
+      this->alwaysCallSys = alwaysCallSys;
+      LoadCache();
+    }
+
+  public:
+    void BeginImage()
+    {
+      current = std::make_shared<Job>();
+    }
+
+  public:
+    bool Record(const char* command)
+    {
+      if (current == nullptr)
+      {
+        return false;
+      }
+      current->commands.push_back(command);
+      AddOutputs(command, current->outputs);
+      return true;
+    }
+
+  public:
+    void EndImage(const char* idvName, long pageNo, const char* imageName, const std::string& target, bool reuse)
+    {
+      std::shared_ptr<Job> job = current;
+      current = nullptr;
+      if (job == nullptr)
+      {
+        return;
+      }
+      job->imageName = imageName;
+      if (pageNo >= 0 && ComputeDigest(*job, idvName, pageNo) && reuse)
+      {
+        auto it = cache.find(job->imageName);
+        if (it != cache.end() && it->second == job->digest && MiKTeX::Core::File::Exists(MiKTeX::Core::PathName(target)))
+        {
+          job->commands.clear();
+          job->log = job->imageName + " unchanged since the last run\n";
+          job->done = true;
+          job->succeeded = true;
+        }
+      }
+      if (job->commands.empty())
+      {
+        job->done = true;
+      }
+      else if (maxJobs > 1)
+      {
+        MakeTemporariesUnique(*job);
+      }
+      Submit(job);
+    }
+
+  public:
+    void Message(const std::string& text)
+    {
+      std::shared_ptr<Job> job = std::make_shared<Job>();
+      job->log = text;
+      job->done = true;
+      Submit(job);
+    }
+
+  public:
+    void Finish()
+    {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        jobDone.wait(lock, [this]() { return AllDone(); });
+        stopping = true;
+      }
+      workAvailable.notify_all();
+      for (std::thread& worker : workers)
+      {
+        worker.join();
+      }
+      workers.clear();
+      stopping = false;
+      Flush();
+      SaveCache();
+    }
+
+  private:
+    void Submit(std::shared_ptr<Job> job)
+    {
+      if (maxJobs == 1 && !job->done)
+      {
+        // print the output as it comes
+        Flush();
+        Run(*job, false);
+        job->done = true;
+      }
+      bool pending = !job->done;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(job);
+      }
+      if (pending)
+      {
+        if (workers.empty())
+        {
+          for (int idx = 0; idx < maxJobs; ++idx)
+          {
+            workers.push_back(std::thread(&Scheduler::Work, this));
+          }
+        }
+        workAvailable.notify_one();
+      }
+      Flush();
+    }
+
+    /* Prints the output of the finished jobs at the front of the queue. */
+  private:
+    void Flush()
+    {
+      while (true)
+      {
+        std::shared_ptr<Job> job;
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          if (queue.empty() || !queue.front()->done)
+          {
+            break;
+          }
+          job = queue.front();
+          queue.pop_front();
+        }
+        (void)fputs(job->log.c_str(), stdout);
+        if (!job->commands.empty())
+        {
+          if (job->succeeded && job->digest != 0)
+          {
+            cache[job->imageName] = job->digest;
+          }
+          else
+          {
+            cache.erase(job->imageName);
+          }
+          cacheModified = true;
+        }
+      }
+      (void)fflush(stdout);
+    }
+
+  private:
+    void Work()
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      while (true)
+      {
+        std::shared_ptr<Job> job;
+        workAvailable.wait(lock, [this, &job]() { return stopping || (job = NextJob()) != nullptr; });
+        if (job == nullptr)
+        {
+          break;
+        }
+        job->running = true;
+        lock.unlock();
+        Run(*job, true);
+        for (const std::string& temporary : job->temporaries)
+        {
+          (void)remove(temporary.c_str());
+        }
+        lock.lock();
+        job->running = false;
+        job->done = true;
+        jobDone.notify_all();
+        // a job waiting for our outputs may now start
+        workAvailable.notify_all();
+      }
+    }
+
+    /* Gets the first pending job which doesn't write a file written by
+       a running job or by an earlier pending job. */
+  private:
+    std::shared_ptr<Job> NextJob()
+    {
+      std::set<std::string> busy;
+      for (const std::shared_ptr<Job>& job : queue)
+      {
+        if (job->done)
+        {
+          continue;
+        }
+        if (!job->running)
+        {
+          bool conflict = false;
+          for (const std::string& output : job->outputs)
+          {
+            conflict = conflict || busy.find(output) != busy.end();
+          }
+          if (!conflict)
+          {
+            return job;
+          }
+        }
+        busy.insert(job->outputs.begin(), job->outputs.end());
+      }
+      return nullptr;
+    }
+
+  private:
+    bool AllDone() const
+    {
+      for (const std::shared_ptr<Job>& job : queue)
+      {
+        if (!job->done)
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    /* Runs the commands of a job until one of them fails. */
+  private:
+    void Run(Job& job, bool capture)
+    {
+      job.succeeded = true;
+      for (const std::string& command : job.commands)
+      {
+        std::string log = "System call: " + command + "\n";
+        int exitCode = -1;
+        try
+        {
+          if (capture)
+          {
+            exitCode = Execute(command, &log);
+          }
+          else
+          {
+            (void)fputs(log.c_str(), stdout);
+            (void)fflush(stdout);
+            log.clear();
+            exitCode = Execute(command, nullptr);
+          }
+        }
+        catch (const MiKTeX::Core::MiKTeXException&)
+        {
+          exitCode = -1;
+        }
+        log += (exitCode != 0 ? "--- Warning --- System return: " : "System return: ") + std::to_string(exitCode) + "\n";
+        if (capture)
+        {
+          job.log += log;
+        }
+        else
+        {
+          (void)fputs(log.c_str(), stdout);
+        }
+        if (exitCode != 0)
+        {
+          job.succeeded = false;
+          if (!alwaysCallSys)
+          {
+            break;
+          }
+        }
+      }
+    }
+
+    /* Runs a shell command and returns its exit code (-1, if it
+       didn't exit normally).  Starting a process uses the session,
+       which is not thread-safe: the start is serialized, whereas
+       reading the output and waiting for the exit are not.  The
+       pipe receives the standard error of the command, too. */
+  private:
+    int Execute(const std::string& command, std::string* log)
+    {
+      std::unique_ptr<MiKTeX::Core::Process> process;
+      FILE* output = nullptr;
+      {
+        std::lock_guard<std::mutex> lock(startMutex);
+        process = MiKTeX::Core::Process::StartSystemCommand(command, nullptr, log == nullptr ? nullptr : &output);
+      }
+      if (output != nullptr)
+      {
+        char buf[4096];
+        std::size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), output)) > 0)
+        {
+          log->append(buf, n);
+        }
+        (void)fclose(output);
+      }
+      process->WaitForExit();
+      int exitCode = process->get_ExitStatus() == MiKTeX::Core::ProcessExitStatus::Exited ? process->get_ExitCode() : -1;
+      process->Close();
+      return exitCode;
+    }
+
+    /* FNV-1a over the commands and the contents of the .idv page
+       (including the font definitions). */
+  private:
+    bool ComputeDigest(Job& job, const std::string& idvName, long pageNo)
+    {
+      if (idvName != loadedIdvName)
+      {
+        loadedIdvName = idvName;
+        idvLoaded = idvFile.Load(idvName);
+      }
+      std::uint64_t digest = 0xcbf29ce484222325;
+      auto update = [&digest](const void* data, std::size_t n) {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+        for (std::size_t idx = 0; idx < n; ++idx)
+        {
+          digest = (digest ^ bytes[idx]) * 0x100000001b3;
+        }
+      };
+      for (const std::string& command : job.commands)
+      {
+        update(command.c_str(), command.length() + 1);
+      }
+      if (!idvLoaded || !idvFile.ForPage(pageNo, update))
+      {
+        return false;
+      }
+      job.digest = digest == 0 ? 1 : digest;
+      return true;
+    }
+
+    /* Renames the files which a command of the job writes by
+       redirection and a later command reads.  The image itself keeps
+       its name.  The digest has been computed before, so the cache
+       doesn't depend on -j. */
+  private:
+    void MakeTemporariesUnique(Job& job)
+    {
+      for (std::size_t idx = 0; idx + 1 < job.commands.size(); ++idx)
+      {
+        std::set<std::string> written;
+        AddOutputs(job.commands[idx], written);
+        for (const std::string& output : written)
+        {
+          if (output.find(job.imageName) != std::string::npos)
+          {
+            continue;
+          }
+          bool readLater = false;
+          for (std::size_t later = idx + 1; later < job.commands.size(); ++later)
+          {
+            readLater = readLater || FindWord(job.commands[later], output, 0) != std::string::npos;
+          }
+          if (!readLater)
+          {
+            continue;
+          }
+          std::size_t dot = output.find_last_of('.');
+          std::size_t slash = output.find_last_of("/\\");
+          if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+          {
+            dot = output.length();
+          }
+          std::string temporary = output.substr(0, dot) + "-" + std::to_string(++numTemporaries) + output.substr(dot);
+          for (std::string& command : job.commands)
+          {
+            for (std::size_t pos = FindWord(command, output, 0); pos != std::string::npos; pos = FindWord(command, output, pos + temporary.length()))
+            {
+              command.replace(pos, output.length(), temporary);
+            }
+          }
+          job.temporaries.push_back(temporary);
+        }
+      }
+      job.outputs.clear();
+      for (const std::string& command : job.commands)
+      {
+        AddOutputs(command, job.outputs);
+      }
+    }
+
+    /* Finds `word' in a command line, where it is not part of a
+       longer file name. */
+  private:
+    static std::size_t FindWord(const std::string& command, const std::string& word, std::size_t start)
+    {
+      auto isNameChar = [](char ch) {
+        return isalnum(static_cast<unsigned char>(ch)) || ch == '.' || ch == '_' || ch == '-' || ch == '/' || ch == '\\' || ch == ':';
+      };
+      for (std::size_t pos = command.find(word, start); pos != std::string::npos; pos = command.find(word, pos + 1))
+      {
+        std::size_t end = pos + word.length();
+        if ((pos == 0 || !isNameChar(command[pos - 1])) && (end == command.length() || !isNameChar(command[end])))
+        {
+          return pos;
+        }
+      }
+      return std::string::npos;
+    }
+
+    /* Collects the targets of `>' and `>>' redirections. */
+  private:
+    static void AddOutputs(const std::string& command, std::set<std::string>& outputs)
+    {
+      char quote = 0;
+      for (std::size_t pos = 0; pos < command.length(); ++pos)
+      {
+        char ch = command[pos];
+        if (quote != 0)
+        {
+          quote = ch == quote ? 0 : quote;
+          continue;
+        }
+        if (ch == '"' || ch == '\'')
+        {
+          quote = ch;
+          continue;
+        }
+        if (ch != '>')
+        {
+          continue;
+        }
+        while (pos + 1 < command.length() && (command[pos + 1] == '>' || command[pos + 1] == ' '))
+        {
+          pos++;
+        }
+        if (pos + 1 < command.length() && command[pos + 1] == '&')
+        {
+          continue;
+        }
+        std::size_t end = command.find_first_of(" \t;|&<>", pos + 1);
+        std::string output = command.substr(pos + 1, end == std::string::npos ? std::string::npos : end - pos - 1);
+        if (!output.empty())
+        {
+          outputs.insert(output);
+        }
+      }
+    }
+
+  private:
+    void LoadCache()
+    {
+      cache.clear();
+      std::ifstream stream(cachePath);
+      std::string line;
+      if (!std::getline(stream, line) || line != "# t4ht image cache 1")
+      {
+        return;
+      }
+      while (std::getline(stream, line))
+      {
+        std::istringstream fields(line);
+        std::uint64_t digest;
+        std::string imageName;
+        if (fields >> std::hex >> digest && fields.get() == ' ' && std::getline(fields, imageName))
+        {
+          cache[imageName] = digest;
+        }
+      }
+    }
+
+  private:
+    void SaveCache()
+    {
+      if (!cacheModified)
+      {
+        return;
+      }
+      cacheModified = false;
+      MiKTeX::Core::PathName tmpPath(cachePath + ".tmp");
+      try
+      {
+        {
+          std::ofstream stream = MiKTeX::Core::File::CreateOutputStream(tmpPath);
+          stream << "# t4ht image cache 1\n";
+          for (const auto& entry : cache)
+          {
+            stream << std::hex << entry.second << " " << entry.first << "\n";
+          }
+        }
+        MiKTeX::Core::File::Move(tmpPath, MiKTeX::Core::PathName(cachePath), { MiKTeX::Core::FileMoveOption::ReplaceExisting });
+      }
+      catch (const MiKTeX::Core::MiKTeXException& e)
+      {
+        // all images will be generated again next time
+        (void)fprintf(stderr, "--- warning --- the image cache %s could not be saved: %s\n", cachePath.c_str(), e.GetErrorMessage().c_str());
+        try
+        {
+          if (MiKTeX::Core::File::Exists(tmpPath))
+          {
+            MiKTeX::Core::File::Delete(tmpPath);
+          }
+        }
+        catch (const MiKTeX::Core::MiKTeXException&)
+        {
+        }
+      }
+    }
+
+  private:
+    std::string cachePath;
+
+  private:
+    std::map<std::string, std::uint64_t> cache;
+
+  private:
+    bool cacheModified = false;
+
+  private:
+    int maxJobs = 1;
+
+  private:
+    int numTemporaries = 0;
+
+  private:
+    bool alwaysCallSys = false;
+
+  private:
+    std::shared_ptr<Job> current;
+
+  private:
+    std::deque<std::shared_ptr<Job>> queue;
+
+  private:
+    std::vector<std::thread> workers;
+
+  private:
+    bool stopping = false;
+
+  private:
+    std::mutex mutex;
+
+  private:
+    std::mutex startMutex;
+
+  private:
+    std::condition_variable workAvailable;
+
+  private:
+    std::condition_variable jobDone;
+
+  private:
+    std::string loadedIdvName;
+
+  private:
+    IdvFile idvFile;
+
+  private:
+    bool idvLoaded = false;
+  };
+
+  Scheduler scheduler;
+}
+
+void miktex_t4ht_init(const char* jobName, int maxJobs, int alwaysCallSys)
+{
+  miktex_t4ht::scheduler.Initialize(jobName, maxJobs, alwaysCallSys != 0);
+}
+
+void miktex_t4ht_begin_image()
+{
+  miktex_t4ht::scheduler.BeginImage();
+}
+
+int miktex_t4ht_record(const char* command)
+{
+  return miktex_t4ht::scheduler.Record(command) ? 1 : 0;
+}
+
+void miktex_t4ht_end_image(const char* idvName, long pageNo, const char* imageName, const char* dir, int reuse)
+{
+  std::string target = dir == nullptr ? "" : dir;
+  target += imageName;
+  miktex_t4ht::scheduler.EndImage(idvName, pageNo, imageName, target, reuse != 0);
+}
+
+void miktex_t4ht_message(const char* text)
+{
+  miktex_t4ht::scheduler.Message(text);
+}
+
+void miktex_t4ht_finish()
+{
+  miktex_t4ht::scheduler.Finish();
+}
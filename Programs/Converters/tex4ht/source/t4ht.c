@@ -112,6 +112,7 @@
 #endif
 #if defined(MIKTEX)
 # include <miktex/tex4ht.h>
+# include <miktex/t4ht.h>
 #endif
 
 #ifdef KPATHSEA
@@ -459,6 +460,9 @@ static const C_CHAR *warn_err_mssg[]={
 "  -d...  directory for output files       (default:  current)\n"
 "  -e...  location of tex4ht.env\n"
 "  -i     debugging info\n"
+#if defined(MIKTEX)
+"  -j...  number of pictures converted at the same time\n"
+#endif
 "  -g     ignore errors in system calls\n"
 "  -m...  chmod ... of new output files (reused bitmaps excluded)\n"
 "  -p     don't convert pictures           (default:  convert)\n"
@@ -493,6 +497,9 @@ static BOOL system_yes;
 
 
 static BOOL always_call_sys = FALSE;
+#if defined(MIKTEX)
+static int max_jobs = 1;
+#endif
 
 
 static Q_CHAR* match[10];
@@ -1188,6 +1195,11 @@ static void call_sys
 #endif
 {
    if( *command ){
+#if defined(MIKTEX)
+      if( system_yes && miktex_t4ht_record(command) ){
+         system_return = 0;  return;
+      }
+#endif
       (IGNORED) printf("System call: %s\n", command);
 #if defined(MIKTEX)
       system_return = system_yes ? miktex_system(command) : -1;
@@ -1668,6 +1680,9 @@ lg_name++;
 
  break; }
   case 'i':{ debug = q-1;  break;}
+#if defined(MIKTEX)
+  case 'j':{ max_jobs = (int) get_long_int(q);  break;}
+#endif
   case 'g':{ always_call_sys = TRUE;  break;}
   case 'm':{ ch_mod = q;  break; }
   case 'p':{ nopict = q-1;  break;}
@@ -2593,6 +2608,9 @@ last->n = get_long_int(match[1]);
   
 {                               BOOL characters, skip;
    characters = skip = FALSE;
+#if defined(MIKTEX)
+   miktex_t4ht_init(job_name, max_jobs, always_call_sys);
+#endif
    while( TRUE ) {
       status = scan_until_str("--- ", 1, TRUE, lg_file);
       status = scan_until_str( " ---" , 2, status, lg_file);
@@ -2628,6 +2646,9 @@ if( dir && !bitmaps_no_dm ){ (IGNORED) strct(filename, dir); }
 file  = fopen(filename, READ_TEXT_FLAGS);
 if( !file || noreuse ){
    
+#if defined(MIKTEX)
+miktex_t4ht_begin_image();
+#endif
 filtered_dvigif_script = dvigif_glyp_script?
    filterGifScript(dvigif_glyp_script, match[3]):
    filterGifScript(dvigif_script, match[3]);
@@ -2643,10 +2664,17 @@ if( ch_mod && !bitmaps_no_dm && !system_return ){
 
 
 }
+#if defined(MIKTEX)
+miktex_t4ht_end_image(match[1], gif_i, match[3],
+                      (dir && !bitmaps_no_dm)? dir : "", !noreuse);
+#endif
 
 
 } else {
    (IGNORED) fclose(file);
+#if defined(MIKTEX)
+   miktex_t4ht_begin_image();
+#endif
    if( newchmod )
    { 
 if( ch_mod && !bitmaps_no_dm && !system_return ){
@@ -2654,8 +2682,17 @@ if( ch_mod && !bitmaps_no_dm && !system_return ){
 }
 
  }
+#if defined(MIKTEX)
+   miktex_t4ht_end_image(match[1], -1, match[3], "", FALSE);
+   {  char mssg[512];
+      (IGNORED) snprintf(mssg, sizeof(mssg), "%s already in %s\n", match[3],
+                           dir? dir : "current directory" );
+      miktex_t4ht_message(mssg);
+   }
+#else
    (IGNORED) printf("%s already in %s\n", match[3],
                            dir? dir : "current directory" );
+#endif
 }
 
 
@@ -2666,12 +2703,18 @@ empty_pic->n
  ) {
   
 if( !skip ){
+#if defined(MIKTEX)
+   miktex_t4ht_begin_image();
+#endif
    (void) execute_script(empty_fig_script,
                            (dir && !bitmaps_no_dm )? dir :"", match[3],"","");
    if( ch_mod && !bitmaps_no_dm && !system_return ){
      (void) execute_script(chmod_script, ch_mod,
                            dir?dir:"",match[3], "");
    }
+#if defined(MIKTEX)
+   miktex_t4ht_end_image(match[1], -1, match[3], "", FALSE);
+#endif
 }
 empty_pic = empty_pic->next;
 
@@ -2679,6 +2722,9 @@ empty_pic = empty_pic->next;
 } else { 
 if( !nopict && !skip ){
    
+#if defined(MIKTEX)
+miktex_t4ht_begin_image();
+#endif
 filtered_dvigif_script = filterGifScript(dvigif_script, match[3]);
 (void) execute_script(
   filtered_dvigif_script,match[1],match[2],match[3],job_name);
@@ -2689,6 +2735,10 @@ if( dir && !bitmaps_no_dm && !system_return ){
 if( ch_mod && !bitmaps_no_dm && !system_return ){
   (void) execute_script(chmod_script, ch_mod, dir?dir:"",match[3], "");
 }
+#if defined(MIKTEX)
+miktex_t4ht_end_image(match[1], gif_i, match[3],
+                      (dir && !bitmaps_no_dm)? dir : "", !noreuse);
+#endif
 
 
 }
@@ -2719,7 +2769,11 @@ if( status ){
  }
       }
       if ( eoln_ch == EOF ){ break; }
-}  }
+}
+#if defined(MIKTEX)
+   miktex_t4ht_finish();
+#endif
+}
 
 
    
@@ -33,12 +33,18 @@
 #endif
 #include <lcdf/error.hh>
 #include <lcdf/straccum.hh>
+#include <lcdf/vector.hh>
+#include <lcdf/hashmap.hh>
 #if HAVE_FCNTL_H
 # include <fcntl.h>
 #endif
 #include <algorithm>
 #if defined(MIKTEX)
 #include <miktex/Core/c/api.h>
+#include <miktex/Core/Exceptions>
+#include <miktex/Core/Fndb>
+#include <miktex/Core/PathName>
+#include <vector>
 #endif
 
 #ifdef WIN32
@@ -70,6 +76,13 @@ static String map_file;
 #define DEFAULT_VENDOR "lcdftools"
 #define DEFAULT_TYPEFACE "unknown"
 
+// batch mode: jobs record ls-R and updmap updates in a file instead of
+// performing them; the batch driver performs them once for all jobs
+static FILE *deferred_updates = 0;
+static Vector<String> deferred_records;
+static HashMap<String, int> deferred_record_seen(-1);
+static HashMap<String, String> batch_installed_files;
+
 static const struct {
     const char *name;
     const char *envvar;
@@ -95,8 +108,10 @@ static bool writable_texdir_tried = false;
 static String writable_texdir;  // always ends with directory separator
 static int tds_1_1 = -1;
 
+#if !defined(MIKTEX)
 static bool mktexupd_tried = false;
 static String mktexupd;
+#endif
 
 static String
 kpsei_string(char* x)
@@ -277,6 +292,76 @@ file_in_kpathsea_odir(int o, const String &file)
 }
 #endif
 
+#if HAVE_KPATHSEA
+static void
+update_ls_r(const String &texdir, const Vector<String> &directories, const Vector<String> &files, ErrorHandler *errh)
+{
+#if defined(MIKTEX)
+    // MiKTeX has no ls-R: add the files to the file name database in one
+    // go (a batch calls us once for all its files)
+    std::vector<MiKTeX::Core::Fndb::Record> records;
+    for (int i = 0; i < files.size(); i++) {
+        MiKTeX::Core::PathName path(texdir.c_str());
+        if (directories[i])
+            path /= directories[i].c_str();
+        path /= files[i].c_str();
+        records.push_back({ path });
+    }
+    try {
+        MiKTeX::Core::Fndb::Add(records);
+    } catch (const MiKTeX::Core::MiKTeXException &e) {
+        errh->error("cannot update the file name database: %s", e.GetErrorMessage().c_str());
+    }
+#else
+    // try to update ls-R ourselves, rather than running mktexupd --
+    // mktexupd's runtime is painful: a half second to update a file
+    String ls_r = texdir + "ls-R";
+    bool success = false;
+    if (access(ls_r.c_str(), R_OK) >= 0) // make sure it already exists
+        if (FILE *f = fopen(ls_r.c_str(), "a")) {
+            for (int i = 0; i < files.size(); i++) {
+                if (i == 0 || directories[i] != directories[i - 1])
+                    fprintf(f, "./%s:\n", directories[i].c_str());
+                fprintf(f, "%s\n", files[i].c_str());
+            }
+            success = true;
+            fclose(f);
+        }
+
+    // otherwise, run mktexupd
+    if (success)
+        return;
+    for (int i = 0; i < files.size(); i++) {
+        const String &directory = directories[i], &file = files[i];
+        if (texdir.find_left('\'') >= 0 || directory.find_left('\'') >= 0 || file.find_left('\'') >= 0)
+            continue;
+
+        // look for mktexupd script
+        if (!mktexupd_tried) {
+            mktexupd = kpsei_string(kpsei_find_file("mktexupd", KPSEI_FMT_WEB2C));
+            mktexupd_tried = true;
+        }
+
+        // run script
+        if (mktexupd) {
+            String command = mktexupd + " " + shell_quote(texdir + directory) + " " + shell_quote(file);
+#if defined(MIKTEX)
+            int retval = miktex_system(command.c_str());
+#else
+            int retval = system(command.c_str());
+#endif
+            if (retval == 127)
+                errh->error("could not run %<%s%>", command.c_str());
+            else if (retval < 0)
+                errh->error("could not run %<%s%>: %s", command.c_str(), strerror(errno));
+            else if (retval != 0)
+                errh->error("%<%s%> failed", command.c_str());
+        }
+    }
+#endif
+}
+#endif
+
 void
 update_odir(int o, String file, ErrorHandler *errh)
 {
@@ -285,6 +370,10 @@ update_odir(int o, String file, ErrorHandler *errh)
     if (file.find_left('/') < 0)
         file = odir[o] + "/" + file;
 
+    // tell later jobs of the batch about generated fonts
+    if (deferred_updates && (o == O_TYPE1 || o == O_TYPE42))
+        fprintf(deferred_updates, "installed\t%s\n", file.c_str());
+
     // exit if this directory was not found via kpathsea, or the file is not
     // in the kpathsea directory
     if (!file_in_kpathsea_odir(o, file))
@@ -311,41 +400,10 @@ update_odir(int o, String file, ErrorHandler *errh)
     } else if (verbose)
         errh->message("updating %sls-R for %s/%s", writable_texdir.c_str(), directory.c_str(), file.c_str());
 
-    // try to update ls-R ourselves, rather than running mktexupd --
-    // mktexupd's runtime is painful: a half second to update a file
-    String ls_r = writable_texdir + "ls-R";
-    bool success = false;
-    if (access(ls_r.c_str(), R_OK) >= 0) // make sure it already exists
-        if (FILE *f = fopen(ls_r.c_str(), "a")) {
-            fprintf(f, "./%s:\n%s\n", directory.c_str(), file.c_str());
-            success = true;
-            fclose(f);
-        }
-
-    // otherwise, run mktexupd
-    if (!success && writable_texdir.find_left('\'') < 0 && directory.find_left('\'') < 0 && file.find_left('\'') < 0) {
-        // look for mktexupd script
-        if (!mktexupd_tried) {
-            mktexupd = kpsei_string(kpsei_find_file("mktexupd", KPSEI_FMT_WEB2C));
-            mktexupd_tried = true;
-        }
-
-        // run script
-        if (mktexupd) {
-            String command = mktexupd + " " + shell_quote(writable_texdir + directory) + " " + shell_quote(file);
-#if defined(MIKTEX)
-            int retval = miktex_system(command.c_str());
-#else
-            int retval = system(command.c_str());
-#endif
-            if (retval == 127)
-                errh->error("could not run %<%s%>", command.c_str());
-            else if (retval < 0)
-                errh->error("could not run %<%s%>: %s", command.c_str(), strerror(errno));
-            else if (retval != 0)
-                errh->error("%<%s%> failed", command.c_str());
-        }
-    }
+    if (deferred_updates)
+        fprintf(deferred_updates, "ls-R\t%s\t%s\t%s\n", writable_texdir.c_str(), directory.c_str(), file.c_str());
+    else
+        update_ls_r(writable_texdir, Vector<String>(1, directory), Vector<String>(1, file), errh);
 #else
     (void) file, (void) errh;
 #endif
@@ -359,6 +417,17 @@ set_map_file(const String &s)
     return !had;
 }
 
+#if HAVE_KPATHSEA
+static String
+batch_installed(const String &file, ErrorHandler *errh)
+{
+    String path = batch_installed_files[file];
+    if (path && verbose)
+        errh->message("%s generated earlier in this batch at %s", file.c_str(), path.c_str());
+    return path;
+}
+#endif
+
 String
 installed_type1(const String &otf_filename, const String &ps_fontname, bool allow_generate, ErrorHandler *errh)
 {
@@ -372,6 +441,8 @@ installed_type1(const String &otf_filename, const String &ps_fontname, bool allo
     if (!(force && allow_generate && otf_filename && otf_filename != "-" && getodir(O_TYPE1, errh))) {
 # endif
         // look for .pfb and .pfa
+        if (String path = batch_installed(ps_fontname + ".pfb", errh))
+            return path;
         String file, path;
         if ((file = ps_fontname + ".pfb", path = kpsei_string(kpsei_find_file(file.c_str(), KPSEI_FMT_TYPE1)))
             || (file = ps_fontname + ".pfa", path = kpsei_string(kpsei_find_file(file.c_str(), KPSEI_FMT_TYPE1)))) {
@@ -430,6 +501,8 @@ installed_type1_dotlessj(const String &otf_filename, const String &ps_fontname,
     if (!(force && allow_generate && getodir(O_TYPE1, errh))) {
 # endif
         // look for existing .pfb or .pfa
+        if (String path = batch_installed(j_ps_fontname + ".pfb", errh))
+            return path;
         String file, path;
         if ((file = j_ps_fontname + ".pfb", path = kpsei_string(kpsei_find_file(file.c_str(), KPSEI_FMT_TYPE1)))
             || (file = j_ps_fontname + ".pfa", path = kpsei_string(kpsei_find_file(file.c_str(), KPSEI_FMT_TYPE1)))) {
@@ -540,7 +613,9 @@ installed_type42(const String &ttf_filename, const String &ps_fontname, bool all
 # if HAVE_AUTO_TTFTOTYPE42
     if (!(force && allow_generate && ttf_filename && ttf_filename != "-" && getodir(O_TYPE42, errh))) {
 # endif
-        // look for .pfb and .pfa
+        // look for .t42
+        if (String path = batch_installed(ps_fontname + ".t42", errh))
+            return path;
         String file, path;
         if ((file = ps_fontname + ".t42", path = kpsei_string(kpsei_find_file(file.c_str(), KPSEI_FMT_TYPE42)))) {
             if (path == "./" + file || path == file) {
@@ -581,6 +656,85 @@ installed_type42(const String &ttf_filename, const String &ps_fontname, bool all
     return String();
 }
 
+#if HAVE_KPATHSEA && !WIN32
+static void
+run_updmap(unsigned flags, const String &updmap_dir, const Vector<String> &map_files, ErrorHandler *errh)
+{
+    // run 'updmap' if present
+    String updmap_prog = flags & G_UPDMAP_USER ? "updmap-user" : "updmap-sys";
+    String updmap_file;
+    if (updmap_dir
+        && (updmap_file = updmap_dir + "/" + updmap_prog)
+        && access(updmap_file.c_str(), X_OK) >= 0) {
+        // want to run `updmap` from its directory, can't use system()
+        if (verbose)
+            errh->message("running %s", updmap_file.c_str());
+
+        pid_t child = fork();
+        if (child < 0)
+            errh->fatal("%s during fork", strerror(errno));
+        else if (child == 0) {
+            // change to updmap directory, run it
+            if (chdir(updmap_dir.c_str()) < 0)
+                errh->fatal("%s: %s during chdir", updmap_dir.c_str(), strerror(errno));
+            if (execl(flags & G_UPDMAP_USER ? "./updmap-user" : "./updmap-sys",
+                      updmap_file.c_str(),
+                      (const char*) 0) < 0)
+                errh->fatal("%s: %s during exec", updmap_file.c_str(), strerror(errno));
+            exit(1);            // should never get here
+        }
+
+# if HAVE_WAITPID
+        // wait for updmap to finish
+        int status;
+        while (1) {
+            pid_t answer = waitpid(child, &status, 0);
+            if (answer >= 0)
+                break;
+            else if (errno != EINTR)
+                errh->fatal("%s during wait", strerror(errno));
+        }
+        if (!WIFEXITED(status))
+            errh->warning("%s exited abnormally", updmap_file.c_str());
+        else if (WEXITSTATUS(status) != 0)
+            errh->warning("%s exited with status %d", updmap_file.c_str(), WEXITSTATUS(status));
+# else
+#  error "need waitpid() support: report this bug to the maintainer"
+# endif
+        return;
+    }
+
+# if HAVE_AUTO_UPDMAP
+    // run system updmap: enable each map file, then rebuild the maps once
+    if (flags & G_UPDMAP) {
+        String redirect = verbose ? " 1>&2" : " >" DEV_NULL " 2>&1";
+        String command;
+        for (int i = 0; i < map_files.size(); i++) {
+            String filename = map_files[i];
+            int slash = filename.find_right('/');
+            if (slash >= 0)
+                filename = filename.substring(slash + 1);
+            command += updmap_prog + " --nomkmap --enable Map " + shell_quote(filename) + redirect + CMD_SEP " ";
+        }
+        command += updmap_prog + redirect;
+        int retval = mysystem(command.c_str(), errh);
+        if (retval == 127)
+            errh->warning("could not run %<%s%>", command.c_str());
+        else if (retval < 0)
+            errh->warning("could not run %<%s%>: %s", command.c_str(), strerror(errno));
+        else if (retval != 0)
+            errh->warning("%<%s%> exited with status %d;\nrun it manually to check for errors", command.c_str(), WEXITSTATUS(retval));
+        return;
+    }
+# else
+    (void) map_files;
+# endif
+
+    if (verbose)
+        errh->message("not running updmap");
+}
+#endif
+
 int
 update_autofont_map(const String &fontname, String mapline, ErrorHandler *errh)
 {
@@ -699,77 +853,13 @@ update_autofont_map(const String &fontname, String mapline, ErrorHandler *errh)
             update_odir(O_MAP, map_file, errh);
 
 #if HAVE_KPATHSEA && !WIN32
-        // run 'updmap' if present
-        String updmap_prog = output_flags & G_UPDMAP_USER ? "updmap-user" : "updmap-sys";
-        String updmap_dir, updmap_file;
+        String updmap_dir;
         if (automatic && (output_flags & G_UPDMAP))
             updmap_dir = getodir(O_MAP_PARENT, errh);
-        if (updmap_dir
-            && (updmap_file = updmap_dir + "/" + updmap_prog)
-            && access(updmap_file.c_str(), X_OK) >= 0) {
-            // want to run `updmap` from its directory, can't use system()
-            if (verbose)
-                errh->message("running %s", updmap_file.c_str());
-
-            pid_t child = fork();
-            if (child < 0)
-                errh->fatal("%s during fork", strerror(errno));
-            else if (child == 0) {
-                // change to updmap directory, run it
-                if (chdir(updmap_dir.c_str()) < 0)
-                    errh->fatal("%s: %s during chdir", updmap_dir.c_str(), strerror(errno));
-                if (execl(output_flags & G_UPDMAP_USER ? "./updmap-user" : "./updmap-sys",
-                          updmap_file.c_str(),
-                          (const char*) 0) < 0)
-                    errh->fatal("%s: %s during exec", updmap_file.c_str(), strerror(errno));
-                exit(1);        // should never get here
-            }
-
-# if HAVE_WAITPID
-            // wait for updmap to finish
-            int status;
-            while (1) {
-                pid_t answer = waitpid(child, &status, 0);
-                if (answer >= 0)
-                    break;
-                else if (errno != EINTR)
-                    errh->fatal("%s during wait", strerror(errno));
-            }
-            if (!WIFEXITED(status))
-                errh->warning("%s exited abnormally", updmap_file.c_str());
-            else if (WEXITSTATUS(status) != 0)
-                errh->warning("%s exited with status %d", updmap_file.c_str(), WEXITSTATUS(status));
-# else
-#  error "need waitpid() support: report this bug to the maintainer"
-# endif
-            goto ran_updmap;
-        }
-
-# if HAVE_AUTO_UPDMAP
-        // run system updmap
-        if (output_flags & G_UPDMAP) {
-            String filename = map_file;
-            int slash = filename.find_right('/');
-            if (slash >= 0)
-                filename = filename.substring(slash + 1);
-            String redirect = verbose ? " 1>&2" : " >" DEV_NULL " 2>&1";
-            String command = updmap_prog + " --nomkmap --enable Map " + shell_quote(filename) + redirect
-                + CMD_SEP " " + updmap_prog + redirect;
-            int retval = mysystem(command.c_str(), errh);
-            if (retval == 127)
-                errh->warning("could not run %<%s%>", command.c_str());
-            else if (retval < 0)
-                errh->warning("could not run %<%s%>: %s", command.c_str(), strerror(errno));
-            else if (retval != 0)
-                errh->warning("%<%s%> exited with status %d;\nrun it manually to check for errors", command.c_str(), WEXITSTATUS(retval));
-            goto ran_updmap;
-        }
-# endif
-
-        if (verbose)
-            errh->message("not running updmap");
-
-      ran_updmap: ;
+        if (deferred_updates)
+            fprintf(deferred_updates, "updmap\t%u\t%s\t%s\n", output_flags & (G_UPDMAP | G_UPDMAP_USER), updmap_dir.c_str(), map_file.c_str());
+        else
+            run_updmap(output_flags, updmap_dir, Vector<String>(1, map_file), errh);
 #endif
     }
 
@@ -804,3 +894,97 @@ locate_encoding(String encfile, ErrorHandler *errh, bool literal)
     else
         return String();
 }
+
+void
+set_deferred_updates(FILE *f)
+{
+    deferred_updates = f;
+}
+
+void
+add_deferred_updates(const String &records)
+{
+    int pos = 0;
+    while (pos < records.length()) {
+        int nl = records.find_left('\n', pos);
+        if (nl < 0)
+            nl = records.length();
+        String record = records.substring(pos, nl - pos);
+        pos = nl + 1;
+
+        if (record.substring(0, 10) == "installed\t") {
+            String path = record.substring(10);
+            batch_installed_files.insert(pathname_filename(path), path);
+        } else if (record && deferred_record_seen[record] < 0) {
+            deferred_record_seen.insert(record, deferred_records.size());
+            deferred_records.push_back(record);
+        }
+    }
+}
+
+#if HAVE_KPATHSEA
+static Vector<String>
+split_record(const String &record)
+{
+    Vector<String> fields;
+    int pos = 0, tab;
+    while ((tab = record.find_left('\t', pos)) >= 0) {
+        fields.push_back(record.substring(pos, tab - pos));
+        pos = tab + 1;
+    }
+    fields.push_back(record.substring(pos));
+    return fields;
+}
+#endif
+
+void
+run_deferred_updates(ErrorHandler *errh)
+{
+#if HAVE_KPATHSEA
+    // one ls-R update per texmf tree
+    Vector<int> done(deferred_records.size(), 0);
+    for (int i = 0; i < deferred_records.size(); i++) {
+        Vector<String> fields = split_record(deferred_records[i]);
+        if (done[i] || fields.size() != 4 || fields[0] != "ls-R")
+            continue;
+        Vector<String> directories, files;
+        for (int j = i; j < deferred_records.size(); j++) {
+            Vector<String> fj = split_record(deferred_records[j]);
+            if (!done[j] && fj.size() == 4 && fj[0] == "ls-R" && fj[1] == fields[1]) {
+                directories.push_back(fj[2]);
+                files.push_back(fj[3]);
+                done[j] = 1;
+            }
+        }
+        if (verbose)
+            errh->message("updating %sls-R for %d files", fields[1].c_str(), files.size());
+        update_ls_r(fields[1], directories, files, errh);
+    }
+
+# if !WIN32
+    // one updmap run per updmap configuration; on Windows, otftotfm never
+    // runs updmap (see update_autofont_map), so there are no such records
+    for (int i = 0; i < deferred_records.size(); i++) {
+        Vector<String> fields = split_record(deferred_records[i]);
+        if (done[i] || fields.size() != 4 || fields[0] != "updmap")
+            continue;
+        Vector<String> map_files;
+        for (int j = i; j < deferred_records.size(); j++) {
+            Vector<String> fj = split_record(deferred_records[j]);
+            if (!done[j] && fj.size() == 4 && fj[0] == "updmap"
+                && fj[1] == fields[1] && fj[2] == fields[2]) {
+                if (std::find(map_files.begin(), map_files.end(), fj[3]) == map_files.end())
+                    map_files.push_back(fj[3]);
+                done[j] = 1;
+            }
+        }
+        run_updmap(strtoul(fields[1].c_str(), 0, 10), fields[2], map_files, errh);
+    }
+# endif
+#else
+    (void) errh;
+#endif
+
+    deferred_records.clear();
+    deferred_record_seen.clear();
+}
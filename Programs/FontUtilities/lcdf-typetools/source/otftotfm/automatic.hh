@@ -1,6 +1,7 @@
 #ifndef OTFTOTFM_AUTOMATIC_HH
 #define OTFTOTFM_AUTOMATIC_HH
 #include <lcdf/string.hh>
+#include <stdio.h>
 class ErrorHandler;
 
 enum {
@@ -24,4 +25,8 @@ String installed_type42(const String &ttf_filename, const String &ps_fontname, b
 int update_autofont_map(const String &fontname, String mapline, ErrorHandler *);
 String locate_encoding(String encfile, ErrorHandler *, bool literal = false);
 
+void set_deferred_updates(FILE *);
+void add_deferred_updates(const String &records);
+void run_deferred_updates(ErrorHandler *);
+
 #endif
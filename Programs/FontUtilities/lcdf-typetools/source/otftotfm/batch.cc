@@ -0,0 +1,335 @@
+/* batch.{cc,hh} -- running several otftotfm jobs from one invocation
+ *
+ * Copyright (c) 2020 Christian Schenk
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version. This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ */
+
+#include <config.h>
+#include "batch.hh"
+#include "automatic.hh"
+#include "util.hh"
+#include <lcdf/error.hh>
+#include <lcdf/straccum.hh>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <ctype.h>
+#if HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#include <sys/stat.h>
+#include <sys/types.h>
+#if HAVE_SYS_WAIT_H
+# include <sys/wait.h>
+#endif
+
+// Jobs are separate processes: otftotfm keeps its state in globals.  If
+// fork() is available, the jobs are forked from the batch process and share
+// the tables it has read; otherwise (on Windows) they are run one after the
+// other, and --jobs has no effect.
+#if HAVE_FORK && HAVE_WAITPID && !defined(WIN32)
+# define BATCH_FORK 1
+#endif
+
+static bool
+has_prefix(const String &s, const char *prefix)
+{
+    int len = strlen(prefix);
+    return s.length() >= len && memcmp(s.data(), prefix, len) == 0;
+}
+
+bool
+parse_batch_options(int argc, char *argv[], String &batch_file, String &jobs, Vector<String> &common_args)
+{
+    bool found = false;
+    for (int i = 1; i < argc; i++) {
+        String arg = argv[i];
+        if (arg == "--") {
+            for (; i < argc; i++)
+                common_args.push_back(argv[i]);
+        } else if (arg == "--batch" && i + 1 < argc)
+            batch_file = argv[++i], found = true;
+        else if (has_prefix(arg, "--batch="))
+            batch_file = arg.substring(8), found = true;
+        else if ((arg == "-j" || arg == "--jobs") && i + 1 < argc)
+            jobs = argv[++i], found = true;
+        else if (has_prefix(arg, "--jobs="))
+            jobs = arg.substring(7), found = true;
+        else if (has_prefix(arg, "-j") && arg.length() > 2 && isdigit((unsigned char) arg[2]))
+            jobs = arg.substring(2), found = true;
+        else
+            common_args.push_back(arg);
+    }
+    return found;
+}
+
+static bool
+split_batch_line(const char *s, const char *end, Vector<String> &args, ErrorHandler *errh)
+{
+    while (1) {
+        while (s != end && isspace((unsigned char) *s))
+            ++s;
+        if (s == end)
+            return true;
+
+        StringAccum sa;
+        char quote = 0;
+        for (; s != end && (quote || !isspace((unsigned char) *s)); ++s)
+            if (*s == quote)
+                quote = 0;
+            else if (!quote && (*s == '\'' || *s == '\"'))
+                quote = *s;
+            else if (*s == '\\' && quote != '\'' && s + 1 != end)
+                sa << *++s;
+            else
+                sa << *s;
+        if (quote)
+            return errh->error("unterminated quotation"), false;
+        args.push_back(sa.take_string());
+    }
+}
+
+static bool
+is_font_file(const String &arg)
+{
+    int dot = arg.find_right('.');
+    if (dot < 0 || arg[0] == '-')
+        return false;
+    String ext = arg.substring(dot).lower();
+    struct stat st;
+    return (ext == ".otf" || ext == ".ttf" || ext == ".otc" || ext == ".ttc")
+        && stat(arg.c_str(), &st) >= 0 && S_ISREG(st.st_mode);
+}
+
+bool
+read_batch_file(const String &batch_file, const String &program, const Vector<String> &common_args, Vector<BatchJob> &jobs, ErrorHandler *errh)
+{
+    String text = read_file(batch_file, errh);
+    if (errh->nerrors())
+        return false;
+
+    LandmarkErrorHandler lerrh(errh, printable_filename(batch_file));
+    const char *s = text.begin(), *end = text.end();
+    for (int lineno = 1; s != end; lineno++) {
+        const char *eol = s;
+        while (eol != end && *eol != '\n' && *eol != '\r')
+            ++eol;
+
+        const char *first = s;
+        while (first != eol && isspace((unsigned char) *first))
+            ++first;
+        if (first != eol && *first != '#') {
+            BatchJob job;
+            job.args.push_back(program);
+            for (int i = 0; i < common_args.size(); i++)
+                job.args.push_back(common_args[i]);
+            int nargs = job.args.size();
+            lerrh.set_landmark(printable_filename(batch_file) + ":" + String(lineno));
+            if (!split_batch_line(first, eol, job.args, &lerrh))
+                return false;
+            for (int i = nargs; i < job.args.size(); i++)
+                if (is_font_file(job.args[i]))
+                    job.fonts.push_back(job.args[i]);
+            jobs.push_back(job);
+        }
+
+        s = eol;
+        if (s != end && *s == '\r')
+            ++s;
+        if (s != end && *s == '\n')
+            ++s;
+    }
+    return true;
+}
+
+
+#if BATCH_FORK
+
+namespace {
+struct RunningJob {
+    pid_t pid;
+    FILE *out;
+    FILE *err;
+    FILE *updates;
+    int status;
+    bool done;
+    RunningJob() : pid(-1), out(0), err(0), updates(0), status(0), done(false) { }
+};
+}
+
+static void
+copy_file(FILE *from, FILE *to)
+{
+    char buf[8192];
+    size_t n;
+    rewind(from);
+    while ((n = fread(buf, 1, sizeof(buf), from)) > 0)
+        ignore_result(fwrite(buf, 1, n, to));
+    fclose(from);
+}
+
+static bool
+start_job(const BatchJob &job, RunningJob &rj, batch_job_function run_job, ErrorHandler *errh)
+{
+    if (!(rj.out = tmpfile()) || !(rj.err = tmpfile()) || !(rj.updates = tmpfile())) {
+        errh->error("temporary file: %s", strerror(errno));
+        return false;
+    }
+
+    fflush(stdout);
+    fflush(stderr);
+    rj.pid = fork();
+    if (rj.pid < 0) {
+        errh->error("%s during fork", strerror(errno));
+        return false;
+    } else if (rj.pid > 0)
+        return true;
+
+    // child: run the job, capturing its output
+    dup2(fileno(rj.out), STDOUT_FILENO);
+    dup2(fileno(rj.err), STDERR_FILENO);
+    set_deferred_updates(rj.updates);
+    Vector<String> args(job.args);
+    Vector<char *> argv;
+    for (int i = 0; i < args.size(); i++)
+        argv.push_back(args[i].mutable_c_str());
+    argv.push_back(0);
+    int status;
+#if defined(MIKTEX)
+    try {
+        status = run_job(args.size(), argv.begin());
+    } catch (int x) {
+        status = x;
+    }
+#else
+    status = run_job(args.size(), argv.begin());
+#endif
+    fflush(stdout);
+    fflush(stderr);
+    fflush(rj.updates);
+    _exit(status);
+}
+
+static int
+finish_job(RunningJob &rj)
+{
+    if (rj.out)
+        copy_file(rj.out, stdout);
+    if (rj.err)
+        copy_file(rj.err, stderr);
+    if (rj.updates) {
+        StringAccum sa;
+        char buf[8192];
+        size_t n;
+        rewind(rj.updates);
+        while ((n = fread(buf, 1, sizeof(buf), rj.updates)) > 0)
+            sa.append(buf, n);
+        fclose(rj.updates);
+        add_deferred_updates(sa.take_string());
+    }
+    fflush(stdout);
+    return rj.status;
+}
+
+// A job waits for the earlier jobs on the same font: these may generate
+// files for the font, which the job can reuse once they have finished.
+static bool
+font_busy(const Vector<BatchJob> &jobs, int first, int j)
+{
+    for (int i = first; i < j; i++)
+        for (int a = 0; a < jobs[i].fonts.size(); a++)
+            for (int b = 0; b < jobs[j].fonts.size(); b++)
+                if (same_filename(jobs[i].fonts[a], jobs[j].fonts[b]))
+                    return true;
+    return false;
+}
+
+int
+run_batch(const Vector<BatchJob> &jobs, int max_jobs, batch_job_function run_job, ErrorHandler *errh)
+{
+    Vector<RunningJob> rj(jobs.size(), RunningJob());
+    int next = 0, flushed = 0, running = 0, failed = 0;
+
+    while (flushed < jobs.size()) {
+        while (next < jobs.size() && running < max_jobs
+               && !font_busy(jobs, flushed, next)) {
+            if (start_job(jobs[next], rj[next], run_job, errh))
+                running++;
+            else
+                rj[next].done = true, rj[next].status = 1;
+            next++;
+        }
+
+        // report finished jobs in order
+        if (rj[flushed].done) {
+            if (finish_job(rj[flushed]) != 0)
+                failed++;
+            flushed++;
+            continue;
+        }
+
+        int status;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0) {
+            if (errno == EINTR)
+                continue;
+            errh->fatal("%s during wait", strerror(errno));
+        }
+        for (int i = flushed; i < next; i++)
+            if (rj[i].pid == pid && !rj[i].done) {
+                rj[i].done = true;
+                rj[i].status = WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+                running--;
+            }
+    }
+
+    return failed;
+}
+
+#else  // !BATCH_FORK
+
+int
+run_batch(const Vector<BatchJob> &jobs, int max_jobs, batch_job_function run_job, ErrorHandler *errh)
+{
+    (void) run_job;
+
+    if (max_jobs > 1)
+        errh->warning("%<--jobs%> is not supported on this platform, running one job at a time");
+
+    // all jobs append to one update file; each job learns about the fonts
+    // generated by the jobs before it from that file
+    String updates_file;
+    int fd = temporary_file(updates_file, errh);
+    if (fd < 0)
+        return jobs.size();
+    close(fd);
+
+    int failed = 0;
+    for (int i = 0; i < jobs.size(); i++) {
+        StringAccum sa;
+        for (int a = 0; a < jobs[i].args.size(); a++)
+            sa << shell_quote(jobs[i].args[a]) << ' ';
+        sa << "--deferred-updates=" << shell_quote(updates_file);
+        int retval = mysystem(sa.c_str(), errh);
+        if (retval == 127)
+            errh->error("could not run %<%s%>", sa.c_str());
+        else if (retval < 0)
+            errh->error("could not run %<%s%>: %s", sa.c_str(), strerror(errno));
+        if (retval != 0)
+            failed++;
+    }
+
+    add_deferred_updates(read_file(updates_file, errh, true));
+    unlink(updates_file.c_str());
+    return failed;
+}
+
+#endif
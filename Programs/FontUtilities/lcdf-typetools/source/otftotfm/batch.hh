@@ -0,0 +1,18 @@
+#ifndef OTFTOTFM_BATCH_HH
+#define OTFTOTFM_BATCH_HH
+#include <lcdf/string.hh>
+#include <lcdf/vector.hh>
+class ErrorHandler;
+
+struct BatchJob {
+    Vector<String> args;        // argv, including the program name
+    Vector<String> fonts;       // font files read by the job
+};
+
+typedef int (*batch_job_function)(int argc, char *argv[]);
+
+bool parse_batch_options(int argc, char *argv[], String &batch_file, String &jobs, Vector<String> &common_args);
+bool read_batch_file(const String &batch_file, const String &program, const Vector<String> &common_args, Vector<BatchJob> &jobs, ErrorHandler *);
+int run_batch(const Vector<BatchJob> &jobs, int max_jobs, batch_job_function, ErrorHandler *);
+
+#endif
@@ -33,6 +33,7 @@
 #include "metrics.hh"
 #include "dvipsencoding.hh"
 #include "automatic.hh"
+#include "batch.hh"
 #include "secondary.hh"
 #include "kpseinterface.h"
 #include "util.hh"
@@ -77,6 +78,8 @@ using namespace Efont;
 #define QUERY_SCRIPTS_OPT       303
 #define QUERY_FEATURES_OPT      304
 #define KPATHSEA_DEBUG_OPT      305
+#define BATCH_OPT               306
+#define JOBS_OPT                307
 
 #define SCRIPT_OPT              311
 #define FEATURE_OPT             312
@@ -123,6 +126,7 @@ using namespace Efont;
 #define NOCREATE_OPT            356
 #define VERBOSE_OPT             357
 #define FORCE_OPT               358
+#define DEFERRED_UPDATES_OPT    359
 
 #define VIRTUAL_OPT             360
 #define PL_OPT                  361
@@ -235,6 +239,9 @@ static Clp_Option options[] = {
     { "force", 0, FORCE_OPT, 0, Clp_Negate },
     { "verbose", 'V', VERBOSE_OPT, 0, Clp_Negate },
     { "kpathsea-debug", 0, KPATHSEA_DEBUG_OPT, Clp_ValInt, 0 },
+    { "batch", 0, BATCH_OPT, Clp_ValString, 0 },
+    { "jobs", 'j', JOBS_OPT, Clp_ValInt, 0 },
+    { "deferred-updates", 0, DEFERRED_UPDATES_OPT, Clp_ValString, 0 },
 
     { "help", 'h', HELP_OPT, 0, 0 },
     { "version", 0, VERSION_OPT, 0, 0 },
@@ -408,7 +415,11 @@ Other options:\n\
       --glyphlist=FILE         Use FILE to map Adobe glyph names to Unicode.\n\
   -V, --verbose                Print progress information to standard error.\n\
       --no-create              Print messages, don't modify any files.\n\
-      --force                  Generate files even if versions already exist.\n"
+      --force                  Generate files even if versions already exist.\n\
+      --batch=FILE             Run the otftotfm argument lists in FILE, one\n\
+                               per line; ls-R and updmap are updated once.\n\
+  -j, --jobs=N                 Run up to N batch jobs at a time [1]; needs\n\
+                               fork(), else jobs run one at a time.\n"
 #if HAVE_KPATHSEA
 "      --kpathsea-debug=MASK    Set path searching debug flags to MASK.\n"
 #endif
@@ -1848,12 +1859,32 @@ parse_base_encodings(const String &filename, ErrorHandler *errh)
     }
 }
 
-int
-#if defined(MIKTEX)
-Main(int argc, char** argv)
-#else
-main(int argc, char *argv[])
+static bool default_glyphlists_loaded = false;
+
+static void
+find_default_glyphlists(Vector<String> &glyphlist_files, ErrorHandler *errh)
+{
+    (void) errh;
+#if HAVE_KPATHSEA
+    if (String g = kpsei_find_file("glyphlist.txt", KPSEI_FMT_MAP)) {
+        glyphlist_files.push_back(g);
+        if (verbose)
+            errh->message("glyphlist.txt found with kpathsea at %s", g.c_str());
+    } else
+#endif
+        glyphlist_files.push_back(GLYPHLISTDIR "/glyphlist.txt");
+#if HAVE_KPATHSEA
+    if (String g = kpsei_find_file("texglyphlist.txt", KPSEI_FMT_MAP)) {
+        glyphlist_files.push_back(g);
+        if (verbose)
+            errh->message("texglyphlist.txt found with kpathsea at %s", g.c_str());
+    } else
 #endif
+        glyphlist_files.push_back(GLYPHLISTDIR "/texglyphlist.txt");
+}
+
+static int
+run_job(int argc, char *argv[])
 {
 #ifndef WIN32
     handle_sigchld();
@@ -1873,7 +1904,8 @@ main(int argc, char *argv[])
     }
 #endif
     for (int i = 0; i < argc; i++)
-        invocation << (i ? " " : "") << argv[i];
+        if (strncmp(argv[i], "--deferred-updates=", 19) != 0)
+            invocation << (i ? " " : "") << argv[i];
 
     ErrorHandler *errh = ErrorHandler::static_initialize(new FileErrorHandler(stderr, String(program_name) + ": "));
     const char *input_file = 0;
@@ -2251,6 +2283,20 @@ main(int argc, char *argv[])
             force = !clp->negated;
             break;
 
+          case BATCH_OPT:
+          case JOBS_OPT:
+            usage_error(errh, "%<--batch%> and %<--jobs%> must be spelled out on the command line");
+            break;
+
+          case DEFERRED_UPDATES_OPT:
+            // the batch driver records the updates of all jobs in one file
+            add_deferred_updates(read_file(clp->vstr, ErrorHandler::silent_handler()));
+            if (FILE *f = fopen(clp->vstr, "a"))
+                set_deferred_updates(f);
+            else
+                errh->fatal("%s: %s", clp->vstr, strerror(errno));
+            break;
+
           case KPATHSEA_DEBUG_OPT:
 #if HAVE_KPATHSEA
             kpsei_set_debug_flags(clp->val.u);
@@ -2371,24 +2417,8 @@ particular purpose.\n");
         std::sort(altselector_features.begin(), altselector_features.end());
 
         // find glyphlist
-        if (!glyphlist_files.size()) {
-#if HAVE_KPATHSEA
-            if (String g = kpsei_find_file("glyphlist.txt", KPSEI_FMT_MAP)) {
-                glyphlist_files.push_back(g);
-                if (verbose)
-                    errh->message("glyphlist.txt found with kpathsea at %s", g.c_str());
-            } else
-#endif
-                glyphlist_files.push_back(GLYPHLISTDIR "/glyphlist.txt");
-#if HAVE_KPATHSEA
-            if (String g = kpsei_find_file("texglyphlist.txt", KPSEI_FMT_MAP)) {
-                glyphlist_files.push_back(g);
-                if (verbose)
-                    errh->message("texglyphlist.txt found with kpathsea at %s", g.c_str());
-            } else
-#endif
-                glyphlist_files.push_back(GLYPHLISTDIR "/texglyphlist.txt");
-        }
+        if (!glyphlist_files.size() && !default_glyphlists_loaded)
+            find_default_glyphlists(glyphlist_files, errh);
 
         // read glyphlist
         for (String *g = glyphlist_files.begin(); g < glyphlist_files.end(); g++)
@@ -2458,3 +2488,67 @@ particular purpose.\n");
     Clp_DeleteParser(clp);
     return (errh->nerrors() == 0 ? 0 : 1);
 }
+
+static int
+run_batch_file(char *argv0, const String &batch_file, const String &jobs_arg, const Vector<String> &common_args)
+{
+    static String batch_program_name = pathname_filename(argv0);
+    program_name = batch_program_name.c_str();
+#if HAVE_KPATHSEA
+    kpsei_init(argv0, "lcdftools");
+#endif
+    ErrorHandler *errh = ErrorHandler::static_initialize(new FileErrorHandler(stderr, String(program_name) + ": "));
+
+    int max_jobs = 1;
+    if (jobs_arg) {
+        char *ends;
+        max_jobs = strtol(jobs_arg.c_str(), &ends, 10);
+        if (*ends || max_jobs < 1)
+            usage_error(errh, "%<--jobs%> takes a positive integer");
+    }
+    if (!batch_file)
+        usage_error(errh, "%<--jobs%> requires %<--batch%>");
+
+    Vector<BatchJob> jobs;
+    if (!read_batch_file(batch_file, argv0, common_args, jobs, errh))
+        return 1;
+
+    // read the tables the jobs share once: the font files, and the default
+    // glyphlists unless a job names its own
+    bool own_glyphlists = false;
+    for (int i = 0; i < jobs.size(); i++) {
+        for (int j = 0; j < jobs[i].fonts.size(); j++)
+            preload_file(jobs[i].fonts[j], errh);
+        for (int j = 1; j < jobs[i].args.size(); j++)
+            if (jobs[i].args[j].substring(0, 4) == "--gl")
+                own_glyphlists = true;
+    }
+    if (!own_glyphlists) {
+        Vector<String> glyphlist_files;
+        find_default_glyphlists(glyphlist_files, errh);
+        for (String *g = glyphlist_files.begin(); g < glyphlist_files.end(); g++)
+            if (String s = read_file(*g, errh, true))
+                DvipsEncoding::add_glyphlist(s);
+        default_glyphlists_loaded = true;
+    }
+
+    int failed = run_batch(jobs, max_jobs, run_job, errh);
+    run_deferred_updates(errh);
+    if (failed)
+        errh->error("%d of %d jobs failed", failed, jobs.size());
+    return (failed || errh->nerrors() ? 1 : 0);
+}
+
+int
+#if defined(MIKTEX)
+Main(int argc, char** argv)
+#else
+main(int argc, char *argv[])
+#endif
+{
+    String batch_file, jobs_arg;
+    Vector<String> common_args;
+    if (parse_batch_options(argc, argv, batch_file, jobs_arg, common_args))
+        return run_batch_file(argv[0], batch_file, jobs_arg, common_args);
+    return run_job(argc, argv);
+}
@@ -18,6 +18,7 @@
 #include <lcdf/error.hh>
 #include <lcdf/straccum.hh>
 #include <lcdf/vector.hh>
+#include <lcdf/hashmap.hh>
 #include <ctype.h>
 #include <stdio.h>
 #include <errno.h>
@@ -35,9 +36,23 @@
 #include <miktex/Core/c/api.h>
 #endif
 
+// batch mode: files shared by several jobs are read once
+static HashMap<String, String> preloaded_files;
+
+void
+preload_file(const String &filename, ErrorHandler *errh)
+{
+    if (filename && filename != "-" && !preloaded_files[filename])
+        if (String s = read_file(filename, errh, true))
+            preloaded_files.insert(filename, s);
+}
+
 String
 read_file(String filename, ErrorHandler *errh, bool warning)
 {
+    if (String s = preloaded_files[filename])
+        return s;
+
     FILE *f;
     if (!filename || filename == "-") {
         filename = "<stdin>";
@@ -16,6 +16,7 @@ enum { G_ENCODING = 1, G_METRICS = 2, G_VMETRICS = 4, G_TYPE1 = 8,
 extern unsigned output_flags;
 
 String read_file(String filename, ErrorHandler *, bool warn = false);
+void preload_file(const String &filename, ErrorHandler *);
 String printable_filename(const String &);
 String pathname_filename(const String &);
 bool same_filename(const String &a, const String &b);
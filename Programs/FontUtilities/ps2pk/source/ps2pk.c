@@ -111,6 +111,12 @@
  *       -e<encoding>   The encoding scheme (default the encoding from the 
  *                      AFM file is used).
  *	 -E<extension>	The extension factor (real value, default 1.0).
+ *	 -M<mag>[,<mag>...]
+ *			Magnifications (real values) of <baseres> at
+ *			which the font is to be rendered. One PK font
+ *			is written for each of them; the type1 font and
+ *			the AFM file are read only once. -M can not be
+ *			combined with -X or -Y.
  *	 -O		Create old checksums (for compatibility)
  *	 -P<pointsize>	The desired pointsize (real value, default 10.0
  *			points). PK fonts created with a value different
@@ -121,10 +127,17 @@
  *			identification strings in PK postamble.
  *	 -S<slant>	The slant (real value, default 0.0).
  *	 -X<xres>	The resolution (integer value) in the X direction 
- *			(default 300 dpi).
+ *			(default 300 dpi). A comma separated list of
+ *			resolutions renders the font at each of them,
+ *			writing one PK font per resolution.
  *	 -Y<yres>	The resolution (integer value) in the Y direction 
  *			(defaults to the value of <xres>).
  *	 -d		Debug stat() calls during recursive path searching
+ *	 -j<jobs>	The number of resolutions rendered concurrently
+ *			(default 1). Each one is rendered by a process
+ *			forked after the font has been read, because the
+ *			type1 rasterizer keeps its state in globals. Not
+ *			available on systems without fork().
  *	 -v		Verbose flag. (Tells what the program is doing.)
  *	
  *	 type1font	The name of the PostScript type 1 font. When no
@@ -139,6 +152,8 @@
  *			   ps2pk -P17.28 Utopia-Regular
  *			will result in:
  *				Utopia-Regular17.300pk
+ *			[pkname] can not be given together with more than
+ *			one resolution.
  *
  * ENVIRONMENTS
  *
@@ -180,6 +195,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 /* PostScript Resource lookup functions */
 /* 
 #include "PSres.h"	
@@ -199,6 +215,16 @@
 #include "util.h"
 #include "fontfcn.h"
 
+/* Several resolutions are rendered in parallel by forked processes: the
+   type1 rasterizer keeps its state in globals. */
+#if defined(HAVE_FORK) && defined(HAVE_WAITPID) && defined(HAVE_SYS_WAIT_H) \
+    && !defined(_WIN32)
+#define PARALLEL_SIZES
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 FontScalableRec vals;
 FontEntryRec entry;
 #define Succesful	85
@@ -218,8 +244,25 @@ int W, H,	        /* width and height of character glyph */
     x_resolution = 0, 
     y_resolution = 0;
 
+#define MAXSIZES 64
+
+int xres_list[MAXSIZES],	/* resolutions given via -X or -M */
+    yres_list[MAXSIZES],
+    nsizes = 0,
+    jobs = 1;			/* resolutions rendered concurrently */
+double mag_list[MAXSIZES];	/* magnifications given via -M */
+int nmags = 0;
+
+/* The font, read once for all resolutions */
+char *psfile = NULL, *psfilebn, *psbasename, *encodingscheme = NULL;
+encoding ev;
+int WX[256];
+float efactor = 1.0, slant = 0.0;
+
 int verbose = 0, debug = 0;
 
+static float HXU = -1.0; /* horizontal pixels per design unit */
+
 /* Provide old (-O flag) and new (default) checksum function */
 static uint32_t checksum(encoding, int [256]);
 static uint32_t old_checksum(encoding, int [256]);
@@ -234,28 +277,19 @@ static void first_pixel(CharInfoRec *);
 static int32_t TFMwidth(int);
 static int h_escapement(int);
 static void add_option(const char *, const char *);
+static void size_options(char *, int, int);
+static void make_pk(char *, char *);
+static void make_size(int, int, char *);
 
 int main(int argc, char *argv[])
 {
    char c;
    int done, i;
    const char *myname = "ps2pk";
-   char *psname, *psbasename, *afmname = NULL,
-	*encname = NULL, *psfile = NULL, *psfilebn, pkname[80],
-	*AFM_fontname = NULL,
-	*encodingscheme = NULL;
-
-   FontPtr fontptr;
-   unsigned char glyphcode[1]; /* must be an array */
-   CharInfoRec *glyphs[1];
-   unsigned int count;
-   int charcode, rc = -1, charno;
-   char comment[256];
-   long cs;
-   encoding ev;
-   int WX[256];
-
-   float efactor = 1.0, slant = 0.0;
+   char *psname, *afmname = NULL,
+	*encname = NULL, *pkname = NULL,
+	*AFM_fontname = NULL, *p;
+   int rc = -1, failed = 0;
 
 #ifdef KPATHSEA
    kpse_set_program_name(argv[0], "ps2pk");
@@ -291,6 +325,25 @@ int main(int argc, char *argv[])
 	    add_option("-E", argv[0]);
 	    done = 1;
       	    break;
+      	 case 'j':
+      	    if (*++argv[0] == '\0') {
+      	       argc--; argv++;
+      	    }
+	    jobs = atoi(argv[0]);
+	    if (jobs < 1) jobs = 1;
+	    done = 1;
+      	    break;
+      	 case 'M':
+      	    if (*++argv[0] == '\0') {
+      	       argc--; argv++;
+      	    }
+	    for (p = strtok(argv[0], ","); p; p = strtok(NULL, ",")) {
+	       if (nmags == MAXSIZES)
+		  fatal("%s: more than %d magnifications\n", myname, MAXSIZES);
+	       mag_list[nmags++] = atof(p);
+	    }
+	    done = 1;
+      	    break;
       	 case 'O':
       	    pchecksum = old_checksum;
 	    add_option("-O", "");
@@ -323,9 +376,20 @@ int main(int argc, char *argv[])
       	    if (*++argv[0] == '\0') {
       	       argc--; argv++;
       	    }
-	    x_resolution = atoi(argv[0]); done = 1;
+	    if (strchr(argv[0], ',') == NULL) {
+	       x_resolution = atoi(argv[0]);
+	       add_option("-X", argv[0]);
+	    }
+	    else {
+	       for (p = strtok(argv[0], ","); p; p = strtok(NULL, ",")) {
+		  if (nsizes == MAXSIZES)
+		     fatal("%s: more than %d resolutions\n", myname, MAXSIZES);
+		  xres_list[nsizes++] = atoi(p);
+	       }
+	       x_resolution = xres_list[0];
+	    }
+	    done = 1;
 	    if (y_resolution == 0) y_resolution = x_resolution;
-	    add_option("-X", argv[0]);
       	    break;
       	 case 'Y':
       	    if (*++argv[0] == '\0') {
@@ -346,9 +410,20 @@ int main(int argc, char *argv[])
    if (argc < 1 || argc >2) {
       msg  ("ps2pk version " PACKAGE_VERSION " (1992-2016)\n");
       msg  ("Usage: %s [options] type1font [pkname]\n", myname);
-      msg  ("options: -d -v -e<enc> -X<xres> -E<expansion> -S<slant>\n");
-      fatal("options: -O -P<pointsize> -Y<yres> -a<AFM> -R<baseres>\n");
+      msg  ("options: -d -v -e<enc> -X<xres>[,<xres>...] -E<expansion> -S<slant>\n");
+      msg  ("options: -O -P<pointsize> -Y<yres> -a<AFM> -R<baseres>\n");
+      fatal("options: -M<mag>[,<mag>...] -j<jobs>\n");
+   }
+
+   if (nmags > 0) {
+      if (x_resolution != 0 || y_resolution != 0)
+	 fatal("%s: -M can not be combined with -X or -Y\n", myname);
+      for (i = 0; i < nmags; i++)
+	 xres_list[i] = base_resolution * mag_list[i] + 0.5;
+      nsizes = nmags;
    }
+   if (nsizes > 1 && argc == 2)
+      fatal("%s: no pkname can be given for several resolutions\n", myname);
 
    psname = argv[0]; argc--; argv++;
 
@@ -464,6 +539,13 @@ int main(int argc, char *argv[])
    psfilebn = basename(psfile, NULL);
 
    if (pointsize == 0.0) pointsize = DEFAULTPOINTSIZE;
+   if (nsizes > 0) {
+      /* keep the aspect ratio of -X and -Y for all resolutions */
+      if (nmags > 0) x_resolution = y_resolution = xres_list[0];
+      for (i = 0; i < nsizes; i++)
+	 yres_list[i] = y_resolution == x_resolution ? xres_list[i] :
+	    xres_list[i] * (double) y_resolution / x_resolution + 0.5;
+   }
    if (x_resolution == 0) x_resolution = DEFAULTRES;
    if (y_resolution == 0) y_resolution = x_resolution;
    if (verbose)
@@ -477,21 +559,96 @@ int main(int argc, char *argv[])
       }
    if (verbose) msg(" done\n");
    
-   if (argc == 1) strcpy(pkname,  argv[0]);
-   else 
-      sprintf(pkname, "%s%d.%dpk", psbasename,
-         (int) (pointsize + 0.5), x_resolution);
+   if (argc == 1) pkname = argv[0];
     
+   if (verbose) msg("Checking type1 font %s ...", psfilebn);
+   Type1RegisterFontFileFunctions();
+   if (verbose) msg(" done\n");
+
+   if (nsizes == 0) {
+      /* a single resolution, given as before */
+      make_size(x_resolution, y_resolution, pkname);
+      exit(0);
+   }
+
+   /* Read the font once; the rasterizer keeps it for the next sizes. */
+   if (verbose) msg("Loading type1 font %s ...", psfilebn);
+   if (!fontfcnA(psfile, &rc))
+      fatal("Can not load %s (result: %d)\n", psfile, rc);
+   if (verbose) msg(" done\n");
+
+#ifdef PARALLEL_SIZES
+   if (jobs > 1 && nsizes > 1) {
+      int running = 0, next = 0, status;
+      pid_t pid;
+
+      while (next < nsizes || running > 0) {
+	 if (next < nsizes && running < jobs) {
+	    fflush(stdout); fflush(stderr);
+	    pid = fork();
+	    if (pid < 0)
+	       fatal("%s: fork failed: %s\n", myname, strerror(errno));
+	    if (pid == 0) {
+	       make_size(xres_list[next], yres_list[next], pkname);
+	       fflush(stdout); fflush(stderr);
+	       _exit(0);
+	    }
+	    running++; next++;
+	    continue;
+	 }
+	 pid = waitpid(-1, &status, 0);
+	 if (pid < 0) {
+	    if (errno == EINTR) continue;
+	    fatal("%s: wait failed: %s\n", myname, strerror(errno));
+	 }
+	 running--;
+	 if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) failed++;
+      }
+   }
+   else
+#endif
+   for (i = 0; i < nsizes; i++)
+      make_size(xres_list[i], yres_list[i], pkname);
+   exit(failed ? 1 : 0);
+}
+
+/* Create the PK font for one resolution; <pkname> may be NULL */
+static void
+make_size(int xres, int yres, char *pkname)
+{
+   char name[MAXPATHLEN], args[MAXSTRLEN + 32];
+
+   if (pkname == NULL) {
+      sprintf(name, "%s%d.%dpk", psbasename, (int) (pointsize + 0.5), xres);
+      pkname = name;
+   }
+   if (nsizes == 0)
+      strcpy(args, ps2pk_args);
+   else
+      size_options(args, xres, yres);
+   x_resolution = xres;
+   y_resolution = yres;
+   make_pk(pkname, args);
+}
+
+static void
+make_pk(char *pkname, char *args)
+{
+   FontPtr fontptr;
+   unsigned char glyphcode[1]; /* must be an array */
+   CharInfoRec *glyphs[1];
+   unsigned int count;
+   int charcode, rc = -1, charno;
+   char comment[256];
+   long cs;
+
    /* next values are needed! */
    vals.x =     x_resolution;
    vals.y =     y_resolution;
    vals.point = 10.0 * pointsize + 0.5; /* DECIPOINTS */
    vals.pixel = pointsize * y_resolution / POINTSPERINCH + 0.5;
+   HXU = -1.0;
    
-   if (verbose) msg("Checking type1 font %s ...", psfilebn);
-   Type1RegisterFontFileFunctions();
-   if (verbose) msg(" done\n");
-
 	/* next line prevents UNIX core dumps */
    entry.name.name = "-adobe-utopia-medium-r-normal--0-0-0-0-p-0-iso8859-1";
    if (verbose)
@@ -532,9 +689,9 @@ int main(int argc, char *argv[])
    if (debug) msg("%c", '\n');
    ps2pk_postamble(psbasename, encodingscheme,
               base_resolution, x_resolution, y_resolution, pointsize,
-	      ps2pk_args);
+	      args);
    pk_close();
-   exit(0);
+   (fontptr->unload_font)(fontptr);
 }
 
 /*
@@ -636,8 +793,6 @@ TFMwidth(int wx)
            (((wx % 1000) << 20) + 500) / 1000) ;
 }
 
-static float HXU = -1.0; /* horizontal pixels per design unit */
-
 /* the horizontal escapent is the number of pixels to next origin */
 static int
 h_escapement(int wx)
@@ -662,6 +817,26 @@ add_option(const char *option, const char *value)
    p_args+= strlen(p_args);
 }
 
+/* The essential ps2pk arguments for one of several resolutions: those
+   given, with the resolution options replaced */
+static void
+size_options(char *args, int xres, int yres)
+{
+   char *p = args, *opt, copy[MAXSTRLEN];
+
+   *p = '\0';
+   if (strcmp(ps2pk_args, "none") != 0) {
+      strcpy(copy, ps2pk_args);
+      for (opt = strtok(copy, " "); opt; opt = strtok(NULL, " ")) {
+	 if (opt[0] == '-' && (opt[1] == 'X' || opt[1] == 'Y')) continue;
+	 sprintf(p, "%s ", opt);
+	 p += strlen(p);
+      }
+   }
+   if (xres == yres) sprintf(p, "-X%d", xres);
+   else sprintf(p, "-X%d -Y%d", xres, yres);
+}
+
 /* Next stuff is needed by type1 rendering functions */
 
 int CheckFSFormat(int format, int fmask, int *bit, int *Byte, int *scan,
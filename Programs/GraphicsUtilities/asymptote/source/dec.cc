@@ -820,6 +820,7 @@ void includedec::loadFailed(coenv &)
 
 void includedec::transAsField(coenv &e, record *r)
 {
+  e.e.noteInclude(filename);
   file *ast = parser::parseFile(filename,"Including");
   em.sync();
 
@@ -214,4 +214,9 @@ record *env::getModule(symbol id, string filename)
   return ge.getModule(id, filename);
 }
 
+void env::noteInclude(string filename)
+{
+  ge.noteInclude(filename);
+}
+
 }
@@ -180,6 +180,8 @@ public:
   ~env();
 
   record *getModule(symbol id, string filename);
+
+  void noteInclude(string filename);
 };
 
 } // namespace trans
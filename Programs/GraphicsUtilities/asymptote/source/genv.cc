@@ -11,11 +11,25 @@
  * builtin functions, casts and operators, and imports plain (if set),
  * but all other initialization is done by the local environment defined
  * in env.h.
+ *
+ * A new genv is created for every file processed, but translated modules
+ * are kept for the lifetime of the process: a later genv reuses a module
+ * as long as its source, the files it includes, and the modules it imports
+ * are unchanged.  Only translation is shared; every run initializes the
+ * modules afresh.  The cache is in memory only (translated records point
+ * into types, builtins and other modules and cannot be written out), so it
+ * helps when one asy process handles several files, as with `asy *.asy' or
+ * in interactive mode, but not across separate asy invocations.
  *****/
 
 #include <sstream>
+#include <fstream>
 #include <unistd.h>
 #include <algorithm>
+#if defined(MIKTEX_WINDOWS)
+#include <miktex/Util/CharBuffer>
+#define UW_(x) MiKTeX::Util::CharBuffer<wchar_t>(x).GetData()
+#endif
 
 #include "genv.h"
 #include "env.h"
@@ -38,6 +52,89 @@ types::record *transExternalModule(trans::genv& ge, string filename, symbol id);
 
 namespace trans {
 
+struct moduleImport {
+  symbol id;
+  string filename;
+  record *r;
+
+  moduleImport(symbol id, string filename, record *r)
+    : id(id), filename(filename), r(r) {}
+};
+
+struct moduleInclude {
+  string filename;
+  string digest;
+
+  moduleInclude(string filename, string digest)
+    : filename(filename), digest(digest) {}
+};
+
+struct cachedModule : public gc {
+  string digest;
+  record *r;
+
+  // The modules imported, in order, with the records they were translated
+  // against.
+  mem::vector<moduleImport> imports;
+  mem::vector<moduleInclude> includes;
+
+  cachedModule(string digest)
+    : digest(digest), r(0) {}
+};
+
+namespace {
+
+// Translated modules, indexed by filename and autoplain setting; in memory
+// only, for the lifetime of the process.
+typedef mem::map<CONST string,cachedModule *> moduleCache;
+
+moduleCache& theModuleCache()
+{
+  static moduleCache *cache=new moduleCache;
+  return *cache;
+}
+
+string cacheKey(string filename)
+{
+  return filename+(getSetting<bool>("autoplain") ? "" : "\n-noautoplain");
+}
+
+// Returns a digest of the located source file, or the empty string if the
+// source cannot be cached.
+string sourceDigest(string filename)
+{
+  if(filename == "-" || parser::isURL(filename))
+    return "";
+
+  string file=settings::locateFile(filename);
+  if(file.empty())
+    return "";
+
+#if defined(MIKTEX_WINDOWS)
+  std::ifstream in(UW_(file), std::ios::binary);
+#else
+  std::ifstream in(file.c_str(), std::ios::binary);
+#endif
+  if(!in)
+    return "";
+
+  // FNV-1a
+  unsigned long long hash=14695981039346656037ULL;
+  char buf[8192];
+  while(in.read(buf,sizeof(buf)) || in.gcount() > 0) {
+    for(std::streamsize i=0; i < in.gcount(); ++i) {
+      hash ^= (unsigned char) buf[i];
+      hash *= 1099511628211ULL;
+    }
+  }
+
+  ostringstream digest;
+  digest << file << ":" << std::hex << hash;
+  return digest.str();
+}
+
+} // private namespace
+
 genv::genv()
   : imap()
 {
@@ -72,6 +169,14 @@ record *genv::loadModule(symbol id, string filename) {
   }
 #endif
 
+  string digest=sourceDigest(filename);
+  if(!digest.empty())
+    if(record *r=reuseModule(id, filename, digest))
+      return r;
+
+  cachedModule *m=new cachedModule(digest);
+  loading.push_front(m);
+
   // Get the abstract syntax tree.
   absyntax::file *ast = parser::parseFile(filename,"Loading");
 
@@ -82,10 +187,53 @@ record *genv::loadModule(symbol id, string filename) {
   record *r=ast->transAsFile(*this, id);
 
   inTranslation.remove(filename);
+  loading.pop_front();
+
+  if(!digest.empty() && !em.errors()) {
+    m->r=r;
+    theModuleCache()[cacheKey(filename)]=m;
+  }
 
   return r;
 }
 
+record *genv::reuseModule(symbol id, string filename, string digest) {
+  moduleCache& cache=theModuleCache();
+  moduleCache::iterator p=cache.find(cacheKey(filename));
+  if(p == cache.end() || p->second->digest != digest)
+    return 0;
+  cachedModule *m=p->second;
+
+  for(size_t i=0; i < m->includes.size(); ++i)
+    if(sourceDigest(m->includes[i].filename) != m->includes[i].digest)
+      return 0;
+
+  // The imports must resolve to the very records the module was translated
+  // against; loading them here also keeps the import order.
+  loading.push_front(0);
+  inTranslation.push_front(filename);
+  bool valid=true;
+  for(size_t i=0; valid && i < m->imports.size(); ++i) {
+    moduleImport& imp=m->imports[i];
+    valid=getModule(imp.id, imp.filename) == imp.r;
+  }
+  inTranslation.remove(filename);
+  loading.pop_front();
+
+  if(!valid)
+    return 0;
+
+  if(settings::verbose > 1)
+    cerr << "Reusing " << filename << endl;
+  return m->r;
+}
+
+void genv::noteInclude(string filename) {
+  if(!loading.empty() && loading.front())
+    loading.front()->includes.push_back(
+      moduleInclude(filename, sourceDigest(filename)));
+}
+
 void genv::checkRecursion(string filename) {
   if (find(inTranslation.begin(), inTranslation.end(), filename) !=
       inTranslation.end()) {
@@ -100,18 +248,19 @@ record *genv::getModule(symbol id, string filename) {
   checkRecursion(filename);
 
   record *r=imap[filename];
-  if (r)
-    return r;
-  else {
-    record *r=loadModule(id, filename);
+  if (!r) {
+    r=loadModule(id, filename);
     // Don't add an erroneous module to the dictionary in interactive mode, as
     // the user may try to load it again.
     if (!interact::interactive || !em.errors())
       imap[filename]=r;
-
-    return r;
   }
 
+  // Note the import for the module being loaded.
+  if (!loading.empty() && loading.front())
+    loading.front()->imports.push_back(moduleImport(id, filename, r));
+
+  return r;
 }
 
 typedef vm::stack::importInitMap importInitMap;
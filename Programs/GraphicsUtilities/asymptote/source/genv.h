@@ -29,6 +29,9 @@ using vm::lambda;
 
 namespace trans {
 
+// A translated module, as kept by the in-process module cache (see genv.cc).
+struct cachedModule;
+
 class genv : public gc {
   // The initializer functions for imports, indexed by filename.
   typedef mem::map<CONST string,record *> importMap;
@@ -38,6 +41,11 @@ class genv : public gc {
   // recursion in loading modules.
   mem::list<string> inTranslation;
 
+  // Modules being loaded, innermost first.  Each one notes the modules it
+  // imports and the files it includes, which decide whether it can be reused
+  // by a later global environment.
+  mem::list<cachedModule *> loading;
+
   // Checks for recursion in loading, reporting an error and throwing an
   // exception if it occurs.
   void checkRecursion(string filename);
@@ -45,12 +53,19 @@ class genv : public gc {
   // Translate a module to build the record type.
   record *loadModule(symbol name, string s);
 
+  // Returns the module translated by an earlier global environment, if
+  // neither its source nor its imports have changed since.
+  record *reuseModule(symbol name, string s, string digest);
+
 public:
   genv();
 
   // Get an imported module, translating if necessary.
   record *getModule(symbol name, string s);
 
+  // Notes a file included by the module being loaded.
+  void noteInclude(string filename);
+
   // Uses the filename->record map to build a filename->initializer map to be
   // used at runtime.
   vm::stack::importInitMap *getInitMap();
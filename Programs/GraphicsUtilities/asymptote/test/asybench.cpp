@@ -0,0 +1,168 @@
+/* asybench.cpp: measure the startup of asy
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 2, or (at your
+   option) any later version.
+
+   This file is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this file; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA. */
+
+// asybench generates FILES figures which import plain (implicitly)
+// and a module of FUNCTIONS functions.  The figures draw nothing, so
+// that neither LaTeX nor a PostScript interpreter is involved: what
+// is measured is the time spent loading and translating the modules.
+//
+//   separate: one asy invocation per figure
+//   batch:    one asy invocation for all figures
+//
+// A batch run translates plain and the module once and reuses them
+// for the remaining figures; the difference between the two phases
+// is the startup cost that the module cache saves.  The cache lives
+// in the asy process only: separate invocations gain nothing from it.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/Exceptions>
+#include <miktex/Core/PathName>
+#include <miktex/Core/Process>
+#include <miktex/Core/Session>
+
+using namespace std;
+using namespace std::chrono;
+
+using namespace MiKTeX::Core;
+
+const string MODULE_NAME = "asybench_module";
+
+void WriteText(const PathName& path, const string& text)
+{
+  ofstream stream(path.ToString(), ios::binary);
+  stream << text;
+  if (!stream)
+  {
+    throw runtime_error("cannot write " + path.ToString());
+  }
+}
+
+void WriteModule(const PathName& path, int numFunctions)
+{
+  string text;
+  for (int i = 0; i < numFunctions; ++i)
+  {
+    string name = "f" + to_string(i);
+    text += "real " + name + "(real x) { return " + (i == 0 ? "x" : "f" + to_string(i - 1) + "(x)") + " + " + to_string(i % 7) + "; }\n";
+    text += "pair " + name + "(pair z) { return (" + name + "(z.x), " + name + "(z.y)); }\n";
+  }
+  text += "struct asybenchState { real total; void add(real x) { total += x; } }\n";
+  WriteText(path, text);
+}
+
+void WriteFigure(const PathName& path, int idx, int numFunctions)
+{
+  WriteText(path,
+    "import " + MODULE_NAME + ";\n"
+    "asybenchState state;\n"
+    "state.add(f" + to_string(idx % numFunctions) + "(" + to_string(idx) + "));\n"
+    "pair z = f0((" + to_string(idx) + ", 1));\n");
+}
+
+duration<double> Measure(const PathName& asy, const vector<vector<string>>& invocations, int runs)
+{
+  duration<double> best = duration<double>::max();
+  for (int run = 0; run < runs; ++run)
+  {
+    auto start = steady_clock::now();
+    for (const vector<string>& arguments : invocations)
+    {
+      Process::Run(asy, arguments);
+    }
+    best = min(best, duration<double>(steady_clock::now() - start));
+  }
+  return best;
+}
+
+int main(int argc, char* argv[])
+{
+  int numFiles = argc > 2 ? atoi(argv[2]) : 20;
+  int numFunctions = argc > 3 ? atoi(argv[3]) : 1000;
+  if (argc < 2 || argc > 5 || numFiles < 1 || numFunctions < 1)
+  {
+    cerr << "usage: " << argv[0] << " ASY [FILES [FUNCTIONS [DIR]]]" << endl;
+    return 1;
+  }
+  try
+  {
+    shared_ptr<Session> session = Session::Create(Session::InitInfo(argv[0]));
+    PathName asy(argv[1]);
+    asy.MakeFullyQualified();
+    PathName workDir(argc > 4 ? argv[4] : "asybench");
+    if (Directory::Exists(workDir))
+    {
+      Directory::Delete(workDir, true);
+    }
+    Directory::Create(workDir);
+    Directory::SetCurrent(workDir);
+
+    WriteModule(PathName(MODULE_NAME + ".asy"), numFunctions);
+    vector<string> figures;
+    for (int i = 0; i < numFiles; ++i)
+    {
+      figures.push_back("figure" + to_string(i) + ".asy");
+      WriteFigure(PathName(figures.back()), i, numFunctions);
+    }
+
+    const vector<string> options = { "asy", "-noV" };
+    vector<vector<string>> separate;
+    for (const string& figure : figures)
+    {
+      separate.push_back(options);
+      separate.back().push_back(figure);
+    }
+    vector<vector<string>> batch{ options };
+    batch.back().insert(batch.back().end(), figures.begin(), figures.end());
+
+    const int runs = 3;
+    duration<double> separateTime = Measure(asy, separate, runs);
+    duration<double> batchTime = Measure(asy, batch, runs);
+
+    cout << fixed << setprecision(3)
+      << "files:       " << numFiles << "\n"
+      << "functions:   " << numFunctions << "\n"
+      << "separate:    " << separateTime.count() * 1000 << " ms (best of " << runs << ")" << "\n"
+      << "batch:       " << batchTime.count() * 1000 << " ms (best of " << runs << ")" << "\n"
+      << "per figure:  " << separateTime.count() * 1000 / numFiles << " ms separate, " << batchTime.count() * 1000 / numFiles << " ms batch" << "\n"
+      << "speedup:     " << separateTime.count() / batchTime.count() << endl;
+    return 0;
+  }
+  catch (const MiKTeXException& ex)
+  {
+    cerr << ex.GetErrorMessage() << endl;
+    return 1;
+  }
+  catch (const exception& ex)
+  {
+    cerr << ex.what() << endl;
+    return 1;
+  }
+}
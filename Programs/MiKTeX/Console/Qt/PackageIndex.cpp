@@ -0,0 +1,234 @@
+/* PackageIndex.cpp:
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of MiKTeX Console.
+
+   MiKTeX Console is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   MiKTeX Console is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with MiKTeX Console; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA. */
+
+#include <algorithm>
+#include <cctype>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+
+#include <miktex/Core/PathName>
+
+#include "PackageIndex.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Packages;
+
+namespace
+{
+  // same semantics as PathName::Match(), but without preparing the
+  // operands on every call
+  bool MatchPattern(const char* pattern, const char* name)
+  {
+    const char* starPattern = nullptr;
+    const char* starName = nullptr;
+    while (*name != 0)
+    {
+      if (*pattern == '*')
+      {
+        starPattern = ++pattern;
+        starName = name;
+      }
+      else if (*pattern == '?' || *pattern == *name)
+      {
+        ++pattern;
+        ++name;
+      }
+      else if (starPattern != nullptr)
+      {
+        pattern = starPattern;
+        name = ++starName;
+      }
+      else
+      {
+        return false;
+      }
+    }
+    while (*pattern == '*')
+    {
+      ++pattern;
+    }
+    return *pattern == 0;
+  }
+
+  string PrepareForComparison(const PathName& path)
+  {
+    PathName result(path);
+    result.TransformForComparison();
+    return result.ToString();
+  }
+
+  int CompareIgnoringCase(const string& s1, const string& s2)
+  {
+    size_t n = min(s1.length(), s2.length());
+    for (size_t i = 0; i < n; ++i)
+    {
+      int cmp = tolower(static_cast<unsigned char>(s1[i])) - tolower(static_cast<unsigned char>(s2[i]));
+      if (cmp != 0)
+      {
+        return cmp;
+      }
+    }
+    return s1.length() < s2.length() ? -1 : s1.length() > s2.length() ? 1 : 0;
+  }
+
+  // equal strings get equal ranks
+  vector<int> MakeRanks(const vector<string>& column)
+  {
+    vector<int> order(column.size());
+    iota(order.begin(), order.end(), 0);
+    sort(order.begin(), order.end(), [&column](int row1, int row2) { return CompareIgnoringCase(column[row1], column[row2]) < 0; });
+    vector<int> ranks(column.size());
+    int rank = 0;
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+      if (i > 0 && CompareIgnoringCase(column[order[i - 1]], column[order[i]]) != 0)
+      {
+        ++rank;
+      }
+      ranks[order[i]] = rank;
+    }
+    return ranks;
+  }
+}
+
+PackageIndex::PackageIndex(const vector<PackageInfo>& packages)
+{
+  ids.reserve(packages.size());
+  titles.reserve(packages.size());
+  sizes.reserve(packages.size());
+  vector<pair<string, int>> runFiles;
+  for (const PackageInfo& packageInfo : packages)
+  {
+    int row = static_cast<int>(ids.size());
+    ids.push_back(packageInfo.id);
+    titles.push_back(packageInfo.title);
+    sizes.push_back(packageInfo.GetSize());
+    for (const string& f : packageInfo.runFiles)
+    {
+      runFiles.push_back(make_pair(PrepareForComparison(PathName(f).GetFileName()), row));
+    }
+  }
+  idRanks = MakeRanks(ids);
+  titleRanks = MakeRanks(titles);
+  sort(runFiles.begin(), runFiles.end());
+  runFiles.erase(unique(runFiles.begin(), runFiles.end()), runFiles.end());
+  fileNameRows.reserve(runFiles.size());
+  for (pair<string, int>& p : runFiles)
+  {
+    if (fileNames.empty() || fileNames.back() != p.first)
+    {
+      fileNameStart.push_back(fileNameRows.size());
+      fileNames.push_back(move(p.first));
+    }
+    fileNameRows.push_back(p.second);
+  }
+  fileNameStart.push_back(fileNameRows.size());
+}
+
+shared_ptr<PackageIndex::FilterResult> PackageIndex::Filter(const string& filter, const FilterResult* previous) const
+{
+  shared_ptr<FilterResult> result = make_shared<FilterResult>();
+  result->filter = filter;
+  result->accepted.resize(ids.size(), false);
+
+  // a row which does not contain the old text does not contain the new one
+  auto containsText = [this, &filter](int row) {
+    return ids[row].find(filter) != string::npos || titles[row].find(filter) != string::npos;
+  };
+  if (previous != nullptr && filter.compare(0, previous->filter.length(), previous->filter) == 0)
+  {
+    copy_if(previous->textMatches.begin(), previous->textMatches.end(), back_inserter(result->textMatches), containsText);
+  }
+  else
+  {
+    for (int row = 0; row < GetCount(); ++row)
+    {
+      if (containsText(row))
+      {
+        result->textMatches.push_back(row);
+      }
+    }
+  }
+  for (int row : result->textMatches)
+  {
+    result->accepted[row] = true;
+  }
+
+  // only names starting with the literal prefix of the pattern can match
+  string pattern = PrepareForComparison(PathName(filter));
+  size_t wildcard = pattern.find_first_of("*?");
+  if (wildcard == string::npos)
+  {
+    auto range = equal_range(fileNames.begin(), fileNames.end(), pattern);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+      MarkFileName(it - fileNames.begin(), result->accepted);
+    }
+  }
+  else
+  {
+    string prefix = pattern.substr(0, wildcard);
+    for (auto it = lower_bound(fileNames.begin(), fileNames.end(), prefix); it != fileNames.end() && it->compare(0, prefix.length(), prefix) == 0; ++it)
+    {
+      if (MatchPattern(pattern.c_str(), it->c_str()))
+      {
+        MarkFileName(it - fileNames.begin(), result->accepted);
+      }
+    }
+  }
+
+  return result;
+}
+
+shared_ptr<PackageIndex::FilterResult> PackageIndex::Translate(const PackageIndex& other, const FilterResult& result) const
+{
+  shared_ptr<FilterResult> translated = make_shared<FilterResult>();
+  translated->filter = result.filter;
+  translated->accepted.resize(ids.size(), false);
+  unordered_map<string, int> rows;
+  for (int row = 0; row < GetCount(); ++row)
+  {
+    rows[ids[row]] = row;
+  }
+  for (int row = 0; row < other.GetCount(); ++row)
+  {
+    if (result.accepted[row])
+    {
+      auto it = rows.find(other.ids[row]);
+      if (it != rows.end())
+      {
+        translated->accepted[it->second] = true;
+      }
+    }
+  }
+  return translated;
+}
+
+void PackageIndex::MarkFileName(size_t idx, vector<bool>& accepted) const
+{
+  for (size_t i = fileNameStart[idx]; i < fileNameStart[idx + 1]; ++i)
+  {
+    accepted[fileNameRows[i]] = true;
+  }
+}
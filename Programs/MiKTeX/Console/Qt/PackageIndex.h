@@ -0,0 +1,125 @@
+/* PackageIndex.h:                                      -*- C++ -*-
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of MiKTeX Console.
+
+   MiKTeX Console is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   MiKTeX Console is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with MiKTeX Console; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA. */
+
+#pragma once
+
+#if !defined(B3C5E0D6F1A94E2C8A7D2B6E4F9C1A35)
+#define B3C5E0D6F1A94E2C8A7D2B6E4F9C1A35
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <miktex/PackageManager/PackageManager>
+
+/// An immutable column store of the displayed package fields.  It is
+/// shared with filter threads, so it must not change once built.
+class PackageIndex
+{
+public:
+  struct FilterResult
+  {
+    /// The filter text.
+    std::string filter;
+    /// Rows whose name or title contains the filter text.
+    std::vector<int> textMatches;
+    /// One flag per row.
+    std::vector<bool> accepted;
+  };
+
+public:
+  PackageIndex(const std::vector<MiKTeX::Packages::PackageInfo>& packages);
+
+  /// Finds the rows matching a filter text.
+  /// @param filter The filter text.
+  /// @param previous The result of the last run, or `nullptr`. When the new filter text
+  /// extends the old one, only the old text matches need to be searched.
+  /// @return Returns the filter result.
+public:
+  std::shared_ptr<FilterResult> Filter(const std::string& filter, const FilterResult* previous) const;
+
+  /// Carries a filter result over to this index.  Rows are matched by package name.
+  /// The carried result has no text matches: it must not be passed to `Filter()`.
+  /// @param other The index from which the result has been computed.
+  /// @param result The filter result.
+  /// @return Returns the carried result.
+public:
+  std::shared_ptr<FilterResult> Translate(const PackageIndex& other, const FilterResult& result) const;
+
+public:
+  int GetCount() const
+  {
+    return static_cast<int>(ids.size());
+  }
+
+public:
+  std::size_t GetSize(int row) const
+  {
+    return sizes[row];
+  }
+
+  /// Gets the position of the row, when the rows are sorted case-insensitively by name.
+public:
+  int GetIdRank(int row) const
+  {
+    return idRanks[row];
+  }
+
+  /// Gets the position of the row, when the rows are sorted case-insensitively by title.
+public:
+  int GetTitleRank(int row) const
+  {
+    return titleRanks[row];
+  }
+
+private:
+  void MarkFileName(std::size_t idx, std::vector<bool>& accepted) const;
+
+private:
+  std::vector<std::string> ids;
+
+private:
+  std::vector<std::string> titles;
+
+private:
+  std::vector<std::size_t> sizes;
+
+private:
+  std::vector<int> idRanks;
+
+private:
+  std::vector<int> titleRanks;
+
+  // distinct names of run files, prepared for comparison and sorted
+private:
+  std::vector<std::string> fileNames;
+
+  // the rows containing fileNames[i] are
+  // fileNameRows[fileNameStart[i]] .. fileNameRows[fileNameStart[i + 1] - 1]
+private:
+  std::vector<std::size_t> fileNameStart;
+
+private:
+  std::vector<int> fileNameRows;
+};
+
+#endif
@@ -1,6 +1,6 @@
 /* PackageProxyModel.cpp:
 
-   Copyright (C) 2018-2019 Christian Schenk
+   Copyright (C) 2018-2020 Christian Schenk
 
    This file is part of MiKTeX Console.
 
@@ -19,7 +19,6 @@
    Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
    USA. */
 
-#include <miktex/Core/PathName>
 #include <miktex/PackageManager/PackageManager>
 
 #include "PackageProxyModel.h"
@@ -33,67 +32,163 @@ using namespace MiKTeX::Packages;
 PackageProxyModel::PackageProxyModel(QObject* parent) :
   QSortFilterProxyModel(parent)
 {
+  worker = new PackageFilterWorker;
+  worker->moveToThread(&filterThread);
+  (void)connect(&filterThread, SIGNAL(finished()), worker, SLOT(deleteLater()));
+  (void)connect(worker, &PackageFilterWorker::OnFinish, this, [this]() {
+    PackageFilterWorker::Response response = worker->TakeResponse();
+    if (response.index != nullptr && response.generation == generation)
+    {
+      filterIndex = response.index;
+      filterResult = response.result;
+      shownIndex = filterIndex;
+      shownResult = filterResult;
+      invalidateFilter();
+      emit FilterApplied();
+    }
+  });
+  filterThread.start();
 }
 
-void PackageProxyModel::SetFilter(const string& filter)
+PackageProxyModel::~PackageProxyModel()
 {
-  this->filterText = filter;
-  invalidateFilter();
+  filterThread.quit();
+  filterThread.wait();
 }
 
-bool PackageProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const
+void PackageProxyModel::setSourceModel(QAbstractItemModel* sourceModel)
 {
-  if (filterText.empty())
-  {
-    return true;
-  }
-  PackageTableModel* packageTableModel = dynamic_cast<PackageTableModel*>(sourceModel());
+  packageTableModel = dynamic_cast<PackageTableModel*>(sourceModel);
   MIKTEX_ASSERT(packageTableModel != nullptr);
-  PackageInfo packageInfo;
-  if (!packageTableModel->TryGetPackageInfo(sourceModel()->index(sourceRow, 0, sourceParent), packageInfo))
+  QSortFilterProxyModel::setSourceModel(sourceModel);
+  (void)connect(sourceModel, &QAbstractItemModel::modelReset, this, [this]() {
+    if (filterText.empty())
+    {
+      return;
+    }
+    // keep the package list filtered while the new result is computed
+    shared_ptr<const PackageIndex> index = packageTableModel->GetIndex();
+    if (shownResult != nullptr && shownIndex != index)
+    {
+      shownResult = index->Translate(*shownIndex, *shownResult);
+      shownIndex = index;
+      invalidateFilter();
+    }
+    StartFilter();
+  });
+}
+
+void PackageProxyModel::SetFilter(const string& filter)
+{
+  if (filter == filterText)
   {
-    return false;
+    return;
   }
-  bool accept = false;
-  if (!accept)
+  this->filterText = filter;
+  if (filterText.empty())
   {
-    accept = packageInfo.id.find(filterText) != string::npos;
+    generation++;
+    filterIndex = nullptr;
+    filterResult = nullptr;
+    shownIndex = nullptr;
+    shownResult = nullptr;
+    invalidateFilter();
+    emit FilterApplied();
   }
-  if (!accept)
+  else
   {
-    accept = packageInfo.title.find(filterText) != string::npos;
+    StartFilter();
   }
-  if (!accept)
+}
+
+void PackageProxyModel::StartFilter()
+{
+  shared_ptr<const PackageIndex> index = packageTableModel->GetIndex();
+  generation++;
+  worker->Post({ index, filterText, filterIndex == index ? filterResult : nullptr, generation });
+}
+
+bool PackageProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const
+{
+  // until the first result arrives, all rows are shown
+  if (filterText.empty() || shownResult == nullptr || shownIndex != packageTableModel->GetIndex())
   {
-    for (const string& f : packageInfo.runFiles)
-    {
-      accept = PathName::Match(filterText.c_str(), PathName(f).RemoveDirectorySpec());
-      if (accept)
-      {
-        break;
-      }
-    }
+    return true;
   }
-  return accept;
+  return shownResult->accepted[sourceRow];
 }
 
 bool PackageProxyModel::lessThan(const QModelIndex& left, const QModelIndex& right) const
 {
   MIKTEX_ASSERT(left.column() == right.column());
-  PackageTableModel* packageTableModel = dynamic_cast<PackageTableModel*>(sourceModel());
-  MIKTEX_ASSERT(packageTableModel != nullptr);
-  PackageInfo packageInfoLeft;
-  PackageInfo packageInfoRight;
-  if (packageTableModel->TryGetPackageInfo(sourceModel()->index(left.row(), 0, left.parent()), packageInfoLeft)
-    && packageTableModel->TryGetPackageInfo(sourceModel()->index(right.row(), 0, right.parent()), packageInfoRight))
+  const PackageIndex& index = *packageTableModel->GetIndex();
+  bool useRanks = sortCaseSensitivity() == Qt::CaseInsensitive && !isSortLocaleAware();
+  switch (left.column())
   {
-    switch (left.column())
+  case 0:
+    if (useRanks)
     {
-    case 2:
-      return packageInfoLeft.GetSize() < packageInfoRight.GetSize();
-    default:
-      break;
+      return index.GetIdRank(left.row()) < index.GetIdRank(right.row());
     }
+    break;
+  case 2:
+    return index.GetSize(left.row()) < index.GetSize(right.row());
+  case 6:
+    if (useRanks)
+    {
+      return index.GetTitleRank(left.row()) < index.GetTitleRank(right.row());
+    }
+    break;
+  default:
+    break;
   }
   return QSortFilterProxyModel::lessThan(left, right);
 }
+
+void PackageFilterWorker::Post(const Request& request)
+{
+  bool idle;
+  {
+    lock_guard<mutex> lock(requestMutex);
+    idle = !pending;
+    pending = true;
+    next = request;
+  }
+  if (idle)
+  {
+    QMetaObject::invokeMethod(this, "Process", Qt::QueuedConnection);
+  }
+}
+
+PackageFilterWorker::Response PackageFilterWorker::TakeResponse()
+{
+  lock_guard<mutex> lock(requestMutex);
+  Response taken = move(response);
+  response = Response();
+  return taken;
+}
+
+void PackageFilterWorker::Process()
+{
+  Request request;
+  {
+    lock_guard<mutex> lock(requestMutex);
+    request = move(next);
+    next = Request();
+    pending = false;
+  }
+  shared_ptr<const PackageIndex::FilterResult> result;
+  try
+  {
+    result = request.index->Filter(request.filter, request.previous.get());
+  }
+  catch (const exception&)
+  {
+    result = nullptr;
+  }
+  {
+    lock_guard<mutex> lock(requestMutex);
+    response = { request.index, result, request.generation };
+  }
+  emit OnFinish();
+}
@@ -1,6 +1,6 @@
 /* PackageProxyModel.h:                                 -*- C++ -*-
 
-   Copyright (C) 2018 Christian Schenk
+   Copyright (C) 2018-2020 Christian Schenk
 
    This file is part of MiKTeX Console.
 
@@ -24,7 +24,17 @@
 #if !defined(E7AF14B9D04F41D48C47DDB1A55839A8)
 #define E7AF14B9D04F41D48C47DDB1A55839A8
 
+#include <memory>
+#include <mutex>
+#include <string>
+
 #include <QSortFilterProxyModel>
+#include <QThread>
+
+#include "PackageIndex.h"
+
+class PackageFilterWorker;
+class PackageTableModel;
 
 class PackageProxyModel :
   public QSortFilterProxyModel
@@ -35,17 +45,113 @@ private:
 public:
   PackageProxyModel(QObject* parent = nullptr);
 
+public:
+  ~PackageProxyModel() override;
+
+public:
+  void setSourceModel(QAbstractItemModel* sourceModel) override;
+
+  /// Filters the package list.  The filter runs in the background; the
+  /// `FilterApplied` signal is emitted when the result is shown.  Until
+  /// then, the last result stays in effect.
 public:
   void SetFilter(const std::string& filter);
 
+signals:
+  void FilterApplied();
+
 protected:
   bool filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const override;
 
 protected:
   bool lessThan(const QModelIndex& left, const QModelIndex& right) const override;
-  
+
+private:
+  void StartFilter();
+
+private:
+  PackageTableModel* packageTableModel = nullptr;
+
 private:
   std::string filterText;
+
+  // the index from which filterResult has been computed
+private:
+  std::shared_ptr<const PackageIndex> filterIndex;
+
+private:
+  std::shared_ptr<const PackageIndex::FilterResult> filterResult;
+
+  // the result shown by filterAcceptsRow(); after a model reset, this
+  // is filterResult carried over to the new index
+private:
+  std::shared_ptr<const PackageIndex> shownIndex;
+
+private:
+  std::shared_ptr<const PackageIndex::FilterResult> shownResult;
+
+  // incremented on every filter change; results of older runs are dropped
+private:
+  unsigned generation = 0;
+
+private:
+  QThread filterThread;
+
+private:
+  PackageFilterWorker* worker = nullptr;
+};
+
+/// Runs filter requests on the filter thread, one at a time.
+class PackageFilterWorker :
+  public QObject
+{
+private:
+  Q_OBJECT;
+
+public:
+  struct Request
+  {
+    std::shared_ptr<const PackageIndex> index;
+    std::string filter;
+    std::shared_ptr<const PackageIndex::FilterResult> previous;
+    unsigned generation = 0;
+  };
+
+public:
+  struct Response
+  {
+    std::shared_ptr<const PackageIndex> index;
+    std::shared_ptr<const PackageIndex::FilterResult> result;
+    unsigned generation = 0;
+  };
+
+  /// Queues a request.  A request which has not been started yet is
+  /// replaced, so that only the newest one runs after the current one.
+public:
+  void Post(const Request& request);
+
+  /// Takes the response of the last finished run.
+  /// @return Returns the response, or an empty response if it has already been taken.
+public:
+  Response TakeResponse();
+
+public slots:
+  void Process();
+
+signals:
+  void OnFinish();
+
+private:
+  std::mutex requestMutex;
+
+private:
+  bool pending = false;
+
+private:
+  Request next;
+
+private:
+  Response response;
 };
 
 #endif
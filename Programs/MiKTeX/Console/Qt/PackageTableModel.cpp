@@ -57,60 +57,57 @@ QVariant PackageTableModel::data(const QModelIndex& index, int role) const
     return QVariant();
   }
 
+  const PackageInfo& packageInfo = packages[index.row()];
+
   if (role == Qt::DisplayRole)
   {
-    PackageInfo packageInfo;
-    if (TryGetPackageInfo(index, packageInfo))
+    switch (index.column())
     {
-      switch (index.column())
-      {
-      case 0:
-        return QString::fromUtf8(packageInfo.id.c_str());
-      case 1:
-        return QString::fromUtf8(packageManager->GetContainerPath(packageInfo.id, true).c_str());
-      case 2:
+    case 0:
+      return QString::fromUtf8(packageInfo.id.c_str());
+    case 1:
+      return QString::fromUtf8(packageManager->GetContainerPath(packageInfo.id, true).c_str());
+    case 2:
 #if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
-        return QLocale::system().formattedDataSize(packageInfo.GetSize());
+      return QLocale::system().formattedDataSize(packageInfo.GetSize());
 #else
-        return static_cast<qlonglong>(packageInfo.GetSize());
+      return static_cast<qlonglong>(packageInfo.GetSize());
 #endif
-      case 3:
-        return QDateTime::fromTime_t(packageInfo.timePackaged).date();
-      case 4:
-        if (packageInfo.IsInstalled())
-        {
-          return QDateTime::fromTime_t(packageInfo.GetTimeInstalled()).date();
-        }
-        break;
-      case 5:
-        if (packageInfo.IsInstalled(ConfigurationScope::Common) && packageInfo.IsInstalled(ConfigurationScope::User))
-        {
-          return "Admin, User";
-        }
-        else if (packageInfo.IsInstalled(ConfigurationScope::Common))
-        {
-          return session->IsSharedSetup() ? "Admin" : "User";
-        }
-        else if (packageInfo.IsInstalled(ConfigurationScope::User))
-        {
-          return "User";
-        }
-        break;
-      case 6:
-        return QString::fromUtf8(packageInfo.title.c_str());
-      case 7:
-        if (!packageInfo.runFiles.empty())
-        {
-          return QString("%1 +%2").arg(QString::fromUtf8(PathName(packageInfo.runFiles[0]).GetFileName().GetData())).arg(packageInfo.runFiles.size());
-        }
-        break;
+    case 3:
+      return QDateTime::fromTime_t(packageInfo.timePackaged).date();
+    case 4:
+      if (packageInfo.IsInstalled())
+      {
+        return QDateTime::fromTime_t(packageInfo.GetTimeInstalled()).date();
+      }
+      break;
+    case 5:
+      if (packageInfo.IsInstalled(ConfigurationScope::Common) && packageInfo.IsInstalled(ConfigurationScope::User))
+      {
+        return "Admin, User";
+      }
+      else if (packageInfo.IsInstalled(ConfigurationScope::Common))
+      {
+        return session->IsSharedSetup() ? "Admin" : "User";
+      }
+      else if (packageInfo.IsInstalled(ConfigurationScope::User))
+      {
+        return "User";
       }
+      break;
+    case 6:
+      return QString::fromUtf8(packageInfo.title.c_str());
+    case 7:
+      if (!packageInfo.runFiles.empty())
+      {
+        return QString("%1 +%2").arg(QString::fromUtf8(PathName(packageInfo.runFiles[0]).GetFileName().GetData())).arg(packageInfo.runFiles.size());
+      }
+      break;
     }
   }
   else if (role == Qt::ForegroundRole)
   {
-    PackageInfo packageInfo;
-    if (TryGetPackageInfo(index, packageInfo) && packageInfo.IsInstalled(ConfigurationScope::Common) && packageInfo.IsInstalled(ConfigurationScope::User))
+    if (packageInfo.IsInstalled(ConfigurationScope::Common) && packageInfo.IsInstalled(ConfigurationScope::User))
     {
       return QColor("red");
     }
@@ -148,34 +145,35 @@ QVariant PackageTableModel::headerData(int section, Qt::Orientation orientation,
 
 void PackageTableModel::Reload()
 {
-  beginResetModel();
-  MIKTEX_AUTO(endResetModel());
-  packages.clear();  
   packageManager->UnloadDatabase();
   unique_ptr<PackageIterator> iter(packageManager->CreateIterator());
+  vector<PackageInfo> newPackages;
   PackageInfo packageInfo;
-  int row = 0;
   while (iter->GetNext(packageInfo))
   {
     if (!packageInfo.IsPureContainer())
     {
-      packages[row] = packageInfo;
-      ++row;
+      newPackages.push_back(packageInfo);
     }
   }
   iter->Dispose();
+  Load(move(newPackages));
+}
+
+void PackageTableModel::Load(vector<PackageInfo>&& packages)
+{
+  beginResetModel();
+  MIKTEX_AUTO(endResetModel());
+  this->packages = move(packages);
+  packageIndex = make_shared<PackageIndex>(this->packages);
 }
 
 bool PackageTableModel::TryGetPackageInfo(const QModelIndex& index, PackageInfo& packageInfo) const
 {
-  map<int, PackageInfo>::const_iterator it = packages.find(index.row());
-  if (it == packages.end())
+  if (index.row() < 0 || index.row() >= packages.size())
   {
     return false;
   }
-  else
-  {
-    packageInfo = it->second;
-    return true;
-  }
+  packageInfo = packages[index.row()];
+  return true;
 }
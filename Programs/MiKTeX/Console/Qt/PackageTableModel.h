@@ -1,6 +1,6 @@
 /* PackageTableModel.h:                                 -*- C++ -*-
 
-   Copyright (C) 2018-2019 Christian Schenk
+   Copyright (C) 2018-2020 Christian Schenk
 
    This file is part of MiKTeX Console.
 
@@ -24,11 +24,16 @@
 #if !defined(A767D31C530F42158B96C0AF14BBF92B)
 #define A767D31C530F42158B96C0AF14BBF92B
 
+#include <memory>
+#include <vector>
+
 #include <QAbstractTableModel>
 
 #include <miktex/PackageManager/PackageManager>
 #include <miktex/Core/Session>
 
+#include "PackageIndex.h"
+
 class PackageTableModel :
   public QAbstractTableModel
 {
@@ -53,6 +58,9 @@ public:
 public:
   void Reload();
 
+public:
+  void Load(std::vector<MiKTeX::Packages::PackageInfo>&& packages);
+
 public:
   bool TryGetPackageInfo(const QModelIndex& index, MiKTeX::Packages::PackageInfo& packageInfo) const;
 
@@ -60,14 +68,23 @@ private:
   std::shared_ptr<MiKTeX::Packages::PackageManager> packageManager;
 
 private:
-  std::map<int, MiKTeX::Packages::PackageInfo> packages;
+  std::vector<MiKTeX::Packages::PackageInfo> packages;
 
 public:
-  const std::map<int, MiKTeX::Packages::PackageInfo>& GetData() const
+  const std::vector<MiKTeX::Packages::PackageInfo>& GetData() const
   {
     return packages;
   }
 
+private:
+  std::shared_ptr<const PackageIndex> packageIndex = std::make_shared<PackageIndex>(std::vector<MiKTeX::Packages::PackageInfo>());
+
+public:
+  const std::shared_ptr<const PackageIndex>& GetIndex() const
+  {
+    return packageIndex;
+  }
+
 private:
   std::shared_ptr<MiKTeX::Core::Session> session = MiKTeX::Core::Session::Get();
 };
@@ -2111,6 +2111,7 @@ void MainWindow::SetupUiPackages()
   toolBarPackages->addWidget(lineEditPackageFilter);
   toolBarPackages->addAction(ui->actionFilterPackages);
   (void)connect(lineEditPackageFilter, SIGNAL(returnPressed()), this, SLOT(FilterPackages()));
+  (void)connect(lineEditPackageFilter, SIGNAL(textChanged(const QString&)), this, SLOT(FilterPackages()));
   ui->hboxPackageToolBar->addWidget(toolBarPackages);
   ui->hboxPackageToolBar->addStretch();
   packageModel = new PackageTableModel(packageManager, this);
@@ -0,0 +1,175 @@
+/* packagefilterbench.cpp:
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is part of MiKTeX Console.
+
+   MiKTeX Console is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   MiKTeX Console is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with MiKTeX Console; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA. */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <QApplication>
+#include <QEventLoop>
+#include <QTreeView>
+
+#include <miktex/Core/PathName>
+#include <miktex/Core/Session>
+#include <miktex/PackageManager/PackageManager>
+
+#include "PackageProxyModel.h"
+#include "PackageTableModel.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Packages;
+
+namespace
+{
+  const char* const words[] = { "ams", "math", "font", "graph", "tikz", "bib", "lang", "util", "doc", "code" };
+  const char* const extensions[] = { ".sty", ".tex", ".cls", ".tfm", ".def" };
+
+  vector<PackageInfo> MakePackages(int numPackages, int numFiles)
+  {
+    mt19937 generator(42);
+    vector<PackageInfo> packages(numPackages);
+    for (int i = 0; i < numPackages; ++i)
+    {
+      PackageInfo& packageInfo = packages[i];
+      packageInfo.id = string(words[i % 10]) + words[(i / 10) % 10] + to_string(i);
+      packageInfo.title = "The " + packageInfo.id + " package for " + words[(i / 100) % 10];
+      packageInfo.sizeRunFiles = generator() % 1000000;
+      for (int k = 0; k < numFiles; ++k)
+      {
+        packageInfo.runFiles.push_back("texmf/tex/latex/" + packageInfo.id + "/" + packageInfo.id + "-" + to_string(k) + extensions[k % 5]);
+      }
+    }
+    return packages;
+  }
+
+  // the filter as it was before the package index existed
+  int CountMatches(const vector<PackageInfo>& packages, const string& filter)
+  {
+    int count = 0;
+    for (const PackageInfo& packageInfo : packages)
+    {
+      bool accept = packageInfo.id.find(filter) != string::npos || packageInfo.title.find(filter) != string::npos;
+      for (size_t i = 0; !accept && i < packageInfo.runFiles.size(); ++i)
+      {
+        accept = PathName::Match(filter.c_str(), PathName(packageInfo.runFiles[i]).RemoveDirectorySpec());
+      }
+      if (accept)
+      {
+        count++;
+      }
+    }
+    return count;
+  }
+
+  double Milliseconds(chrono::steady_clock::time_point start)
+  {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+  }
+}
+
+int main(int argc, char** argv)
+{
+  int numPackages = argc > 1 ? atoi(argv[1]) : 4000;
+  int numFiles = argc > 2 ? atoi(argv[2]) : 25;
+  if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+  {
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+  }
+  QApplication application(argc, argv);
+  shared_ptr<Session> session = Session::Create(Session::InitInfo(argv[0]));
+  vector<PackageInfo> packages = MakePackages(numPackages, numFiles);
+  cout << numPackages << " packages, " << numPackages * numFiles << " files" << endl;
+
+  PackageTableModel packageModel(nullptr);
+  PackageProxyModel packageProxyModel;
+  packageProxyModel.setSourceModel(&packageModel);
+  packageProxyModel.setSortCaseSensitivity(Qt::CaseInsensitive);
+  QTreeView view;
+  view.setModel(&packageProxyModel);
+  // the category column needs the package manager
+  view.setColumnHidden(1, true);
+  view.show();
+
+  auto start = chrono::steady_clock::now();
+  packageModel.Load(vector<PackageInfo>(packages));
+  cout << "load: " << Milliseconds(start) << "ms" << endl;
+
+  QEventLoop loop;
+  (void)QObject::connect(&packageProxyModel, &PackageProxyModel::FilterApplied, &loop, &QEventLoop::quit);
+  bool ok = true;
+
+  // type a filter, waiting for the result after each key
+  vector<string> typed;
+  for (const string& text : { string("amsmath12"), string("*.cls"), string("amsmath12-3.sty") })
+  {
+    for (size_t n = 1; n <= text.length(); ++n)
+    {
+      typed.push_back(text.substr(0, n));
+    }
+  }
+  for (const string& filter : typed)
+  {
+    start = chrono::steady_clock::now();
+    int expected = CountMatches(packages, filter);
+    double before = Milliseconds(start);
+    start = chrono::steady_clock::now();
+    packageProxyModel.SetFilter(filter);
+    loop.exec();
+    double after = Milliseconds(start);
+    int count = packageProxyModel.rowCount();
+    cout << "filter " << filter << ": " << count << " rows in " << after << "ms (scan without index: " << before << "ms)" << endl;
+    if (count != expected)
+    {
+      cerr << "filter " << filter << ": expected " << expected << " rows" << endl;
+      ok = false;
+    }
+  }
+
+  // type without waiting: only the last result is applied
+  packageProxyModel.SetFilter("");
+  start = chrono::steady_clock::now();
+  for (const string& filter : typed)
+  {
+    packageProxyModel.SetFilter(filter);
+  }
+  loop.exec();
+  cout << "burst of " << typed.size() << " keys: " << Milliseconds(start) << "ms" << endl;
+  if (packageProxyModel.rowCount() != CountMatches(packages, typed.back()))
+  {
+    cerr << "burst: wrong number of rows" << endl;
+    ok = false;
+  }
+
+  packageProxyModel.SetFilter("");
+  for (int column : { 0, 2, 6 })
+  {
+    start = chrono::steady_clock::now();
+    packageProxyModel.sort(column, Qt::AscendingOrder);
+    cout << "sort by column " << column << ": " << Milliseconds(start) << "ms" << endl;
+  }
+
+  return ok ? 0 : 1;
+}
@@ -247,6 +247,9 @@ private:
 private:
   void FindConflicts();
 
+private:
+  void FindPackages(const string& fileName);
+
 private:
   void ImportPackage(const string& packageId, vector<string>& toBeinstalled);
 
@@ -388,6 +391,7 @@ enum Option
   OPT_CHECK_REPOSITORIES,       // EXPERIMENTAL
   OPT_CSV,                      // deprecated
   OPT_FIND_CONFLICTS,           // internal
+  OPT_FIND_PACKAGES,
   OPT_FIND_UPDATES,
   OPT_FIND_UPGRADES,
   OPT_HHELP,
@@ -456,6 +460,12 @@ const struct poptOption Application::aoption[] = {
     nullptr,
   },
 
+  {
+    "find-packages", 0, POPT_ARG_STRING, nullptr, OPT_FIND_PACKAGES,
+    T_("Print the packages which contain the specified file."),
+    T_("FILE")
+  },
+
   {
     "find-updates", 0, POPT_ARG_NONE, nullptr, OPT_FIND_UPDATES,
     T_("Test the package repository for updates, then print the list of updateable packages."),
@@ -897,40 +907,26 @@ void Application::RegisterComponents(bool doRegister)
 
 void Application::FindConflicts()
 {
-  map<string, vector<string> > filesAndPackages;
-  unique_ptr<PackageIterator> packageIterator(packageManager->CreateIterator());
-  PackageInfo packageInfo;
-  while (packageIterator->GetNext(packageInfo))
+  for (const auto& conflict : packageManager->FindFileConflicts())
   {
-    for (const string& fileName : packageInfo.runFiles)
-    {
-      PathName file(fileName);
-      file.TransformForComparison();
-      filesAndPackages[file.GetData()].push_back(packageInfo.id);
-    }
-    for (const string& fileName : packageInfo.docFiles)
+    cout << conflict.first << endl;
+    for (const string& packageId : conflict.second)
     {
-      PathName file(fileName);
-      file.TransformForComparison();
-      filesAndPackages[file.GetData()].push_back(packageInfo.id);
-    }
-    for (const string& fileName : packageInfo.sourceFiles)
-    {
-      PathName file(fileName);
-      file.TransformForComparison();
-      filesAndPackages[file.GetData()].push_back(packageInfo.id);
+      cout << "  " << packageId << endl;
     }
   }
-  for (const auto& package : filesAndPackages)
+}
+
+void Application::FindPackages(const string& fileName)
+{
+  vector<string> packages = packageManager->FindPackagesContainingFile(fileName);
+  if (packages.empty())
+  {
+    Error(fmt::format(T_("No package contains {0}."), Q_(fileName)));
+  }
+  for (const string& packageId : packages)
   {
-    if (package.second.size() > 1)
-    {
-      cout << package.first << endl;
-      for (const string& fileName : package.second)
-      {
-        cout << "  " << fileName << endl;
-      }
-    }
+    cout << packageId << endl;
   }
 }
 
@@ -967,14 +963,11 @@ void Application::Verify(const vector<string>& toBeVerifiedArg)
       }
     }
   }
-  bool ok = true;
-  for (const string& packageId : toBeVerified)
+  vector<string> brokenPackages = packageManager->VerifyInstalledPackages(toBeVerified);
+  bool ok = brokenPackages.empty();
+  for (const string& packageId : brokenPackages)
   {
-    if (!packageManager->TryVerifyInstalledPackage(packageId))
-    {
-      Message(fmt::format(T_("{0}: this package needs to be reinstalled."), packageId));
-      ok = false;
-    }
+    Message(fmt::format(T_("{0}: this package needs to be reinstalled."), packageId));
   }
   if (ok)
   {
@@ -1511,6 +1504,7 @@ void Application::Main(int argc, const char** argv)
   bool optAdmin = false;
   bool optCheckRepositories = false;
   bool optFindConflicts = false;
+  bool optFindPackages = false;
   bool optFindUpdates = false;
   bool optFindUpgrades = false;
   bool optImport = false;
@@ -1538,6 +1532,7 @@ void Application::Main(int argc, const char** argv)
 #endif
   OutputFormat outputFormat(OutputFormat::Listing);
   string packageId;
+  string fileName;
   string optProxy;
   string optProxyPassword;
   string optProxyUser;
@@ -1595,6 +1590,10 @@ void Application::Main(int argc, const char** argv)
     case OPT_FIND_CONFLICTS:
       optFindConflicts = true;
       break;
+    case OPT_FIND_PACKAGES:
+      optFindPackages = true;
+      fileName = optArg;
+      break;
     case OPT_FIND_UPDATES:
       optFindUpdates = true;
       break;
@@ -2062,6 +2061,12 @@ void Application::Main(int argc, const char** argv)
     restartWindowed = false;
   }
 
+  if (optFindPackages)
+  {
+    FindPackages(fileName);
+    restartWindowed = false;
+  }
+
   if (optVerifyMiKTeX)
   {
     VerifyMiKTeX();
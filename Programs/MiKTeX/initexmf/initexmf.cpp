@@ -1769,73 +1769,11 @@ void IniTeXMFApp::MakeLanguageDat(bool force)
     return;
   }
 
-  PathName languageDatPath = session->GetSpecialPath(SpecialPath::ConfigRoot) / PathName(MIKTEX_PATH_LANGUAGE_DAT);
-  ofstream languageDat = File::CreateOutputStream(languageDatPath);
-
-  PathName languageDatLuaPath = session->GetSpecialPath(SpecialPath::ConfigRoot) / PathName(MIKTEX_PATH_LANGUAGE_DAT_LUA);
-  ofstream languageDatLua = File::CreateOutputStream(languageDatLuaPath);
-
-  PathName languageDefPath = session->GetSpecialPath(SpecialPath::ConfigRoot) / PathName(MIKTEX_PATH_LANGUAGE_DEF);
-  ofstream languageDef = File::CreateOutputStream(languageDefPath);
-
-  languageDatLua << "return {" << "\n";
-  languageDef << "%% e-TeX V2.2" << "\n";
-
-  for (const LanguageInfo& languageInfo : session->GetLanguages())
-  {
-    if (languageInfo.exclude)
-    {
-      continue;
-    }
-
-    PathName loaderPath;
-    if (!session->FindFile(languageInfo.loader, "%r/tex//", loaderPath))
-    {
-      continue;
-    }
-
-    // language.dat
-    languageDat << languageInfo.key << " " << languageInfo.loader << "\n";
-    for (const string& synonym : StringUtil::Split(languageInfo.synonyms, ','))
-    {
-      languageDat << "=" << synonym << "\n";
-    }
-
-    // language.def
-    languageDef << "\\addlanguage{" << languageInfo.key << "}{" << languageInfo.loader << "}{}{" << languageInfo.lefthyphenmin << "}{" << languageInfo.righthyphenmin << "}" << "\n";
-
-    // language.dat.lua
-    languageDatLua << "\t['" << languageInfo.key << "'] = {" << "\n";
-    languageDatLua << "\t\tloader='" << languageInfo.loader << "'," << "\n";
-    languageDatLua << "\t\tlefthyphenmin=" << languageInfo.lefthyphenmin << "," << "\n";
-    languageDatLua << "\t\trighthyphenmin=" << languageInfo.righthyphenmin << "," << "\n";
-    languageDatLua << "\t\tsynonyms={ ";
-    int nSyn = 0;
-    for (const string& synonym : StringUtil::Split(languageInfo.synonyms, ','))
-    {
-      languageDatLua << (nSyn > 0 ? "," : "") << "'" << synonym << "'";
-      nSyn++;
-    }
-    languageDatLua << " }," << "\n";
-    languageDatLua << "\t\tpatterns='" << languageInfo.patterns << "'," << "\n";
-    languageDatLua << "\t\thyphenation='" << languageInfo.hyphenation << "'," << "\n";
-    if (!languageInfo.luaspecial.empty())
-    {
-      languageDatLua << "\t\tspecial='" << languageInfo.luaspecial << "'," << "\n";
-    }
-    languageDatLua << "\t}," << "\n";
-  }
-
-  languageDatLua << "}" << "\n";
-
-  languageDatLua.close();
-  Fndb::Add({ {languageDatLuaPath} });
-
-  languageDef.close();
-  Fndb::Add({ {languageDefPath} });
-
-  languageDat.close();
-  Fndb::Add({ {languageDatPath} });
+  MaintenanceOptions options;
+  options.tasks = { MaintenanceTask::MakeLanguageDat };
+  options.force = true;
+  options.packageManager = packageManager;
+  SetupService::RunMaintenance(options);
 }
 
 void IniTeXMFApp::MakeMaps(bool force)
@@ -0,0 +1,422 @@
+/* DocIndex.cpp:
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is a part of MTHelp.
+
+   MTHelp is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   MTHelp is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with MTHelp; if not, write to the Free Software Foundation,
+   59 Temple Place - Suite 330, Boston, MA 02111-1307, USA. */
+
+#if defined(HAVE_CONFIG_H)
+#  include <config.h>
+#endif
+
+#include <algorithm>
+#include <set>
+
+#include <miktex/Core/ConfigNames>
+#include <miktex/Core/Directory>
+#include <miktex/Core/DirectoryLister>
+#include <miktex/Core/File>
+#include <miktex/Core/Fndb>
+#include <miktex/Core/Paths>
+#include <miktex/Core/StreamReader>
+#include <miktex/Core/StreamWriter>
+#include <miktex/PackageManager/PackageIterator>
+#include <miktex/Core/Utils>
+
+#include "DocIndex.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Packages;
+using namespace MiKTeX::Util;
+
+#define DOC_INDEX_FILE_NAME "docindex.tsv"
+#define DOC_INDEX_SIGNATURE "# MiKTeX documentation index 1"
+
+namespace {
+  bool SkipPrefix(const string& str, const char* prefix, string& result)
+  {
+    size_t n = StrLen(prefix);
+    if (str.compare(0, n, prefix) != 0)
+    {
+      return false;
+    }
+    result = str.substr(n);
+    return true;
+  }
+
+  bool SkipTeXMFPrefix(const string& str, string& result)
+  {
+    return SkipPrefix(str, "texmf/", result)
+      || SkipPrefix(str, "texmf\\", result)
+      || SkipPrefix(str, "./texmf/", result)
+      || SkipPrefix(str, ".\\texmf\\", result);
+  }
+
+  const set<string> languageCodes = {
+    "cs", "da", "de", "el", "en", "es", "fi", "fr", "hu", "it", "ja", "ko",
+    "nl", "no", "pl", "pt", "ru", "sk", "sl", "sv", "tr", "uk", "zh"
+  };
+
+  // guess the language from the file name ("foo-de.pdf", "foo_fr.pdf")
+  // or from the name of the containing directory (".../de/foo.pdf")
+  string GuessLanguage(const string& relPath)
+  {
+    PathName path(relPath);
+    string stem = path.GetFileNameWithoutExtension().ToString();
+    size_t pos = stem.find_last_of("-_");
+    if (pos != string::npos)
+    {
+      string code = Utils::MakeLower(stem.substr(pos + 1));
+      if (languageCodes.find(code) != languageCodes.end())
+      {
+        return code;
+      }
+    }
+    PathName dir = path;
+    dir.RemoveFileSpec();
+    string code = Utils::MakeLower(dir.GetFileName().ToString());
+    if (languageCodes.find(code) != languageCodes.end())
+    {
+      return code;
+    }
+    return "";
+  }
+
+  vector<string> Split(const string& line)
+  {
+    vector<string> fields;
+    size_t start = 0;
+    for (size_t pos = line.find('\t'); pos != string::npos; pos = line.find('\t', start))
+    {
+      fields.push_back(line.substr(start, pos - start));
+      start = pos + 1;
+    }
+    fields.push_back(line.substr(start));
+    return fields;
+  }
+}
+
+string DocIndex::MakeKey(const string& name)
+{
+  PathName key(name);
+  return key.TransformForComparison().ToString();
+}
+
+string DocIndex::GetPackagesStamp()
+{
+  string stamp;
+  vector<PathName> manifests;
+  if (!session->IsAdminMode())
+  {
+    manifests.push_back(session->GetSpecialPath(SpecialPath::UserInstallRoot) / PathName(MIKTEX_PATH_PACKAGE_MANIFESTS_INI));
+  }
+  manifests.push_back(session->GetSpecialPath(SpecialPath::CommonInstallRoot) / PathName(MIKTEX_PATH_PACKAGE_MANIFESTS_INI));
+  for (const PathName& path : manifests)
+  {
+    if (!stamp.empty())
+    {
+      stamp += ',';
+    }
+    stamp += File::Exists(path) ? std::to_string(File::GetLastWriteTime(path)) : "-";
+  }
+  return stamp;
+}
+
+string DocIndex::GetRootStamp(unsigned r)
+{
+  PathName fndbPath = session->GetFilenameDatabasePathName(r);
+  // no file name database: the doc tree has to be walked each time
+  if (!File::Exists(fndbPath))
+  {
+    return "";
+  }
+  string stamp = std::to_string(File::GetLastWriteTime(fndbPath));
+  // files added or removed after the database was written are recorded
+  // in the change file
+  PathName changeFile = fndbPath;
+  changeFile.SetExtension(MIKTEX_FNDB_CHANGE_FILE_SUFFIX);
+  if (File::Exists(changeFile))
+  {
+    stamp += "," + std::to_string(File::GetSize(changeFile)) + ":" + std::to_string(File::GetLastWriteTime(changeFile));
+  }
+  return stamp;
+}
+
+bool DocIndex::IsDocFileType(const string& extension) const
+{
+  for (const string& ext : docExtensions)
+  {
+    if (PathName::Compare(PathName(ext), PathName(extension)) == 0)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+void DocIndex::Open(bool rebuild)
+{
+  docExtensions = session->GetConfigValue(MIKTEX_CONFIG_SECTION_CORE_FILETYPES + ".TeX system documentation"s, MIKTEX_CONFIG_VALUE_EXTENSIONS).GetStringArray();
+  indexPath = session->GetSpecialPath(SpecialPath::DataRoot) / PathName(MIKTEX_PATH_MIKTEX_MTHELP_DIR) / PathName(DOC_INDEX_FILE_NAME);
+  packagesSource.id = "packages";
+  packagesSource.stamp = GetPackagesStamp();
+  unsigned numRoots = session->GetNumberOfTEXMFRoots();
+  rootSources.resize(numRoots);
+  rootDocFiles.resize(numRoots);
+  for (unsigned r = 0; r < numRoots; ++r)
+  {
+    rootSources[r].id = session->GetRootDirectoryPath(r).ToUnix().ToString();
+    rootSources[r].stamp = GetRootStamp(r);
+  }
+  if (!rebuild && File::Exists(indexPath))
+  {
+    Load();
+  }
+  bool modified = false;
+  if (packagesSource.dirty)
+  {
+    UpdatePackages();
+    modified = true;
+  }
+  for (unsigned r = 0; r < numRoots; ++r)
+  {
+    if (rootSources[r].dirty)
+    {
+      UpdateRoot(r);
+      modified = true;
+    }
+  }
+  if (modified)
+  {
+    Save();
+  }
+  for (unsigned r = 0; r < numRoots; ++r)
+  {
+    for (const string& relPath : rootDocFiles[r])
+    {
+      relPathToRoot.insert(make_pair(MakeKey(relPath), r));
+      byName[MakeKey(PathName(relPath).GetFileNameWithoutExtension().ToString())].push_back(make_pair(r, relPath));
+    }
+  }
+}
+
+void DocIndex::Load()
+{
+  StreamReader reader(indexPath);
+  string line;
+  if (!reader.ReadLine(line) || line != DOC_INDEX_SIGNATURE)
+  {
+    return;
+  }
+  // records of sources which are out of date are skipped
+  Source* current = nullptr;
+  unsigned currentRoot = 0;
+  while (reader.ReadLine(line))
+  {
+    vector<string> fields = Split(line);
+    if (fields[0] == "S" && fields.size() == 3)
+    {
+      current = nullptr;
+      if (fields[1] == packagesSource.id && fields[2] == packagesSource.stamp)
+      {
+        current = &packagesSource;
+      }
+      else
+      {
+        for (unsigned r = 0; r < rootSources.size(); ++r)
+        {
+          if (fields[1] == rootSources[r].id && fields[2] == rootSources[r].stamp && !fields[2].empty())
+          {
+            current = &rootSources[r];
+            currentRoot = r;
+            break;
+          }
+        }
+      }
+      if (current != nullptr)
+      {
+        current->dirty = false;
+      }
+    }
+    else if (current == nullptr)
+    {
+      continue;
+    }
+    else if (fields[0] == "P" && fields.size() == 3 && current == &packagesSource)
+    {
+      packageDocFiles[fields[1]].push_back(fields[2]);
+    }
+    else if (fields[0] == "F" && fields.size() == 2 && current != &packagesSource)
+    {
+      rootDocFiles[currentRoot].push_back(fields[1]);
+    }
+  }
+  reader.Close();
+}
+
+void DocIndex::Save()
+{
+  PathName dir = indexPath;
+  dir.RemoveFileSpec();
+  Directory::Create(dir);
+  PathName tmpPath = indexPath;
+  tmpPath.AppendExtension(".tmp");
+  StreamWriter writer(tmpPath);
+  writer.WriteLine(DOC_INDEX_SIGNATURE);
+  writer.WriteLine("S\t" + packagesSource.id + "\t" + packagesSource.stamp);
+  for (const auto& p : packageDocFiles)
+  {
+    for (const string& relPath : p.second)
+    {
+      writer.WriteLine("P\t" + p.first + "\t" + relPath);
+    }
+  }
+  for (unsigned r = 0; r < rootSources.size(); ++r)
+  {
+    writer.WriteLine("S\t" + rootSources[r].id + "\t" + rootSources[r].stamp);
+    for (const string& relPath : rootDocFiles[r])
+    {
+      writer.WriteLine("F\t" + relPath);
+    }
+  }
+  writer.Close();
+  if (File::Exists(indexPath))
+  {
+    File::Delete(indexPath);
+  }
+  File::Move(tmpPath, indexPath);
+}
+
+void DocIndex::UpdatePackages()
+{
+  packageDocFiles.clear();
+  unique_ptr<PackageIterator> packageIterator(packageManager->CreateIterator());
+  PackageInfo packageInfo;
+  while (packageIterator->GetNext(packageInfo))
+  {
+    for (const string& fileName : packageInfo.docFiles)
+    {
+      string relPath;
+      if (SkipTeXMFPrefix(fileName, relPath) && IsDocFileType(PathName(relPath).GetExtension()))
+      {
+        packageDocFiles[packageInfo.id].push_back(PathName(relPath).ToUnix().ToString());
+      }
+    }
+  }
+}
+
+void DocIndex::UpdateRoot(unsigned r)
+{
+  rootDocFiles[r].clear();
+  PathName root = session->GetRootDirectoryPath(r);
+  PathName docDir = root / PathName(MIKTEX_PATH_DOC_DIR);
+  vector<Fndb::Record> records;
+  if (Fndb::Enumerate(docDir, records))
+  {
+    for (const Fndb::Record& record : records)
+    {
+      if (IsDocFileType(record.path.GetExtension()))
+      {
+        rootDocFiles[r].push_back(PathName(Utils::GetRelativizedPath(record.path.GetData(), root.GetData())).ToUnix().ToString());
+      }
+    }
+    sort(rootDocFiles[r].begin(), rootDocFiles[r].end());
+  }
+  else if (Directory::Exists(docDir))
+  {
+    // no file name database
+    CollectDocFiles(root, PathName(MIKTEX_PATH_DOC_DIR), rootDocFiles[r]);
+  }
+}
+
+void DocIndex::CollectDocFiles(const PathName& root, const PathName& relDir, vector<string>& files)
+{
+  unique_ptr<DirectoryLister> lister = DirectoryLister::Open(root / relDir);
+  vector<PathName> subDirs;
+  DirectoryEntry entry;
+  while (lister->GetNext(entry))
+  {
+    PathName relPath = relDir / PathName(entry.name);
+    if (entry.isDirectory)
+    {
+      subDirs.push_back(relPath);
+    }
+    else if (IsDocFileType(relPath.GetExtension()))
+    {
+      files.push_back(relPath.ToUnix().ToString());
+    }
+  }
+  lister->Close();
+  for (const PathName& subDir : subDirs)
+  {
+    CollectDocFiles(root, subDir, files);
+  }
+}
+
+DocFile DocIndex::MakeDocFile(unsigned r, const string& relPath) const
+{
+  DocFile docFile;
+  docFile.path = session->GetRootDirectoryPath(r) / PathName(relPath);
+  string ext = PathName(relPath).GetExtension();
+  docFile.type = ext.empty() ? ext : ext.substr(1);
+  docFile.language = GuessLanguage(relPath);
+  return docFile;
+}
+
+vector<DocFile> DocIndex::FindByName(const string& name) const
+{
+  // same result as searching <name><ext> for each documentation file
+  // type: the first match (in root order) for each file type
+  vector<DocFile> result;
+  auto it = byName.find(MakeKey(name));
+  if (it == byName.end())
+  {
+    return result;
+  }
+  for (const string& ext : docExtensions)
+  {
+    for (const auto& p : it->second)
+    {
+      if (PathName::Compare(PathName(PathName(p.second).GetExtension()), PathName(ext)) == 0)
+      {
+        result.push_back(MakeDocFile(p.first, p.second));
+        break;
+      }
+    }
+  }
+  return result;
+}
+
+vector<DocFile> DocIndex::FindByPackage(const string& packageName) const
+{
+  vector<DocFile> result;
+  auto it = packageDocFiles.find(packageName);
+  if (it == packageDocFiles.end())
+  {
+    return result;
+  }
+  for (const string& relPath : it->second)
+  {
+    auto it2 = relPathToRoot.find(MakeKey(relPath));
+    if (it2 != relPathToRoot.end())
+    {
+      result.push_back(MakeDocFile(it2->second, relPath));
+    }
+  }
+  return result;
+}
@@ -0,0 +1,142 @@
+/* DocIndex.h:                                          -*- C++ -*-
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is a part of MTHelp.
+
+   MTHelp is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   MTHelp is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with MTHelp; if not, write to the Free Software Foundation,
+   59 Temple Place - Suite 330, Boston, MA 02111-1307, USA. */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <miktex/Core/PathName>
+#include <miktex/Core/Session>
+#include <miktex/PackageManager/PackageManager>
+
+struct DocFile
+{
+  /// File system path of the documentation file.
+  MiKTeX::Core::PathName path;
+
+  /// File type (the file name extension without the dot).
+  std::string type;
+
+  /// Two-letter language code; empty, if unknown.
+  std::string language;
+};
+
+/// Persistent index of the installed documentation files.
+///
+/// The index maps file names (without extension) and package names to
+/// documentation files. It is built from the package manifests and
+/// the file name databases of the TEXMF roots (a root without a file
+/// name database has its doc tree walked). Each source carries a stamp
+/// (the modification time of package-manifests.ini resp. of the
+/// root's file name database); only sources whose stamp has changed
+/// are re-read when the index is opened.
+class DocIndex
+{
+public:
+  DocIndex(std::shared_ptr<MiKTeX::Core::Session> session, std::shared_ptr<MiKTeX::Packages::PackageManager> packageManager) :
+    session(session),
+    packageManager(packageManager)
+  {
+  }
+
+public:
+  void Open(bool rebuild);
+
+public:
+  std::vector<DocFile> FindByName(const std::string& name) const;
+
+public:
+  std::vector<DocFile> FindByPackage(const std::string& packageName) const;
+
+private:
+  struct Source
+  {
+    std::string id;
+    std::string stamp;
+    bool dirty = true;
+  };
+
+private:
+  void Load();
+
+private:
+  void Save();
+
+private:
+  void UpdatePackages();
+
+private:
+  void UpdateRoot(unsigned r);
+
+private:
+  void CollectDocFiles(const MiKTeX::Core::PathName& root, const MiKTeX::Core::PathName& relDir, std::vector<std::string>& files);
+
+private:
+  bool IsDocFileType(const std::string& extension) const;
+
+private:
+  DocFile MakeDocFile(unsigned r, const std::string& relPath) const;
+
+private:
+  std::string GetPackagesStamp();
+
+private:
+  std::string GetRootStamp(unsigned r);
+
+private:
+  static std::string MakeKey(const std::string& name);
+
+private:
+  MiKTeX::Core::PathName indexPath;
+
+private:
+  std::vector<std::string> docExtensions;
+
+private:
+  Source packagesSource;
+
+private:
+  // package ID => TEXMF-relative doc files
+  std::unordered_map<std::string, std::vector<std::string>> packageDocFiles;
+
+private:
+  std::vector<Source> rootSources;
+
+private:
+  // per root: TEXMF-relative doc files
+  std::vector<std::vector<std::string>> rootDocFiles;
+
+private:
+  // TEXMF-relative doc file => first root which has it
+  std::unordered_map<std::string, unsigned> relPathToRoot;
+
+private:
+  // file name (without extension) => (root, TEXMF-relative doc file)
+  std::unordered_map<std::string, std::vector<std::pair<unsigned, std::string>>> byName;
+
+private:
+  std::shared_ptr<MiKTeX::Core::Session> session;
+
+private:
+  std::shared_ptr<MiKTeX::Packages::PackageManager> packageManager;
+};
@@ -59,6 +59,8 @@ using namespace std;
 
 #include "template.html.h"
 
+#include "DocIndex.h"
+
 #define T_(x) MIKTEXTEXT(x)
 #define Q_(x) MiKTeX::Core::Quoter<char>(x).GetData()
 
@@ -112,6 +114,9 @@ private:
 private:
   bool quiet = false;
 
+private:
+  unique_ptr<DocIndex> docIndex;
+
 private:
   shared_ptr<Session> session;
 
@@ -126,8 +131,10 @@ enum Option
 {
   OPT_AAA = 256,
   OPT_LIST_ONLY,
+  OPT_NO_INDEX,
   OPT_PRINT_ONLY,
   OPT_QUIET,
+  OPT_REBUILD_INDEX,
   OPT_VERSION,
   OPT_VIEW,
 };
@@ -138,6 +145,11 @@ const struct poptOption MiKTeXHelp::aoption[] = {
     T_("List documentation files but do not start a viewer."),
     nullptr
   },
+  {
+    "no-index", 0, POPT_ARG_NONE, nullptr, OPT_NO_INDEX,
+    T_("Search the file system instead of the documentation index."),
+    nullptr
+  },
   {
     "print-only", 'n', POPT_ARG_NONE, nullptr, OPT_PRINT_ONLY,
     T_("Print the commands that would be executed, but do not execute them."),
@@ -148,6 +160,11 @@ const struct poptOption MiKTeXHelp::aoption[] = {
     T_("Suppress all output (except errors)."),
     nullptr
   },
+  {
+    "rebuild-index", 0, POPT_ARG_NONE, nullptr, OPT_REBUILD_INDEX,
+    T_("Rebuild the documentation index from scratch."),
+    nullptr
+  },
   {
     "version", 0, POPT_ARG_NONE, nullptr, OPT_VERSION,
     T_("Show version information and exit."),
@@ -209,6 +226,14 @@ bool MiKTeXHelp::SkipTeXMFPrefix(const string& str, string& result)
 
 void MiKTeXHelp::FindDocFilesByPackage(const string& packageName, map<string, vector<string>>& filesByExtension)
 {
+  if (docIndex != nullptr)
+  {
+    for (const DocFile& docFile : docIndex->FindByPackage(packageName))
+    {
+      filesByExtension[docFile.path.GetExtension()].push_back(docFile.path.ToString());
+    }
+    return;
+  }
   PackageInfo pi;
   if (!pManager->TryGetPackageInfo(packageName, pi))
   {
@@ -259,6 +284,14 @@ void MiKTeXHelp::FindDocFilesByPackage(const string& packageName, vector<string>
 
 void MiKTeXHelp::FindDocFilesByName(const string& name, vector<string>& files)
 {
+  if (docIndex != nullptr)
+  {
+    for (const DocFile& docFile : docIndex->FindByName(name))
+    {
+      files.push_back(docFile.path.ToString());
+    }
+    return;
+  }
   vector<string> extensions = session->GetConfigValue(MIKTEX_CONFIG_SECTION_CORE_FILETYPES + ".TeX system documentation"s, MIKTEX_CONFIG_VALUE_EXTENSIONS).GetStringArray();
   string searchSpec = MIKTEX_PATH_TEXMF_PLACEHOLDER_NO_MPM;
   searchSpec += MIKTEX_PATH_DIRECTORY_DELIMITER_STRING;
@@ -481,6 +514,8 @@ void MiKTeXHelp::WriteText(StreamWriter& writer, const string& text)
 void MiKTeXHelp::Run(int argc, const char** argv)
 {
   bool optListOnly = false;
+  bool optNoIndex = false;
+  bool optRebuildIndex = false;
   bool optView = false;
 
   PoptWrapper popt(argc, argv, aoption);
@@ -495,12 +530,18 @@ void MiKTeXHelp::Run(int argc, const char** argv)
     case OPT_LIST_ONLY:
       optListOnly = true;
       break;
+    case OPT_NO_INDEX:
+      optNoIndex = true;
+      break;
     case OPT_PRINT_ONLY:
       printOnly = true;
       break;
     case OPT_QUIET:
       quiet = true;
       break;
+    case OPT_REBUILD_INDEX:
+      optRebuildIndex = true;
+      break;
     case OPT_VERSION:
       ShowVersion();
       throw (0);
@@ -520,11 +561,17 @@ void MiKTeXHelp::Run(int argc, const char** argv)
 
   vector<string> leftovers = popt.GetLeftovers();
 
-  if (leftovers.empty())
+  if (leftovers.empty() && !optRebuildIndex)
   {
     FatalError(T_("Missing NAME argument."));
   }
 
+  if (!optNoIndex)
+  {
+    docIndex = make_unique<DocIndex>(session, pManager);
+    docIndex->Open(optRebuildIndex);
+  }
+
   for (const string& name : leftovers)
   {
     vector<string> filesByPackage;
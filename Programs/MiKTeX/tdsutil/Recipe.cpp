@@ -21,15 +21,21 @@
 #  include <config.h>
 #endif
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <exception>
 #include <iostream>
+#include <thread>
 #include <unordered_set>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
-#include <miktex/Core/CommandLineBuilder>
 #include <miktex/Core/Directory>
 #include <miktex/Core/DirectoryLister>
+#include <miktex/Core/File>
+#include <miktex/Core/FileStream>
 #include <miktex/Core/Process>
 #include <miktex/Core/Quoter>
 #include <miktex/Core/StreamWriter>
@@ -44,16 +50,6 @@
 using namespace MiKTeX::Core;
 using namespace std;
 
-class ProcessOutputTrash :
-  public IRunProcessCallback
-{
-public:
-  bool MIKTEXTHISCALL OnProcessOutput(const void* pOutput, size_t n) override
-  {
-    return true;
-  }
-};
-
 void CollectPathNames(vector<PathName>& pathNames, const PathName& dir, const string& pattern)
 {
   unique_ptr<DirectoryLister> lister = DirectoryLister::Open(dir, pattern.c_str());
@@ -123,11 +119,18 @@ vector<string> Split(const string& s)
   return argv;
 }
 
+mutex Recipe::sessionMutex;
+
+string Recipe::Expand(const string& s)
+{
+  return session->Expand(s, this);
+}
+
 void Recipe::Verbose(const string& message)
 {
   if (verbose)
   {
-    cout << message << endl;
+    *out << message << endl;
   }
 }
 
@@ -135,7 +138,7 @@ bool Recipe::PrintOnly(const string& message)
 {
   if (printOnly)
   {
-    cout << message << endl;
+    *out << message << endl;
   }
   return printOnly;
 }
@@ -150,6 +153,8 @@ void Recipe::CreateDirectory(const PathName& path)
 
 void Recipe::Execute(bool printOnly)
 {
+  unique_lock<mutex> lock(sessionMutex);
+  sessionLock = &lock;
   this->printOnly = printOnly;
   if (format.empty())
   {
@@ -167,7 +172,7 @@ void Recipe::Execute(bool printOnly)
     }
     SetFoundry(foundry);
   }
-  if (Directory::Exists(destDir))
+  if (!sharedDestDir && Directory::Exists(destDir))
   {
     MIKTEX_FATAL_ERROR("destination directory alread exists");
   }
@@ -286,7 +291,7 @@ void Recipe::WriteFiles()
 
 void Recipe::DoAction(const string& action, const PathName& actionDir)
 {
-  vector<string> argv = Split(session->Expand(action, this));
+  vector<string> argv = Split(Expand(action));
   if (argv.empty())
   {
     MIKTEX_UNEXPECTED();
@@ -365,9 +370,9 @@ void Recipe::DoAction(const string& action, const PathName& actionDir)
   {
     for (int idx = 1; idx < argv.size(); ++ idx)
     {
-      cout << (idx == 1 ? "! " : " ") << argv[idx];
+      *out << (idx == 1 ? "! " : " ") << argv[idx];
     }
-    cout << endl;
+    *out << endl;
   }
   else if (actionName == "abort")
   {
@@ -375,7 +380,7 @@ void Recipe::DoAction(const string& action, const PathName& actionDir)
     {
       MIKTEX_FATAL_ERROR(T_("syntax error (action)"));
     }
-    cerr << "aborting" << endl;
+    *err << "aborting" << endl;
     throw 1;
   }
   else
@@ -424,8 +429,13 @@ void Recipe::Unpack(const PathName& path)
   }
 }
 
-void Recipe::RunInsEngine(const string& engine, const vector<string>& options, const PathName& insFile, const PathName& outDir )
+void Recipe::RunInsEngine(const string& engine, const vector<string>& options, const PathName& insFile, const PathName& outDir, const PathName& auxDir, unique_lock<mutex>& lock)
 {
+  PathName enginePath;
+  if (!session->FindFile(engine, FileType::EXE, enginePath))
+  {
+    MIKTEX_FATAL_ERROR_2(T_("The .ins engine could not be found."), "engine", engine);
+  }
   unique_ptr<TemporaryFile> alwaysYes = TemporaryFile::Create();
   StreamWriter writer(alwaysYes->GetPathName());
   for (int i = 0; i < 100; ++i)
@@ -433,17 +443,27 @@ void Recipe::RunInsEngine(const string& engine, const vector<string>& options, c
     writer.WriteLine("y");
   }
   writer.Close();
-  CommandLineBuilder cmd;
-  cmd.AppendArgument(engine);
-  cmd.AppendOption("-disable-installer");
-  cmd.AppendOption("-output-directory=", outDir);
-  cmd.AppendOption("-aux-directory=", workDir);
-  cmd.AppendArguments(options);
-  cmd.AppendArgument(insFile);
-  cmd.AppendStdinRedirection(alwaysYes->GetPathName());
-  ProcessOutputTrash trash;
+  FileStream alwaysYesStream(File::Open(alwaysYes->GetPathName(), FileMode::Open, FileAccess::Read, false));
+  ProcessStartInfo startInfo(enginePath);
+  startInfo.Arguments = { engine, "-disable-installer", "-output-directory=" + outDir.ToString(), "-aux-directory=" + auxDir.ToString() };
+  startInfo.Arguments.insert(startInfo.Arguments.end(), options.begin(), options.end());
+  startInfo.Arguments.push_back(insFile.ToString());
+  startInfo.StandardInput = alwaysYesStream.GetFile();
+  startInfo.RedirectStandardOutput = true;
+  startInfo.WorkingDirectory = workDir.ToString();
   Verbose("running .ins engine on '" + insFile.GetFileName().ToString() + "'");
-  Process::ExecuteSystemCommand(cmd.ToString(), nullptr, &trash, workDir.GetData());
+  unique_ptr<Process> process = Process::Start(startInfo);
+  FileStream engineOutput(process->get_StandardOutput());
+  // other recipes may use the session while the engine runs
+  lock.unlock();
+  char buf[4096];
+  while (fread(buf, 1, sizeof(buf), engineOutput.GetFile()) > 0)
+  {
+  }
+  process->WaitForExit();
+  lock.lock();
+  engineOutput.Close();
+  process->Close();
 }
 
 void Recipe::RunDtxUnpacker()
@@ -466,7 +486,7 @@ void Recipe::RunDtxUnpacker()
   vector<PathName> insFiles;
   for (const string& pat : patterns)
   {
-    PathName pattern(session->Expand(pat, this));
+    PathName pattern(Expand(pat));
     PathName dir(workDir);
     dir /= pattern;
     dir.RemoveFileSpec();
@@ -481,7 +501,7 @@ void Recipe::RunDtxUnpacker()
     }
     for (const string& pat : patterns)
     {
-      PathName pattern(session->Expand(pat, this));
+      PathName pattern(Expand(pat));
       PathName dir(workDir);
       dir /= pattern;
       dir.RemoveFileSpec();
@@ -493,17 +513,100 @@ void Recipe::RunDtxUnpacker()
   packageInsFile /= package + ".ins";
   bool packageInsFileExists = File::Exists(packageInsFile);
   unique_ptr<TemporaryDirectory> outDir = TemporaryDirectory::Create();
+  string parallel;
+  if (maxJobs > 1 && insFiles.size() > 1 && !(recipe->TryGetValueAsString("ins", "parallel", parallel) && (parallel == "false" || parallel == "0")))
+  {
+    RunInsEngines(engine, options, insFiles, outDir->GetPathName());
+    if (!packageInsFileExists && File::Exists(packageInsFile))
+    {
+      Verbose("re-running .ins engine because '" + package + ".ins' has been unpacked");
+      RunInsEngine(engine, options, packageInsFile, outDir->GetPathName(), workDir, *sessionLock);
+    }
+    return;
+  }
   for (const PathName& insFile : insFiles)
   {
-    RunInsEngine(engine, options, insFile, outDir->GetPathName());
+    RunInsEngine(engine, options, insFile, outDir->GetPathName(), workDir, *sessionLock);
     if (!packageInsFileExists)
     {
       packageInsFileExists = File::Exists(packageInsFile);
       if (packageInsFileExists)
       {
         Verbose("re-running .ins engine because '" + package + ".ins' has been unpacked");
-        RunInsEngine(engine, options, packageInsFile, outDir->GetPathName());
+        RunInsEngine(engine, options, packageInsFile, outDir->GetPathName(), workDir, *sessionLock);
+      }
+    }
+  }
+}
+
+void Recipe::RunInsEngines(const string& engine, const vector<string>& options, const vector<PathName>& insFiles, const PathName& outDir)
+{
+  // each engine run writes its generated files into a private
+  // directory; the results are merged in .ins file order so that the
+  // outcome is the same as with sequential runs
+  vector<unique_ptr<TemporaryDirectory>> auxDirs;
+  for (size_t idx = 0; idx < insFiles.size(); ++idx)
+  {
+    auxDirs.push_back(TemporaryDirectory::Create());
+  }
+  atomic<size_t> next(0);
+  vector<exception_ptr> errors(insFiles.size());
+  auto worker = [&]()
+  {
+    unique_lock<mutex> lock(sessionMutex);
+    for (size_t idx = next++; idx < insFiles.size(); idx = next++)
+    {
+      try
+      {
+        RunInsEngine(engine, options, insFiles[idx], outDir, auxDirs[idx]->GetPathName(), lock);
+      }
+      catch (...)
+      {
+        if (!lock.owns_lock())
+        {
+          lock.lock();
+        }
+        errors[idx] = current_exception();
+      }
+    }
+  };
+  size_t numThreads = min<size_t>(maxJobs, insFiles.size());
+  Verbose("running .ins engine on " + std::to_string(insFiles.size()) + " file(s) using " + std::to_string(numThreads) + " job(s)");
+  vector<thread> threads;
+  sessionLock->unlock();
+  for (size_t n = 0; n < numThreads; ++n)
+  {
+    threads.push_back(thread(worker));
+  }
+  for (thread& t : threads)
+  {
+    t.join();
+  }
+  sessionLock->lock();
+  for (const exception_ptr& error : errors)
+  {
+    if (error)
+    {
+      rethrow_exception(error);
+    }
+  }
+  for (const unique_ptr<TemporaryDirectory>& auxDir : auxDirs)
+  {
+    unordered_set<PathName> generated;
+    GetSnapshot(generated, auxDir->GetPathName());
+    vector<PathName> sorted(generated.begin(), generated.end());
+    sort(sorted.begin(), sorted.end());
+    for (const PathName& path : sorted)
+    {
+      PathName toPath = workDir / PathName(Utils::GetRelativizedPath(path.GetData(), auxDir->GetPathName().GetData()));
+      PathName toDir = toPath;
+      toDir.RemoveFileSpec();
+      Directory::Create(toDir);
+      if (File::Exists(toPath))
+      {
+        File::Delete(toPath);
       }
+      File::Move(path, toPath);
     }
   }
 }
@@ -529,7 +632,7 @@ void Recipe::InstallFileSets()
     {
       MIKTEX_FATAL_ERROR(T_("missing file patterns"));
     }
-    Install(patterns, PathName(session->Expand(tdsdir, this)));
+    Install(patterns, PathName(Expand(tdsdir)));
   }
 }
 
@@ -540,7 +643,7 @@ void Recipe::Install(const vector<string>& patterns, const PathName& tdsDir)
   bool madeDestDirectory = false;
   for (const string& pat : patterns)
   {
-    PathName pattern(session->Expand(pat, this));
+    PathName pattern(Expand(pat));
     PathName dir(workDir);
     dir /= pattern;
     dir.RemoveFileSpec();
@@ -572,6 +675,10 @@ void Recipe::Install(const vector<string>& patterns, const PathName& tdsDir)
       }
       else
       {
+        if (File::Exists(toPath))
+        {
+          MIKTEX_FATAL_ERROR_2(T_("The file has already been installed."), "path", toPath.ToString());
+        }
         File::Move(file, toPath);
       }
     }
@@ -1,6 +1,6 @@
 /* Recipe.h:                                            -*- C++ -*-
 
-   Copyright (C) 2016-2017 Christian Schenk
+   Copyright (C) 2016-2020 Christian Schenk
 
    This file is free software; you can redistribute it and/or modify
    it under the terms of the GNU General Public License as published
@@ -19,7 +19,10 @@
 
 #pragma once
 
+#include <iostream>
+#include <mutex>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include <miktex/Core/Cfg>
@@ -62,6 +65,27 @@ public:
     tds.SetFoundry(foundry);
   }
 
+public:
+  void SetMaxJobs(unsigned maxJobs)
+  {
+    this->maxJobs = maxJobs == 0 ? 1 : maxJobs;
+  }
+
+public:
+  /// The destination directory is shared with other recipes: it may
+  /// exist already.
+  void SetSharedDestDir(bool sharedDestDir)
+  {
+    this->sharedDestDir = sharedDestDir;
+  }
+
+public:
+  void SetOutput(std::ostream& out, std::ostream& err)
+  {
+    this->out = &out;
+    this->err = &err;
+  }
+
 public:
   void Execute(bool printOnly);
 
@@ -90,7 +114,13 @@ private:
   void Finalize();
 
 private:
-  void RunInsEngine(const std::string& engine, const std::vector<std::string>& options, const MiKTeX::Core::PathName& insFile, const MiKTeX::Core::PathName& outDir );
+  void RunInsEngine(const std::string& engine, const std::vector<std::string>& options, const MiKTeX::Core::PathName& insFile, const MiKTeX::Core::PathName& outDir, const MiKTeX::Core::PathName& auxDir, std::unique_lock<std::mutex>& lock);
+
+private:
+  void RunInsEngines(const std::string& engine, const std::vector<std::string>& options, const std::vector<MiKTeX::Core::PathName>& insFiles, const MiKTeX::Core::PathName& outDir);
+
+private:
+  std::string Expand(const std::string& s);
 
 private:
   void RunDtxUnpacker();
@@ -167,6 +197,28 @@ private:
 private:
   bool printOnly;
 
+private:
+  unsigned maxJobs = 1;
+
+private:
+  bool sharedDestDir = false;
+
+private:
+  std::ostream* out = &std::cout;
+
+private:
+  std::ostream* err = &std::cerr;
+
+private:
+  // neither the session nor the destination tree (shared by the
+  // recipes in batch mode) may be accessed concurrently: a recipe holds
+  // this lock while it executes, except while it waits for a child
+  // process, which writes into a private directory
+  static std::mutex sessionMutex;
+
+private:
+  std::unique_lock<std::mutex>* sessionLock = nullptr;
+
 private:
   std::unique_ptr<MiKTeX::Core::TemporaryDirectory> scratchDir;
 
@@ -23,7 +23,13 @@
 
 #include "tdsutil-version.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <exception>
 #include <iostream>
+#include <sstream>
+#include <thread>
 #include <unordered_set>
 
 #include <fmt/format.h>
@@ -31,6 +37,7 @@
 
 #include <miktex/App/Application>
 
+#include <miktex/Core/Directory>
 #include <miktex/Core/Paths>
 #include <miktex/Core/TemporaryDirectory>
 
@@ -57,12 +64,23 @@ public:
 private:
   MIKTEXNORETURN void Error(const string& msg);
 
+private:
+  void Install(const vector<string>& packages, const PathName& source, const PathName& destDir, const vector<PathName>& optionRecipeFiles);
+
+private:
+  void ReadRecipeFiles(Recipe& recipe, const string& package, const vector<PathName>& optionRecipeFiles);
+
 private:
   bool verbose = false;
 
 private:
   bool printOnly = false;
 
+private:
+  // .ins files may depend on files generated by other .ins files: run
+  // in parallel only when asked to
+  unsigned maxJobs = 1;
+
 private:
   shared_ptr<Session> session;
 
@@ -74,6 +92,7 @@ enum Option
 {
   OPT_AAA = 1000,
   OPT_DEST_DIR,
+  OPT_JOBS,
   OPT_PRINT_ONLY,
   OPT_RECIPE,
   OPT_SOURCE,
@@ -91,6 +110,14 @@ struct poptOption TdsUtility::aoption[] = {
     nullptr
   },
 
+  {
+    "jobs", 'j',
+    POPT_ARG_STRING, nullptr,
+    OPT_JOBS,
+    T_("The maximum number of .ins engine runs or packages processed in parallel (default: 1)."),
+    "N"
+  },
+
   {
     "print-only", 'n',
     POPT_ARG_NONE, nullptr,
@@ -141,10 +168,103 @@ MIKTEXNORETURN void TdsUtility::Error(const string& msg)
   throw 1;
 }
 
+void TdsUtility::ReadRecipeFiles(Recipe& recipe, const string& package, const vector<PathName>& optionRecipeFiles)
+{
+  vector<PathName> recipeFiles;
+  if (optionRecipeFiles.empty())
+  {
+    string packageRecipeFile = package + MIKTEX_TDSUTIL_RECIPE_FILE_SUFFIX;
+    session->FindFile(MIKTEX_PATH_TDSUTIL_DEFAULT_RECIPE, MIKTEX_PATH_TEXMF_PLACEHOLDER, { Session::FindFileOption::All }, recipeFiles);
+    session->FindFile(packageRecipeFile, MIKTEX_PATH_TEXMF_PLACEHOLDER "/" MIKTEX_PATH_MIKTEX_TDSUTIL_RECIPES_DIR, { Session::FindFileOption::All }, recipeFiles);
+  }
+  recipeFiles.insert(recipeFiles.end(), optionRecipeFiles.begin(), optionRecipeFiles.end());
+  for (const PathName& recipeFile : recipeFiles)
+  {
+    recipe.Read(recipeFile);
+  }
+}
+
+void TdsUtility::Install(const vector<string>& packages, const PathName& source, const PathName& destDir, const vector<PathName>& optionRecipeFiles)
+{
+  if (packages.size() == 1)
+  {
+    Recipe recipe(packages[0], source, destDir, verbose);
+    recipe.SetMaxJobs(maxJobs);
+    ReadRecipeFiles(recipe, packages[0], optionRecipeFiles);
+    recipe.Execute(printOnly);
+    return;
+  }
+
+  // batch mode: <source>/<package> is installed into the TDS tree
+  // <destdir>, as in single-package mode; recipes are read up front and
+  // executed in parallel; the output of each recipe is printed in
+  // package order
+  if (Directory::Exists(destDir))
+  {
+    Error(T_("The destination directory already exists."));
+  }
+  vector<unique_ptr<Recipe>> recipes;
+  vector<ostringstream> outputs(packages.size());
+  for (size_t idx = 0; idx < packages.size(); ++idx)
+  {
+    recipes.push_back(make_unique<Recipe>(packages[idx], source / PathName(packages[idx]), destDir, verbose));
+    recipes.back()->SetSharedDestDir(true);
+    recipes.back()->SetOutput(outputs[idx], outputs[idx]);
+    ReadRecipeFiles(*recipes.back(), packages[idx], optionRecipeFiles);
+  }
+  atomic<size_t> next(0);
+  vector<string> errors(packages.size());
+  auto worker = [&]()
+  {
+    for (size_t idx = next++; idx < recipes.size(); idx = next++)
+    {
+      try
+      {
+        recipes[idx]->Execute(printOnly);
+      }
+      catch (const MiKTeXException& e)
+      {
+        errors[idx] = e.GetErrorMessage();
+      }
+      catch (const exception& e)
+      {
+        errors[idx] = e.what();
+      }
+      catch (int)
+      {
+        errors[idx] = T_("aborted");
+      }
+    }
+  };
+  vector<thread> threads;
+  for (size_t n = 0; n < min<size_t>(maxJobs, recipes.size()); ++n)
+  {
+    threads.push_back(thread(worker));
+  }
+  for (thread& t : threads)
+  {
+    t.join();
+  }
+  bool failed = false;
+  for (size_t idx = 0; idx < packages.size(); ++idx)
+  {
+    cout << outputs[idx].str();
+    if (!errors[idx].empty())
+    {
+      cerr << "tdsutil: " << packages[idx] << ": " << errors[idx] << endl;
+      failed = true;
+    }
+  }
+  if (failed)
+  {
+    throw 1;
+  }
+}
+
 void TdsUtility::Run(int argc, const char ** argv)
 {
   PoptWrapper popt(argc, argv, aoption);
-  popt.SetOtherOptionHelp("install <package>");
+  popt.SetOtherOptionHelp("install <package>...");
 
   int option;
   vector<PathName> optionRecipeFiles;
@@ -161,6 +281,17 @@ void TdsUtility::Run(int argc, const char ** argv)
     case OPT_DEST_DIR:
       destDir = optArg;
       break;
+    case OPT_JOBS:
+    {
+      char* endptr = nullptr;
+      long jobs = strtol(optArg.c_str(), &endptr, 10);
+      if (optArg.empty() || *endptr != 0 || jobs < 1 || jobs > 1024)
+      {
+        Error(fmt::format(T_("Invalid number of jobs: {0}"), optArg));
+      }
+      maxJobs = static_cast<unsigned>(jobs);
+      break;
+    }
     case OPT_PRINT_ONLY:
       printOnly = true;
       break;
@@ -198,11 +329,11 @@ void TdsUtility::Run(int argc, const char ** argv)
 
   if (leftovers[0] == "install")
   {
-    if (leftovers.size() != 2)
+    if (leftovers.size() < 2)
     {
-      Error(fmt::format("Usage: {0} install <package>", argv[0]));
+      Error(fmt::format("Usage: {0} install <package>...", argv[0]));
     }
-    string package = leftovers[1];
+    vector<string> packages(leftovers.begin() + 1, leftovers.end());
     if (source.Empty())
     {
       source.SetToCurrentDirectory();
@@ -213,20 +344,7 @@ void TdsUtility::Run(int argc, const char ** argv)
       // TODO: home texmf
       destDir = session->GetSpecialPath(SpecialPath::UserDataRoot);
     }
-    Recipe recipe(package, source, destDir, verbose);
-    vector<PathName> recipeFiles;
-    if (optionRecipeFiles.empty())
-    {
-      string packageRecipeFile = package + MIKTEX_TDSUTIL_RECIPE_FILE_SUFFIX;
-      session->FindFile(MIKTEX_PATH_TDSUTIL_DEFAULT_RECIPE, MIKTEX_PATH_TEXMF_PLACEHOLDER, { Session::FindFileOption::All }, recipeFiles);
-      session->FindFile(packageRecipeFile, MIKTEX_PATH_TEXMF_PLACEHOLDER "/" MIKTEX_PATH_MIKTEX_TDSUTIL_RECIPES_DIR, { Session::FindFileOption::All }, recipeFiles);
-    }
-    recipeFiles.insert(recipeFiles.end(), optionRecipeFiles.begin(), optionRecipeFiles.end());
-    for (const PathName & recipeFile : recipeFiles)
-    {
-      recipe.Read(recipeFile);
-    }
-    recipe.Execute(printOnly);
+    Install(packages, source, destDir, optionRecipeFiles);
   }
   else
   {
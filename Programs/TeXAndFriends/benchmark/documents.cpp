@@ -0,0 +1,284 @@
+/* documents.cpp: synthetic benchmark documents
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 2, or (at your
+   option) any later version.
+
+   This file is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this file; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA. */
+
+// The documents rely on nothing but the primitives and the Computer
+// Modern TFM files, so that they run on a bare installation: the
+// format is built from texbench-ENGINE.ini, which takes the place of
+// plain.tex.  Each TeX document repeats a chunk of material until the
+// requested number of pages has been shipped out.
+
+#include <fstream>
+#include <stdexcept>
+
+#include "texbench.h"
+
+using namespace std;
+
+namespace {
+  const char* const SENTENCES =
+    "The quick brown fox jumps over the lazy dog. "
+    "Pack my box with five dozen liquor jugs, then waffle about the affine office. "
+    "An efficient typesetter breaks paragraphs into lines of nearly equal tightness, "
+    "and the first fitting of fifty different figures is left to the final pass. "
+    "Sphinx of black quartz, judge my vow! "
+    "Would you like an AVATAR, a WAVE, or a VAT of coffee today? ";
+
+  const char* const FONT_NAMES[] = {
+    "cmr5", "cmr6", "cmr7", "cmr8", "cmr9", "cmr10", "cmr12", "cmr17",
+    "cmbx5", "cmbx6", "cmbx7", "cmbx8", "cmbx9", "cmbx10", "cmbx12",
+    "cmti7", "cmti8", "cmti9", "cmti10", "cmti12",
+    "cmsl8", "cmsl9", "cmsl10", "cmsl12",
+    "cmtt8", "cmtt9", "cmtt10", "cmtt12",
+    "cmss8", "cmss9", "cmss10", "cmss12", "cmss17", "cmssbx10", "cmssi10",
+    "cmcsc10", "cmdunh10", "cmb10", "cmbxsl10", "cmbxti10",
+  };
+
+  const int FONT_SIZES[] = { 8, 10, 12 };
+
+  // \bfaa, \bfab, ...: control sequences without digits
+  string FontSwitch(size_t idx)
+  {
+    return string("\\bf") + static_cast<char>('a' + idx / 26) + static_cast<char>('a' + idx % 26);
+  }
+
+  void WriteTeXFormatSource(ostream& stream, const EngineProfile& engine)
+  {
+    stream
+      << "\\catcode`\\{=1 \\catcode`\\}=2 \\catcode`\\$=3 \\catcode`\\&=4\n"
+      << "\\catcode`\\#=6 \\catcode`\\^=7 \\catcode`\\_=8 \\catcode`\\^^I=10\n"
+      << engine.iniPreamble
+      << "\\def\\space{ }\n"
+      << "\\def\\,{\\mskip\\thinmuskip}\n"
+      << "\\def\\strut{\\vrule height 8.5pt depth 3.5pt width 0pt}\n"
+      << "\\def\\sqrt{\\radical\"270370 }\n"
+      // page layout
+      << "\\hsize=345pt \\vsize=550pt \\maxdepth=2pt \\topskip=10pt\n"
+      << "\\baselineskip=12pt \\lineskip=1pt \\lineskiplimit=0pt\n"
+      << "\\parskip=0pt plus 1pt \\parindent=15pt \\parfillskip=0pt plus 1fil\n"
+      << "\\tolerance=1000 \\emergencystretch=10pt \\hbadness=10000 \\vbadness=10000 \\hfuzz=1pt\n"
+      << "\\abovedisplayskip=12pt plus 3pt minus 9pt \\belowdisplayskip=12pt plus 3pt minus 9pt\n"
+      << "\\abovedisplayshortskip=0pt plus 3pt \\belowdisplayshortskip=7pt plus 3pt minus 4pt\n"
+      << "\\thinmuskip=3mu \\medmuskip=4mu plus 2mu minus 4mu \\thickmuskip=5mu plus 5mu\n"
+      << "\\scriptspace=0.5pt \\nulldelimiterspace=1.2pt \\delimiterfactor=901 \\delimitershortfall=5pt\n"
+      // fonts
+      << "\\font\\tenrm=cmr10 \\font\\sevenrm=cmr7 \\font\\fiverm=cmr5\n"
+      << "\\font\\teni=cmmi10 \\font\\seveni=cmmi7 \\font\\fivei=cmmi5\n"
+      << "\\font\\tensy=cmsy10 \\font\\sevensy=cmsy7 \\font\\fivesy=cmsy5\n"
+      << "\\font\\tenex=cmex10 \\font\\tenbf=cmbx10\n"
+      << "\\skewchar\\teni='177 \\skewchar\\seveni='177 \\skewchar\\fivei='177\n"
+      << "\\skewchar\\tensy='60 \\skewchar\\sevensy='60 \\skewchar\\fivesy='60\n"
+      << "\\textfont0=\\tenrm \\scriptfont0=\\sevenrm \\scriptscriptfont0=\\fiverm\n"
+      << "\\textfont1=\\teni \\scriptfont1=\\seveni \\scriptscriptfont1=\\fivei\n"
+      << "\\textfont2=\\tensy \\scriptfont2=\\sevensy \\scriptscriptfont2=\\fivesy\n"
+      << "\\textfont3=\\tenex \\scriptfont3=\\tenex \\scriptscriptfont3=\\tenex\n"
+      // math
+      << "\\mathcode`\\+=\"202B \\mathcode`\\-=\"2200 \\mathcode`\\==\"303D\n"
+      << "\\mathcode`\\<=\"313C \\mathcode`\\>=\"313E \\mathcode`\\,=\"613B\n"
+      << "\\mathcode`\\(=\"4028 \\mathcode`\\)=\"5029 \\mathcode`\\[=\"405B \\mathcode`\\]=\"505D\n"
+      << "\\delcode`\\(=\"028300 \\delcode`\\)=\"029301 \\delcode`\\[=\"05B302 \\delcode`\\]=\"05D303\n"
+      << "\\delcode`\\|=\"26A30C \\delcode`\\.=0\n"
+      << "\\mathchardef\\alpha=\"010B \\mathchardef\\beta=\"010C \\mathchardef\\gamma=\"010D\n"
+      << "\\mathchardef\\partial=\"0140 \\mathchardef\\infty=\"0231 \\mathchardef\\cdot=\"2201\n"
+      << "\\mathchardef\\times=\"2202 \\mathchardef\\le=\"3214 \\mathchardef\\ge=\"3215\n"
+      << "\\mathchardef\\sum=\"1350 \\mathchardef\\prod=\"1351 \\mathchardef\\int=\"1352\n"
+      // registers used by the documents
+      << "\\countdef\\benchi=10 \\countdef\\benchk=11 \\countdef\\benchm=12\n"
+      << "\\output={\\shipout\\box255 \\global\\advance\\count0 by 1 }\n"
+      << "\\tenrm\n"
+      << "\\dump\n";
+  }
+
+  void WriteTeXDocument(ostream& stream, const EngineProfile& engine, const string& kind, int pages, bool dvi)
+  {
+    stream << (dvi || engine.pdfSetup.empty() ? engine.dviSetup : engine.pdfSetup) << "\n";
+    if (kind == "startup")
+    {
+      stream << "\\end\n";
+      return;
+    }
+    if (kind == "text")
+    {
+      stream
+        << "\\def\\benchchunk{" << SENTENCES << SENTENCES << SENTENCES << "\\par}\n";
+    }
+    else if (kind == "math")
+    {
+      stream
+        << "\\def\\benchchunk{Let $\\alpha_i^2+\\beta_{i+1}\\le\\sum_{k=1}^n a_kx^k$ and\n"
+        << "  $f(x)={p(x)\\over q(x)}$ with $\\sqrt{x^2+y^2}\\cdot\\gamma_{j,k}$, so that\n"
+        << "  $$\\int_0^\\infty{e^{-x^2}\\over 1+x}\\,dx\\le\\left(\\sum_{k=0}^n{\\alpha_k\\over k+1}\\right)^2\\times\\prod_{j=1}^m(1-\\beta_j)$$\n"
+        << "  holds whenever $\\partial f/\\partial x\\ge 0$ and $[a,b]\\times[c,d]$ is compact,\n"
+        << "  while ${n\\over 2}<{x_1+x_2\\over y_1-y_2}$ and $\\sqrt{1+\\sqrt{1+\\sqrt{1+x}}}<\\infty$.\\par}\n";
+    }
+    else if (kind == "fonts")
+    {
+      size_t count = 0;
+      for (const char* name : FONT_NAMES)
+      {
+        for (int size : FONT_SIZES)
+        {
+          stream << "\\font" << FontSwitch(count++) << "=" << name << " at " << size << "pt\n";
+        }
+      }
+      // visit the fonts with a stride, so that neighbouring words differ in family and size
+      stream << "\\def\\benchchunk{";
+      const char* words[] = { "typography", "office", "waffle", "AVATAR", "quartz", "jumps", "fluffy", "VAT" };
+      for (size_t idx = 0; idx < 2 * count; ++idx)
+      {
+        stream << "{" << FontSwitch(idx * 7 % count) << " " << words[idx % (sizeof(words) / sizeof(words[0]))] << "} ";
+      }
+      stream << "\\par}\n";
+    }
+    else if (kind == "macros")
+    {
+      // expansion, \csname lookups and a steady stream of redefinitions
+      stream
+        << "\\def\\benchdigit#1{\\ifcase#1 zero\\or one\\or two\\or three\\or four\\or five\\or six\\or seven\\or eight\\or nine\\fi}\n"
+        << "\\def\\benchdigits#1{\\ifx#1\\relax\\else\\benchdigit#1\\space\\expandafter\\benchdigits\\fi}\n"
+        << "\\def\\benchstep{\\global\\advance\\benchk by 1\n"
+        << "  \\benchm=\\benchk \\divide\\benchm by 500 \\multiply\\benchm by -500 \\advance\\benchm by \\benchk\n"
+        << "  \\expandafter\\edef\\csname benchw\\number\\benchm\\endcsname{\\expandafter\\benchdigits\\number\\benchk\\relax}%\n"
+        << "  \\csname benchw\\number\\benchm\\endcsname}\n"
+        << "\\def\\benchrepeat{\\ifnum\\benchi>0 \\advance\\benchi by -1 \\benchstep\\expandafter\\benchrepeat\\fi}\n"
+        << "\\def\\benchchunk{\\benchi=60 \\benchrepeat\\par}\n";
+    }
+    else if (kind == "tables")
+    {
+      stream
+        << "\\def\\benchcell{\\global\\advance\\benchk by 1 \\number\\benchk}\n"
+        << "\\def\\benchrow{\\benchcell&alpha&\\benchcell&beta gamma&\\benchcell&delta\\cr}\n"
+        << "\\def\\benchrows{\\benchrow\\benchrow\\benchrow\\benchrow\\benchrow\\benchrow\\benchrow\\benchrow\\benchrow\\benchrow}\n"
+        << "\\def\\benchchunk{\\halign to\\hsize{\\strut##\\tabskip=0pt plus 1fil&&\\hfil##\\hfil\\cr\n"
+        << "  \\benchrows\\benchrows\\benchrows\\benchrows\\benchrows}}\n";
+    }
+    else if (kind == "write")
+    {
+      // immediate writes while reading, deferred writes while shipping out
+      stream
+        << "\\immediate\\openout3=\\jobname-data\n"
+        << "\\def\\benchsentence{" << SENTENCES << "}\n"
+        << "\\def\\benchwrites{\\ifnum\\benchi>0 \\advance\\benchi by -1 \\global\\advance\\benchk by 1\n"
+        << "  \\immediate\\write3{\\the\\benchk: \\benchsentence}\\expandafter\\benchwrites\\fi}\n"
+        << "\\def\\benchchunk{\\benchi=40 \\benchwrites\n"
+        << "  The quick brown fox\\write3{fox on page \\the\\count0}jumps over the lazy dog.\n"
+        << "  Pack my box\\write3{box on page \\the\\count0}with five dozen liquor jugs.\n"
+        << "  Sphinx of black quartz\\write3{quartz on page \\the\\count0}judge my vow!\\par}\n";
+    }
+    else
+    {
+      throw invalid_argument("unknown document kind: " + kind);
+    }
+    stream
+      << "\\def\\benchbody{\\ifnum\\count0<" << pages << " \\benchchunk\\expandafter\\benchbody\\fi}\n"
+      << "\\benchbody\n"
+      << "\\end\n";
+  }
+
+  // the same shapes for METAFONT and MetaPost, restricted to primitives
+  void WriteMetaSource(ostream& stream, const EngineProfile& engine)
+  {
+    stream << "tracingstats:=0; tracingonline:=0; showstopping:=0;\n";
+    if (engine.language == Language::METAFONT)
+    {
+      stream << "hppp:=10; vppp:=10; fontmaking:=0; proofing:=0; autorounding:=0; granularity:=1;\n";
+    }
+    stream
+      << "pen benchpen; benchpen:=pencircle scaled 8;\n"
+      << "picture benchpic;\n"
+      << "def benchshape(expr k) =\n"
+      << "  benchpic:=nullpicture;\n"
+      << "  addto benchpic doublepath (0,0)..(100,150+k/100)..(200,0)..(100,-50)..cycle withpen benchpen;\n"
+      << "  addto benchpic doublepath (20,20)..(100,k/50)..(180,120) withpen benchpen;\n"
+      << "  addto benchpic contour (40,40)--(160,40)--(160,100)--(40,100)--cycle;\n"
+      << "  charcode:=k; shipout benchpic;\n"
+      << "enddef;\n";
+    if (engine.language == Language::METAFONT)
+    {
+      stream << "dump\n";
+    }
+  }
+
+  void WriteMetaDocument(ostream& stream, const EngineProfile& engine, const string& kind, int units)
+  {
+    if (engine.formatOption.empty())
+    {
+      // MetaPost has no dump files: the macros are read on every run
+      stream << "input texbench-" << engine.name << "\n";
+    }
+    if (kind != "startup")
+    {
+      if (kind != GetDocumentKinds(engine.language)[0])
+      {
+        throw invalid_argument("unknown document kind: " + kind);
+      }
+      stream << "for k=1 upto " << units << ": benchshape(k); endfor\n";
+    }
+    stream << "end\n";
+  }
+
+  ofstream CreateOutputStream(const string& path)
+  {
+    ofstream stream(path, ios_base::binary);
+    if (!stream)
+    {
+      throw runtime_error("cannot create " + path);
+    }
+    return stream;
+  }
+}
+
+vector<string> GetDocumentKinds(Language language)
+{
+  switch (language)
+  {
+  case Language::TeX:
+    return { "text", "math", "fonts", "macros", "tables", "write" };
+  case Language::METAFONT:
+    return { "characters" };
+  case Language::MetaPost:
+    return { "figures" };
+  }
+  return {};
+}
+
+void WriteFormatSource(const string& path, const EngineProfile& engine)
+{
+  ofstream stream = CreateOutputStream(path);
+  if (engine.language == Language::TeX)
+  {
+    WriteTeXFormatSource(stream, engine);
+  }
+  else
+  {
+    WriteMetaSource(stream, engine);
+  }
+}
+
+void WriteDocument(const string& path, const EngineProfile& engine, const string& kind, int units, bool dvi)
+{
+  ofstream stream = CreateOutputStream(path);
+  if (engine.language == Language::TeX)
+  {
+    WriteTeXDocument(stream, engine, kind, units, dvi);
+  }
+  else
+  {
+    WriteMetaDocument(stream, engine, kind, units);
+  }
+}
@@ -0,0 +1,310 @@
+/* process.cpp: child processes and temporary files
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 2, or (at your
+   option) any later version.
+
+   This file is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this file; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA. */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#  include <windows.h>
+#  include <psapi.h>
+#  include <direct.h>
+#else
+#  include <cerrno>
+#  include <fcntl.h>
+#  include <ftw.h>
+#  include <sys/resource.h>
+#  include <sys/stat.h>
+#  include <sys/types.h>
+#  include <sys/wait.h>
+#  include <unistd.h>
+#endif
+
+#include "texbench.h"
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+#if defined(_WIN32)
+  string Quote(const string& arg)
+  {
+    if (!arg.empty() && arg.find_first_of(" \t\"") == string::npos)
+    {
+      return arg;
+    }
+    string result = "\"";
+    for (char ch : arg)
+    {
+      if (ch == '"')
+      {
+        result += '\\';
+      }
+      result += ch;
+    }
+    return result + "\"";
+  }
+
+  double ToSeconds(const FILETIME& ft)
+  {
+    ULARGE_INTEGER li;
+    li.LowPart = ft.dwLowDateTime;
+    li.HighPart = ft.dwHighDateTime;
+    return li.QuadPart / 1.0e7;
+  }
+
+  void RemoveDirectoryTreeRecursive(const string& path)
+  {
+    WIN32_FIND_DATAA data;
+    HANDLE h = FindFirstFileA((path + "\\*").c_str(), &data);
+    if (h != INVALID_HANDLE_VALUE)
+    {
+      do
+      {
+        string name = data.cFileName;
+        if (name == "." || name == "..")
+        {
+          continue;
+        }
+        string child = path + "\\" + name;
+        if ((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0)
+        {
+          RemoveDirectoryTreeRecursive(child);
+        }
+        else
+        {
+          DeleteFileA(child.c_str());
+        }
+      } while (FindNextFileA(h, &data));
+      FindClose(h);
+    }
+    RemoveDirectoryA(path.c_str());
+  }
+#else
+  double ToSeconds(const timeval& tv)
+  {
+    return tv.tv_sec + tv.tv_usec / 1.0e6;
+  }
+
+  int RemoveEntry(const char* path, const struct stat*, int, FTW*)
+  {
+    remove(path);
+    return 0;
+  }
+#endif
+}
+
+ProcessUsage RunProcess(const string& program, const vector<string>& arguments)
+{
+  ProcessUsage usage;
+  auto start = steady_clock::now();
+#if defined(_WIN32)
+  string commandLine = Quote(program);
+  for (const string& arg : arguments)
+  {
+    commandLine += " " + Quote(arg);
+  }
+  vector<char> commandLineBuffer(commandLine.begin(), commandLine.end());
+  commandLineBuffer.push_back(0);
+  SECURITY_ATTRIBUTES sa = { sizeof(sa), nullptr, TRUE };
+  HANDLE nul = CreateFileA("NUL", GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, &sa, OPEN_EXISTING, 0, nullptr);
+  STARTUPINFOA startupInfo = {};
+  startupInfo.cb = sizeof(startupInfo);
+  startupInfo.dwFlags = STARTF_USESTDHANDLES;
+  startupInfo.hStdInput = nul;
+  startupInfo.hStdOutput = nul;
+  startupInfo.hStdError = nul;
+  PROCESS_INFORMATION processInfo;
+  if (!CreateProcessA(program.c_str(), commandLineBuffer.data(), nullptr, nullptr, TRUE, 0, nullptr, nullptr, &startupInfo, &processInfo))
+  {
+    CloseHandle(nul);
+    throw runtime_error("cannot start " + program);
+  }
+  CloseHandle(processInfo.hThread);
+  WaitForSingleObject(processInfo.hProcess, INFINITE);
+  usage.seconds = duration<double>(steady_clock::now() - start).count();
+  DWORD exitCode;
+  if (GetExitCodeProcess(processInfo.hProcess, &exitCode))
+  {
+    usage.exitCode = static_cast<int>(exitCode);
+  }
+  FILETIME creationTime, exitTime, kernelTime, userTime;
+  if (GetProcessTimes(processInfo.hProcess, &creationTime, &exitTime, &kernelTime, &userTime))
+  {
+    usage.userSeconds = ToSeconds(userTime);
+    usage.systemSeconds = ToSeconds(kernelTime);
+  }
+  PROCESS_MEMORY_COUNTERS memoryCounters;
+  if (GetProcessMemoryInfo(processInfo.hProcess, &memoryCounters, sizeof(memoryCounters)))
+  {
+    usage.peakMemory = memoryCounters.PeakWorkingSetSize;
+  }
+  CloseHandle(processInfo.hProcess);
+  CloseHandle(nul);
+#else
+  vector<char*> argv;
+  argv.push_back(const_cast<char*>(program.c_str()));
+  for (const string& arg : arguments)
+  {
+    argv.push_back(const_cast<char*>(arg.c_str()));
+  }
+  argv.push_back(nullptr);
+  pid_t pid = fork();
+  if (pid < 0)
+  {
+    throw runtime_error("cannot start " + program);
+  }
+  if (pid == 0)
+  {
+    int fd = open("/dev/null", O_RDWR);
+    if (fd >= 0)
+    {
+      dup2(fd, 0);
+      dup2(fd, 1);
+      dup2(fd, 2);
+    }
+    execv(program.c_str(), argv.data());
+    _exit(127);
+  }
+  int status;
+  struct rusage resourceUsage;
+  while (wait4(pid, &status, 0, &resourceUsage) < 0)
+  {
+    if (errno != EINTR)
+    {
+      throw runtime_error("cannot wait for " + program);
+    }
+  }
+  usage.seconds = duration<double>(steady_clock::now() - start).count();
+  usage.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+  usage.userSeconds = ToSeconds(resourceUsage.ru_utime);
+  usage.systemSeconds = ToSeconds(resourceUsage.ru_stime);
+#if defined(__APPLE__)
+  usage.peakMemory = resourceUsage.ru_maxrss;
+#else
+  // kilobytes
+  usage.peakMemory = static_cast<uint64_t>(resourceUsage.ru_maxrss) * 1024;
+#endif
+#endif
+  return usage;
+}
+
+string MakeTemporaryDirectory()
+{
+#if defined(_WIN32)
+  char tempPath[MAX_PATH];
+  if (GetTempPathA(MAX_PATH, tempPath) == 0)
+  {
+    throw runtime_error("cannot determine the temporary directory");
+  }
+  string path = string(tempPath) + "texbench-" + to_string(GetCurrentProcessId()) + "-" + to_string(GetTickCount());
+  MakeDirectory(path);
+  return path;
+#else
+  const char* tmpdir = getenv("TMPDIR");
+  string pattern = string(tmpdir != nullptr && *tmpdir != 0 ? tmpdir : "/tmp") + "/texbench-XXXXXX";
+  vector<char> buffer(pattern.begin(), pattern.end());
+  buffer.push_back(0);
+  if (mkdtemp(buffer.data()) == nullptr)
+  {
+    throw runtime_error("cannot create " + pattern);
+  }
+  return buffer.data();
+#endif
+}
+
+void MakeDirectory(const string& path)
+{
+#if defined(_WIN32)
+  int result = _mkdir(path.c_str());
+#else
+  int result = mkdir(path.c_str(), 0777);
+#endif
+  if (result != 0)
+  {
+    throw runtime_error("cannot create " + path);
+  }
+}
+
+void RemoveDirectoryTree(const string& path)
+{
+#if defined(_WIN32)
+  RemoveDirectoryTreeRecursive(path);
+#else
+  nftw(path.c_str(), RemoveEntry, 16, FTW_DEPTH | FTW_PHYS);
+#endif
+}
+
+void ChangeDirectory(const string& path)
+{
+#if defined(_WIN32)
+  int result = _chdir(path.c_str());
+#else
+  int result = chdir(path.c_str());
+#endif
+  if (result != 0)
+  {
+    throw runtime_error("cannot change to " + path);
+  }
+}
+
+string GetFullPath(const string& path)
+{
+#if defined(_WIN32)
+  char* fullPath = _fullpath(nullptr, path.c_str(), 0);
+#else
+  char* fullPath = realpath(path.c_str(), nullptr);
+#endif
+  if (fullPath == nullptr)
+  {
+    throw runtime_error(path + " does not exist");
+  }
+  string result = fullPath;
+  free(fullPath);
+  return result;
+}
+
+uint64_t GetFileLength(const string& path)
+{
+#if defined(_WIN32)
+  struct _stat64 statBuf;
+  if (_stat64(path.c_str(), &statBuf) != 0)
+#else
+  struct stat statBuf;
+  if (stat(path.c_str(), &statBuf) != 0)
+#endif
+  {
+    return 0;
+  }
+  return statBuf.st_size;
+}
+
+void SetEnvironmentString(const string& name, const string& value)
+{
+#if defined(_WIN32)
+  int result = _putenv_s(name.c_str(), value.c_str());
+#else
+  int result = setenv(name.c_str(), value.c_str(), 1);
+#endif
+  if (result != 0)
+  {
+    throw runtime_error("cannot set " + name);
+  }
+}
@@ -0,0 +1,452 @@
+/* texbench.cpp: measure the throughput of TeX engines
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 2, or (at your
+   option) any later version.
+
+   This file is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this file; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA. */
+
+// For each engine, texbench builds a format from scratch, measures
+// the startup time with an empty document and then runs the synthetic
+// documents.  All files live in a temporary directory, which also
+// serves as the user data root of the engines, and the package
+// installer is disabled, so that a run neither touches the
+// installation nor goes online.  The results are written as JSON:
+//
+//   { "engines": [ { "name": "pdftex", "phases": { "format": {...},
+//     "startup": {...}, "text": {...}, ... } }, ... ], ... }
+//
+// Every phase reports the best wall-clock time of the runs together
+// with the CPU times of that run and the peak memory of all runs.
+// Document phases add the number of pages (characters, figures)
+// produced, the time net of startup, and the resulting rates.
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "texbench.h"
+
+using namespace std;
+
+using json = nlohmann::ordered_json;
+
+namespace {
+  struct Engine
+  {
+    EngineProfile profile;
+    string path;
+  };
+
+  const vector<EngineProfile> PROFILES = {
+    { "tex", Language::TeX, {}, {}, "--undump=", ".fmt", "pages", "", "", "" },
+    { "etex", Language::TeX, {}, { "--etex" }, "--undump=", ".fmt", "pages", "", "", "\\pdfoutput=0 " },
+    {
+      "pdftex", Language::TeX, {}, {}, "--undump=", ".fmt", "pages", "",
+      "\\pdfoutput=1 \\pdfhorigin=1in \\pdfvorigin=1in \\pdfpagewidth=8.5in \\pdfpageheight=11in ",
+      "\\pdfoutput=0 "
+    },
+    { "xetex", Language::TeX, { "--no-pdf" }, {}, "--undump=", ".fmt", "pages", "", "", "" },
+    {
+      "luatex", Language::TeX, {}, {}, "--fmt=", ".fmt", "pages",
+      "\\directlua{tex.enableprimitives('',tex.extraprimitives())}\n",
+      "\\outputmode=1 \\pagewidth=8.5in \\pageheight=11in ",
+      "\\outputmode=0 "
+    },
+    { "mf", Language::METAFONT, {}, {}, "--undump=", ".base", "characters", "", "", "" },
+    { "mpost", Language::MetaPost, {}, {}, "", "", "figures", "", "", "" },
+  };
+
+  const vector<string> COMMON_OPTIONS = {
+    "--miktex-disable-installer",
+    "--miktex-disable-maintenance",
+    "--interaction=batchmode",
+  };
+
+  struct Options
+  {
+    int pages = 100;
+    int runs = 3;
+    bool dvi = false;
+    bool keep = false;
+    vector<string> kinds;
+    string outputPath;
+    vector<Engine> engines;
+  };
+
+  // ENGINE is either NAME=PATH or PATH; in the latter case, the name is
+  // derived from the file name, e.g., miktex-pdftex.exe => pdftex
+  Engine ParseEngine(const string& arg)
+  {
+    Engine engine;
+    string name;
+    size_t eq = arg.find('=');
+    if (eq != string::npos)
+    {
+      name = arg.substr(0, eq);
+      engine.path = arg.substr(eq + 1);
+    }
+    else
+    {
+      engine.path = arg;
+      size_t slash = arg.find_last_of("/\\");
+      name = slash == string::npos ? arg : arg.substr(slash + 1);
+      if (name.size() > 4 && name.compare(name.size() - 4, 4, ".exe") == 0)
+      {
+        name.erase(name.size() - 4);
+      }
+      if (name.compare(0, 7, "miktex-") == 0)
+      {
+        name.erase(0, 7);
+      }
+    }
+    auto it = find_if(PROFILES.begin(), PROFILES.end(), [&name](const EngineProfile& p) { return p.name == name; });
+    if (it == PROFILES.end())
+    {
+      throw invalid_argument("unknown engine: " + name);
+    }
+    engine.profile = *it;
+    engine.path = GetFullPath(engine.path);
+    return engine;
+  }
+
+  vector<string> Split(const string& s)
+  {
+    vector<string> result;
+    size_t start = 0;
+    while (start <= s.size())
+    {
+      size_t end = s.find(',', start);
+      if (end == string::npos)
+      {
+        end = s.size();
+      }
+      if (end > start)
+      {
+        result.push_back(s.substr(start, end - start));
+      }
+      start = end + 1;
+    }
+    return result;
+  }
+
+  bool ParseOptions(int argc, char* argv[], Options& options)
+  {
+    for (int idx = 1; idx < argc; ++idx)
+    {
+      const char* arg = argv[idx];
+      if (strncmp(arg, "--pages=", 8) == 0)
+      {
+        options.pages = atoi(arg + 8);
+      }
+      else if (strncmp(arg, "--runs=", 7) == 0)
+      {
+        options.runs = atoi(arg + 7);
+      }
+      else if (strncmp(arg, "--kinds=", 8) == 0)
+      {
+        options.kinds = Split(arg + 8);
+      }
+      else if (strncmp(arg, "--output=", 9) == 0)
+      {
+        options.outputPath = arg + 9;
+      }
+      else if (strcmp(arg, "--dvi") == 0)
+      {
+        options.dvi = true;
+      }
+      else if (strcmp(arg, "--keep") == 0)
+      {
+        options.keep = true;
+      }
+      else if (arg[0] == '-')
+      {
+        return false;
+      }
+      else
+      {
+        options.engines.push_back(ParseEngine(arg));
+      }
+    }
+    return !options.engines.empty() && options.pages > 0 && options.runs > 0;
+  }
+
+  // finds "Output written on texbench-tex-text.dvi (N pages" (TeX,
+  // METAFONT) or "N output files written" (MetaPost) in the transcript
+  int GetUnitCount(const string& logPath, Language language)
+  {
+    ifstream stream(logPath, ios_base::binary);
+    string line;
+    while (getline(stream, line))
+    {
+      if (language == Language::MetaPost)
+      {
+        if (line.find(" output file") != string::npos && line.find(" written") != string::npos)
+        {
+          return atoi(line.c_str());
+        }
+        continue;
+      }
+      size_t pos = line.find("Output written on ");
+      if (pos == string::npos)
+      {
+        continue;
+      }
+      pos = line.find('(', pos);
+      if (pos != string::npos)
+      {
+        return atoi(line.c_str() + pos + 1);
+      }
+    }
+    return 0;
+  }
+
+  json Measure(const Engine& engine, const vector<string>& arguments, const string& jobName, int runs)
+  {
+    ProcessUsage best;
+    best.seconds = numeric_limits<double>::max();
+    uint64_t peakMemory = 0;
+    json runSeconds = json::array();
+    for (int run = 0; run < runs; ++run)
+    {
+      ProcessUsage usage = RunProcess(engine.path, arguments);
+      if (usage.exitCode != 0)
+      {
+        throw runtime_error(engine.profile.name + " exited with code " + to_string(usage.exitCode) + " (see " + jobName + ".log)");
+      }
+      runSeconds.push_back(usage.seconds);
+      peakMemory = max(peakMemory, usage.peakMemory);
+      if (usage.seconds < best.seconds)
+      {
+        best = usage;
+      }
+    }
+    return {
+      { "seconds", best.seconds },
+      { "user_seconds", best.userSeconds },
+      { "system_seconds", best.systemSeconds },
+      { "peak_memory_bytes", peakMemory },
+      { "run_seconds", runSeconds },
+    };
+  }
+
+  vector<string> MakeArguments(const Engine& engine, const string& formatPath, const string& fileName)
+  {
+    vector<string> arguments = COMMON_OPTIONS;
+    arguments.insert(arguments.end(), engine.profile.options.begin(), engine.profile.options.end());
+    if (formatPath.empty())
+    {
+      arguments.push_back("--ini");
+    }
+    else
+    {
+      arguments.push_back(engine.profile.formatOption + formatPath);
+    }
+    arguments.push_back(fileName);
+    return arguments;
+  }
+
+  json RunEngine(const Engine& engine, const Options& options, const string& workDir)
+  {
+    const EngineProfile& profile = engine.profile;
+    string stem = "texbench-" + profile.name;
+    string extension = profile.language == Language::TeX ? ".tex" : profile.language == Language::METAFONT ? ".mf" : ".mp";
+    json phases;
+
+    // the format; MetaPost reads the macros on every run instead
+    string formatSource = stem + (profile.language == Language::TeX ? ".ini" : extension);
+    WriteFormatSource(formatSource, profile);
+    string formatPath;
+    if (!profile.formatOption.empty())
+    {
+      vector<string> arguments = COMMON_OPTIONS;
+      arguments.insert(arguments.end(), profile.options.begin(), profile.options.end());
+      arguments.insert(arguments.end(), profile.iniOptions.begin(), profile.iniOptions.end());
+      arguments.push_back("--ini");
+      arguments.push_back(formatSource);
+      phases["format"] = Measure(engine, arguments, stem, options.runs);
+      formatPath = workDir + "/" + stem + profile.formatExtension;
+      phases["format"]["size_bytes"] = GetFileLength(formatPath);
+    }
+
+    string startupJob = stem + "-startup";
+    WriteDocument(startupJob + extension, profile, "startup", 0, options.dvi);
+    phases["startup"] = Measure(engine, MakeArguments(engine, formatPath, startupJob + extension), startupJob, options.runs);
+    double startupSeconds = phases["startup"]["seconds"];
+
+    for (const string& kind : GetDocumentKinds(profile.language))
+    {
+      if (!options.kinds.empty() && find(options.kinds.begin(), options.kinds.end(), kind) == options.kinds.end())
+      {
+        continue;
+      }
+      string job = stem + "-" + kind;
+      WriteDocument(job + extension, profile, kind, options.pages, options.dvi);
+      json phase = Measure(engine, MakeArguments(engine, formatPath, job + extension), job, options.runs);
+      int units = GetUnitCount(job + ".log", profile.language);
+      if (units == 0)
+      {
+        throw runtime_error(profile.name + " produced no " + profile.unit + " (see " + job + ".log)");
+      }
+      double seconds = phase["seconds"];
+      double netSeconds = max(seconds - startupSeconds, 0.0);
+      phase["units"] = units;
+      phase["net_seconds"] = netSeconds;
+      phase["units_per_second"] = units / seconds;
+      phase["net_units_per_second"] = netSeconds > 0.0 ? json(units / netSeconds) : json(nullptr);
+      phases[kind] = phase;
+    }
+    return phases;
+  }
+
+  void PrintSummary(ostream& stream, const json& report)
+  {
+    stream << fixed;
+    for (const json& engine : report["engines"])
+    {
+      stream << engine["name"].get<string>() << " (" << engine["path"].get<string>() << ")\n";
+      if (engine.count("error") > 0)
+      {
+        stream << "  failed: " << engine["error"].get<string>() << "\n";
+      }
+      if (engine.count("phases") == 0)
+      {
+        continue;
+      }
+      for (auto it = engine["phases"].begin(); it != engine["phases"].end(); ++it)
+      {
+        const json& phase = it.value();
+        stream
+          << "  " << left << setw(10) << it.key() << right
+          << setprecision(3) << setw(9) << phase["seconds"].get<double>() << " s"
+          << setprecision(1) << setw(9) << phase["peak_memory_bytes"].get<uint64_t>() / (1024.0 * 1024.0) << " MB";
+        if (phase.count("units") > 0)
+        {
+          stream
+            << setw(7) << phase["units"].get<int>() << " " << engine["unit"].get<string>()
+            << setw(9) << phase["units_per_second"].get<double>() << "/s";
+        }
+        stream << "\n";
+      }
+    }
+    stream.flush();
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  Options options;
+  try
+  {
+    if (!ParseOptions(argc, argv, options))
+    {
+      cerr
+        << "usage: " << argv[0] << " [--pages=N] [--runs=N] [--kinds=KIND,...] [--dvi] [--keep] [--output=FILE] ENGINE...\n"
+        << "ENGINE is [NAME=]PATH, where NAME is one of: tex, etex, pdftex, xetex, luatex, mf, mpost\n"
+        << "KIND is one of: text, math, fonts, macros, tables, write, characters (mf), figures (mpost)" << endl;
+      return 1;
+    }
+  }
+  catch (const exception& e)
+  {
+    cerr << argv[0] << ": " << e.what() << endl;
+    return 1;
+  }
+
+  json report;
+  report["pages"] = options.pages;
+  report["runs"] = options.runs;
+  report["dvi"] = options.dvi;
+  report["engines"] = json::array();
+
+  string startDir;
+  string tempDir;
+  bool failed = false;
+  try
+  {
+    startDir = GetFullPath(".");
+    tempDir = MakeTemporaryDirectory();
+    string workDir = tempDir + "/work";
+    MakeDirectory(workDir);
+    MakeDirectory(tempDir + "/data");
+    SetEnvironmentString("MIKTEX_USERDATA", tempDir + "/data");
+    ChangeDirectory(workDir);
+    for (const Engine& engine : options.engines)
+    {
+      json result = {
+        { "name", engine.profile.name },
+        { "path", engine.path },
+        { "unit", engine.profile.unit },
+      };
+      try
+      {
+        result["phases"] = RunEngine(engine, options, workDir);
+      }
+      catch (const exception& e)
+      {
+        result["error"] = e.what();
+        failed = true;
+      }
+      report["engines"].push_back(result);
+    }
+  }
+  catch (const exception& e)
+  {
+    cerr << argv[0] << ": " << e.what() << endl;
+    failed = true;
+  }
+
+  if (!tempDir.empty())
+  {
+    if (options.keep || failed)
+    {
+      report["temporary_directory"] = tempDir;
+    }
+    else
+    {
+      ChangeDirectory(startDir);
+      RemoveDirectoryTree(tempDir);
+    }
+  }
+
+  if (options.outputPath.empty())
+  {
+    cout << report.dump(2) << endl;
+  }
+  else
+  {
+    if (!startDir.empty())
+    {
+      ChangeDirectory(startDir);
+    }
+    ofstream stream(options.outputPath, ios_base::binary);
+    stream << report.dump(2) << endl;
+    if (!stream)
+    {
+      cerr << argv[0] << ": cannot write " << options.outputPath << endl;
+      failed = true;
+    }
+    PrintSummary(cout, report);
+  }
+  return failed ? 1 : 0;
+}
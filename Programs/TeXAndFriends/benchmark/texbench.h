@@ -0,0 +1,78 @@
+/* texbench.h:                                          -*- C++ -*-
+
+   Copyright (C) 2020 Christian Schenk
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 2, or (at your
+   option) any later version.
+
+   This file is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this file; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA. */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class Language
+{
+  TeX,
+  METAFONT,
+  MetaPost
+};
+
+/// Describes how to drive one engine.
+struct EngineProfile
+{
+  std::string name;
+  Language language;
+  /// options passed on every invocation
+  std::vector<std::string> options;
+  /// options passed only when building the format
+  std::vector<std::string> iniOptions;
+  /// the option which loads a format; empty, if the engine cannot dump
+  std::string formatOption;
+  std::string formatExtension;
+  /// what the engine produces: pages, characters or figures
+  std::string unit;
+  /// TeX code which must run before anything else in ini mode
+  std::string iniPreamble;
+  /// TeX code which selects PDF output; empty, if not supported
+  std::string pdfSetup;
+  /// TeX code which selects DVI output
+  std::string dviSetup;
+};
+
+/// Resources consumed by a child process.
+struct ProcessUsage
+{
+  int exitCode = -1;
+  double seconds = 0.0;
+  double userSeconds = 0.0;
+  double systemSeconds = 0.0;
+  std::uint64_t peakMemory = 0;
+};
+
+// documents.cpp
+std::vector<std::string> GetDocumentKinds(Language language);
+void WriteFormatSource(const std::string& path, const EngineProfile& engine);
+void WriteDocument(const std::string& path, const EngineProfile& engine, const std::string& kind, int units, bool dvi);
+
+// process.cpp
+ProcessUsage RunProcess(const std::string& program, const std::vector<std::string>& arguments);
+std::string MakeTemporaryDirectory();
+void MakeDirectory(const std::string& path);
+void RemoveDirectoryTree(const std::string& path);
+void ChangeDirectory(const std::string& path);
+std::string GetFullPath(const std::string& path);
+std::uint64_t GetFileLength(const std::string& path);
+void SetEnvironmentString(const std::string& name, const std::string& value);
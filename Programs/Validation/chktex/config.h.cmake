@@ -20,6 +20,9 @@
 /* Define to 1 if you have the `fileno' function. */
 #cmakedefine HAVE_FILENO 1
 
+/* Define to 1 if you have the `fork' function. */
+#cmakedefine HAVE_FORK 1
+
 /* Define to 1 if you have the <inttypes.h> header file. */
 #cmakedefine HAVE_INTTYPES_H 1
 
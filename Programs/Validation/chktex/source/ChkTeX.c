@@ -38,6 +38,11 @@
 #include "FindErrs.h"
 #include "Resource.h"
 #include <string.h>
+#if defined(HAVE_FORK)
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
 
 #undef MSG
 #define MSG(num, type, inuse, ctxt, text) {(enum ErrNum)num, type, inuse, ctxt, text},
@@ -180,6 +185,7 @@ static const char *HelpText =
     "\n"
     "Miscellaneous switches:\n"
     "~~~~~~~~~~~~~~~~~~~~~~~\n"
+    "    -j  --jobs      : Check up to # files at the same time.\n"
     "    -W  --version   : Version information\n"
     "\n"
     "----------------------------------------------------------------------\n"
@@ -227,6 +233,11 @@ static int ParseArgs(int argc, char **argv);
 static void ShowIntStatus(void);
 static int OpenOut(void);
 static int ShiftArg(char **Argument);
+static void ResetState(void);
+static int CheckInput(long Tab);
+#if defined(HAVE_FORK)
+static int CheckFilesConcurrently(int NumFiles, char **FileNames, long Tab);
+#endif
 
 
 /*
@@ -352,7 +363,6 @@ static void ExpandTabs(char *From, char *To, long TSize, long MaxDiff)
 int main(int argc, char **argv)
 {
     int retval = EXIT_FAILURE, ret, CurArg;
-    unsigned long Count;
     int StdInUse = FALSE;
     long Tab = 8;
 
@@ -458,14 +468,20 @@ int main(int argc, char **argv)
 
             if (OpenOut())
             {
+#if defined(HAVE_FORK)
+                if (!UsingStdIn && Jobs > 1 && argc - CurArg > 1)
+                {
+                    ret = CheckFilesConcurrently(argc - CurArg, argv + CurArg, Tab);
+                    if ( ret != EXIT_SUCCESS ) {
+                        retval = ret;
+                    }
+                    return retval;
+                }
+#endif
                 for (;;)
                 {
-                    for (Count = 0; Count < NUMBRACKETS; Count++)
-                        Brackets[Count] = 0L;
+                    ResetState();
 
-#define DEF(type, name, value) name = value
-                    STATE_VARS;
-#undef DEF
                     if (UsingStdIn)
                     {
                         if (StdInUse)
@@ -489,38 +505,216 @@ int main(int argc, char **argv)
                         }
                     }
 
-                    if (StkTop(&InputStack) && OutputFile)
-                    {
-                        while (!ferror(OutputFile)
-                               && StkTop(&InputStack)
-                               && !ferror(CurStkFile(&InputStack))
-                               && FGetsStk(ReadBuffer, BUFSIZ - 1,
-                                           &InputStack))
-                        {
+                    ret = CheckInput(Tab);
+                    if ( ret != EXIT_SUCCESS ) {
+                        retval = ret;
+                    }
+                }
+            }
+        }
+    }
+    return retval;
+}
 
-                            /* Make all spaces ordinary spaces */
+/*
+ * Resets the state before a new file is checked.
+ */
 
-                            strrep(ReadBuffer, '\n', ' ');
-                            strrep(ReadBuffer, '\r', ' ');
-                            ExpandTabs(ReadBuffer, TmpBuffer, Tab, BUFSIZ - 1 - strlen(ReadBuffer) );
-                            strcpy(ReadBuffer, TmpBuffer);
+static void ResetState(void)
+{
+    unsigned long Count;
 
-                            strcat(ReadBuffer, " ");
-                            ret = FindErr(ReadBuffer, CurStkLine(&InputStack));
-                            if ( ret != EXIT_SUCCESS ) {
-                                retval = ret;
-                            }
-                        }
+    for (Count = 0; Count < NUMBRACKETS; Count++)
+        Brackets[Count] = 0L;
 
-                        PrintStatus(CurStkLine(&InputStack));
-                    }
-                }
+#define DEF(type, name, value) name = value
+    STATE_VARS;
+#undef DEF
+}
+
+/*
+ * Checks the file on top of the input stack and prints the status.
+ */
+
+static int CheckInput(long Tab)
+{
+    int retval = EXIT_SUCCESS, ret;
+
+    if (StkTop(&InputStack) && OutputFile)
+    {
+        while (!ferror(OutputFile)
+               && StkTop(&InputStack)
+               && !ferror(CurStkFile(&InputStack))
+               && FGetsStk(ReadBuffer, BUFSIZ - 1,
+                           &InputStack))
+        {
+
+            /* Make all spaces ordinary spaces */
+
+            strrep(ReadBuffer, '\n', ' ');
+            strrep(ReadBuffer, '\r', ' ');
+            ExpandTabs(ReadBuffer, TmpBuffer, Tab, BUFSIZ - 1 - strlen(ReadBuffer) );
+            strcpy(ReadBuffer, TmpBuffer);
+
+            strcat(ReadBuffer, " ");
+            ret = FindErr(ReadBuffer, CurStkLine(&InputStack));
+            if ( ret != EXIT_SUCCESS ) {
+                retval = ret;
             }
         }
+
+        PrintStatus(CurStkLine(&InputStack));
+    }
+    return retval;
+}
+
+#if defined(HAVE_FORK)
+
+/* Exit code of a job which could not open its file */
+#define EXIT_NO_INPUT 255
+
+struct Job
+{
+    pid_t Pid;                  /* -1: check in this process */
+    FILE *Out, *Err;            /* what the job printed */
+    const char *FileName;
+    long Tab;
+};
+
+static void CopyOutput(FILE *From, FILE *To)
+{
+    char Buffer[BUFSIZ];
+    size_t Len;
+
+    rewind(From);
+    while ((Len = fread(Buffer, 1, sizeof(Buffer), From)) > 0)
+        fwrite(Buffer, 1, Len, To);
+    fflush(To);
+}
+
+/*
+ * Checks a file in a child process, which prints into temporary
+ * files.  If the child can't be created, the file will be checked
+ * in this process when its turn comes.
+ */
+
+static void StartJob(struct Job *Job, const char *FileName, long Tab)
+{
+    Job->FileName = FileName;
+    Job->Tab = Tab;
+    Job->Pid = -1;
+    Job->Out = tmpfile();
+    Job->Err = tmpfile();
+    if (Job->Out && Job->Err)
+    {
+        fflush(OutputFile);
+        fflush(stdout);
+        fflush(stderr);
+        Job->Pid = fork();
+    }
+    if (Job->Pid == 0)
+    {
+        int Ret = EXIT_NO_INPUT;
+
+        OutputFile = Job->Out;
+        dup2(fileno(Job->Err), fileno(stderr));
+        ResetState();
+        if (PushFileName(FileName, &InputStack))
+            Ret = CheckInput(Tab);
+        fflush(OutputFile);
+        fflush(stderr);
+        /* Don't run the exit handlers of the parent */
+        _exit(Ret);
+    }
+    if (Job->Pid < 0)
+    {
+        if (Job->Out)
+            fclose(Job->Out);
+        if (Job->Err)
+            fclose(Job->Err);
+        Job->Out = Job->Err = NULL;
+    }
+}
+
+/*
+ * Waits for a job and prints its output, if `Print' is set.
+ */
+
+static int FinishJob(struct Job *Job, int Print)
+{
+    int Ret = EXIT_FAILURE, Status;
+
+    if (Job->Pid < 0)
+    {
+        if (!Print)
+            return EXIT_SUCCESS;
+        ResetState();
+        if (!PushFileName(Job->FileName, &InputStack))
+            return EXIT_NO_INPUT;
+        return CheckInput(Job->Tab);
+    }
+
+    while (waitpid(Job->Pid, &Status, 0) < 0)
+    {
+        if (errno != EINTR)
+        {
+            Status = -1;
+            break;
+        }
+    }
+    if (Status != -1 && WIFEXITED(Status))
+        Ret = WEXITSTATUS(Status);
+    if (Print)
+    {
+        CopyOutput(Job->Out, OutputFile);
+        CopyOutput(Job->Err, stderr);
+    }
+    fclose(Job->Out);
+    fclose(Job->Err);
+    return Ret;
+}
+
+/*
+ * Checks up to `Jobs' files at the same time.  The output is printed
+ * in the order of the files.  As with sequential checking, we stop
+ * at the first file which can't be opened.
+ */
+
+static int CheckFilesConcurrently(int NumFiles, char **FileNames, long Tab)
+{
+    struct Job *Running = calloc(NumFiles, sizeof(struct Job));
+    int Started = 0, Done, Stop = FALSE, retval = EXIT_SUCCESS, ret;
+
+    if (!Running)
+    {
+        PrintPrgErr(pmNoStackMem);
+        return EXIT_FAILURE;
+    }
+
+    for (Done = 0; Done < NumFiles; Done++)
+    {
+        while (!Stop && Started < NumFiles && Started - Done < Jobs)
+        {
+            StartJob(&Running[Started], FileNames[Started], Tab);
+            Started++;
+        }
+        if (Done == Started)
+            break;
+        ret = FinishJob(&Running[Done], !Stop);
+        if (Stop)
+            continue;
+        if (ret == EXIT_NO_INPUT)
+            Stop = TRUE;
+        else if (ret != EXIT_SUCCESS)
+            retval = ret;
     }
+
+    free(Running);
     return retval;
 }
 
+#endif
+
 /*
  * Opens the output file handle & possibly renames
  */
@@ -823,6 +1017,7 @@ static int ParseArgs(int argc, char **argv)
         {"tictoc", optional_argument, 0L, 't'},
         {"headererr", optional_argument, 0L, 'H'},
         {"version", no_argument, 0L, 'W'},
+        {"jobs", required_argument, 0L, 'j'},
 
         {0L, 0L, 0L, 0L}
     };
@@ -846,7 +1041,7 @@ static int ParseArgs(int argc, char **argv)
 
     while (!ArgErr &&
            ((c = getopt_long((int) argc, argv,
-                             "b::d:e:f:g::hH::I::il:m:n:Lo:p:qrs:t::v::V::w:Wx::",
+                             "b::d:e:f:g::hH::I::ij:l:m:n:Lo:p:qrs:t::v::V::w:Wx::",
                              long_options, &option_index)) != EOF))
     {
         while (c)
@@ -959,6 +1154,11 @@ static int ParseArgs(int argc, char **argv)
                 }
                 break;
 
+            case 'j':
+                nextc = ParseNumArg(&Jobs, 1, &optarg);
+                if (Jobs < 1)
+                    Jobs = 1;
+                break;
             case 'v':
                 nextc = ParseNumArg(&Verb, 2, &optarg);
 
@@ -325,6 +325,7 @@ extern FILE *OutputFile, *InputFile;
   DEF(char *, PipeOutputFormat, NULL); \
   DEF(const char *, Delimit, ":"); \
   DEF(long,  DebugLevel, 0); \
+  DEF(long,  Jobs, 1); \
   DEF(int,  NoLineSupp, FALSE)
 
 #define STATE_VARS \
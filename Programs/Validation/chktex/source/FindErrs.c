@@ -32,6 +32,7 @@
 #include "OpSys.h"
 #include "Utility.h"
 #include "Resource.h"
+#include "MultiMatch.h"
 
 #if HAVE_PCRE || HAVE_POSIX_ERE
 
@@ -49,6 +50,11 @@ regex_t* RegexArray = NULL;
 regex_t* SilentRegex = NULL;
 int NumRegexes = 0;
 
+/* Literals required by the user regexes, to find the candidates for a
+   line in a single pass. */
+struct MultiMatch* RegexMatcher = NULL;
+char* RegexCandidates = NULL;
+
 #endif
 
 int FoundErr = EXIT_SUCCESS;
@@ -892,18 +898,50 @@ static void CheckRest(void)
                         {
                             ((char*)UserWarnRegex.Stack.Data[NumRegexes])[0] = '\0';
                         }
+                        /* Lines which don't contain the literal can't match. */
+                        if ( !RegexMatcher && !RegexCandidates )
+                        {
+                            RegexMatcher = MultiMatchCreate(UserWarnRegex.Stack.Used);
+                            RegexCandidates = (char*)malloc( UserWarnRegex.Stack.Used );
+                        }
+                        if ( RegexMatcher )
+                        {
+                            char *literal = RegexRequiredLiteral(pattern);
+                            if ( !literal || !MultiMatchAdd(RegexMatcher, literal, NumRegexes) )
+                            {
+                                MultiMatchFree(RegexMatcher);
+                                RegexMatcher = NULL;
+                            }
+                            free(literal);
+                        }
                         ++NumRegexes;
                     }
                 }
+                if ( RegexMatcher && (!RegexCandidates || !MultiMatchCompile(RegexMatcher)) )
+                {
+                    MultiMatchFree(RegexMatcher);
+                    RegexMatcher = NULL;
+                }
             }
         }
 
+        /* Find the regexes which may match in one pass */
+        if ( RegexMatcher )
+        {
+            MultiMatchScan(RegexMatcher, TmpBuffer, RegexCandidates);
+        }
+
         for (Count = 0; Count < NumRegexes; ++Count)
         {
             int offset = 0;
             char *ErrMessage = UserWarnRegex.Stack.Data[Count];
             const int NamedWarning = strlen(ErrMessage) > 0;
 
+            if ( RegexMatcher && !RegexCandidates[Count] )
+            {
+                continue;
+            }
+
             while (offset < len)
             {
                 /* Check if this warning should be suppressed. */
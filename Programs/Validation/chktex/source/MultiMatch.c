@@ -0,0 +1,421 @@
+/*
+ *  ChkTeX, multi-pattern matching.
+ *  Copyright (C) 2020 Christian Schenk
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "ChkTeX.h"
+#include "MultiMatch.h"
+
+#define NUM_CHARS 256
+
+struct MMOutput
+{
+    int Pattern;
+    int Next;
+};
+
+struct MultiMatch
+{
+    int NumPatterns;
+    int NumNodes, MaxNodes;
+    int *Goto;                  /* NUM_CHARS transitions per node */
+    int *Fail;
+    int *Out;                   /* first output of a node */
+    int *DictLink;              /* next node with outputs on the fail path */
+    struct MMOutput *Outputs;
+    int NumOutputs, MaxOutputs;
+    char *Always;               /* patterns without a literal */
+};
+
+/*
+ * Appends a trie node; returns its index or -1.
+ */
+
+static int NewNode(struct MultiMatch *mm)
+{
+    int i;
+
+    if (mm->NumNodes == mm->MaxNodes)
+    {
+        int MaxNodes = mm->MaxNodes ? mm->MaxNodes * 2 : 64;
+        int *Goto = realloc(mm->Goto, sizeof(int) * NUM_CHARS * MaxNodes);
+        int *Fail, *Out, *DictLink;
+
+        if (!Goto)
+            return -1;
+        mm->Goto = Goto;
+        if (!(Fail = realloc(mm->Fail, sizeof(int) * MaxNodes)))
+            return -1;
+        mm->Fail = Fail;
+        if (!(Out = realloc(mm->Out, sizeof(int) * MaxNodes)))
+            return -1;
+        mm->Out = Out;
+        if (!(DictLink = realloc(mm->DictLink, sizeof(int) * MaxNodes)))
+            return -1;
+        mm->DictLink = DictLink;
+        mm->MaxNodes = MaxNodes;
+    }
+
+    for (i = 0; i < NUM_CHARS; i++)
+        mm->Goto[mm->NumNodes * NUM_CHARS + i] = -1;
+    mm->Fail[mm->NumNodes] = 0;
+    mm->Out[mm->NumNodes] = -1;
+    mm->DictLink[mm->NumNodes] = -1;
+
+    return mm->NumNodes++;
+}
+
+struct MultiMatch *MultiMatchCreate(int NumPatterns)
+{
+    struct MultiMatch *mm = calloc(1, sizeof(struct MultiMatch));
+
+    if (!mm)
+        return NULL;
+    mm->NumPatterns = NumPatterns;
+    if (!(mm->Always = calloc(NumPatterns > 0 ? NumPatterns : 1, 1))
+        || NewNode(mm) < 0)
+    {
+        MultiMatchFree(mm);
+        return NULL;
+    }
+    return mm;
+}
+
+/*
+ * Adds a literal string; returns FALSE if we ran out of memory.
+ */
+
+int MultiMatchAdd(struct MultiMatch *mm, const char *Literal, int Pattern)
+{
+    int Node = 0;
+
+    if (!*Literal)
+    {
+        mm->Always[Pattern] = 1;
+        return TRUE;
+    }
+
+    for (; *Literal; Literal++)
+    {
+        int *Next = &mm->Goto[Node * NUM_CHARS + (unsigned char) *Literal];
+
+        if (*Next < 0)
+        {
+            int Child = NewNode(mm);
+
+            if (Child < 0)
+                return FALSE;
+            /* NewNode() may have moved the table */
+            mm->Goto[Node * NUM_CHARS + (unsigned char) *Literal] = Child;
+            Node = Child;
+        }
+        else
+            Node = *Next;
+    }
+
+    if (mm->NumOutputs == mm->MaxOutputs)
+    {
+        int MaxOutputs = mm->MaxOutputs ? mm->MaxOutputs * 2 : 16;
+        struct MMOutput *Outputs =
+            realloc(mm->Outputs, sizeof(struct MMOutput) * MaxOutputs);
+
+        if (!Outputs)
+            return FALSE;
+        mm->Outputs = Outputs;
+        mm->MaxOutputs = MaxOutputs;
+    }
+    mm->Outputs[mm->NumOutputs].Pattern = Pattern;
+    mm->Outputs[mm->NumOutputs].Next = mm->Out[Node];
+    mm->Out[Node] = mm->NumOutputs++;
+
+    return TRUE;
+}
+
+/*
+ * Computes the failure links and turns the trie into a complete
+ * automaton; no literals may be added afterwards.
+ */
+
+int MultiMatchCompile(struct MultiMatch *mm)
+{
+    int *Queue = malloc(sizeof(int) * mm->NumNodes);
+    int Head = 0, Tail = 0, c;
+
+    if (!Queue)
+        return FALSE;
+
+    for (c = 0; c < NUM_CHARS; c++)
+    {
+        int v = mm->Goto[c];
+
+        if (v < 0)
+            mm->Goto[c] = 0;
+        else
+        {
+            mm->Fail[v] = 0;
+            Queue[Tail++] = v;
+        }
+    }
+
+    /* Breadth-first, so that the transitions of the failure node are
+       complete when they are needed. */
+    while (Head < Tail)
+    {
+        int u = Queue[Head++];
+
+        for (c = 0; c < NUM_CHARS; c++)
+        {
+            int v = mm->Goto[u * NUM_CHARS + c];
+            int f = mm->Goto[mm->Fail[u] * NUM_CHARS + c];
+
+            if (v < 0)
+                mm->Goto[u * NUM_CHARS + c] = f;
+            else
+            {
+                mm->Fail[v] = f;
+                mm->DictLink[v] = mm->Out[f] >= 0 ? f : mm->DictLink[f];
+                Queue[Tail++] = v;
+            }
+        }
+    }
+
+    free(Queue);
+    return TRUE;
+}
+
+/*
+ * Sets Found[i] to 1 for each pattern i which has a literal occurring
+ * in `Text'; the other entries are set to 0.
+ */
+
+void MultiMatchScan(const struct MultiMatch *mm, const char *Text,
+                    char *Found)
+{
+    int State = 0;
+
+    memcpy(Found, mm->Always, mm->NumPatterns);
+
+    for (; *Text; Text++)
+    {
+        int Node;
+
+        State = mm->Goto[State * NUM_CHARS + (unsigned char) *Text];
+        Node = mm->Out[State] >= 0 ? State : mm->DictLink[State];
+        for (; Node >= 0; Node = mm->DictLink[Node])
+        {
+            int o;
+
+            for (o = mm->Out[Node]; o >= 0; o = mm->Outputs[o].Next)
+                Found[mm->Outputs[o].Pattern] = 1;
+        }
+    }
+}
+
+void MultiMatchFree(struct MultiMatch *mm)
+{
+    if (!mm)
+        return;
+    free(mm->Goto);
+    free(mm->Fail);
+    free(mm->Out);
+    free(mm->DictLink);
+    free(mm->Outputs);
+    free(mm->Always);
+    free(mm);
+}
+
+/*
+ * Skips a bracket expression; `p' points behind the `['.
+ */
+
+static const char *SkipBracket(const char *p)
+{
+    if (*p == '^')
+        p++;
+    if (*p == ']')
+        p++;
+    while (*p && *p != ']')
+    {
+        if (*p == '[' && (p[1] == ':' || p[1] == '.' || p[1] == '='))
+        {
+            char Delim = p[1];
+
+            p += 2;
+            while (*p && !(*p == Delim && p[1] == ']'))
+                p++;
+            if (*p)
+                p += 2;
+        }
+        else
+            p++;
+    }
+    return *p ? p + 1 : p;
+}
+
+/*
+ * Skips a parenthesized group; `p' points behind the `('.
+ */
+
+static const char *SkipGroup(const char *p)
+{
+    int Depth = 1;
+
+    while (*p && Depth > 0)
+    {
+        switch (*p)
+        {
+        case '\\':
+            p += p[1] ? 2 : 1;
+            break;
+        case '[':
+            p = SkipBracket(p + 1);
+            break;
+        case '(':
+            Depth++;
+            p++;
+            break;
+        case ')':
+            Depth--;
+            p++;
+            break;
+        default:
+            p++;
+            break;
+        }
+    }
+    return p;
+}
+
+static int IsQuantifier(const char *p)
+{
+    return *p == '*' || *p == '?' || *p == '+' || *p == '{';
+}
+
+static const char *SkipQuantifiers(const char *p)
+{
+    while (IsQuantifier(p))
+    {
+        if (*p == '{')
+        {
+            while (*p && *p != '}')
+                p++;
+            if (*p)
+                p++;
+        }
+        else
+            p++;
+    }
+    return p;
+}
+
+char *RegexRequiredLiteral(const char *Pattern)
+{
+    size_t Len = strlen(Pattern);
+    char *Best = calloc(Len + 1, 1);
+    char *Run = calloc(Len + 1, 1);
+    size_t BestLen = 0, RunLen = 0;
+    const char *p;
+
+    if (!Best || !Run)
+    {
+        free(Run);
+        return Best;
+    }
+
+    /* Alternatives and extensions (flags such as `(?i)') are beyond
+       us: every line is a candidate. */
+    for (p = Pattern; *p;)
+    {
+        if (*p == '\\')
+            p += p[1] ? 2 : 1;
+        else if (*p == '[')
+            p = SkipBracket(p + 1);
+        else if (*p == '(')
+        {
+            if (p[1] == '?')
+            {
+                free(Run);
+                return Best;
+            }
+            p = SkipGroup(p + 1);
+        }
+        else if (*p == '|')
+        {
+            free(Run);
+            return Best;
+        }
+        else
+            p++;
+    }
+
+    p = Pattern;
+    while (1)
+    {
+        int c = -1;
+
+        if (*p == '\\' && p[1] && !isalnum((unsigned char) p[1])
+            && !strchr("<>`'", p[1]))
+        {
+            /* escaped special character */
+            c = (unsigned char) p[1];
+            p += 2;
+        }
+        else if (*p && !strchr(".[]()*+?{}|^$\\", *p))
+        {
+            c = (unsigned char) *p;
+            p++;
+        }
+        else if (*p == '[')
+            p = SkipQuantifiers(SkipBracket(p + 1));
+        else if (*p == '(')
+            p = SkipQuantifiers(SkipGroup(p + 1));
+        else if (*p == '\\')
+            /* a class such as `\w' or an anchor such as `\<' */
+            p = SkipQuantifiers(p + (p[1] ? 2 : 1));
+        else if (*p)
+            p = SkipQuantifiers(p + 1);
+
+        if (c >= 0 && IsQuantifier(p))
+        {
+            /* an optional character ends the run; a repeated
+               character is its last member */
+            if (*p == '+')
+                Run[RunLen++] = (char) c;
+            p = SkipQuantifiers(p);
+            c = -1;
+        }
+
+        if (c >= 0)
+            Run[RunLen++] = (char) c;
+        else
+        {
+            if (RunLen > BestLen)
+            {
+                memcpy(Best, Run, RunLen);
+                Best[RunLen] = '\0';
+                BestLen = RunLen;
+            }
+            RunLen = 0;
+            if (!*p)
+                break;
+        }
+    }
+
+    free(Run);
+    return Best;
+}
@@ -0,0 +1,48 @@
+/*
+ *  ChkTeX, multi-pattern matching -- header file.
+ *  Copyright (C) 2020 Christian Schenk
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef MULTIMATCH_H
+#define MULTIMATCH_H 1
+
+/*
+ * A set of literal strings, which are searched for in a single pass
+ * (Aho-Corasick automaton).  Each string is tagged with the index of a
+ * pattern; the scan reports the patterns whose strings occur in a
+ * text.  Patterns with an empty string are always reported.
+ */
+
+struct MultiMatch;
+
+struct MultiMatch *MultiMatchCreate(int NumPatterns);
+int MultiMatchAdd(struct MultiMatch *mm, const char *Literal, int Pattern);
+int MultiMatchCompile(struct MultiMatch *mm);
+void MultiMatchScan(const struct MultiMatch *mm, const char *Text,
+                    char *Found);
+void MultiMatchFree(struct MultiMatch *mm);
+
+/*
+ * Returns the longest literal string which any match of the POSIX
+ * extended regular expression `Pattern' must contain.  The result is
+ * malloc()ed; it is empty if no such string could be determined.
+ */
+
+char *RegexRequiredLiteral(const char *Pattern);
+
+#endif /* MULTIMATCH_H */
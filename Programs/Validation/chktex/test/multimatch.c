@@ -0,0 +1,98 @@
+/*
+ *  ChkTeX, tests for the multi-pattern matching.
+ *  Copyright (C) 2020 Christian Schenk
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "MultiMatch.h"
+
+static int Failures = 0;
+
+static void ExpectLiteral(const char *Pattern, const char *Expected)
+{
+    char *Literal = RegexRequiredLiteral(Pattern);
+
+    if (!Literal || strcmp(Literal, Expected) != 0)
+    {
+        fprintf(stderr, "RegexRequiredLiteral(\"%s\"): expected \"%s\", got \"%s\"\n",
+                Pattern, Expected, Literal ? Literal : "(null)");
+        Failures++;
+    }
+    free(Literal);
+}
+
+/*
+ * Prefilters `Text' with the literal of `Pattern'.
+ */
+
+static void ExpectCandidate(const char *Pattern, const char *Text,
+                            int Expected)
+{
+    struct MultiMatch *mm = MultiMatchCreate(1);
+    char *Literal = RegexRequiredLiteral(Pattern);
+    char Found = 0;
+
+    if (!mm || !Literal || !MultiMatchAdd(mm, Literal, 0)
+        || !MultiMatchCompile(mm))
+    {
+        fprintf(stderr, "%s: cannot build the automaton\n", Pattern);
+        Failures++;
+    }
+    else
+    {
+        MultiMatchScan(mm, Text, &Found);
+        if (!Found != !Expected)
+        {
+            fprintf(stderr, "\"%s\" on \"%s\": expected %s\n", Pattern, Text,
+                    Expected ? "a candidate" : "no candidate");
+            Failures++;
+        }
+    }
+    free(Literal);
+    if (mm)
+        MultiMatchFree(mm);
+}
+
+int main(void)
+{
+    /* escaped special characters are literal */
+    ExpectLiteral("\\\\foo\\{", "\\foo{");
+    ExpectLiteral("a\\.b", "a.b");
+
+    /* GNU anchors are zero-width */
+    ExpectLiteral("\\<in\\>", "in");
+    ExpectLiteral("\\`begin\\'", "begin");
+    ExpectLiteral("\\<a\\>bcd", "bcd");
+    ExpectLiteral("\\bfoo\\B", "foo");
+
+    /* quantifiers and alternatives */
+    ExpectLiteral("ab?cd", "cd");
+    ExpectLiteral("xy+z", "xy");
+    ExpectLiteral("foo|bar", "");
+
+    /* a word-boundary pattern must select the lines which contain the
+       word */
+    ExpectCandidate("\\<in\\>", "x in y", 1);
+    ExpectCandidate("\\<in\\>", "in", 1);
+    ExpectCandidate("\\<in\\>", "out", 0);
+
+    return Failures ? 1 : 0;
+}
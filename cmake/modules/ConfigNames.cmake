@@ -53,6 +53,7 @@ set(MIKTEX_CONFIG_VALUE_ENVVARS "EnvVars[]")
 set(MIKTEX_CONFIG_VALUE_EXTENSIONS "Extensions[]")
 set(MIKTEX_CONFIG_VALUE_FORCE_LOCAL_SERVER "ForceLocalServer")
 set(MIKTEX_CONFIG_VALUE_GUI_FRAMEWORK "GUIFramework")
+set(MIKTEX_CONFIG_VALUE_HUGE_PAGES "HugePages")
 set(MIKTEX_CONFIG_VALUE_LAST_ADMIN_DIAGNOSE "LastAdminDiagnose")
 set(MIKTEX_CONFIG_VALUE_LAST_ADMIN_MAINTENANCE "LastAdminMaintenance")
 set(MIKTEX_CONFIG_VALUE_LAST_ADMIN_UPDATE "LastAdminUpdate")
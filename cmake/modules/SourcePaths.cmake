@@ -131,6 +131,7 @@ set(MIKTEX_REL_SYNCTEX_INCLUDE_DIR      "${MIKTEX_REL_SYNCTEX_DIR}")
 set(MIKTEX_REL_TDSUTIL_DIR              "Programs/MiKTeX/tdsutil")
 set(MIKTEX_REL_TECKIT_DIR               "Libraries/3rd/teckit")
 set(MIKTEX_REL_TEX4HT_DIR               "Programs/Converters/tex4ht")
+set(MIKTEX_REL_TEX_BENCHMARK_DIR        "Programs/TeXAndFriends/benchmark")
 set(MIKTEX_REL_TEX_DIR                  "Programs/TeXAndFriends/Knuth/tex")
 set(MIKTEX_REL_TEX_ETC_DIR              "Programs/TeXAndFriends/Knuth/etc")
 set(MIKTEX_REL_TEXIFY_DIR               "Programs/MiKTeX/texify")